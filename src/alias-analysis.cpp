@@ -0,0 +1,504 @@
+/**
+ * @file alias-analysis.cpp
+ * @author Barney Wilks
+ *
+ * Implements alias-analysis.h
+ */
+
+/* Internal Project Includes */
+#include "alias-analysis.h"
+#include "function.h"
+#include "instructions.h"
+#include "ir-helpers.h"
+#include "options.h"
+#include "target-info-armv7.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <unordered_set>
+
+using namespace Helix;
+
+/******************************************************************************/
+
+/// Limit on how far back through definitions a pointer is followed, to stop
+/// pathological (or cyclic, in unreachable code) chains running away.
+static constexpr unsigned kMaxDecomposeDepth = 32;
+
+/******************************************************************************/
+
+/// Return the byte offset of the given field from the start of the struct
+/// (using the same layout as genlower).
+static int64_t
+GetFieldOffset(const StructType* structType, unsigned int fieldIndex)
+{
+	int64_t offset = 0;
+
+	for (unsigned int i = 0; i < fieldIndex; ++i) {
+		offset += (int64_t) ARMv7::TypeSize(structType->GetField(i));
+	}
+
+	return offset;
+}
+
+/******************************************************************************/
+
+/// Return true if C's type based aliasing rules say that an access of type 'a'
+/// can never overlap an access of type 'b' - both are (different) scalar types
+/// & neither of them is `char`, which is allowed to alias anything.
+static bool
+AreTypesDisjoint(const Type* a, const Type* b)
+{
+	if (!a || !b)
+		return false;
+
+	const bool aScalar = a->IsIntegral() || a->IsPointer();
+	const bool bScalar = b->IsIntegral() || b->IsPointer();
+
+	if (!aScalar || !bScalar)
+		return false;
+
+	const IntegerType* aInt = type_cast<IntegerType>(a);
+	const IntegerType* bInt = type_cast<IntegerType>(b);
+
+	if ((aInt && aInt->GetBitWidth() == 8) || (bInt && bInt->GetBitWidth() == 8))
+		return false;
+
+	if (aInt && bInt)
+		return aInt->GetBitWidth() != bInt->GetBitWidth();
+
+	return a->IsPointer() != b->IsPointer();
+}
+
+/******************************************************************************/
+
+MemoryLocation::MemoryLocation(Value* ptr, const Type* accessType)
+	: Ptr(ptr), AccessType(accessType)
+{
+	if (accessType && !accessType->IsVoid())
+		Size = ARMv7::TypeSize(accessType);
+}
+
+/******************************************************************************/
+
+MemoryLocation
+MemoryLocation::Get(const Instruction* insn)
+{
+	switch (insn->GetOpcode()) {
+	case HLIR::Load: {
+		const LoadInsn* load = static_cast<const LoadInsn*>(insn);
+		return MemoryLocation(load->GetSrc(), load->GetDst()->GetType());
+	}
+
+	case HLIR::Store: {
+		const StoreInsn* store = static_cast<const StoreInsn*>(insn);
+		return MemoryLocation(store->GetDst(), store->GetSrc()->GetType());
+	}
+
+	default:
+		helix_unreachable("memory locations can only be found for loads & stores");
+		break;
+	}
+
+	return MemoryLocation();
+}
+
+/******************************************************************************/
+
+AliasAnalysis::AliasAnalysis(Function* fn)
+	: m_Function(fn), m_StrictAliasing(!Options::GetNoStrictAliasing())
+{
+}
+
+/******************************************************************************/
+
+bool
+AliasAnalysis::IsPointerDerived(Value* value, unsigned depth) const
+{
+	if (value->GetType()->IsPointer())
+		return true;
+
+	if (depth >= kMaxDecomposeDepth)
+		return false;
+
+	Instruction* def = IR::GetSingleDefinition(value);
+
+	if (!def)
+		return false;
+
+	switch (def->GetOpcode()) {
+	case HLIR::PtrToInt:
+		return true;
+
+	case HLIR::Set:
+		return IsPointerDerived(static_cast<SetInsn*>(def)->GetNewValue(), depth + 1);
+
+	case HLIR::IAdd: {
+		BinOpInsn* add = static_cast<BinOpInsn*>(def);
+		return IsPointerDerived(add->GetLHS(), depth + 1) || IsPointerDerived(add->GetRHS(), depth + 1);
+	}
+
+	case HLIR::ISub:
+		return IsPointerDerived(static_cast<BinOpInsn*>(def)->GetLHS(), depth + 1);
+
+	default:
+		return false;
+	}
+}
+
+/******************************************************************************/
+
+void
+AliasAnalysis::DecomposeValue(Value* value, DecomposedPointer& result, unsigned depth) const
+{
+	// Unless we find out otherwise, 'value' is the object itself & we know
+	// nothing about it.
+	result.Object = value;
+	result.Kind   = kObject_Unknown;
+
+	if (depth >= kMaxDecomposeDepth)
+		return;
+
+	if (value_isa<GlobalVariable>(value)) {
+		result.Kind = kObject_Global;
+		return;
+	}
+
+	if (std::find(m_Function->params_begin(), m_Function->params_end(), value) != m_Function->params_end()) {
+		if (IR::GetCountWriteUsers(value) == 0)
+			result.Kind = kObject_Parameter;
+
+		return;
+	}
+
+	if (!value_isa<VirtualRegisterName>(value))
+		return;
+
+	Instruction* def = IR::GetSingleDefinition(value);
+
+	if (!def)
+		return;
+
+	switch (def->GetOpcode()) {
+	case HLIR::StackAlloc:
+		result.Kind = kObject_StackSlot;
+		break;
+
+	case HLIR::Set:
+		DecomposeValue(static_cast<SetInsn*>(def)->GetNewValue(), result, depth + 1);
+		break;
+
+	case HLIR::PtrToInt:
+	case HLIR::IntToPtr:
+		DecomposeValue(static_cast<CastInsn*>(def)->GetSrc(), result, depth + 1);
+		break;
+
+	case HLIR::LoadElementAddress: {
+		LoadEffectiveAddressInsn* lea = static_cast<LoadEffectiveAddressInsn*>(def);
+		DecomposeValue(lea->GetInputPtr(), result, depth + 1);
+
+		if (ConstantInt* index = value_cast<ConstantInt>(lea->GetIndex())) {
+			result.Offset += index->GetSignedIntegralValue() * (int64_t) ARMv7::TypeSize(lea->GetBaseType());
+		} else {
+			result.HasConstantOffset = false;
+		}
+
+		break;
+	}
+
+	case HLIR::LoadFieldAddress: {
+		LoadFieldAddressInsn* lfa = static_cast<LoadFieldAddressInsn*>(def);
+		DecomposeValue(lfa->GetInputPtr(), result, depth + 1);
+
+		result.Offset += GetFieldOffset(type_cast<StructType>(lfa->GetBaseType()), lfa->GetFieldIndex());
+		break;
+	}
+
+	case HLIR::IAdd:
+	case HLIR::ISub: {
+		// Pointer arithmetic as lowered by genlower, `ptrtoint` the base pointer
+		// and then add a (constant or scaled) byte offset to it.
+		BinOpInsn* binop = static_cast<BinOpInsn*>(def);
+
+		Value* base   = binop->GetLHS();
+		Value* offset = binop->GetRHS();
+
+		const bool isAdd = def->GetOpcode() == HLIR::IAdd;
+
+		if (isAdd && !IsPointerDerived(base, depth + 1)) {
+			std::swap(base, offset);
+		}
+
+		if (!IsPointerDerived(base, depth + 1) || IsPointerDerived(offset, depth + 1))
+			break;
+
+		DecomposeValue(base, result, depth + 1);
+
+		if (ConstantInt* c = value_cast<ConstantInt>(offset)) {
+			result.Offset += isAdd ? c->GetSignedIntegralValue() : -c->GetSignedIntegralValue();
+		} else {
+			result.HasConstantOffset = false;
+		}
+
+		break;
+	}
+
+	default:
+		break;
+	}
+}
+
+/******************************************************************************/
+
+AliasAnalysis::DecomposedPointer
+AliasAnalysis::Decompose(Value* ptr)
+{
+	auto it = m_Decomposed.find(ptr);
+
+	if (it != m_Decomposed.end())
+		return it->second;
+
+	DecomposedPointer result;
+	DecomposeValue(ptr, result, 0);
+
+	m_Decomposed[ptr] = result;
+	return result;
+}
+
+/******************************************************************************/
+
+bool
+AliasAnalysis::ComputeIsEscaped(Value* object) const
+{
+	// Walk every value computed from the address of the object, if any of them
+	// are used by anything other than loads/stores/compares (or other address
+	// computations) then the address might be visible elsewhere.
+	//
+	// Any derived value that wouldn't decompose back to the object (e.g.
+	// because it's merged with other values in a register that's written more
+	// than once) also has to count as escaping, otherwise accesses through it
+	// would be assumed to not touch the object.
+	std::vector<Value*>        worklist = { object };
+	std::unordered_set<Value*> visited  = { object };
+
+	while (!worklist.empty()) {
+		Value* value = worklist.back();
+		worklist.pop_back();
+
+		for (const Use& use : value->uses()) {
+			Instruction* insn = use.GetInstruction();
+
+			if (insn->OperandHasFlags(use.GetOperandIndex(), Instruction::OP_WRITE))
+				continue;
+
+			Value* derived = nullptr;
+
+			switch (insn->GetOpcode()) {
+			case HLIR::Load:
+				break;
+
+			case HLIR::Store:
+				if (use.GetOperandIndex() == 0)
+					return true;
+
+				break;
+
+			case HLIR::ICmp_Eq:
+			case HLIR::ICmp_Neq:
+			case HLIR::ICmp_Lt:
+			case HLIR::ICmp_Gt:
+			case HLIR::ICmp_Lte:
+			case HLIR::ICmp_Gte:
+				break;
+
+			case HLIR::LoadElementAddress:
+				if (use.GetOperandIndex() != 0)
+					return true;
+
+				derived = static_cast<LoadEffectiveAddressInsn*>(insn)->GetOutputPtr();
+				break;
+
+			case HLIR::LoadFieldAddress:
+				derived = static_cast<LoadFieldAddressInsn*>(insn)->GetOutputPtr();
+				break;
+
+			case HLIR::PtrToInt:
+			case HLIR::IntToPtr:
+				derived = static_cast<CastInsn*>(insn)->GetDst();
+				break;
+
+			case HLIR::IAdd:
+			case HLIR::ISub:
+				derived = static_cast<BinOpInsn*>(insn)->GetResult();
+				break;
+
+			case HLIR::Set:
+				derived = static_cast<SetInsn*>(insn)->GetRegister();
+				break;
+
+			default:
+				return true;
+			}
+
+			if (!derived || visited.count(derived))
+				continue;
+
+			DecomposedPointer dp;
+			DecomposeValue(derived, dp, 0);
+
+			if (dp.Object != object)
+				return true;
+
+			visited.insert(derived);
+			worklist.push_back(derived);
+		}
+	}
+
+	return false;
+}
+
+/******************************************************************************/
+
+bool
+AliasAnalysis::IsEscaped(Value* object)
+{
+	auto it = m_Escaped.find(object);
+
+	if (it != m_Escaped.end())
+		return it->second;
+
+	const bool escaped = ComputeIsEscaped(object);
+	m_Escaped[object] = escaped;
+
+	return escaped;
+}
+
+/******************************************************************************/
+
+AliasResult
+AliasAnalysis::AliasObjects(const DecomposedPointer& a, const DecomposedPointer& b)
+{
+	helix_assert(a.Object != b.Object, "expected pointers into different objects");
+
+	auto isIdentified = [](const DecomposedPointer& dp) {
+		return dp.Kind == kObject_StackSlot || dp.Kind == kObject_Global;
+	};
+
+	// Distinct stack slots & globals never overlap.
+	if (isIdentified(a) && isIdentified(b))
+		return AliasResult::NoAlias;
+
+	// Parameters point to memory that existed before the function was
+	// called, so can't point into any of its stack slots.
+	if ((a.Kind == kObject_StackSlot && b.Kind == kObject_Parameter)
+	 || (b.Kind == kObject_StackSlot && a.Kind == kObject_Parameter))
+		return AliasResult::NoAlias;
+
+	// If the address of a stack slot (or `restrict` parameter) is never
+	// captured, then the only way to access it is through pointers that are
+	// based on it, which 'b' isn't.
+	auto isNotCaptured = [this](const DecomposedPointer& dp) {
+		switch (dp.Kind) {
+		case kObject_StackSlot:
+			return !IsEscaped(dp.Object);
+
+		case kObject_Parameter:
+			return m_Function->IsNoAliasParameter(dp.Object) && !IsEscaped(dp.Object);
+
+		default:
+			return false;
+		}
+	};
+
+	if (isNotCaptured(a) || isNotCaptured(b))
+		return AliasResult::NoAlias;
+
+	// C99 6.7.3.1 - an object accessed through a `restrict` pointer can't
+	// be accessed through anything not based on that pointer (including
+	// globals & other parameters).
+	auto isRestrict = [this](const DecomposedPointer& dp) {
+		return dp.Kind == kObject_Parameter && m_Function->IsNoAliasParameter(dp.Object);
+	};
+
+	if ((isRestrict(a) && b.Kind != kObject_Unknown) || (isRestrict(b) && a.Kind != kObject_Unknown))
+		return AliasResult::NoAlias;
+
+	return AliasResult::MayAlias;
+}
+
+/******************************************************************************/
+
+AliasResult
+AliasAnalysis::Alias(const MemoryLocation& a, const MemoryLocation& b)
+{
+	if (!a.Ptr || !b.Ptr)
+		return AliasResult::MayAlias;
+
+	const DecomposedPointer da = Decompose(a.Ptr);
+	const DecomposedPointer db = Decompose(b.Ptr);
+
+	AliasResult result = AliasResult::MayAlias;
+
+	if (da.Object == db.Object) {
+		if (da.HasConstantOffset && db.HasConstantOffset) {
+			if (da.Offset == db.Offset && a.Size == b.Size && a.Size != MemoryLocation::kUnknownSize)
+				return AliasResult::MustAlias;
+
+			const bool aBeforeB = a.Size != MemoryLocation::kUnknownSize && da.Offset + (int64_t) a.Size <= db.Offset;
+			const bool bBeforeA = b.Size != MemoryLocation::kUnknownSize && db.Offset + (int64_t) b.Size <= da.Offset;
+
+			if (aBeforeB || bBeforeA)
+				return AliasResult::NoAlias;
+		}
+	} else {
+		result = AliasObjects(da, db);
+	}
+
+	if (result == AliasResult::MayAlias && m_StrictAliasing && AreTypesDisjoint(a.AccessType, b.AccessType))
+		return AliasResult::NoAlias;
+
+	return result;
+}
+
+/******************************************************************************/
+
+AliasResult
+AliasAnalysis::Alias(const Instruction* a, const Instruction* b)
+{
+	return Alias(MemoryLocation::Get(a), MemoryLocation::Get(b));
+}
+
+/******************************************************************************/
+
+ModRefInfo
+AliasAnalysis::GetModRefInfo(const Instruction* insn, const MemoryLocation& loc)
+{
+	switch (insn->GetOpcode()) {
+	case HLIR::Load:
+		return Alias(MemoryLocation::Get(insn), loc) != AliasResult::NoAlias ? kRef : kNoModRef;
+
+	case HLIR::Store:
+		return Alias(MemoryLocation::Get(insn), loc) != AliasResult::NoAlias ? kMod : kNoModRef;
+
+	case HLIR::Call: {
+		Function* callee = IR::GetCalledFunction(insn);
+
+		if (callee && callee->DoesNotAccessMemory())
+			return kNoModRef;
+
+		// Nothing outside of the function can touch a stack slot whose address
+		// hasn't escaped.
+		const DecomposedPointer dp = Decompose(loc.Ptr);
+
+		if (dp.Kind == kObject_StackSlot && !IsEscaped(dp.Object))
+			return kNoModRef;
+
+		return callee && callee->DoesNotWriteMemory() ? kRef : kModRef;
+	}
+
+	default:
+		return kNoModRef;
+	}
+}
+
+/******************************************************************************/
@@ -0,0 +1,152 @@
+/**
+ * @file alias-analysis.h
+ * @author Barney Wilks
+ *
+ * Alias analysis for memory accesses (loads, stores & calls).
+ *
+ * Every pointer is decomposed into the underlying object that it points into
+ * and a byte offset from the start of that object, looking through `lea`,
+ * `lfa`, copies with `set` and the ptrtoint/iadd/inttoptr sequences that
+ * genlower turns `lea` & `lfa` into. Underlying objects are either stack slots
+ * (the output of a `stack_alloc`), global variables, parameters of the function
+ * or something unknown (e.g. a pointer that has been loaded from memory).
+ *
+ * Two accesses can't alias if they are
+ *   - into different stack slots or global variables
+ *   - at non overlapping constant offsets into the same object
+ *   - into a stack slot whose address never escapes the function (or a
+ *     `restrict` parameter that is never captured) & anything else
+ *   - of different scalar types, neither of which is `char` (the C type based
+ *     aliasing rules, disabled with -fno-strict-aliasing)
+ *
+ * Passes should get this through the AnalysisManager.
+ */
+
+#pragma once
+
+/* Internal Project Includes */
+#include "system.h"
+#include "analysis-manager.h"
+
+/* C++ Standard Library Includes */
+#include <unordered_map>
+
+/* C Standard Library Includes */
+#include <stdint.h>
+
+namespace Helix
+{
+	class Function;
+	class Instruction;
+	class Value;
+	class Type;
+
+	enum class AliasResult
+	{
+		/// The two locations never overlap.
+		NoAlias,
+
+		/// The two locations might overlap, but might not.
+		MayAlias,
+
+		/// The two locations always start at the same address & are the same
+		/// size (they may still be accessed as different types).
+		MustAlias
+	};
+
+	/// Describes how an instruction might access a memory location.
+	enum ModRefInfo
+	{
+		kNoModRef = 0,
+		kRef      = 1 << 0,
+		kMod      = 1 << 1,
+		kModRef   = kRef | kMod
+	};
+
+	/// A range of memory starting at a pointer, e.g. the memory read by a
+	/// `load`.
+	struct MemoryLocation
+	{
+		static constexpr size_t kUnknownSize = SIZE_MAX;
+
+		MemoryLocation() = default;
+
+		MemoryLocation(Value* ptr, const Type* accessType);
+
+		/// Get the location read by a `load` or written by a `store`
+		static MemoryLocation Get(const Instruction* insn);
+
+		Value*      Ptr        = nullptr;
+
+		/// Number of bytes accessed, kUnknownSize if that isn't known.
+		size_t      Size       = kUnknownSize;
+
+		/// The type that the memory is accessed as (only used for the type
+		/// based rules). Null if unknown.
+		const Type* AccessType = nullptr;
+	};
+
+	class AliasAnalysis : public Analysis
+	{
+	public:
+		enum ObjectKind
+		{
+			kObject_StackSlot,
+			kObject_Global,
+			kObject_Parameter,
+			kObject_Unknown
+		};
+
+		/// A pointer split into the object it points into & the offset
+		/// from the start of that object.
+		struct DecomposedPointer
+		{
+			Value*     Object            = nullptr;
+			ObjectKind Kind              = kObject_Unknown;
+			int64_t    Offset            = 0;
+			bool       HasConstantOffset = true;
+		};
+
+		AliasAnalysis(Function* fn);
+
+		HELIX_NO_STEAL(AliasAnalysis);
+
+		/// Return whether the two memory locations may overlap.
+		AliasResult Alias(const MemoryLocation& a, const MemoryLocation& b);
+
+		/// Return whether the memory accessed by the two loads/stores may overlap.
+		AliasResult Alias(const Instruction* a, const Instruction* b);
+
+		/// Return how 'insn' might access the memory at 'loc'. Calls are
+		/// assumed to read & write any memory that isn't local to this
+		/// function, unless the function called is known not to (see
+		/// MemoryEffects).
+		ModRefInfo GetModRefInfo(const Instruction* insn, const MemoryLocation& loc);
+
+		/// Find the object that the given pointer points into.
+		DecomposedPointer Decompose(Value* ptr);
+
+		/// Return true if the address of the given stack slot or parameter
+		/// may be visible to anything other than loads & stores in this
+		/// function (e.g. it's stored to memory, passed to a call or returned)
+		bool IsEscaped(Value* object);
+
+	private:
+		void DecomposeValue(Value* value, DecomposedPointer& result, unsigned depth) const;
+
+		bool IsPointerDerived(Value* value, unsigned depth) const;
+
+		AliasResult AliasObjects(const DecomposedPointer& a, const DecomposedPointer& b);
+
+		bool ComputeIsEscaped(Value* object) const;
+
+	private:
+		Function*                                      m_Function;
+		bool                                           m_StrictAliasing;
+
+		std::unordered_map<Value*, DecomposedPointer>  m_Decomposed;
+		std::unordered_map<Value*, bool>               m_Escaped;
+	};
+}
+
+REGISTER_ANALYSIS(AliasAnalysis, aa, "Alias analysis for loads, stores & calls");
@@ -0,0 +1,31 @@
+/**
+ * @file analysis-manager.cpp
+ * @author Barney Wilks
+ *
+ * Implements analysis-manager.h
+ */
+
+/* Internal Project Includes */
+#include "analysis-manager.h"
+
+using namespace Helix;
+
+HELIX_DEFINE_LOG_CHANNEL(analysis);
+
+/******************************************************************************/
+
+void
+AnalysisManager::Invalidate(Function* fn)
+{
+	m_Cache.erase(fn);
+}
+
+/******************************************************************************/
+
+void
+AnalysisManager::InvalidateAll()
+{
+	m_Cache.clear();
+}
+
+/******************************************************************************/
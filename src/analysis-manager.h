@@ -0,0 +1,135 @@
+/**
+ * @file analysis-manager.h
+ * @author Barney Wilks
+ *
+ * Registry & cache of per function analyses (dominator trees, loop info etc...)
+ *
+ * Analyses are computed lazily the first time a pass asks for them, and are
+ * then cached until something invalidates them. Any class deriving from
+ * Analysis and registered with REGISTER_ANALYSIS can be requested, as long as
+ * it can be constructed from either (Function*, AnalysisManager&) - for
+ * analyses that depend on other analyses - or just (Function*).
+ *
+ * The pass manager throws away every cached analysis after each pass has run,
+ * so passes don't need to worry about results going stale between passes.
+ * A pass that modifies a function and then wants fresh results for that same
+ * function must call Invalidate() itself.
+ */
+
+#pragma once
+
+/* Internal Project Includes */
+#include "system.h"
+
+/* C++ Standard Library Includes */
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+#define REGISTER_ANALYSIS(ClassName, AnalysisName, AnalysisDesc) \
+	namespace Helix { template <> \
+	struct AnalysisTraits<ClassName> { \
+		static constexpr const char* Name = #AnalysisName; \
+		static constexpr const char* Desc = AnalysisDesc; \
+	}; }
+
+HELIX_EXTERN_LOG_CHANNEL(analysis);
+
+namespace Helix
+{
+	class Function;
+
+	class Analysis
+	{
+	public:
+		virtual ~Analysis() = default;
+	};
+
+	template <typename T>
+	struct AnalysisTraits;
+
+	class AnalysisManager
+	{
+	public:
+		/// Get the analysis 'T' for the given function, computing it if there
+		/// is no up to date result cached.
+		template <typename T>
+		T& Get(Function* fn);
+
+		/// Return true if there is a cached result of 'T' for the function.
+		template <typename T>
+		bool IsCached(Function* fn) const;
+
+		/// Drop the cached result of 'T' for the given function (if any).
+		template <typename T>
+		void Invalidate(Function* fn);
+
+		/// Drop every cached analysis for the given function.
+		void Invalidate(Function* fn);
+
+		/// Drop every cached analysis for every function.
+		void InvalidateAll();
+
+	private:
+		using AnalysisCache = std::unordered_map<std::string, std::unique_ptr<Analysis>>;
+
+		std::unordered_map<const Function*, AnalysisCache> m_Cache;
+	};
+}
+
+/******************************************************************************/
+
+template <typename T>
+inline T& Helix::AnalysisManager::Get(Function* fn)
+{
+	static_assert(std::is_base_of_v<Analysis, T>, "analyses must derive from Helix::Analysis");
+
+	AnalysisCache& cache = m_Cache[fn];
+
+	auto it = cache.find(AnalysisTraits<T>::Name);
+
+	if (it != cache.end())
+		return static_cast<T&>(*it->second);
+
+	helix_trace(logs::analysis, "Computing analysis '{}'", AnalysisTraits<T>::Name);
+
+	std::unique_ptr<T> result;
+
+	if constexpr (std::is_constructible_v<T, Function*, AnalysisManager&>) {
+		result = std::make_unique<T>(fn, *this);
+	} else {
+		result = std::make_unique<T>(fn);
+	}
+
+	T& ref = *result;
+	cache[AnalysisTraits<T>::Name] = std::move(result);
+
+	return ref;
+}
+
+/******************************************************************************/
+
+template <typename T>
+inline bool Helix::AnalysisManager::IsCached(Function* fn) const
+{
+	auto it = m_Cache.find(fn);
+
+	if (it == m_Cache.end())
+		return false;
+
+	return it->second.find(AnalysisTraits<T>::Name) != it->second.end();
+}
+
+/******************************************************************************/
+
+template <typename T>
+inline void Helix::AnalysisManager::Invalidate(Function* fn)
+{
+	auto it = m_Cache.find(fn);
+
+	if (it != m_Cache.end())
+		it->second.erase(AnalysisTraits<T>::Name);
+}
+
+/******************************************************************************/
@@ -0,0 +1,167 @@
+/**
+ * @file arm-multiply.cpp
+ * @author Barney Wilks
+ */
+
+#include "arm-multiply.h"
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+// Cortex-A72 latencies (from the Cortex-A72 Software Optimization Guide, AArch32 instructions).
+
+/// add/sub/rsb of two registers, and shifts by an immediate.
+static constexpr unsigned kLatencyAlu        = 1;
+
+/// add/sub/rsb where the second register is shifted by an immediate.
+static constexpr unsigned kLatencyAluShifted = 2;
+
+/// mul (the movw/movt to get the multiplier into a register can normally be done
+/// in parallel, so isn't counted here).
+static constexpr unsigned kLatencyMul        = 3;
+
+/*********************************************************************************************************************/
+
+static unsigned GetLatency(const ARMv7::MultiplyStep& step)
+{
+	switch (step.Op) {
+	case ARMv7::MultiplyStep::Lsl:
+	case ARMv7::MultiplyStep::Neg:
+		return kLatencyAlu;
+
+	default:
+		return step.Shift == 0 ? kLatencyAlu : kLatencyAluShifted;
+	}
+}
+
+/*********************************************************************************************************************/
+
+static uint32_t ApplyStep(const ARMv7::MultiplyStep& step, uint32_t input, uint32_t previous)
+{
+	const uint32_t lhs = step.Lhs == ARMv7::MultiplyStep::Input ? input : previous;
+	const uint32_t rhs = (step.Rhs == ARMv7::MultiplyStep::Input ? input : previous) << step.Shift;
+
+	switch (step.Op) {
+	case ARMv7::MultiplyStep::Lsl: return lhs << step.Shift;
+	case ARMv7::MultiplyStep::Add: return lhs + rhs;
+	case ARMv7::MultiplyStep::Sub: return lhs - rhs;
+	case ARMv7::MultiplyStep::Rsb: return rhs - lhs;
+	case ARMv7::MultiplyStep::Neg: return 0u - lhs;
+	}
+
+	return 0;
+}
+
+/*********************************************************************************************************************/
+
+/// Every step that can be made from the input (and the result of the previous step, if
+/// there is one).
+static std::vector<ARMv7::MultiplyStep> GetCandidateSteps(bool hasPrevious)
+{
+	using Step = ARMv7::MultiplyStep;
+
+	std::vector<Step> steps;
+
+	const Step::Operand operands[] = { Step::Input, Step::Previous };
+	const size_t nOperands = hasPrevious ? 2 : 1;
+
+	for (size_t i = 0; i < nOperands; ++i) {
+		const Step::Operand lhs = operands[i];
+
+		steps.push_back({ Step::Neg, lhs, lhs, 0 });
+
+		for (unsigned shift = 1; shift < 32; ++shift) {
+			steps.push_back({ Step::Lsl, lhs, lhs, shift });
+		}
+
+		for (size_t j = 0; j < nOperands; ++j) {
+			const Step::Operand rhs = operands[j];
+
+			for (unsigned shift = 0; shift < 32; ++shift) {
+				steps.push_back({ Step::Add, lhs, rhs, shift });
+				steps.push_back({ Step::Sub, lhs, rhs, shift });
+
+				// Without a shift this is the same as a `sub` the other way around.
+				if (shift > 0)
+					steps.push_back({ Step::Rsb, lhs, rhs, shift });
+			}
+		}
+	}
+
+	return steps;
+}
+
+/*********************************************************************************************************************/
+
+static bool UsesPrevious(const ARMv7::MultiplyStep& step)
+{
+	return step.Lhs == ARMv7::MultiplyStep::Previous
+		|| (step.Rhs == ARMv7::MultiplyStep::Previous && step.Op != ARMv7::MultiplyStep::Lsl && step.Op != ARMv7::MultiplyStep::Neg);
+}
+
+/*********************************************************************************************************************/
+
+bool ARMv7::FindMultiplySequence(uint32_t multiplier, MultiplySequence* sequence)
+{
+	// Multiplying by one doesn't need any instructions at all (& should have been
+	// removed long before now).
+	if (multiplier == 1)
+		return false;
+
+	static const std::vector<MultiplyStep> firstSteps  = GetCandidateSteps(false);
+	static const std::vector<MultiplyStep> secondSteps = GetCandidateSteps(true);
+
+	MultiplySequence best;
+	bool found = false;
+
+	auto consider = [&](std::vector<MultiplyStep> steps, unsigned latency) {
+		if (found && (latency > best.Latency || (latency == best.Latency && steps.size() >= best.Steps.size())))
+			return;
+
+		best.Steps   = std::move(steps);
+		best.Latency = latency;
+		found        = true;
+	};
+
+	// Multiplication distributes over addition, so the multiplier that a sequence
+	// gives is the value it gives for an input of 1.
+	for (const MultiplyStep& first : firstSteps) {
+		const unsigned firstLatency = GetLatency(first);
+		const uint32_t firstValue   = ApplyStep(first, 1, 0);
+
+		if (firstValue == multiplier)
+			consider({ first }, firstLatency);
+
+		for (const MultiplyStep& second : secondSteps) {
+			const unsigned latency = firstLatency + GetLatency(second);
+
+			if (latency > kLatencyMul || !UsesPrevious(second))
+				continue;
+
+			if (ApplyStep(second, 1, firstValue) == multiplier)
+				consider({ first, second }, latency);
+		}
+	}
+
+	if (!found)
+		return false;
+
+	*sequence = std::move(best);
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+uint32_t ARMv7::EvaluateMultiplySequence(const MultiplySequence& sequence, uint32_t x)
+{
+	uint32_t previous = 0;
+
+	for (const MultiplyStep& step : sequence.Steps) {
+		previous = ApplyStep(step, x, previous);
+	}
+
+	return previous;
+}
+
+/*********************************************************************************************************************/
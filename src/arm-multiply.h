@@ -0,0 +1,66 @@
+/**
+ * @file arm-multiply.h
+ * @author Barney Wilks
+ *
+ * Multiplication by a constant without a `mul`.
+ *
+ * ARM can shift the second register operand of `add`, `sub` & `rsb` for free
+ * (well, for one more cycle of latency), so most small multipliers (& plenty
+ * of large ones) can be done in one or two instructions - x * 5 is
+ * `add r0, r1, r1, lsl #2` & x * 10 is that followed by `lsl r0, r0, #1`.
+ *
+ * The cheapest sequence (by Cortex-A72 latency) is found by searching every
+ * sequence of up to two instructions, and is only used if it is no slower than
+ * a `mul` (which would also need a movw/movt to get the constant into a
+ * register).
+ */
+
+#pragma once
+
+/* C++ Standard Library Includes */
+#include <cstdint>
+#include <vector>
+
+namespace Helix
+{
+	namespace ARMv7
+	{
+		struct MultiplyStep
+		{
+			enum Operation
+			{
+				Lsl, ///< dst = lhs << shift
+				Add, ///< dst = lhs + (rhs << shift)
+				Sub, ///< dst = lhs - (rhs << shift)
+				Rsb, ///< dst = (rhs << shift) - lhs
+				Neg  ///< dst = 0 - lhs
+			};
+
+			enum Operand
+			{
+				Input,   ///< The value being multiplied
+				Previous ///< The result of the previous step
+			};
+
+			Operation Op;
+			Operand   Lhs;
+			Operand   Rhs;
+			unsigned  Shift;
+		};
+
+		struct MultiplySequence
+		{
+			std::vector<MultiplyStep> Steps;
+
+			/// Cycles from the input being ready to the result being ready.
+			unsigned Latency = 0;
+		};
+
+		/// Find the cheapest sequence of shifts, adds & subtracts that multiplies a 32 bit
+		/// value by 'multiplier'. Returns false if a `mul` would be just as fast.
+		bool FindMultiplySequence(uint32_t multiplier, MultiplySequence* sequence);
+
+		/// Work out the value that 'sequence' gives for an input of 'x'.
+		uint32_t EvaluateMultiplySequence(const MultiplySequence& sequence, uint32_t x);
+	}
+}
@@ -1,5 +1,6 @@
 #include "arm-split-constants.h"
 #include "arm-md.h" /* generated */
+#include "arm-multiply.h"
 #include "function.h"
 #include "ir-helpers.h"
 #include "mir.h"
@@ -74,6 +75,51 @@ static VirtualRegisterName* GetIntegerIntoRegister_8(Instruction* user, Constant
 
 /*********************************************************************************************************************/
 
+/// Return true if the operand is a constant amount to shift a 32 bit register by, that
+/// can be encoded in the shift instruction itself.
+static bool IsShiftAmountImmediate(const Instruction& insn, size_t opIndex)
+{
+	switch (insn.GetOpcode()) {
+	case HLIR::Shl:
+	case HLIR::Shr:
+	case HLIR::AShr:
+		break;
+
+	default:
+		return false;
+	}
+
+	const ConstantInt* amount = value_cast<ConstantInt>(insn.GetOperand(opIndex));
+
+	if (opIndex != 1 || !amount || amount->GetType() != BuiltinTypes::GetInt32()
+		|| insn.GetOperand(0)->GetType() != BuiltinTypes::GetInt32())
+		return false;
+
+	// `lsr` & `asr` can't encode a shift by 0 (that encoding means a shift by 32), so
+	// those are done with the amount in a register.
+	const Integer minimum = insn.GetOpcode() == HLIR::Shl ? 0 : 1;
+
+	return amount->GetIntegralValue() >= minimum && amount->GetIntegralValue() < 32;
+}
+
+/*********************************************************************************************************************/
+
+/// Return true if the operand is a constant that a 32 bit register is multiplied by, that
+/// is cheaper to do with shifts & adds than getting it into a register for a `mul`.
+static bool IsCheapMultiplier(const Instruction& insn, size_t opIndex)
+{
+	if (insn.GetOpcode() != HLIR::IMul || opIndex != 1 || insn.GetOperand(0)->GetType() != BuiltinTypes::GetInt32())
+		return false;
+
+	const ConstantInt* multiplier = value_cast<ConstantInt>(insn.GetOperand(opIndex));
+
+	ARMv7::MultiplySequence sequence;
+	return multiplier && multiplier->GetType() == BuiltinTypes::GetInt32()
+		&& ARMv7::FindMultiplySequence((uint32_t) multiplier->GetIntegralValue(), &sequence);
+}
+
+/*********************************************************************************************************************/
+
 void ArmSplitConstants::Execute(Function* fn, const PassRunInformation&)
 {
 	struct IntegerReference
@@ -88,6 +134,9 @@ void ArmSplitConstants::Execute(Function* fn, const PassRunInformation&)
 	for (BasicBlock& bb : fn->blocks()) {
 		for (Instruction& insn : bb) {
 			for (size_t opIndex = 0; opIndex < insn.GetCountOperands(); ++opIndex) {
+				if (IsShiftAmountImmediate(insn, opIndex) || IsCheapMultiplier(insn, opIndex))
+					continue;
+
 				if (ConstantInt* integerValue = value_cast<ConstantInt>(insn.GetOperand(opIndex))) {
 					constantIntegers.push_back({ &insn, integerValue, Use(&insn, (uint16_t) opIndex)});
 				}
@@ -1,4 +1,5 @@
 #include "mir.h"
+#include "arm-multiply.h"
 #include "system.h"
 #include "basic-block.h"
 #include "ir-helpers.h"
@@ -338,6 +339,77 @@ MachineInstruction* ARMv7::expand_store(Instruction* insn)
 
 /*********************************************************************************************************************/
 
+MachineInstruction* ARMv7::expand_mulh(Instruction* insn)
+{
+	helix_assert(insn->GetOpcode() == HLIR::IMulHS || insn->GetOpcode() == HLIR::IMulHU, "instruction is not a mulh");
+	BinOpInsn* mulh = (BinOpInsn*) insn;
+
+	// smull/umull write the bottom half of the product as well, which isn't needed but
+	// has to go somewhere (and can't be the same register as the top half).
+	VirtualRegisterName* bottomHalf = VirtualRegisterName::Create(BuiltinTypes::GetInt32());
+
+	if (insn->GetOpcode() == HLIR::IMulHS)
+		return ARMv7::CreateSmull(bottomHalf, mulh->GetResult(), mulh->GetLHS(), mulh->GetRHS());
+
+	return ARMv7::CreateUmull(bottomHalf, mulh->GetResult(), mulh->GetLHS(), mulh->GetRHS());
+}
+
+/*********************************************************************************************************************/
+
+MachineInstruction* ARMv7::expand_mul_constant(Instruction* insn)
+{
+	helix_assert(insn->GetOpcode() == HLIR::IMul, "instruction is not a mul");
+	BinOpInsn* mul = (BinOpInsn*) insn;
+
+	ConstantInt* multiplier = value_cast<ConstantInt>(mul->GetRHS());
+	helix_assert(multiplier, "multiplier is not a constant");
+
+	MultiplySequence sequence;
+
+	if (!ARMv7::FindMultiplySequence((uint32_t) multiplier->GetIntegralValue(), &sequence))
+		helix_unreachable("no cheaper sequence for multiplication by constant (ArmSplitConstants should have split it)");
+
+	Value* input    = mul->GetLHS();
+	Value* previous = nullptr;
+
+	MachineInstruction* last = nullptr;
+
+	for (size_t i = 0; i < sequence.Steps.size(); ++i) {
+		const MultiplyStep& step = sequence.Steps[i];
+
+		// Only the last step writes to the result, everything before that is temporary.
+		Value* dst = (i == sequence.Steps.size() - 1) ? mul->GetResult() : VirtualRegisterName::Create(BuiltinTypes::GetInt32());
+		Value* lhs = step.Lhs == MultiplyStep::Input ? input : previous;
+		Value* rhs = step.Rhs == MultiplyStep::Input ? input : previous;
+
+		ConstantInt* shift = ConstantInt::Create(BuiltinTypes::GetInt32(), step.Shift);
+
+		switch (step.Op) {
+		case MultiplyStep::Lsl: last = ARMv7::CreateLsl_r32i32(lhs, shift, dst); break;
+		case MultiplyStep::Neg: last = ARMv7::CreateRsbi(dst, lhs, ConstantInt::Create(BuiltinTypes::GetInt32(), 0)); break;
+		case MultiplyStep::Rsb: last = ARMv7::CreateRsb_lsl(dst, lhs, rhs, shift); break;
+
+		case MultiplyStep::Add:
+			last = step.Shift == 0 ? ARMv7::CreateAdd_r32r32(lhs, rhs, dst) : ARMv7::CreateAdd_lsl(dst, lhs, rhs, shift);
+			break;
+
+		case MultiplyStep::Sub:
+			last = step.Shift == 0 ? ARMv7::CreateSub_r32r32(lhs, rhs, dst) : ARMv7::CreateSub_lsl(dst, lhs, rhs, shift);
+			break;
+		}
+
+		// The last instruction replaces the `imul` itself.
+		if (i != sequence.Steps.size() - 1)
+			IR::InsertBefore(insn, last);
+
+		previous = dst;
+	}
+
+	return last;
+}
+
+/*********************************************************************************************************************/
+
 MachineInstruction* ARMv7::expand_void_call(Instruction* insn)
 {
 	helix_assert(insn->GetOpcode() == HLIR::Call, "instruction is not a call");
@@ -30,6 +30,7 @@
 #pragma warning(push, 0) 
 
 #include <clang/AST/ASTConsumer.h>
+#include <clang/AST/Attr.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Frontend/FrontendActions.h>
 #include <clang/Tooling/Tooling.h>
@@ -292,6 +293,8 @@ Helix::Value* CodeGenerator::DoLocalStringLiteralExpr(clang::StringLiteral* stri
 	s_StringIndex++;
 
 	Helix::GlobalVariable* gvar = Helix::GlobalVariable::Create(name, ca->GetType(), ca);
+	gvar->SetLinkage(Helix::Linkage::Internal);
+
 	m_Module->RegisterGlobalVariable(gvar);
 	return gvar;
 }
@@ -367,6 +370,9 @@ void CodeGenerator::DoGlobalVariable(clang::VarDecl* varDecl)
 
 	helix_assert(m_GlobalVars.find(varDecl) == m_GlobalVars.end(), "global VarDecl is not unique");
 
+	if (!varDecl->isExternallyVisible())
+		gvar->SetLinkage(Linkage::Internal);
+
 	m_GlobalVars.insert({ varDecl, gvar });
 	m_Module->RegisterGlobalVariable(gvar);
 }
@@ -1639,6 +1645,16 @@ void CodeGenerator::DoFunctionDecl(clang::FunctionDecl* functionDecl)
 
 		m_CurrentFunction = Function::Create(functionType, functionDecl->getNameAsString(), parameterValues);
 
+		// Let the optimiser know which pointer parameters can't alias anything
+		// else (C99 6.7.3.1)
+		for (unsigned i = 0; i < functionDecl->getNumParams(); ++i) {
+			if (functionDecl->getParamDecl(i)->getType().isRestrictQualified())
+				m_CurrentFunction->SetNoAliasParameter(i);
+		}
+
+		if (!functionDecl->isExternallyVisible())
+			m_CurrentFunction->SetLinkage(Linkage::Internal);
+
 		m_FunctionDecls.insert({
 			functionDecl,
 			m_CurrentFunction
@@ -1649,6 +1665,24 @@ void CodeGenerator::DoFunctionDecl(clang::FunctionDecl* functionDecl)
 		m_Module->RegisterFunction(m_CurrentFunction);
 	}
 
+	// Attributes are inherited by later redeclarations, so whichever declaration
+	// comes last knows about all of them.
+	if (functionDecl->hasAttr<clang::NoInlineAttr>())
+		m_CurrentFunction->SetInlineHint(InlineHint::NoInline);
+	else if (functionDecl->hasAttr<clang::AlwaysInlineAttr>())
+		m_CurrentFunction->SetInlineHint(InlineHint::AlwaysInline);
+	else if (functionDecl->isInlineSpecified())
+		m_CurrentFunction->SetInlineHint(InlineHint::Inline);
+
+	// Both promise that the function returns, as well as what it does to memory.
+	if (functionDecl->hasAttr<clang::ConstAttr>()) {
+		m_CurrentFunction->SetMemoryEffects(MemoryEffects::ReadNone);
+		m_CurrentFunction->SetAlwaysReturns(true);
+	} else if (functionDecl->hasAttr<clang::PureAttr>()) {
+		m_CurrentFunction->SetMemoryEffects(MemoryEffects::ReadOnly);
+		m_CurrentFunction->SetAlwaysReturns(true);
+	}
+
 	if (!functionDecl->doesThisDeclarationHaveABody()) {
 		m_BasicBlockIterator.invalidate();
 		m_InstructionIterator.invalidate();
@@ -0,0 +1,231 @@
+/**
+ * @file call-graph.cpp
+ * @author Barney Wilks
+ *
+ * Implements call-graph.h
+ */
+
+/* Internal Project Includes */
+#include "call-graph.h"
+#include "module.h"
+#include "instructions.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <unordered_set>
+
+using namespace Helix;
+
+/******************************************************************************/
+
+template <typename T>
+static void
+AddUnique(std::vector<T>& values, T value)
+{
+	if (std::find(values.begin(), values.end(), value) == values.end())
+		values.push_back(value);
+}
+
+/******************************************************************************/
+
+/// Bookkeeping for Tarjan's algorithm while finding the SCCs.
+struct CallGraph::SCCState
+{
+	std::unordered_map<Function*, size_t> Index;
+	std::unordered_map<Function*, size_t> LowLink;
+	std::unordered_set<Function*>         OnStack;
+	std::vector<Function*>                Stack;
+};
+
+/******************************************************************************/
+
+CallGraph::CallGraph(Module* mod)
+{
+	HELIX_PROFILE_ZONE;
+
+	for (Function* fn : mod->functions()) {
+		this->AddFunction(fn);
+	}
+
+	for (GlobalVariable* gvar : mod->globals()) {
+		// Make sure that every global has a (possibly empty) list of references
+		m_InitialiserReferences[gvar];
+
+		if (gvar->HasInit())
+			this->AddInitialiserReferences(gvar, gvar->GetInit());
+	}
+
+	SCCState state;
+
+	for (Function* fn : mod->functions()) {
+		if (!state.Index.count(fn))
+			this->VisitSCC(fn, state);
+	}
+}
+
+/******************************************************************************/
+
+void
+CallGraph::VisitSCC(Function* fn, SCCState& state)
+{
+	const size_t index = state.Index.size();
+
+	state.Index[fn]   = index;
+	state.LowLink[fn] = index;
+	state.Stack.push_back(fn);
+	state.OnStack.insert(fn);
+
+	bool callsItself = false;
+
+	for (Function* callee : this->GetNode(fn)->GetCallees()) {
+		if (callee == fn)
+			callsItself = true;
+
+		if (!state.Index.count(callee)) {
+			this->VisitSCC(callee, state);
+			state.LowLink[fn] = std::min(state.LowLink[fn], state.LowLink[callee]);
+		}
+		else if (state.OnStack.count(callee)) {
+			state.LowLink[fn] = std::min(state.LowLink[fn], state.Index[callee]);
+		}
+	}
+
+	if (state.LowLink[fn] != index)
+		return;
+
+	// 'fn' is the first function visited in its component, so everything above
+	// it on the stack is in the same component. Components are finished after
+	// every component that they call into, which makes this order bottom up.
+	std::vector<Function*> scc;
+	Function* member = nullptr;
+
+	do {
+		member = state.Stack.back();
+		state.Stack.pop_back();
+		state.OnStack.erase(member);
+
+		scc.push_back(member);
+	} while (member != fn);
+
+	for (Function* sccMember : scc) {
+		m_Recursive[sccMember] = scc.size() > 1 || callsItself;
+	}
+
+	m_SCCs.push_back(std::move(scc));
+}
+
+/******************************************************************************/
+
+CallGraphNode*
+CallGraph::GetOrCreateNode(Function* fn)
+{
+	std::unique_ptr<CallGraphNode>& node = m_Nodes[fn];
+
+	if (!node)
+		node = std::make_unique<CallGraphNode>(fn);
+
+	return node.get();
+}
+
+/******************************************************************************/
+
+void
+CallGraph::AddFunction(Function* fn)
+{
+	CallGraphNode* node = this->GetOrCreateNode(fn);
+
+	for (BasicBlock& bb : fn->blocks()) {
+		for (Instruction& insn : bb) {
+			for (size_t i = 0; i < insn.GetCountOperands(); ++i) {
+				Value* operand = insn.GetOperand(i);
+
+				if (Function* referenced = value_cast<Function>(operand)) {
+					CallGraphNode* referencedNode = this->GetOrCreateNode(referenced);
+
+					// Anything other than the function being called (e.g. passing a
+					// function as an argument) is taking the function's address.
+					const bool isDirectCall = insn.GetOpcode() == HLIR::Call && i == 1;
+
+					if (isDirectCall) {
+						AddUnique(node->m_Callees, referenced);
+						AddUnique(referencedNode->m_Callers, fn);
+
+						referencedNode->m_CallSites.push_back(static_cast<CallInsn*>(&insn));
+					} else {
+						AddUnique(node->m_References, operand);
+						referencedNode->m_CountAddressTaken++;
+					}
+				}
+				else if (GlobalVariable* gvar = value_cast<GlobalVariable>(operand)) {
+					AddUnique(node->m_References, operand);
+					m_GlobalReferenceCounts[gvar]++;
+				}
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+
+void
+CallGraph::AddInitialiserReferences(GlobalVariable* gvar, Value* init)
+{
+	if (ConstantArray* array = value_cast<ConstantArray>(init)) {
+		for (Value* value : *array) {
+			this->AddInitialiserReferences(gvar, value);
+		}
+	}
+	else if (ConstantStruct* structure = value_cast<ConstantStruct>(init)) {
+		for (Value* value : *structure) {
+			this->AddInitialiserReferences(gvar, value);
+		}
+	}
+	else if (Function* fn = value_cast<Function>(init)) {
+		AddUnique(m_InitialiserReferences[gvar], init);
+		this->GetOrCreateNode(fn)->m_CountAddressTaken++;
+	}
+	else if (GlobalVariable* referenced = value_cast<GlobalVariable>(init)) {
+		AddUnique(m_InitialiserReferences[gvar], init);
+		m_GlobalReferenceCounts[referenced]++;
+	}
+}
+
+/******************************************************************************/
+
+CallGraphNode*
+CallGraph::GetNode(Function* fn) const
+{
+	auto it = m_Nodes.find(fn);
+	return it != m_Nodes.end() ? it->second.get() : nullptr;
+}
+
+/******************************************************************************/
+
+const std::vector<Value*>&
+CallGraph::GetInitialiserReferences(GlobalVariable* gvar) const
+{
+	static const std::vector<Value*> s_NoReferences;
+
+	auto it = m_InitialiserReferences.find(gvar);
+	return it != m_InitialiserReferences.end() ? it->second : s_NoReferences;
+}
+
+/******************************************************************************/
+
+size_t
+CallGraph::GetCountReferences(GlobalVariable* gvar) const
+{
+	auto it = m_GlobalReferenceCounts.find(gvar);
+	return it != m_GlobalReferenceCounts.end() ? it->second : 0;
+}
+
+/******************************************************************************/
+
+bool
+CallGraph::IsRecursive(Function* fn) const
+{
+	auto it = m_Recursive.find(fn);
+	return it != m_Recursive.end() && it->second;
+}
+
+/******************************************************************************/
@@ -0,0 +1,127 @@
+/**
+ * @file call-graph.h
+ * @author Barney Wilks
+ *
+ * Call graph of a module.
+ *
+ * For every function in a module this records the functions that it calls
+ * directly, the functions that call it directly (and the call instructions
+ * that do so) and every other reference to it - taking its address in an
+ * instruction or in the initialiser of a global variable. Global variables
+ * referenced by each function & initialiser are recorded as well, so that
+ * everything reachable from a function (or global) can be found.
+ *
+ * The strongly connected components of the graph (functions that can end up
+ * calling each other) are found with Tarjan's algorithm, which gives them
+ * bottom up, callees before callers - the order that interprocedural passes
+ * want to visit functions in.
+ *
+ * The graph is a snapshot of the module when it was built, it isn't updated
+ * as the module changes.
+ */
+
+#pragma once
+
+/* Internal Project Includes */
+#include "system.h"
+
+/* C++ Standard Library Includes */
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Helix
+{
+	class Module;
+	class Function;
+	class GlobalVariable;
+	class CallInsn;
+	class Value;
+
+	class CallGraphNode
+	{
+	public:
+		CallGraphNode(Function* fn)
+			: m_Function(fn) { }
+
+		Function* GetFunction() const { return m_Function; }
+
+		/// Functions that this function calls directly (each only listed once)
+		const std::vector<Function*>& GetCallees() const { return m_Callees; }
+
+		/// Functions that call this function directly (each only listed once)
+		const std::vector<Function*>& GetCallers() const { return m_Callers; }
+
+		/// Every call instruction (in the module) that calls this function.
+		const std::vector<CallInsn*>& GetCallSites() const { return m_CallSites; }
+
+		/// Functions & global variables that this function references, other
+		/// than the functions it calls directly.
+		const std::vector<Value*>& GetReferences() const { return m_References; }
+
+		/// Number of places that take the address of this function (any
+		/// reference that isn't a direct call, including global initialisers)
+		size_t GetCountAddressTaken() const { return m_CountAddressTaken; }
+
+		bool IsAddressTaken() const { return m_CountAddressTaken > 0; }
+
+		/// Total number of references to this function, calls & otherwise.
+		size_t GetCountReferences() const { return m_CallSites.size() + m_CountAddressTaken; }
+
+	private:
+		friend class CallGraph;
+
+		Function*              m_Function;
+		std::vector<Function*> m_Callees;
+		std::vector<Function*> m_Callers;
+		std::vector<CallInsn*> m_CallSites;
+		std::vector<Value*>    m_References;
+		size_t                 m_CountAddressTaken = 0;
+	};
+
+	class CallGraph
+	{
+	public:
+		CallGraph(Module* mod);
+
+		HELIX_NO_STEAL(CallGraph);
+
+		/// Get the node for the given function, or null if the function isn't
+		/// in (or referenced by) the module.
+		CallGraphNode* GetNode(Function* fn) const;
+
+		/// Functions & global variables referenced by the initialiser of the
+		/// given global variable.
+		const std::vector<Value*>& GetInitialiserReferences(GlobalVariable* gvar) const;
+
+		/// Number of references to the given global variable, from both
+		/// instructions & the initialisers of other global variables.
+		size_t GetCountReferences(GlobalVariable* gvar) const;
+
+		/// Get the strongly connected components of the graph bottom up, so that
+		/// every function comes after the functions it calls (other than those
+		/// in the same component, which call each other).
+		const std::vector<std::vector<Function*>>& GetSCCs() const { return m_SCCs; }
+
+		/// Return true if 'fn' can end up calling itself, either directly or
+		/// through other functions.
+		bool IsRecursive(Function* fn) const;
+
+	private:
+		void AddFunction(Function* fn);
+		void AddInitialiserReferences(GlobalVariable* gvar, Value* init);
+
+		CallGraphNode* GetOrCreateNode(Function* fn);
+
+		struct SCCState;
+		void VisitSCC(Function* fn, SCCState& state);
+
+	private:
+		std::unordered_map<const Function*, std::unique_ptr<CallGraphNode>> m_Nodes;
+		std::unordered_map<const GlobalVariable*, std::vector<Value*>>      m_InitialiserReferences;
+		std::unordered_map<const GlobalVariable*, size_t>                   m_GlobalReferenceCounts;
+
+		std::vector<std::vector<Function*>>                                 m_SCCs;
+		std::unordered_map<const Function*, bool>                           m_Recursive;
+	};
+}
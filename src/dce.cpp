@@ -4,40 +4,246 @@
  */
 
 #include "dce.h"
+#include "dominators.h"
 #include "function.h"
 #include "ir-helpers.h"
+#include "loop-info.h"
+
+/* C++ Standard Library Includes */
+#include <unordered_set>
+#include <vector>
 
 using namespace Helix;
 
-static bool CanBeTriviallyDead(const Instruction& insn)
+/*********************************************************************************************************************/
+
+/// Return true if the instruction has to stay whether or not anything uses it.
+static bool IsAlwaysLive(const Instruction& insn)
 {
-	if (HLIR::IsBranch((HLIR::Opcode) insn.GetOpcode()))
+	switch (insn.GetOpcode()) {
+	case HLIR::Store:
+	case HLIR::Return:
+		return true;
+
+	// Calls are only dead if they can't do anything other than compute their result.
+	case HLIR::Call:
+		return !IR::IsRemovableCall(&insn);
+
+	default:
 		return false;
+	}
+}
+
+/*********************************************************************************************************************/
+
+class DeadCodeEliminator
+{
+public:
+	DeadCodeEliminator(Function* fn, const DominatorTree& domTree, const PostDominatorTree& postDomTree)
+		: m_Function(fn), m_DomTree(domTree), m_PostDomTree(postDomTree) { }
+
+	/// Find everything that is live, starting from the instructions that are always
+	/// live & the loops that might never finish.
+	void MarkLive(LoopInfo& loopInfo);
+
+	/// Delete everything that wasn't marked live, returning true if anything changed.
+	bool Sweep();
+
+private:
+	void MarkInstructionLive(Instruction* insn);
+	void MarkBlockLive(BasicBlock* bb);
+
+	/// Mark everything that the instructions on the worklist need.
+	void Propagate();
+
+private:
+	Function*                         m_Function;
+	const DominatorTree&              m_DomTree;
+	const PostDominatorTree&          m_PostDomTree;
+
+	std::unordered_set<Instruction*>  m_LiveInstructions;
+	std::unordered_set<BasicBlock*>   m_LiveBlocks;
+	std::vector<Instruction*>         m_Worklist;
+};
+
+/*********************************************************************************************************************/
+
+void DeadCodeEliminator::MarkInstructionLive(Instruction* insn)
+{
+	if (m_LiveInstructions.insert(insn).second)
+		m_Worklist.push_back(insn);
+}
+
+/*********************************************************************************************************************/
 
-	return true;
+void DeadCodeEliminator::MarkBlockLive(BasicBlock* bb)
+{
+	if (!m_LiveBlocks.insert(bb).second)
+		return;
+
+	// Whether the block runs at all is decided by the branches that it is control
+	// dependent on (the post dominance frontier), so they are needed too.
+	for (BasicBlock* frontier : m_PostDomTree.GetDominanceFrontier(bb)) {
+		this->MarkInstructionLive(frontier->GetLast());
+	}
 }
 
-void DCE::Execute(Function* fn, const PassRunInformation&)
+/*********************************************************************************************************************/
+
+void DeadCodeEliminator::MarkLive(LoopInfo& loopInfo)
 {
-	std::vector<Instruction*> KillList;
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (!m_DomTree.IsReachable(&bb))
+			continue;
 
-	for (BasicBlock& bb : fn->blocks()) {
 		for (Instruction& insn : bb) {
-			if (!CanBeTriviallyDead(insn))
+			if (IsAlwaysLive(insn))
+				this->MarkInstructionLive(&insn);
+		}
+
+		// A block standing in as the exit of an infinite loop is immediately post dominated
+		// by the virtual exit, so there is nowhere for a dead branch out of it to go instead.
+		if (bb.GetLast()->GetOpcode() == HLIR::ConditionalBranch && !m_PostDomTree.GetImmediateDominator(&bb))
+			this->MarkInstructionLive(bb.GetLast());
+	}
+
+	// A loop that might not finish can't be deleted (even if nothing in it is used),
+	// since the program would then carry on when it shouldn't.
+	for (Loop* loop : loopInfo.GetLoopsInnermostFirst()) {
+		if (loop->HasConstantTripCount())
+			continue;
+
+		for (BasicBlock* exiting : loop->GetExitingBlocks()) {
+			this->MarkInstructionLive(exiting->GetLast());
+		}
+	}
+
+	for (;;) {
+		this->Propagate();
+
+		// A dead branch is replaced by a `br` to its immediate post dominator, which
+		// can't be done if that block has phis that are live (the phis wouldn't have
+		// a value for the new way in). This normally can't happen, but in loops the
+		// phi isn't always control dependent on the branch.
+		bool changed = false;
+
+		for (BasicBlock& bb : m_Function->blocks()) {
+			Instruction* branch = bb.GetLast();
+
+			if (!m_DomTree.IsReachable(&bb) || branch->GetOpcode() != HLIR::ConditionalBranch || m_LiveInstructions.count(branch))
 				continue;
 
-			for (size_t op_index = 0; op_index < insn.GetCountOperands(); ++op_index) {
-				Value* op = insn.GetOperand(op_index);
+			BasicBlock* target = m_PostDomTree.GetImmediateDominator(&bb);
 
-				if (insn.OperandHasFlags(op_index, Instruction::OP_WRITE)) {
-					if (IR::GetCountReadUsers(op) == 0) {
-						KillList.push_back(&insn);
-					}
+			for (BasicBlock::iterator it = target->begin(); it != IR::GetFirstNonPhi(target); ++it) {
+				if (m_LiveInstructions.count(&*it)) {
+					this->MarkInstructionLive(branch);
+					changed = true;
+					break;
 				}
 			}
 		}
+
+		if (!changed)
+			break;
+	}
+}
+
+/*********************************************************************************************************************/
+
+void DeadCodeEliminator::Propagate()
+{
+	while (!m_Worklist.empty()) {
+		Instruction* insn = m_Worklist.back();
+		m_Worklist.pop_back();
+
+		this->MarkBlockLive(insn->GetParent());
+
+		for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+			Value* value = insn->GetOperand(i);
+
+			if (!insn->OperandHasFlags(i, Instruction::OP_READ) || !value_isa<VirtualRegisterName>(value))
+				continue;
+
+			for (const Use& use : value->uses()) {
+				Instruction* def = use.GetInstruction();
+
+				if (def->OperandHasFlags(use.GetOperandIndex(), Instruction::OP_WRITE))
+					this->MarkInstructionLive(def);
+			}
+		}
+
+		if (insn->GetOpcode() != HLIR::Phi)
+			continue;
+
+		// Which value the phi has depends on the way into its block, so each block it
+		// comes from (& the branch that goes that way) is needed.
+		PhiInsn* phi = static_cast<PhiInsn*>(insn);
+
+		for (size_t i = 0; i < phi->GetCountIncoming(); ++i) {
+			BasicBlock* pred = phi->GetIncomingBlock(i);
+
+			this->MarkBlockLive(pred);
+			this->MarkInstructionLive(pred->GetLast());
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+bool DeadCodeEliminator::Sweep()
+{
+	std::vector<Instruction*> deadInstructions;
+	std::vector<BasicBlock*>  deadBranches;
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (!m_DomTree.IsReachable(&bb))
+			continue;
+
+		for (Instruction& insn : bb) {
+			if (m_LiveInstructions.count(&insn))
+				continue;
+
+			if (insn.GetOpcode() == HLIR::ConditionalBranch)
+				deadBranches.push_back(&bb);
+			else if (!insn.IsTerminator())
+				deadInstructions.push_back(&insn);
+		}
 	}
 
-	for (Instruction* insn : KillList)
+	for (Instruction* insn : deadInstructions) {
 		insn->DeleteFromParent();
-}
\ No newline at end of file
+	}
+
+	// Nothing that is live depends on which way a dead branch goes, so it can go
+	// straight to where both ways meet up again (skipping whatever is in between,
+	// which is all dead too).
+	for (BasicBlock* bb : deadBranches) {
+		BasicBlock* target = m_PostDomTree.GetImmediateDominator(bb);
+
+		for (BasicBlock* succ : bb->GetSuccessors()) {
+			IR::RemoveIncomingFrom(succ, bb);
+		}
+
+		IR::ReplaceInstructionAndDestroyOriginal(bb->GetLast(), Helix::CreateUnconditionalBranch(target));
+	}
+
+	const bool removedBlocks = IR::RemoveUnreachableBlocks(m_Function);
+	return removedBlocks || !deadInstructions.empty() || !deadBranches.empty();
+}
+
+/*********************************************************************************************************************/
+
+void DCE::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	DeadCodeEliminator eliminator(fn, info.Analyses->Get<DominatorTree>(fn), info.Analyses->Get<PostDominatorTree>(fn));
+	eliminator.MarkLive(info.Analyses->Get<LoopInfo>(fn));
+
+	if (eliminator.Sweep())
+		info.Analyses->Invalidate(fn);
+}
+
+/*********************************************************************************************************************/
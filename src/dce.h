@@ -1,6 +1,24 @@
 /**
  * @file dce.h
  * @author Barney Wilks
+ *
+ * Aggressive dead code elimination.
+ *
+ * Rather than deleting instructions whose results aren't used (which takes
+ * one run for each link in a chain of dead instructions), everything is
+ * assumed to be dead until it is shown to be needed. Stores, returns & calls
+ * with side effects are always live, and anything that a live instruction
+ * reads is live too. A live instruction also needs the branches that decide
+ * whether its block runs at all (those it's control dependent on, from the
+ * post dominance frontier), & a live phi the branches that decide which way
+ * its block is entered.
+ *
+ * Everything else is deleted in one go. A dead branch is replaced by a `br`
+ * to its immediate post dominator, skipping the blocks in between, which are
+ * then deleted along with any other blocks that can't be reached.
+ *
+ * Loops without a constant trip count are kept even if nothing in them is
+ * used, since they might never finish.
  */
 
 #pragma once
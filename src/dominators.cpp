@@ -0,0 +1,567 @@
+/**
+ * @file dominators.cpp
+ * @author Barney Wilks
+ *
+ * Implements dominators.h
+ */
+
+#if defined(_MSC_VER)
+	#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+/* Internal Project Includes */
+#include "dominators.h"
+#include "function.h"
+#include "module.h"
+#include "print.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+
+/* C Standard Library Includes */
+#include <stdio.h>
+
+using namespace Helix;
+
+/******************************************************************************/
+
+template <typename T>
+static void
+PushUnique(std::vector<T>& list, const T& value)
+{
+	if (std::find(list.begin(), list.end(), value) == list.end())
+		list.push_back(value);
+}
+
+/******************************************************************************/
+
+DominatorTree::DominatorTree(Function* fn, Kind kind)
+	: m_Function(fn), m_Kind(kind)
+{
+	HELIX_PROFILE_ZONE;
+
+	helix_assert(fn->HasBody(), "can't build a dominator tree for a function without a body");
+
+	this->BuildGraph();
+	this->ComputeReversePostOrder();
+	this->ComputeImmediateDominators();
+	this->ComputeTree();
+	this->ComputeDominanceFrontiers();
+}
+
+/******************************************************************************/
+
+size_t
+DominatorTree::GetIndex(const BasicBlock* bb) const
+{
+	if (!bb) {
+		helix_assert(IsPostDominatorTree(), "only the post dominator tree has a (null) virtual exit node");
+		return m_Root;
+	}
+
+	auto it = m_Indices.find(bb);
+	helix_assert(it != m_Indices.end(), "block is not part of the dominator tree");
+
+	return it->second;
+}
+
+/******************************************************************************/
+
+void
+DominatorTree::BuildGraph()
+{
+	const size_t countBlocks = m_Function->GetCountBlocks();
+
+	m_Nodes.resize(IsPostDominatorTree() ? countBlocks + 1 : countBlocks);
+	m_Indices.reserve(countBlocks);
+
+	size_t index = 0;
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		m_Nodes[index].Block = &bb;
+		m_Indices[&bb] = index;
+
+		index++;
+	}
+
+	for (size_t i = 0; i < countBlocks; ++i) {
+		const std::vector<BasicBlock*> successors = m_Nodes[i].Block->GetSuccessors();
+
+		for (BasicBlock* succ : successors) {
+			const size_t j = GetIndex(succ);
+
+			// The post dominator tree is the dominator tree of the reverse CFG,
+			// so just flip the edges.
+			if (IsPostDominatorTree()) {
+				PushUnique(m_Nodes[j].Succs, i);
+				PushUnique(m_Nodes[i].Preds, j);
+			} else {
+				PushUnique(m_Nodes[i].Succs, j);
+				PushUnique(m_Nodes[j].Preds, i);
+			}
+		}
+	}
+
+	if (IsPostDominatorTree()) {
+		m_Root = countBlocks;
+
+		// Any block without successors (e.g. one ending in a 'ret') is an
+		// exit of the function, link them all to the virtual exit node.
+		for (size_t i = 0; i < countBlocks; ++i) {
+			if (m_Nodes[i].Preds.empty()) {
+				m_Nodes[m_Root].Succs.push_back(i);
+				m_Nodes[i].Preds.push_back(m_Root);
+			}
+		}
+
+		this->ConnectNonExitingBlocks();
+	} else {
+		m_Root = GetIndex(m_Function->GetHeadBlock());
+	}
+}
+
+/******************************************************************************/
+
+void
+DominatorTree::ConnectNonExitingBlocks()
+{
+	// Blocks that never reach an exit (e.g. an infinite loop) can't be reached
+	// from the virtual exit over the reverse CFG. Each region of them that has
+	// no way out gets a fake edge from the virtual exit, to the last block that
+	// a DFS over the reverse CFG finishes (which is always in such a region),
+	// until every block is reachable.
+	for (;;) {
+		std::vector<bool> visited(m_Nodes.size(), false);
+		std::vector<size_t> worklist { m_Root };
+
+		visited[m_Root] = true;
+
+		while (!worklist.empty()) {
+			const size_t node = worklist.back();
+			worklist.pop_back();
+
+			for (size_t succ : m_Nodes[node].Succs) {
+				if (!visited[succ]) {
+					visited[succ] = true;
+					worklist.push_back(succ);
+				}
+			}
+		}
+
+		size_t lastFinished = SIZE_MAX;
+
+		std::vector<std::pair<size_t, size_t>> stack;
+
+		for (size_t start = 0; start < m_Root; ++start) {
+			if (visited[start])
+				continue;
+
+			stack.push_back({ start, 0 });
+			visited[start] = true;
+
+			while (!stack.empty()) {
+				auto& [node, nextSucc] = stack.back();
+
+				if (nextSucc < m_Nodes[node].Succs.size()) {
+					const size_t succ = m_Nodes[node].Succs[nextSucc++];
+
+					if (!visited[succ]) {
+						visited[succ] = true;
+						stack.push_back({ succ, 0 });
+					}
+				} else {
+					lastFinished = node;
+					stack.pop_back();
+				}
+			}
+		}
+
+		if (lastFinished == SIZE_MAX)
+			break;
+
+		m_Nodes[m_Root].Succs.push_back(lastFinished);
+		m_Nodes[lastFinished].Preds.push_back(m_Root);
+	}
+}
+
+/******************************************************************************/
+
+void
+DominatorTree::ComputeReversePostOrder()
+{
+	std::vector<size_t> postOrder;
+	postOrder.reserve(m_Nodes.size());
+
+	std::vector<bool> visited(m_Nodes.size(), false);
+
+	// Iterative DFS, each entry is the node and the index of the
+	// next successor to visit.
+	std::vector<std::pair<size_t, size_t>> stack;
+
+	stack.push_back({ m_Root, 0 });
+	visited[m_Root] = true;
+
+	while (!stack.empty()) {
+		auto& [node, nextSucc] = stack.back();
+
+		if (nextSucc < m_Nodes[node].Succs.size()) {
+			const size_t succ = m_Nodes[node].Succs[nextSucc++];
+
+			if (!visited[succ]) {
+				visited[succ] = true;
+				stack.push_back({ succ, 0 });
+			}
+		} else {
+			m_Nodes[node].PostOrder = postOrder.size();
+			postOrder.push_back(node);
+
+			stack.pop_back();
+		}
+	}
+
+	m_ReversePostOrderIndices.assign(postOrder.rbegin(), postOrder.rend());
+
+	for (size_t index : m_ReversePostOrderIndices) {
+		if (m_Nodes[index].Block)
+			m_ReversePostOrder.push_back(m_Nodes[index].Block);
+	}
+}
+
+/******************************************************************************/
+
+size_t
+DominatorTree::Intersect(size_t a, size_t b) const
+{
+	while (a != b) {
+		while (m_Nodes[a].PostOrder < m_Nodes[b].PostOrder)
+			a = m_Nodes[a].IDom;
+
+		while (m_Nodes[b].PostOrder < m_Nodes[a].PostOrder)
+			b = m_Nodes[b].IDom;
+	}
+
+	return a;
+}
+
+/******************************************************************************/
+
+void
+DominatorTree::ComputeImmediateDominators()
+{
+	m_Nodes[m_Root].IDom = m_Root;
+
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+
+		for (size_t node : m_ReversePostOrderIndices) {
+			if (node == m_Root)
+				continue;
+
+			size_t newIDom = SIZE_MAX;
+
+			for (size_t pred : m_Nodes[node].Preds) {
+				// Only consider predecessors that have already been processed,
+				// anything unreachable will never be processed.
+				if (m_Nodes[pred].IDom == SIZE_MAX)
+					continue;
+
+				newIDom = (newIDom == SIZE_MAX) ? pred : Intersect(pred, newIDom);
+			}
+
+			if (newIDom != m_Nodes[node].IDom) {
+				m_Nodes[node].IDom = newIDom;
+				changed = true;
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+
+void
+DominatorTree::ComputeTree()
+{
+	for (size_t node : m_ReversePostOrderIndices) {
+		if (node == m_Root)
+			continue;
+
+		m_Nodes[m_Nodes[node].IDom].Children.push_back(m_Nodes[node].Block);
+	}
+
+	// Number each node on entry & exit of a DFS walk of the tree, then 'a'
+	// dominates 'b' iff b's range is nested within a's.
+	size_t counter = 0;
+
+	std::vector<std::pair<size_t, size_t>> stack;
+	stack.push_back({ m_Root, 0 });
+
+	m_Nodes[m_Root].DFSIn = counter++;
+	m_Nodes[m_Root].Level = 0;
+
+	while (!stack.empty()) {
+		auto& [node, nextChild] = stack.back();
+
+		if (nextChild < m_Nodes[node].Children.size()) {
+			const size_t child = GetIndex(m_Nodes[node].Children[nextChild++]);
+
+			m_Nodes[child].DFSIn = counter++;
+			m_Nodes[child].Level = m_Nodes[node].Level + 1;
+
+			stack.push_back({ child, 0 });
+		} else {
+			m_Nodes[node].DFSOut = counter++;
+			stack.pop_back();
+		}
+	}
+}
+
+/******************************************************************************/
+
+void
+DominatorTree::ComputeDominanceFrontiers()
+{
+	for (size_t node : m_ReversePostOrderIndices) {
+		const std::vector<size_t>& preds = m_Nodes[node].Preds;
+
+		if (preds.size() < 2)
+			continue;
+
+		for (size_t pred : preds) {
+			if (!IsReachable(pred))
+				continue;
+
+			size_t runner = pred;
+
+			while (runner != m_Nodes[node].IDom) {
+				PushUnique(m_Nodes[runner].Frontier, m_Nodes[node].Block);
+				runner = m_Nodes[runner].IDom;
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+
+BasicBlock*
+DominatorTree::GetRoot() const
+{
+	return m_Nodes[m_Root].Block;
+}
+
+/******************************************************************************/
+
+bool
+DominatorTree::IsReachable(const BasicBlock* bb) const
+{
+	return IsReachable(GetIndex(bb));
+}
+
+/******************************************************************************/
+
+BasicBlock*
+DominatorTree::GetImmediateDominator(const BasicBlock* bb) const
+{
+	const size_t index = GetIndex(bb);
+
+	if (index == m_Root || !IsReachable(index))
+		return nullptr;
+
+	return m_Nodes[m_Nodes[index].IDom].Block;
+}
+
+/******************************************************************************/
+
+bool
+DominatorTree::Dominates(const BasicBlock* a, const BasicBlock* b) const
+{
+	const Node& nodeA = m_Nodes[GetIndex(a)];
+	const Node& nodeB = m_Nodes[GetIndex(b)];
+
+	if (nodeA.PostOrder == SIZE_MAX || nodeB.PostOrder == SIZE_MAX)
+		return false;
+
+	return nodeA.DFSIn <= nodeB.DFSIn && nodeB.DFSOut <= nodeA.DFSOut;
+}
+
+/******************************************************************************/
+
+bool
+DominatorTree::StrictlyDominates(const BasicBlock* a, const BasicBlock* b) const
+{
+	return a != b && Dominates(a, b);
+}
+
+/******************************************************************************/
+
+bool
+DominatorTree::Dominates(const Instruction* a, const Instruction* b) const
+{
+	const BasicBlock* blockA = a->GetParent();
+	const BasicBlock* blockB = b->GetParent();
+
+	if (blockA != blockB)
+		return Dominates(blockA, blockB);
+
+	if (a == b)
+		return true;
+
+	// Same block, so whichever comes first dominates (or for post dominators,
+	// whichever comes last).
+	for (const Instruction& insn : *blockA) {
+		if (&insn == a)
+			return !IsPostDominatorTree();
+
+		if (&insn == b)
+			return IsPostDominatorTree();
+	}
+
+	helix_unreachable("instructions not found in their parent block");
+	return false;
+}
+
+/******************************************************************************/
+
+BasicBlock*
+DominatorTree::FindNearestCommonDominator(BasicBlock* a, BasicBlock* b) const
+{
+	const size_t indexA = GetIndex(a);
+	const size_t indexB = GetIndex(b);
+
+	if (!IsReachable(indexA) || !IsReachable(indexB))
+		return nullptr;
+
+	return m_Nodes[Intersect(indexA, indexB)].Block;
+}
+
+/******************************************************************************/
+
+const std::vector<BasicBlock*>&
+DominatorTree::GetChildren(const BasicBlock* bb) const
+{
+	return m_Nodes[GetIndex(bb)].Children;
+}
+
+/******************************************************************************/
+
+const std::vector<BasicBlock*>&
+DominatorTree::GetDominanceFrontier(const BasicBlock* bb) const
+{
+	return m_Nodes[GetIndex(bb)].Frontier;
+}
+
+/******************************************************************************/
+
+size_t
+DominatorTree::GetLevel(const BasicBlock* bb) const
+{
+	return m_Nodes[GetIndex(bb)].Level;
+}
+
+/******************************************************************************/
+
+std::vector<BasicBlock*>
+DominatorTree::GetPreOrder() const
+{
+	std::vector<BasicBlock*> blocks;
+	blocks.reserve(m_ReversePostOrder.size());
+
+	std::vector<size_t> stack = { m_Root };
+
+	while (!stack.empty()) {
+		const size_t node = stack.back();
+		stack.pop_back();
+
+		if (m_Nodes[node].Block)
+			blocks.push_back(m_Nodes[node].Block);
+
+		const std::vector<BasicBlock*>& children = m_Nodes[node].Children;
+
+		for (auto it = children.rbegin(); it != children.rend(); ++it)
+			stack.push_back(GetIndex(*it));
+	}
+
+	return blocks;
+}
+
+/******************************************************************************/
+
+static void
+PrintDominatorTreeNode(SlotTracker& slots, FILE* file, const Function& fn, const BasicBlock* bb)
+{
+	const std::string& name = fn.GetName();
+
+	if (!bb) {
+		fprintf(file, "\"%s.exit\"", name.c_str());
+	} else if (bb->GetName()) {
+		fprintf(file, "\"%s.%s\"", name.c_str(), bb->GetName());
+	} else {
+		fprintf(file, "\"%s.%zu\"", name.c_str(), slots.GetBasicBlockSlot(bb));
+	}
+}
+
+/******************************************************************************/
+
+void
+Helix::DumpDominatorTreesToFile(Module* mod, const std::string& filepath)
+{
+	FILE* file = fopen(filepath.c_str(), "w");
+
+	helix_debug(logs::general, "Dumping module dominator trees to graph '{}'", filepath);
+
+	if (!file) {
+		helix_warn(
+		    logs::general,
+		    "Couldn't open file '{}' for writing, skipping dominator tree dump", filepath
+		);
+
+		return;
+	}
+
+	fprintf(file, "digraph module {\n"
+	              "\tnodesep=1;\n");
+
+	for (Function* fn : mod->functions()) {
+		if (!fn->HasBody())
+			continue;
+
+		SlotTracker slots;
+		slots.CacheFunction(fn);
+
+		const std::string& name = fn->GetName();
+
+		fprintf(file, "\tsubgraph cluster%s {\n", name.c_str());
+		fprintf(file, "\t\tlabel = \"%s\";\n", name.c_str());
+		fprintf(file, "\t\tcolor = black;\n");
+
+		DominatorTree domTree(fn);
+
+		for (BasicBlock* bb : domTree.GetReversePostOrder()) {
+			for (BasicBlock* child : domTree.GetChildren(bb)) {
+				fprintf(file, "\t\t");
+				PrintDominatorTreeNode(slots, file, *fn, bb);
+				fprintf(file, " -> ");
+				PrintDominatorTreeNode(slots, file, *fn, child);
+				fprintf(file, ";\n");
+			}
+
+			// Dominance frontiers are drawn as dashed edges, so that it's
+			// easy to see where they are in relation to the tree.
+			for (BasicBlock* df : domTree.GetDominanceFrontier(bb)) {
+				fprintf(file, "\t\t");
+				PrintDominatorTreeNode(slots, file, *fn, bb);
+				fprintf(file, " -> ");
+				PrintDominatorTreeNode(slots, file, *fn, df);
+				fprintf(file, " [style=dashed];\n");
+			}
+		}
+
+		fprintf(file, "\t}\n");
+	}
+
+	fprintf(file, "}\n");
+	fclose(file);
+}
+
+/******************************************************************************/
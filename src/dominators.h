@@ -0,0 +1,174 @@
+/**
+ * @file dominators.h
+ * @author Barney Wilks
+ *
+ * Dominator (and post dominator) tree analysis over the CFG of a function.
+ *
+ * The tree is built with the iterative algorithm from Cooper, Harvey &
+ * Kennedy ("A Simple, Fast Dominance Algorithm"), which is iterating
+ * to a fixed point over the reverse post order of the CFG. For the size
+ * of CFGs that we generate this beats Lengauer-Tarjan in practice.
+ *
+ * Once built, every node in the tree is given a DFS entry/exit number
+ * so that dominance queries between two blocks are O(1).
+ *
+ * Passes should get these through the AnalysisManager, rather than building
+ * their own.
+ */
+
+#pragma once
+
+/* Internal Project Includes */
+#include "system.h"
+#include "analysis-manager.h"
+
+/* C++ Standard Library Includes */
+#include <vector>
+#include <unordered_map>
+#include <string>
+
+namespace Helix
+{
+	class Function;
+	class BasicBlock;
+	class Instruction;
+	class Module;
+
+	class DominatorTree : public Analysis
+	{
+	public:
+		enum Kind
+		{
+			/// Regular dominators, the tree is rooted at the entry block of
+			/// the function.
+			kDominators,
+
+			/// Post dominators, built over the reverse CFG. Since a function
+			/// may have more than one exit the tree is rooted at a virtual exit
+			/// node (represented by null) which has every exit block as a child.
+			/// Blocks that never reach an exit (infinite loops) are given a fake
+			/// edge to the virtual exit from one block in each such region, so
+			/// that every block is in the tree.
+			kPostDominators
+		};
+
+		DominatorTree(Function* fn, Kind kind = kDominators);
+
+		HELIX_NO_STEAL(DominatorTree);
+
+		/// Return the function that this tree was built for.
+		Function* GetFunction() const { return m_Function; }
+
+		/// Return true if this is a post dominator tree.
+		bool IsPostDominatorTree() const { return m_Kind == kPostDominators; }
+
+		/// Get the root block of the tree. For post dominator trees this is
+		/// null (the virtual exit node).
+		BasicBlock* GetRoot() const;
+
+		/// Return true if the block was reachable when the tree was built. For
+		/// dominators this is reachability from the entry, post dominator trees
+		/// include every block. Dominance information is undefined for
+		/// unreachable blocks.
+		bool IsReachable(const BasicBlock* bb) const;
+
+		/// Get the immediate dominator of the given block. Null is returned for
+		/// the root, unreachable blocks & (for post dominators) blocks that are
+		/// immediately post dominated by the virtual exit (exit blocks, and the
+		/// blocks picked to stand in as exits for infinite loops).
+		BasicBlock* GetImmediateDominator(const BasicBlock* bb) const;
+
+		/// Return true if 'a' dominates 'b' (every block dominates itself). O(1).
+		bool Dominates(const BasicBlock* a, const BasicBlock* b) const;
+
+		/// Return true if 'a' dominates 'b' and 'a' != 'b'. O(1).
+		bool StrictlyDominates(const BasicBlock* a, const BasicBlock* b) const;
+
+		/// Return true if the instruction 'a' dominates 'b', that is 'a' will
+		/// always execute before (or, for post dominators, after) 'b'.
+		/// Instructions in the same block are compared by their position.
+		bool Dominates(const Instruction* a, const Instruction* b) const;
+
+		/// Find the closest block that dominates both 'a' and 'b'. Null if
+		/// there is no such block (one of them is unreachable, or the only
+		/// common post dominator is the virtual exit).
+		BasicBlock* FindNearestCommonDominator(BasicBlock* a, BasicBlock* b) const;
+
+		/// Get the blocks immediately dominated by the given block. Passing
+		/// null returns the children of the virtual exit node for post dominator
+		/// trees.
+		const std::vector<BasicBlock*>& GetChildren(const BasicBlock* bb) const;
+
+		/// Get the dominance frontier of a block, the set of blocks where the
+		/// dominance of 'bb' stops (for post dominators, the set of blocks that
+		/// 'bb' is control dependent on).
+		const std::vector<BasicBlock*>& GetDominanceFrontier(const BasicBlock* bb) const;
+
+		/// Return the depth of the block in the tree (the root is at level 0).
+		size_t GetLevel(const BasicBlock* bb) const;
+
+		/// Get all the reachable blocks in reverse post order (over the reverse
+		/// CFG for post dominators). Handy for passes that want to visit
+		/// definitions before their uses.
+		const std::vector<BasicBlock*>& GetReversePostOrder() const { return m_ReversePostOrder; }
+
+		/// Get all the reachable blocks in a pre-order walk of the tree, so
+		/// that every block is visited after its dominator.
+		std::vector<BasicBlock*> GetPreOrder() const;
+
+	private:
+		struct Node
+		{
+			BasicBlock*              Block     = nullptr;
+			size_t                   IDom      = SIZE_MAX;
+			size_t                   PostOrder = SIZE_MAX;
+			size_t                   DFSIn     = 0;
+			size_t                   DFSOut    = 0;
+			size_t                   Level     = 0;
+			std::vector<size_t>      Preds;
+			std::vector<size_t>      Succs;
+			std::vector<BasicBlock*> Children;
+			std::vector<BasicBlock*> Frontier;
+		};
+
+		size_t GetIndex(const BasicBlock* bb) const;
+
+		void BuildGraph();
+		void ConnectNonExitingBlocks();
+		void ComputeReversePostOrder();
+		void ComputeImmediateDominators();
+		void ComputeTree();
+		void ComputeDominanceFrontiers();
+
+		size_t Intersect(size_t a, size_t b) const;
+
+		bool IsReachable(size_t index) const { return m_Nodes[index].PostOrder != SIZE_MAX; }
+
+	private:
+		Function*                                      m_Function;
+		Kind                                           m_Kind;
+
+		/// One node per block, plus (for post dominators) one extra for the
+		/// virtual exit node, which is always the last node.
+		std::vector<Node>                              m_Nodes;
+		size_t                                         m_Root = 0;
+
+		std::unordered_map<const BasicBlock*, size_t>  m_Indices;
+		std::vector<BasicBlock*>                       m_ReversePostOrder;
+		std::vector<size_t>                            m_ReversePostOrderIndices;
+	};
+
+	class PostDominatorTree : public DominatorTree
+	{
+	public:
+		PostDominatorTree(Function* fn)
+			: DominatorTree(fn, kPostDominators) { }
+	};
+
+	/// Write out the dominator trees for every function in the module to a
+	/// graphviz compatible dot file.
+	void DumpDominatorTreesToFile(Module* mod, const std::string& filepath);
+}
+
+REGISTER_ANALYSIS(DominatorTree, domtree, "Dominator tree & dominance frontiers");
+REGISTER_ANALYSIS(PostDominatorTree, postdomtree, "Post dominator tree & post dominance frontiers");
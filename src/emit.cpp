@@ -173,9 +173,12 @@ void AssemblyEmitter::Execute(Module* mod, const PassRunInformation&)
 			continue;
 		}
 
-		// #FIXME: Not every function has external linkage (and hence wants this)
-		//         Add some attribute to Function to signify linkage
-		fprintf(file, ".globl %s\n%s:\n", functionName.c_str(), functionName.c_str());
+		// Internal (static) functions shouldn't be visible to the linker
+		if (!fn->HasInternalLinkage()) {
+			fprintf(file, ".globl %s\n", functionName.c_str());
+		}
+
+		fprintf(file, "%s:\n", functionName.c_str());
 
 
 		// -----------------------
@@ -0,0 +1,191 @@
+/**
+ * @file function-attrs.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in function-attrs.h
+ */
+
+/* Internal Project Includes */
+#include "function-attrs.h"
+#include "alias-analysis.h"
+#include "call-graph.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "loop-info.h"
+#include "module.h"
+
+/* C++ Standard Library Includes */
+#include <unordered_map>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// Return whichever of 'a' & 'b' allows a function to do more to memory.
+static MemoryEffects Weakest(MemoryEffects a, MemoryEffects b)
+{
+	// ReadWrite < ReadOnly < ReadNone
+	return (int) a < (int) b ? a : b;
+}
+
+/*********************************************************************************************************************/
+
+/// What the source said about a function before anything was inferred.
+struct DeclaredAttributes
+{
+	MemoryEffects Effects;
+	bool          AlwaysReturns;
+};
+
+/*********************************************************************************************************************/
+
+class AttributeInference
+{
+public:
+	AttributeInference(Module* mod, const PassRunInformation& info)
+		: m_Module(mod), m_Info(info), m_CallGraph(mod) { }
+
+	void Run();
+
+private:
+	/// Work out the attributes of 'fn' from its body & the current attributes
+	/// of the functions it calls. Returns true if they changed.
+	bool Infer(Function* fn);
+
+	/// Return true if 'fn' always gets to its `ret` (without looking at calls).
+	bool HasOnlyFiniteLoops(Function* fn) const;
+
+private:
+	Module*                   m_Module;
+	const PassRunInformation& m_Info;
+
+	/// Functions that can end up calling themselves might never return.
+	const CallGraph           m_CallGraph;
+
+	std::unordered_map<Function*, DeclaredAttributes> m_Declared;
+};
+
+/*********************************************************************************************************************/
+
+bool AttributeInference::HasOnlyFiniteLoops(Function* fn) const
+{
+	LoopInfo& loopInfo = m_Info.Analyses->Get<LoopInfo>(fn);
+
+	for (Loop* loop : loopInfo.GetLoopsInnermostFirst()) {
+		if (!loop->HasConstantTripCount())
+			return false;
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool AttributeInference::Infer(Function* fn)
+{
+	AliasAnalysis& aa = m_Info.Analyses->Get<AliasAnalysis>(fn);
+
+	MemoryEffects effects = MemoryEffects::ReadNone;
+	bool alwaysReturns = !m_CallGraph.IsRecursive(fn) && this->HasOnlyFiniteLoops(fn);
+
+	for (BasicBlock& bb : fn->blocks()) {
+		for (Instruction& insn : bb) {
+			switch (insn.GetOpcode()) {
+			case HLIR::Load:
+			case HLIR::Store: {
+				// The function's own stack slots are gone by the time it returns, so
+				// nothing else can tell if they were used (even if their address was
+				// passed to a call, which is accounted for by the call).
+				Value* ptr = insn.GetOpcode() == HLIR::Load
+					? static_cast<LoadInsn&>(insn).GetSrc()
+					: static_cast<StoreInsn&>(insn).GetDst();
+
+				if (aa.Decompose(ptr).Kind == AliasAnalysis::kObject_StackSlot)
+					break;
+
+				effects = Weakest(effects, insn.GetOpcode() == HLIR::Load ? MemoryEffects::ReadOnly
+				                                                          : MemoryEffects::ReadWrite);
+				break;
+			}
+
+			case HLIR::Call:
+				if (Function* callee = IR::GetCalledFunction(&insn)) {
+					effects = Weakest(effects, callee->GetMemoryEffects());
+					alwaysReturns &= callee->AlwaysReturns();
+				} else {
+					effects = MemoryEffects::ReadWrite;
+					alwaysReturns = false;
+				}
+
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	// Whatever the source promised still holds, even if it couldn't be proved.
+	const DeclaredAttributes& declared = m_Declared.at(fn);
+
+	if ((int) declared.Effects > (int) effects)
+		effects = declared.Effects;
+
+	alwaysReturns |= declared.AlwaysReturns;
+
+	// Only ever weaken what is already there, so that going around again (for
+	// recursive functions) always finishes.
+	effects = Weakest(effects, fn->GetMemoryEffects());
+	alwaysReturns &= fn->AlwaysReturns();
+
+	if (effects == fn->GetMemoryEffects() && alwaysReturns == fn->AlwaysReturns())
+		return false;
+
+	fn->SetMemoryEffects(effects);
+	fn->SetAlwaysReturns(alwaysReturns);
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+void AttributeInference::Run()
+{
+	// Everything that a component calls outside of itself is already done by the
+	// time it's visited, so only functions in the same component (that call each
+	// other) have to be gone around again.
+	for (const std::vector<Function*>& scc : m_CallGraph.GetSCCs()) {
+		// Start from the best case for everything with a body & work down, so that
+		// functions that only call each other (but don't do anything else) aren't
+		// held back by each other.
+		for (Function* fn : scc) {
+			if (!fn->HasBody())
+				continue;
+
+			m_Declared[fn] = { fn->GetMemoryEffects(), fn->AlwaysReturns() };
+
+			fn->SetMemoryEffects(MemoryEffects::ReadNone);
+			fn->SetAlwaysReturns(true);
+		}
+
+		for (bool changed = true; changed;) {
+			changed = false;
+
+			for (Function* fn : scc) {
+				if (fn->HasBody())
+					changed |= this->Infer(fn);
+			}
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+void FunctionAttrs::Execute(Module* mod, const PassRunInformation& info)
+{
+	AttributeInference inference(mod, info);
+	inference.Run();
+}
+
+/*********************************************************************************************************************/
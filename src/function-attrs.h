@@ -0,0 +1,40 @@
+/**
+ * @file function-attrs.h
+ * @author Barney Wilks
+ *
+ * Inference of what functions do to memory, & whether they always return.
+ *
+ * A call is normally assumed to read & write anything it can reach and to
+ * maybe never come back, so it can't be removed, merged with another call or
+ * moved out of a loop, and anything loaded before it has to be loaded again
+ * afterwards. Most small helper functions don't need any of that.
+ *
+ * Each function with a body is given the MemoryEffects of the loads & stores
+ * in it (apart from those to its own stack slots) combined with those of the
+ * functions that it calls, visiting callees before callers & repeating until
+ * nothing changes (so mutually recursive functions settle on the same answer).
+ * A function always returns if it isn't recursive, every loop in it has a
+ * constant trip count and every function it calls always returns.
+ *
+ * Functions declared `__attribute__((const))` or `__attribute__((pure))` are
+ * taken at their word. DCE, GVN, LICM & alias analysis all look at the result.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class FunctionAttrs : public Pass
+	{
+	public:
+		void Execute(Module* mod, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(FunctionAttrs, funcattrs, "[Generic] Infer whether functions access memory & always return");
+
+/*********************************************************************************************************************/
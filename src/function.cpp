@@ -188,6 +188,47 @@ Function::GetParameter(size_t index) const
 
 /******************************************************************************/
 
+void
+Function::RemoveParameter(size_t index)
+{
+	helix_assert(index < m_Parameters.size(), "parameter index out of bounds");
+
+	Value* param = m_Parameters[index];
+
+	m_Parameters.erase(m_Parameters.begin() + index);
+	m_NoAliasParameters.erase(std::remove(m_NoAliasParameters.begin(), m_NoAliasParameters.end(), param),
+	                          m_NoAliasParameters.end());
+
+	const FunctionType* type = type_cast<FunctionType>(this->GetType());
+
+	FunctionType::ParametersList types = type->GetParameters();
+	types.erase(types.begin() + index);
+
+	this->SetType(FunctionType::Create(type->GetReturnType(), types));
+}
+
+void
+Function::SetNoAliasParameter(size_t index)
+{
+	helix_assert(index < m_Parameters.size(), "parameter index out of bounds");
+
+	Value* param = m_Parameters[index];
+
+	if (!IsNoAliasParameter(param))
+		m_NoAliasParameters.push_back(param);
+}
+
+/******************************************************************************/
+
+bool
+Function::IsNoAliasParameter(const Value* param) const
+{
+	return std::find(m_NoAliasParameters.begin(), m_NoAliasParameters.end(), param)
+		!= m_NoAliasParameters.end();
+}
+
+/******************************************************************************/
+
 size_t
 Function::GetCountParameters() const
 {
@@ -23,6 +23,41 @@ namespace Helix
 
 	/**************************************************************************/
 
+	/// What the source asked for when it comes to inlining calls to a function.
+	enum class InlineHint
+	{
+		/// Up to the inliner's cost model (the default)
+		None,
+
+		/// Declared `inline`, so calls are worth inlining at a higher cost
+		Inline,
+
+		/// `__attribute__((always_inline))`, inline wherever possible
+		AlwaysInline,
+
+		/// `__attribute__((noinline))`, never inline
+		NoInline
+	};
+
+	/**************************************************************************/
+
+	/// What a function might do to memory, not counting its own stack slots
+	/// (which nothing else can see once it has returned).
+	enum class MemoryEffects
+	{
+		/// Might read or write anything (the default)
+		ReadWrite,
+
+		/// Only reads memory, `__attribute__((pure))`
+		ReadOnly,
+
+		/// Doesn't touch memory at all, so the result only depends on the
+		/// arguments, `__attribute__((const))`
+		ReadNone
+	};
+
+	/**************************************************************************/
+
 	class Function : public Value
 	{
 	public:
@@ -90,10 +125,48 @@ namespace Helix
 		/// is out of bounds, null is returned.
 		Value* GetParameter(size_t index) const;
 
+		/// Remove the parameter at the given index, along with its type from the
+		/// function's type. Nothing in the function may still use it, and every
+		/// call to the function has to have the argument removed as well.
+		void RemoveParameter(size_t index);
+
+		/// Mark the parameter at the given index as not aliasing any other
+		/// pointer that the function can access (e.g. it was declared with
+		/// the C `restrict` qualifier).
+		void SetNoAliasParameter(size_t index);
+
+		/// Return true if the given value is a parameter of this function
+		/// that has been marked with SetNoAliasParameter()
+		bool IsNoAliasParameter(const Value* param) const;
+
 		/// Set the parent module for this function. Originally null
 		/// if nothing has been already set.
 		void SetParent(Module* parent);
 
+		/// Get/set the linkage of this function, functions have external
+		/// linkage unless told otherwise.
+		Linkage GetLinkage() const { return m_Linkage; }
+		void SetLinkage(Linkage linkage) { m_Linkage = linkage; }
+
+		bool HasInternalLinkage() const { return m_Linkage == Linkage::Internal; }
+
+		/// Get/set how calls to this function should be inlined (see InlineHint).
+		InlineHint GetInlineHint() const { return m_InlineHint; }
+		void SetInlineHint(InlineHint hint) { m_InlineHint = hint; }
+
+		/// Get/set what calling this function might do to memory (see MemoryEffects).
+		/// Set from attributes in the source & inferred by the funcattrs pass.
+		MemoryEffects GetMemoryEffects() const { return m_MemoryEffects; }
+		void SetMemoryEffects(MemoryEffects effects) { m_MemoryEffects = effects; }
+
+		bool DoesNotWriteMemory() const { return m_MemoryEffects != MemoryEffects::ReadWrite; }
+		bool DoesNotAccessMemory() const { return m_MemoryEffects == MemoryEffects::ReadNone; }
+
+		/// Get/set whether every call to this function is known to return (it can't
+		/// loop forever or call something that doesn't return).
+		bool AlwaysReturns() const { return m_AlwaysReturns; }
+		void SetAlwaysReturns(bool alwaysReturns) { m_AlwaysReturns = alwaysReturns; }
+
 		iterator       begin()       { return m_Blocks.begin(); }
 		iterator       end()         { return m_Blocks.end();   }
 		const_iterator begin() const { return m_Blocks.begin(); }
@@ -129,8 +202,14 @@ namespace Helix
 	private:
 		BlockList    m_Blocks;
 		ParamList    m_Parameters;
+		ParamList    m_NoAliasParameters;
 		std::string  m_Name;
 		Module*      m_Parent = nullptr;
+		Linkage      m_Linkage = Linkage::External;
+		InlineHint   m_InlineHint = InlineHint::None;
+
+		MemoryEffects m_MemoryEffects = MemoryEffects::ReadWrite;
+		bool          m_AlwaysReturns = false;
 	};
 
 	/**************************************************************************/
@@ -3,10 +3,246 @@
 #include "ir-helpers.h"
 #include "function.h"
 
+/* C++ Standard Library Includes */
+#include <cstdint>
+
 using namespace Helix;
 
 /*********************************************************************************************************************/
 
+// Dividing by a constant is done by multiplying by a fixed point reciprocal of the divisor (a
+// 'magic number') and keeping the top half of the product, followed by some shifts & fixups to
+// get the rounding right. See chapter 10 of Hacker's Delight, or Granlund & Montgomery's
+// "Division by Invariant Integers using Multiplication".
+
+struct SignedMagic
+{
+	int32_t  Multiplier;
+	unsigned Shift;
+};
+
+struct UnsignedMagic
+{
+	uint32_t Multiplier;
+	unsigned Shift;
+
+	/// The real multiplier needs 33 bits, so 2^32 * x has to be added to the product.
+	bool     Add;
+};
+
+/*********************************************************************************************************************/
+
+static bool IsPowerOfTwo(uint32_t value)
+{
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+/*********************************************************************************************************************/
+
+static unsigned Log2(uint32_t value)
+{
+	unsigned result = 0;
+
+	while (value >>= 1)
+		result++;
+
+	return result;
+}
+
+/*********************************************************************************************************************/
+
+/// Compute the magic number for a signed division by 'd' (where |d| >= 2).
+static SignedMagic ComputeSignedMagic(int32_t d)
+{
+	const uint32_t two31 = 0x80000000u;
+
+	const uint32_t ad  = d < 0 ? 0u - (uint32_t) d : (uint32_t) d;
+	const uint32_t t   = two31 + ((uint32_t) d >> 31);
+	const uint32_t anc = t - 1 - t % ad; // |nc|, the largest value that is one less than a multiple of d.
+
+	unsigned p = 31;
+
+	uint32_t q1 = two31 / anc;     // 2^p / |nc|
+	uint32_t r1 = two31 - q1 * anc;
+	uint32_t q2 = two31 / ad;      // 2^p / |d|
+	uint32_t r2 = two31 - q2 * ad;
+
+	uint32_t delta = 0;
+
+	do {
+		p++;
+
+		q1 *= 2;
+		r1 *= 2;
+
+		if (r1 >= anc) {
+			q1++;
+			r1 -= anc;
+		}
+
+		q2 *= 2;
+		r2 *= 2;
+
+		if (r2 >= ad) {
+			q2++;
+			r2 -= ad;
+		}
+
+		delta = ad - r2;
+	} while (q1 < delta || (q1 == delta && r1 == 0));
+
+	const uint32_t multiplier = q2 + 1;
+
+	return { (int32_t) (d < 0 ? 0u - multiplier : multiplier), p - 32 };
+}
+
+/*********************************************************************************************************************/
+
+/// Compute the magic number for an unsigned division by 'd' (where d >= 2).
+static UnsignedMagic ComputeUnsignedMagic(uint32_t d)
+{
+	bool add = false;
+
+	unsigned p   = 31;
+	uint32_t p32 = 0;                     // 2^(p - 32)
+	uint32_t q   = 0x7fffffffu / d;       // (2^p - 1) / d
+	uint32_t r   = 0x7fffffffu - q * d;
+
+	uint32_t delta = 0;
+
+	do {
+		p++;
+		p32 = (p == 32) ? 1 : p32 * 2;
+
+		if (r + 1 >= d - r) {
+			if (q >= 0x7fffffffu)
+				add = true;
+
+			q = 2 * q + 1;
+			r = 2 * r + 1 - d;
+		}
+		else {
+			if (q >= 0x80000000u)
+				add = true;
+
+			q = 2 * q;
+			r = 2 * r + 1;
+		}
+
+		delta = d - 1 - r;
+	} while (p < 64 && (p32 < delta || (p32 == delta && r == 0)));
+
+	return { q + 1, p - 32, add };
+}
+
+/*********************************************************************************************************************/
+
+bool GenericLowering::LowerDivisionByConstant(BasicBlock& bb, BinOpInsn& insn)
+{
+	ConstantInt*       divisor = value_cast<ConstantInt>(insn.GetRHS());
+	const IntegerType* type    = type_cast<IntegerType>(insn.GetResult()->GetType());
+
+	// Magic numbers are only worked out for 32 bit division, the width that the target
+	// has a multiply long for.
+	if (!divisor || !type || type->GetBitWidth() != 32 || insn.GetLHS()->GetType() != type)
+		return false;
+
+	Value* lhs = insn.GetLHS();
+	Value* dst = insn.GetResult();
+
+	const uint32_t ud = (uint32_t) divisor->GetIntegralValue();
+	const int32_t  sd = (int32_t) ud;
+
+	// Dividing by zero is undefined, and by one is left for the peephole optimiser.
+	if (ud == 0 || ud == 1)
+		return false;
+
+	const bool bUnsigned = insn.GetOpcode() == HLIR::IUDiv;
+
+	BasicBlock::iterator where = bb.Where(&insn);
+
+	// Insert 'a <opc> b' after the last instruction, writing to 'result' (or a new register
+	// if there isn't one).
+	auto emit = [&](HLIR::Opcode opc, Value* a, Value* b, Value* result = nullptr) -> Value* {
+		if (!result)
+			result = VirtualRegisterName::Create(type);
+
+		where = bb.InsertAfter(where, Helix::CreateBinOp(opc, a, b, result));
+		return result;
+	};
+
+	auto constant = [type](uint32_t value) {
+		return ConstantInt::Create(type, value);
+	};
+
+	if (bUnsigned && IsPowerOfTwo(ud)) {
+		emit(HLIR::Shr, lhs, constant(Log2(ud)), dst);
+	}
+	else if (bUnsigned) {
+		const UnsignedMagic magic = ComputeUnsignedMagic(ud);
+
+		if (!magic.Add) {
+			// x / d = mulhu(x, m) >> s
+			Value* q = emit(HLIR::IMulHU, lhs, constant(magic.Multiplier), magic.Shift == 0 ? dst : nullptr);
+
+			if (magic.Shift > 0)
+				emit(HLIR::Shr, q, constant(magic.Shift), dst);
+		}
+		else {
+			// The product needs x added to its top half, which can overflow, so it is done
+			// as ((x - q) / 2 + q) & the shift is one less to make up for it.
+			Value* q = emit(HLIR::IMulHU, lhs, constant(magic.Multiplier));
+			Value* t = emit(HLIR::ISub, lhs, q);
+
+			t = emit(HLIR::Shr, t, constant(1));
+			t = emit(HLIR::IAdd, t, q, magic.Shift == 1 ? dst : nullptr);
+
+			if (magic.Shift > 1)
+				emit(HLIR::Shr, t, constant(magic.Shift - 1), dst);
+		}
+	}
+	else if (sd == -1) {
+		emit(HLIR::ISub, constant(0), lhs, dst);
+	}
+	else if (IsPowerOfTwo(sd < 0 ? 0u - ud : ud)) {
+		// Shifting right rounds towards negative infinity, but division rounds towards zero,
+		// so 2^k - 1 is added to negative values before shifting.
+		const unsigned k = Log2(sd < 0 ? 0u - ud : ud);
+
+		Value* sign = (k > 1) ? emit(HLIR::AShr, lhs, constant(k - 1)) : lhs;
+		Value* bias = emit(HLIR::Shr, sign, constant(32 - k));
+		Value* t    = emit(HLIR::IAdd, lhs, bias);
+		Value* q    = emit(HLIR::AShr, t, constant(k), sd > 0 ? dst : nullptr);
+
+		if (sd < 0)
+			emit(HLIR::ISub, constant(0), q, dst);
+	}
+	else {
+		const SignedMagic magic = ComputeSignedMagic(sd);
+
+		Value* q = emit(HLIR::IMulHS, lhs, constant((uint32_t) magic.Multiplier));
+
+		// A multiplier with the wrong sign for the divisor has overflowed (it is really 2^32
+		// more or less than it looks), so x has to be added to (or taken from) the product.
+		if (sd > 0 && magic.Multiplier < 0)
+			q = emit(HLIR::IAdd, q, lhs);
+		else if (sd < 0 && magic.Multiplier > 0)
+			q = emit(HLIR::ISub, q, lhs);
+
+		if (magic.Shift > 0)
+			q = emit(HLIR::AShr, q, constant(magic.Shift));
+
+		// Round towards zero by adding one to negative results.
+		Value* sign = emit(HLIR::Shr, q, constant(31));
+		emit(HLIR::IAdd, q, sign, dst);
+	}
+
+	insn.DeleteFromParent();
+	return true;
+}
+
+/*********************************************************************************************************************/
+
 void GenericLowering::LowerIRem(BasicBlock& bb, BinOpInsn& insn)
 {
 	// #FIXME: This is really an ARM specific optimisation? Can take advantage of a `mls`
@@ -25,14 +261,32 @@ void GenericLowering::LowerIRem(BasicBlock& bb, BinOpInsn& insn)
 
 	BasicBlock::iterator where = bb.Where(&insn);
 
-	const HLIR::Opcode divop
-		= insn.GetOpcode() == HLIR::ISRem ? HLIR::ISDiv : HLIR::IUDiv;
+	const bool bUnsigned = insn.GetOpcode() == HLIR::IURem;
+
+	const HLIR::Opcode divop = bUnsigned ? HLIR::IUDiv : HLIR::ISDiv;
 
-	where = bb.InsertAfter(where, Helix::CreateBinOp(divop, lhs, rhs, t0));
+	ConstantInt* divisor = value_cast<ConstantInt>(rhs);
+
+	// a % 2^k = a & (2^k - 1)
+	if (bUnsigned && divisor && IsPowerOfTwo((uint32_t) divisor->GetIntegralValue()) && operandType == BuiltinTypes::GetInt32()) {
+		ConstantInt* mask = ConstantInt::Create(operandType, (uint32_t) divisor->GetIntegralValue() - 1);
+
+		bb.InsertAfter(where, Helix::CreateBinOp(HLIR::And, lhs, mask, dst));
+		insn.DeleteFromParent();
+
+		return;
+	}
+
+	BinOpInsn* division = Helix::CreateBinOp(divop, lhs, rhs, t0);
+
+	where = bb.InsertAfter(where, division);
 	where = bb.InsertAfter(where, Helix::CreateBinOp(HLIR::IMul, t0, rhs, t1));
 	where = bb.InsertAfter(where, Helix::CreateBinOp(HLIR::ISub, lhs, t1, dst));
 
 	insn.DeleteFromParent();
+
+	if (divisor)
+		this->LowerDivisionByConstant(bb, *division);
 }
 
 /*********************************************************************************************************************/
@@ -106,6 +360,13 @@ void GenericLowering::Execute(Function* fn, const PassRunInformation&)
 				worklist.push_back({&insn, &bb});
 				break;
 
+			case HLIR::IUDiv:
+			case HLIR::ISDiv:
+				if (value_isa<ConstantInt>(insn.GetOperand(1)))
+					worklist.push_back({&insn, &bb});
+
+				break;
+
 			default:
 				break;
 			}
@@ -129,6 +390,11 @@ void GenericLowering::Execute(Function* fn, const PassRunInformation&)
 			this->LowerIRem(*workload.bb, *static_cast<BinOpInsn*>(workload.insn));
 			break;
 
+		case HLIR::IUDiv:
+		case HLIR::ISDiv:
+			this->LowerDivisionByConstant(*workload.bb, *static_cast<BinOpInsn*>(workload.insn));
+			break;
+
 		default:
 			break;
 		}
@@ -18,6 +18,11 @@ namespace Helix
 		void LowerLea(BasicBlock& bb, LoadEffectiveAddressInsn& insn);
 		void LowerLfa(BasicBlock& bb, LoadFieldAddressInsn& insn);
 		void LowerIRem(BasicBlock& bb, BinOpInsn& insn);
+
+		/// Replace a division by a constant with a multiplication by its 'magic' reciprocal
+		/// (or shifts for powers of two). Returns false (leaving 'insn' alone) if there
+		/// isn't a cheaper way to do the division.
+		bool LowerDivisionByConstant(BasicBlock& bb, BinOpInsn& insn);
 	};
 }
 
@@ -0,0 +1,104 @@
+/**
+ * @file global-dce.cpp
+ * @author Barney Wilks
+ */
+
+#include "global-dce.h"
+#include "call-graph.h"
+#include "module.h"
+#include "ir-helpers.h"
+
+#include <unordered_set>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// Destroy every instruction & basic block in the function, dropping any uses that they have.
+static void DropFunctionBody(Function* fn)
+{
+	std::vector<BasicBlock*> blocks;
+
+	for (BasicBlock& bb : fn->blocks())
+		blocks.push_back(&bb);
+
+	IR::DeleteBlocks(fn, blocks);
+}
+
+/*********************************************************************************************************************/
+
+void GlobalDCE::Execute(Module* mod, const PassRunInformation&)
+{
+	CallGraph callGraph(mod);
+
+	std::unordered_set<Value*> live;
+	std::vector<Value*>        worklist;
+
+	auto markLive = [&live, &worklist](Value* value) {
+		if (live.insert(value).second)
+			worklist.push_back(value);
+	};
+
+	// Anything with external linkage could be used from another translation unit, so it
+	// has to stay (as does everything that it uses).
+	for (Function* fn : mod->functions()) {
+		if (!fn->HasInternalLinkage())
+			markLive(fn);
+	}
+
+	for (GlobalVariable* gvar : mod->globals()) {
+		if (!gvar->HasInternalLinkage())
+			markLive(gvar);
+	}
+
+	while (!worklist.empty()) {
+		Value* value = worklist.back();
+		worklist.pop_back();
+
+		if (Function* fn = value_cast<Function>(value)) {
+			CallGraphNode* node = callGraph.GetNode(fn);
+
+			for (Function* callee : node->GetCallees())
+				markLive(callee);
+
+			for (Value* reference : node->GetReferences())
+				markLive(reference);
+		}
+		else if (GlobalVariable* gvar = value_cast<GlobalVariable>(value)) {
+			for (Value* reference : callGraph.GetInitialiserReferences(gvar))
+				markLive(reference);
+		}
+	}
+
+	std::vector<Function*>       deadFunctions;
+	std::vector<GlobalVariable*> deadGlobals;
+
+	for (Function* fn : mod->functions()) {
+		if (live.find(fn) == live.end())
+			deadFunctions.push_back(fn);
+	}
+
+	for (GlobalVariable* gvar : mod->globals()) {
+		if (live.find(gvar) == live.end())
+			deadGlobals.push_back(gvar);
+	}
+
+	// Dead functions can still reference each other, so get rid of all the bodies before
+	// removing anything.
+	for (Function* fn : deadFunctions) {
+		DropFunctionBody(fn);
+	}
+
+	for (Function* fn : deadFunctions) {
+		helix_debug(logs::globaldce, "Removing unused function '{}'", fn->GetName());
+		mod->RemoveFunction(fn);
+	}
+
+	for (GlobalVariable* gvar : deadGlobals) {
+		helix_debug(logs::globaldce, "Removing unused global variable '{}'", gvar->GetName());
+		mod->RemoveGlobalVariable(gvar);
+	}
+}
+
+/*********************************************************************************************************************/
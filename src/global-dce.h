@@ -0,0 +1,28 @@
+/**
+ * @file global-dce.h
+ * @author Barney Wilks
+ *
+ * Removes internal (static) functions & global variables that can't be
+ * reached from anything visible outside of the module - i.e. any function or
+ * global with external linkage. This includes internal functions that only
+ * call each other.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class GlobalDCE : public Pass
+	{
+	public:
+		void Execute(Module* mod, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(GlobalDCE, globaldce, "[Generic] Remove unused internal functions & global variables");
+
+/*********************************************************************************************************************/
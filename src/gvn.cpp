@@ -0,0 +1,341 @@
+/**
+ * @file gvn.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in gvn.h
+ */
+
+/* Internal Project Includes */
+#include "gvn.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "dominators.h"
+#include "alias-analysis.h"
+#include "hash.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// A value that is known to be in memory at a location, either because it was
+/// just loaded from there or just stored there.
+struct AvailableMemoryValue
+{
+	Value*      Ptr;
+	const Type* AccessType;
+	Value*      Available;
+};
+
+/*********************************************************************************************************************/
+
+static bool IsCommutative(HLIR::Opcode opcode)
+{
+	switch (opcode) {
+	case HLIR::IAdd:
+	case HLIR::IMul:
+	case HLIR::IMulHS:
+	case HLIR::IMulHU:
+	case HLIR::And:
+	case HLIR::Or:
+	case HLIR::Xor:
+	case HLIR::ICmp_Eq:
+	case HLIR::ICmp_Neq:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+/*********************************************************************************************************************/
+
+/// Calls to functions that don't touch memory only depend on their arguments, so
+/// they can be numbered like any other expression.
+static bool IsConstantCall(const Instruction* insn)
+{
+	Function* fn = IR::GetCalledFunction(insn);
+	return fn && fn->DoesNotAccessMemory();
+}
+
+/*********************************************************************************************************************/
+
+size_t GVNExpressionHash::operator()(const GVNExpression& expr) const
+{
+	size_t seed = 0;
+
+	hash_combine(seed, (int) expr.Opcode);
+	hash_combine(seed, expr.ResultType);
+	hash_combine(seed, expr.BaseType);
+	hash_combine(seed, expr.FieldIndex);
+
+	for (Value* operand : expr.Operands)
+		hash_combine(seed, operand);
+
+	return seed;
+}
+
+/*********************************************************************************************************************/
+
+bool GVNExpression::Build(Function* fn, Instruction* insn, GVNExpression* expr, Value** result)
+{
+	const HLIR::Opcode opcode = (HLIR::Opcode) insn->GetOpcode();
+
+	if (!IR::IsPure(insn) && !IsConstantCall(insn))
+		return false;
+
+	expr->Opcode = opcode;
+	*result      = nullptr;
+
+	for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+		Value* operand = insn->GetOperand(i);
+
+		if (!IR::IsSingleAssignment(fn, operand))
+			return false;
+
+		if (insn->OperandHasFlags(i, Instruction::OP_WRITE))
+			*result = operand;
+		else
+			expr->Operands.push_back(operand);
+	}
+
+	if (!*result || !value_isa<VirtualRegisterName>(*result))
+		return false;
+
+	expr->ResultType = (*result)->GetType();
+
+	if (opcode == HLIR::LoadElementAddress) {
+		expr->BaseType = static_cast<LoadEffectiveAddressInsn*>(insn)->GetBaseType();
+	} else if (opcode == HLIR::LoadFieldAddress) {
+		LoadFieldAddressInsn* lfa = static_cast<LoadFieldAddressInsn*>(insn);
+
+		expr->BaseType   = lfa->GetBaseType();
+		expr->FieldIndex = lfa->GetFieldIndex();
+	}
+
+	// Make sure that `a + b` and `b + a` are numbered the same. The order doesn't
+	// matter, as long as it's consistent.
+	if (IsCommutative(opcode) && expr->Operands.size() == 2 && std::less<Value*>()(expr->Operands[1], expr->Operands[0]))
+		std::swap(expr->Operands[0], expr->Operands[1]);
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+class ValueNumbering
+{
+public:
+	ValueNumbering(Function* fn, const DominatorTree& domTree, AliasAnalysis& aa)
+		: m_Function(fn), m_DomTree(domTree), m_AliasAnalysis(aa) { }
+
+	void Run();
+
+private:
+	using MemoryState = std::vector<AvailableMemoryValue>;
+
+	void VisitBlock(BasicBlock* bb, MemoryState& memory);
+
+	bool VisitLoad(LoadInsn* load, MemoryState& memory);
+	void VisitStore(StoreInsn* store, MemoryState& memory);
+	void VisitCall(Instruction* call, MemoryState& memory);
+
+	bool VisitPure(Instruction* insn);
+
+	void Replace(Instruction* insn, Value* result, Value* value);
+
+private:
+	Function*                                                    m_Function;
+	const DominatorTree&                                         m_DomTree;
+	AliasAnalysis&                                               m_AliasAnalysis;
+
+	/// Expressions available at the current point in the dominator tree.
+	std::unordered_map<GVNExpression, Value*, GVNExpressionHash> m_Expressions;
+
+	/// Expressions added to m_Expressions, in the order they were added, so
+	/// that they can be removed again when leaving the scope of a block.
+	std::vector<GVNExpression>                                   m_ScopeLog;
+};
+
+/*********************************************************************************************************************/
+
+void ValueNumbering::Replace(Instruction* insn, Value* result, Value* value)
+{
+	IR::ReplaceAllUsesWith(result, value);
+	insn->DeleteFromParent();
+}
+
+/*********************************************************************************************************************/
+
+bool ValueNumbering::VisitPure(Instruction* insn)
+{
+	GVNExpression expr;
+	Value*        result = nullptr;
+
+	if (!GVNExpression::Build(m_Function, insn, &expr, &result))
+		return false;
+
+	auto it = m_Expressions.find(expr);
+
+	if (it != m_Expressions.end()) {
+		this->Replace(insn, result, it->second);
+		return true;
+	}
+
+	m_Expressions.insert({ expr, result });
+	m_ScopeLog.push_back(std::move(expr));
+
+	return false;
+}
+
+/*********************************************************************************************************************/
+
+bool ValueNumbering::VisitLoad(LoadInsn* load, MemoryState& memory)
+{
+	Value* ptr = load->GetSrc();
+	Value* dst = load->GetDst();
+
+	if (!IR::IsSingleAssignment(m_Function, ptr) || !value_isa<VirtualRegisterName>(dst)
+		|| !IR::IsSingleAssignment(m_Function, dst)) {
+		return false;
+	}
+
+	for (const AvailableMemoryValue& available : memory) {
+		if (available.Ptr == ptr && available.AccessType == dst->GetType()) {
+			this->Replace(load, dst, available.Available);
+			return true;
+		}
+	}
+
+	memory.push_back({ ptr, dst->GetType(), dst });
+	return false;
+}
+
+/*********************************************************************************************************************/
+
+void ValueNumbering::VisitStore(StoreInsn* store, MemoryState& memory)
+{
+	const MemoryLocation storeLocation = MemoryLocation::Get(store);
+
+	memory.erase(
+		std::remove_if(memory.begin(), memory.end(), [&](const AvailableMemoryValue& available) {
+			const MemoryLocation location(available.Ptr, available.AccessType);
+			return m_AliasAnalysis.Alias(location, storeLocation) != AliasResult::NoAlias;
+		}),
+		memory.end()
+	);
+
+	// Whatever was stored can be forwarded to later loads of the same location.
+	if (IR::IsSingleAssignment(m_Function, store->GetDst()) && IR::IsSingleAssignment(m_Function, store->GetSrc()))
+		memory.push_back({ store->GetDst(), store->GetSrc()->GetType(), store->GetSrc() });
+}
+
+/*********************************************************************************************************************/
+
+void ValueNumbering::VisitCall(Instruction* call, MemoryState& memory)
+{
+	memory.erase(
+		std::remove_if(memory.begin(), memory.end(), [&](const AvailableMemoryValue& available) {
+			const MemoryLocation location(available.Ptr, available.AccessType);
+			return (m_AliasAnalysis.GetModRefInfo(call, location) & kMod) != 0;
+		}),
+		memory.end()
+	);
+}
+
+/*********************************************************************************************************************/
+
+void ValueNumbering::VisitBlock(BasicBlock* bb, MemoryState& memory)
+{
+	for (BasicBlock::iterator it = bb->begin(); it != bb->end();) {
+		Instruction* insn = &*it;
+		++it;
+
+		switch (insn->GetOpcode()) {
+		case HLIR::Load:
+			this->VisitLoad(static_cast<LoadInsn*>(insn), memory);
+			break;
+
+		case HLIR::Store:
+			this->VisitStore(static_cast<StoreInsn*>(insn), memory);
+			break;
+
+		case HLIR::Call:
+			if (!this->VisitPure(insn))
+				this->VisitCall(insn, memory);
+
+			break;
+
+		default:
+			this->VisitPure(insn);
+			break;
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+void ValueNumbering::Run()
+{
+	struct Scope
+	{
+		BasicBlock* Block;
+		size_t      NextChild;
+		size_t      ScopeLogSize;
+		MemoryState Memory;
+	};
+
+	std::vector<Scope> stack;
+
+	stack.push_back({ m_DomTree.GetRoot(), 0, 0, {} });
+	this->VisitBlock(stack.back().Block, stack.back().Memory);
+
+	while (!stack.empty()) {
+		Scope& scope = stack.back();
+		const std::vector<BasicBlock*>& children = m_DomTree.GetChildren(scope.Block);
+
+		if (scope.NextChild == children.size()) {
+			// Nothing computed in this block is available outside of the
+			// blocks that it dominates.
+			while (m_ScopeLog.size() > scope.ScopeLogSize) {
+				m_Expressions.erase(m_ScopeLog.back());
+				m_ScopeLog.pop_back();
+			}
+
+			stack.pop_back();
+			continue;
+		}
+
+		BasicBlock* child = children[scope.NextChild++];
+
+		// If there's more than one way into the block then memory may have been
+		// written along one of the other paths.
+		MemoryState memory;
+
+		if (IR::GetPredecessors(child).size() == 1)
+			memory = scope.Memory;
+
+		stack.push_back({ child, 0, m_ScopeLog.size(), std::move(memory) });
+		this->VisitBlock(child, stack.back().Memory);
+	}
+}
+
+/*********************************************************************************************************************/
+
+void GVN::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	const DominatorTree& domTree = info.Analyses->Get<DominatorTree>(fn);
+	AliasAnalysis&       aa      = info.Analyses->Get<AliasAnalysis>(fn);
+
+	ValueNumbering valueNumbering(fn, domTree, aa);
+	valueNumbering.Run();
+}
+
+/*********************************************************************************************************************/
@@ -0,0 +1,76 @@
+/**
+ * @file gvn.h
+ * @author Barney Wilks
+ *
+ * Global value numbering, removing computations that have already been done.
+ *
+ * Pure instructions (arithmetic, comparisons, casts & address calculations,
+ * and calls to functions that don't access memory) are hashed by their opcode, operands & type, and the function is walked in
+ * dominator tree order with a scoped table of the expressions that are
+ * available at each point. If an instruction has already been computed by
+ * something that dominates it then it's replaced with that result.
+ *
+ * Loads are handled the same way, except that a load (or store) is only
+ * available until something that alias analysis says may write to the same
+ * memory (and only into blocks with a single predecessor, since memory
+ * could be written along another path into the block).
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+#include "opcodes.h"
+
+/* C++ Standard Library Includes */
+#include <vector>
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class Type;
+	class Value;
+	class Instruction;
+
+	/// The parts of a pure instruction that determine the value it computes, so
+	/// that two instructions with equal expressions compute the same value.
+	struct GVNExpression
+	{
+		HLIR::Opcode        Opcode;
+		const Type*         ResultType = nullptr;
+
+		/// Type & field index of `lea` and `lfa` instructions.
+		const Type*         BaseType   = nullptr;
+		unsigned            FieldIndex = 0;
+
+		std::vector<Value*> Operands;
+
+		bool operator==(const GVNExpression& other) const
+		{
+			return Opcode == other.Opcode
+				&& ResultType == other.ResultType
+				&& BaseType == other.BaseType
+				&& FieldIndex == other.FieldIndex
+				&& Operands == other.Operands;
+		}
+
+		/// Build the expression for the given instruction, returning false if it can't be
+		/// value numbered. 'result' is set to the value that the instruction defines.
+		static bool Build(Function* fn, Instruction* insn, GVNExpression* expr, Value** result);
+	};
+
+	struct GVNExpressionHash
+	{
+		size_t operator()(const GVNExpression& expr) const;
+	};
+
+	class GVN : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(GVN, gvn, "[Generic] Global value numbering, removing redundant computations & loads");
+
+/*********************************************************************************************************************/
@@ -0,0 +1,339 @@
+/**
+ * @file inliner.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in inliner.h
+ */
+
+/* Internal Project Includes */
+#include "inliner.h"
+#include "call-graph.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "loop-info.h"
+#include "mem2reg.h"
+#include "module.h"
+#include "options.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// What a call costs (in instructions) that inlining it saves - the `bl`, the
+/// prologue & epilogue and getting the return value back - not counting the
+/// arguments, which cost one more each.
+static constexpr size_t kCallOverhead = 4;
+
+/// Bonus for each constant argument, since it's likely to fold something in
+/// the callee (a comparison, a loop bound, a multiply...).
+static constexpr size_t kConstantArgumentBonus = 5;
+
+/// The threshold is multiplied by this for functions declared `inline`.
+static constexpr size_t kInlineHintFactor = 3;
+
+/// Each level of loop depth that a call is at raises the threshold by half
+/// as much again, up to this many levels.
+static constexpr size_t kMaxLoopDepthBonus = 3;
+
+/// Callers bigger than this (in instructions) only have calls inlined that
+/// don't make the module any bigger, or are `always_inline`.
+static constexpr size_t kMaxCallerSize = 2000;
+
+/*********************************************************************************************************************/
+
+static size_t GetFunctionSize(Function* fn)
+{
+	size_t size = 0;
+
+	for (BasicBlock& bb : fn->blocks()) {
+		for (Instruction& insn : bb) {
+			if (insn.GetOpcode() != HLIR::Phi)
+				size++;
+		}
+	}
+
+	return size;
+}
+
+/*********************************************************************************************************************/
+
+class FunctionInliner
+{
+public:
+	FunctionInliner(Module* mod, const PassRunInformation& info)
+		: m_Module(mod), m_Info(info), m_Threshold(Options::GetInlineThreshold()), m_CallGraph(mod) { }
+
+	/// Inline what should be inlined in every function in the module, bottom up.
+	void Run();
+
+private:
+	/// Inline what should be inlined in 'caller'.
+	void InlineCallsIn(Function* caller);
+
+	/// Return true if the call can be inlined at all (never mind if it should be).
+	bool IsInlinable(Function* caller, CallInsn* call) const;
+
+	/// Return true if the call at the given loop depth should be inlined.
+	bool ShouldInline(Function* caller, CallInsn* call, size_t loopDepth) const;
+
+	/// Replace 'call' with a copy of the body of the function being called.
+	void InlineCall(Function* caller, CallInsn* call);
+
+private:
+	Module*                   m_Module;
+	const PassRunInformation& m_Info;
+	size_t                    m_Threshold;
+
+	/// Taken before anything is inlined. Functions that can end up calling
+	/// themselves (through any number of other functions) are never inlined.
+	const CallGraph           m_CallGraph;
+
+	/// Number of calls to each function. This changes as calls are inlined (the
+	/// calls in an inlined body are copied, and the call itself goes away).
+	std::unordered_map<Function*, size_t> m_CountCallSites;
+	std::unordered_set<Function*>         m_AddressTaken;
+};
+
+/*********************************************************************************************************************/
+
+bool FunctionInliner::IsInlinable(Function* caller, CallInsn* call) const
+{
+	Function* callee = value_cast<Function>(call->GetFunction());
+
+	if (!callee || callee == caller || !callee->HasBody() || m_CallGraph.IsRecursive(callee))
+		return false;
+
+	if (callee->GetInlineHint() == InlineHint::NoInline)
+		return false;
+
+	if (call->GetCountArguments() != callee->GetCountParameters() || callee->GetReturnType()->IsStruct())
+		return false;
+
+	for (size_t i = 0; i < callee->GetCountParameters(); ++i) {
+		if (callee->GetParameter(i)->GetType()->IsStruct())
+			return false;
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool FunctionInliner::ShouldInline(Function* caller, CallInsn* call, size_t loopDepth) const
+{
+	Function* callee = value_cast<Function>(call->GetFunction());
+
+	if (callee->GetInlineHint() == InlineHint::AlwaysInline)
+		return true;
+
+	// With no other calls left the function is removed once this one is inlined,
+	// so the body is only moved rather than copied.
+	if (callee->HasInternalLinkage() && !m_AddressTaken.count(callee)) {
+		auto it = m_CountCallSites.find(callee);
+
+		if (it != m_CountCallSites.end() && it->second == 1)
+			return true;
+	}
+
+	if (m_Threshold == 0 || GetFunctionSize(caller) > kMaxCallerSize)
+		return false;
+
+	size_t threshold = m_Threshold;
+
+	if (callee->GetInlineHint() == InlineHint::Inline)
+		threshold *= kInlineHintFactor;
+
+	threshold += threshold * std::min(loopDepth, kMaxLoopDepthBonus) / 2;
+
+	size_t saved = kCallOverhead + call->GetCountArguments();
+
+	for (size_t i = 0; i < call->GetCountArguments(); ++i) {
+		if (value_isa<ConstantInt>(call->GetOperand(call->GetStartingArgumentIndex() + i)))
+			saved += kConstantArgumentBonus;
+	}
+
+	const size_t size = GetFunctionSize(callee);
+	return size <= saved || size - saved <= threshold;
+}
+
+/*********************************************************************************************************************/
+
+void FunctionInliner::InlineCall(Function* caller, CallInsn* call)
+{
+	Function* callee = value_cast<Function>(call->GetFunction());
+
+	BasicBlock* bb = call->GetParent();
+	BasicBlock* head = caller->GetHeadBlock();
+
+	// Everything after the call is where the copy of the body returns to.
+	BasicBlock* continuation = IR::SplitBlockAfter(caller, call);
+
+	IR::ValueMap map;
+
+	for (size_t i = 0; i < callee->GetCountParameters(); ++i) {
+		map[callee->GetParameter(i)] = call->GetOperand(call->GetStartingArgumentIndex() + i);
+	}
+
+	std::vector<BasicBlock*> blocks;
+
+	for (BasicBlock& calleeBB : callee->blocks()) {
+		blocks.push_back(&calleeBB);
+	}
+
+	const std::vector<BasicBlock*> clones = IR::CloneBlocks(blocks, map, caller, bb);
+
+	std::vector<std::pair<Value*, BasicBlock*>> returns;
+
+	for (BasicBlock* clone : clones) {
+		for (BasicBlock::iterator it = clone->begin(); it != clone->end();) {
+			Instruction* insn = &*it;
+			++it;
+
+			switch (insn->GetOpcode()) {
+			case HLIR::Return: {
+				RetInsn* ret = static_cast<RetInsn*>(insn);
+
+				if (ret->HasReturnValue())
+					returns.push_back({ ret->GetReturnValue(), clone });
+
+				IR::ReplaceInstructionAndDestroyOriginal(ret, Helix::CreateUnconditionalBranch(continuation));
+				break;
+			}
+
+			// Stack slots are only allocated in the head block.
+			case HLIR::StackAlloc:
+				IR::MoveBefore(&*head->begin(), insn);
+				break;
+
+			// The calls in the body are now made from here as well.
+			case HLIR::Call:
+				if (Function* fn = IR::GetCalledFunction(insn))
+					m_CountCallSites[fn]++;
+
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	Value* result = call->GetReturnValue();
+
+	bb->GetLast()->DeleteFromParent();
+	call->DeleteFromParent();
+
+	BasicBlock* entry = clones.front();
+	bb->Append(Helix::CreateUnconditionalBranch(entry));
+
+	m_CountCallSites[callee]--;
+
+	if (value_isa<VirtualRegisterName>(result) && !returns.empty()) {
+		if (returns.size() > 1) {
+			PhiInsn* phi = Helix::CreatePhi(result);
+
+			for (const auto& [value, from] : returns) {
+				phi->AddIncoming(value, from);
+			}
+
+			continuation->InsertBefore(continuation->begin(), phi);
+		}
+		else if (value_isa<VirtualRegisterName>(returns[0].first)) {
+			IR::ReplaceAllUsesWith(result, returns[0].first);
+		}
+		else {
+			continuation->InsertBefore(continuation->begin(), Helix::CreateSetInsn(result, returns[0].first));
+		}
+	}
+
+	// Splitting the block & the branches in & out of the body leave chains of
+	// blocks that only branch from one to the next.
+	IR::MergeBlockIntoPredecessor(caller, entry);
+	IR::MergeBlockIntoPredecessor(caller, continuation);
+}
+
+/*********************************************************************************************************************/
+
+void FunctionInliner::Run()
+{
+	for (Function* fn : m_Module->functions()) {
+		if (CallGraphNode* node = m_CallGraph.GetNode(fn)) {
+			m_CountCallSites[fn] = node->GetCallSites().size();
+
+			if (node->IsAddressTaken())
+				m_AddressTaken.insert(fn);
+		}
+	}
+
+	for (const std::vector<Function*>& scc : m_CallGraph.GetSCCs()) {
+		for (Function* caller : scc) {
+			this->InlineCallsIn(caller);
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+void FunctionInliner::InlineCallsIn(Function* caller)
+{
+	if (!caller->HasBody())
+		return;
+
+	// Find every call (& how deep in loops it is) before inlining anything, since
+	// inlining moves the code after each call into another block.
+	LoopInfo& loopInfo = m_Info.Analyses->Get<LoopInfo>(caller);
+
+	std::vector<std::pair<CallInsn*, size_t>> calls;
+
+	for (BasicBlock& bb : caller->blocks()) {
+		const Loop* loop = loopInfo.GetLoopFor(&bb);
+
+		for (Instruction& insn : bb) {
+			if (insn.GetOpcode() != HLIR::Call)
+				continue;
+
+			CallInsn* call = static_cast<CallInsn*>(&insn);
+
+			if (this->IsInlinable(caller, call))
+				calls.push_back({ call, loop ? loop->GetDepth() : 0 });
+		}
+	}
+
+	bool changed = false;
+
+	for (const auto& [call, loopDepth] : calls) {
+		if (!this->ShouldInline(caller, call, loopDepth))
+			continue;
+
+		this->InlineCall(caller, call);
+		changed = true;
+	}
+
+	if (!changed)
+		return;
+
+	// Anything that the callee kept on the stack may be promotable now that it's
+	// in the caller (e.g. a local whose address was only passed to another call
+	// that has been inlined too).
+	m_Info.Analyses->Invalidate(caller);
+
+	Mem2Reg mem2reg;
+	mem2reg.Execute(caller, m_Info);
+}
+
+/*********************************************************************************************************************/
+
+void Inliner::Execute(Module* mod, const PassRunInformation& info)
+{
+	FunctionInliner inliner(mod, info);
+	inliner.Run();
+}
+
+/*********************************************************************************************************************/
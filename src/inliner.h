@@ -0,0 +1,43 @@
+/**
+ * @file inliner.h
+ * @author Barney Wilks
+ *
+ * Function inlining.
+ *
+ * Every call pays for moving its arguments into r0-r3, the `bl` itself and
+ * the callee's prologue & epilogue. For small functions that can be more
+ * than the body, and it hides the body from the optimiser at the call site
+ * (e.g. a constant argument that would fold a comparison in the callee).
+ *
+ * The inliner copies the body of the callee into the caller in place of
+ * the call, with the parameters replaced by the arguments and each `ret`
+ * branching to the code after the call. Functions are visited bottom up
+ * (callees before their callers), so a function has already had its own
+ * calls inlined by the time it is inlined somewhere else.
+ *
+ * Whether a call is inlined is decided by comparing the size of the callee
+ * (less the cost of the call itself, and a bonus for each constant argument)
+ * against --inline-threshold, which is raised for calls inside loops & for
+ * functions declared `inline`. The last call to an internal function is
+ * always inlined, since the function is removed afterwards. `always_inline`
+ * & `noinline` are always honoured (other than for recursive calls).
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class Inliner : public Pass
+	{
+	public:
+		void Execute(Module* mod, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(Inliner, inliner, "[Generic] Inline calls to small functions");
+
+/*********************************************************************************************************************/
@@ -37,6 +37,13 @@ SetInsn* Helix::CreateSetInsn(Value* reg, Value* newValue)
 
 /*********************************************************************************************************************/
 
+PhiInsn* Helix::CreatePhi(Value* result)
+{
+	return new PhiInsn(result);
+}
+
+/*********************************************************************************************************************/
+
 CastInsn* Helix::CreateSExt(Value* input, Value* output)
 {
 	return new CastInsn(HLIR::SExt, input, output);
@@ -188,6 +195,22 @@ CallInsn::CallInsn(Function* function, Value* ret, const ParameterList& params)
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void CallInsn::RemoveArgument(size_t index)
+{
+	helix_assert(index < this->GetCountArguments(), "call argument index out of range");
+
+	// Shuffle the arguments after the removed one down (going through SetOperand
+	// so that the use lists, which record operand indices, are kept up to date).
+	for (size_t i = this->GetStartingArgumentIndex() + index; i + 1 < m_Operands.size(); ++i) {
+		this->SetOperand(i, this->GetOperand(i + 1));
+	}
+
+	this->SetOperand(m_Operands.size() - 1, nullptr);
+	m_Operands.resize(m_Operands.size() - 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 ConditionalBranchInsn::ConditionalBranchInsn(BasicBlock* trueBB, BasicBlock* falseBB, Value* cond)
 	: Instruction(HLIR::ConditionalBranch, 3)
 {
@@ -252,6 +275,66 @@ CompareInsn::CompareInsn(HLIR::Opcode cmpOpcode, Value* lhs, Value* rhs, Value*
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void PhiInsn::SetIncomingBlock(size_t index, BasicBlock* bb)
+{
+	this->SetOperand(2 + index * 2, bb->GetBranchTarget());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PhiInsn::AddIncoming(Value* value, BasicBlock* bb)
+{
+	const size_t index = m_Operands.size();
+
+	m_Operands.resize(index + 2, nullptr);
+
+	this->SetOperand(index, value);
+	this->SetOperand(index + 1, bb->GetBranchTarget());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PhiInsn::RemoveIncoming(size_t index)
+{
+	const size_t count = this->GetCountIncoming();
+
+	helix_assert(index < count, "phi incoming index out of range");
+
+	// Shuffle every pair after the removed one down (going through SetOperand
+	// so that the use lists, which record operand indices, are kept up to date).
+	for (size_t i = index; i + 1 < count; ++i) {
+		this->SetOperand(1 + i * 2, this->GetOperand(1 + (i + 1) * 2));
+		this->SetOperand(2 + i * 2, this->GetOperand(2 + (i + 1) * 2));
+	}
+
+	this->SetOperand(m_Operands.size() - 2, nullptr);
+	this->SetOperand(m_Operands.size() - 1, nullptr);
+
+	m_Operands.resize(m_Operands.size() - 2);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+size_t PhiInsn::GetIncomingIndex(const BasicBlock* bb) const
+{
+	for (size_t i = 0; i < this->GetCountIncoming(); ++i) {
+		if (this->GetIncomingBlock(i) == bb)
+			return i;
+	}
+
+	return SIZE_MAX;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Value* PhiInsn::GetIncomingValueForBlock(const BasicBlock* bb) const
+{
+	const size_t index = this->GetIncomingIndex(bb);
+	return index == SIZE_MAX ? nullptr : this->GetIncomingValue(index);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 RetInsn::RetInsn(Value* value)
 	: Instruction(HLIR::Return, 1)
 {
@@ -362,6 +445,15 @@ Instruction::OperandFlags CallInsn::GetOperandFlags(size_t i) const
 	}
 }
 
+Instruction::OperandFlags PhiInsn::GetOperandFlags(size_t i) const
+{
+	if (i >= this->GetCountOperands()) {
+		return Instruction::OP_NONE;
+	}
+
+	return i == 0 ? Instruction::OP_WRITE : Instruction::OP_READ;
+}
+
 Instruction::OperandFlags RetInsn::GetOperandFlags(size_t i) const
 {
 	if (i >= this->GetCountOperands()) {
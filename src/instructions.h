@@ -217,6 +217,9 @@ namespace Helix
 		size_t GetStartingArgumentIndex() const { return 2; }
 		size_t GetCountArguments() const { return GetCountOperands() - 2; }
 
+		/// Remove the argument at the given index (counting from the first argument).
+		void RemoveArgument(size_t index);
+
 		virtual OperandFlags GetOperandFlags(size_t index) const override;
 	};
 
@@ -340,6 +343,46 @@ namespace Helix
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+	/// Selects a value based on the predecessor block that control came from.
+	///
+	/// Operands are the result, followed by a (value, block) pair for every
+	/// incoming edge. Phis must come before any other instruction in a block,
+	/// and (when the IR is in SSA form) have one incoming value for every
+	/// predecessor of the block.
+	class PhiInsn : public Instruction
+	{
+	public:
+		PhiInsn(Value* result)
+			: Instruction(HLIR::Phi, 1)
+		{
+			this->SetOperand(0, result);
+		}
+
+		Value* GetResult() const { return this->GetOperand(0); }
+
+		size_t GetCountIncoming() const { return (this->GetCountOperands() - 1) / 2; }
+
+		Value* GetIncomingValue(size_t index) const { return this->GetOperand(1 + index * 2); }
+		BasicBlock* GetIncomingBlock(size_t index) const { return value_cast<BlockBranchTarget>(this->GetOperand(2 + index * 2))->GetParent(); }
+
+		void SetIncomingValue(size_t index, Value* value) { this->SetOperand(1 + index * 2, value); }
+		void SetIncomingBlock(size_t index, BasicBlock* bb);
+
+		void AddIncoming(Value* value, BasicBlock* bb);
+		void RemoveIncoming(size_t index);
+
+		/// Get the index of the incoming value for the given block, or SIZE_MAX
+		/// if there isn't one.
+		size_t GetIncomingIndex(const BasicBlock* bb) const;
+
+		/// Get the value that comes from the given block, or null if there isn't one.
+		Value* GetIncomingValueForBlock(const BasicBlock* bb) const;
+
+		virtual OperandFlags GetOperandFlags(size_t index) const override;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 	class TruncInsn : public Instruction
 	{
 	public:
@@ -362,6 +405,10 @@ namespace Helix
 
 	SetInsn* CreateSetInsn(Value* reg, Value* newValue);
 
+	/// Create a phi that writes to 'result', with no incoming values (add them
+	/// with PhiInsn::AddIncoming).
+	PhiInsn* CreatePhi(Value* result);
+
 	/// Create a comparison instruction that compares 'lhs' and 'rhs' and stores the result to the given
 	/// 'result' register.
 	CompareInsn* CreateCompare(HLIR::Opcode cmpOpcode, Value* lhs, Value* rhs, Value* result);
@@ -0,0 +1,117 @@
+/**
+ * @file ipcp.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in ipcp.h
+ */
+
+/* Internal Project Includes */
+#include "ipcp.h"
+#include "call-graph.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "module.h"
+
+/* C++ Standard Library Includes */
+#include <utility>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+static bool IsConstant(Value* value)
+{
+	return value_isa<ConstantInt>(value) || value_isa<GlobalVariable>(value) || value_isa<Function>(value);
+}
+
+/*********************************************************************************************************************/
+
+/// If every call passes the same constant as the parameter at 'index' return it,
+/// otherwise null. Recursive calls passing the parameter itself don't count.
+static Value* GetConstantArgument(Function* fn, const std::vector<CallInsn*>& calls, size_t index)
+{
+	Value* param = fn->GetParameter(index);
+	Value* constant = nullptr;
+
+	for (CallInsn* call : calls) {
+		Value* arg = call->GetOperand(call->GetStartingArgumentIndex() + index);
+
+		if (arg == param)
+			continue;
+
+		if (!IsConstant(arg) || (constant && !IR::IsSameValue(constant, arg)))
+			return nullptr;
+
+		constant = arg;
+	}
+
+	return constant;
+}
+
+/*********************************************************************************************************************/
+
+void IPCP::Execute(Module* mod, const PassRunInformation&)
+{
+	const CallGraph callGraph(mod);
+
+	// Internal functions that are only ever called directly, with their calls.
+	std::vector<std::pair<Function*, std::vector<CallInsn*>>> candidates;
+
+	for (Function* fn : mod->functions()) {
+		if (!fn->HasBody() || !fn->HasInternalLinkage())
+			continue;
+
+		CallGraphNode* node = callGraph.GetNode(fn);
+
+		if (!node || node->IsAddressTaken() || node->GetCallSites().empty())
+			continue;
+
+		bool valid = true;
+
+		for (CallInsn* call : node->GetCallSites()) {
+			valid &= call->GetCountArguments() == fn->GetCountParameters();
+		}
+
+		if (valid)
+			candidates.push_back({ fn, node->GetCallSites() });
+	}
+
+	// Replacing a parameter with a constant can make the arguments that function
+	// passes on constant as well, so keep going until nothing changes. Arguments
+	// are only ever replaced (never added), so this finishes.
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+
+		for (const auto& [fn, calls] : candidates) {
+			for (size_t i = 0; i < fn->GetCountParameters(); ++i) {
+				Value* param = fn->GetParameter(i);
+
+				if (param->GetCountUses() == 0)
+					continue;
+
+				if (Value* constant = GetConstantArgument(fn, calls, i)) {
+					IR::ReplaceAllUsesWith(param, constant);
+					changed = true;
+				}
+			}
+		}
+	}
+
+	for (const auto& [fn, calls] : candidates) {
+		for (size_t i = fn->GetCountParameters(); i-- > 0;) {
+			if (fn->GetParameter(i)->GetCountUses() > 0)
+				continue;
+
+			fn->RemoveParameter(i);
+
+			for (CallInsn* call : calls) {
+				call->RemoveArgument(i);
+			}
+		}
+	}
+}
+
+/*********************************************************************************************************************/
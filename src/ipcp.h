@@ -0,0 +1,35 @@
+/**
+ * @file ipcp.h
+ * @author Barney Wilks
+ *
+ * Interprocedural constant propagation & dead argument elimination.
+ *
+ * Only internal functions whose address is never taken are changed, since
+ * every call to them is known. If every call passes the same constant for a
+ * parameter (or passes the parameter straight back in, for recursive calls)
+ * the parameter is replaced by that constant in the body of the function.
+ *
+ * Parameters that are never read afterwards (including those that were just
+ * replaced by a constant) are then removed from the function, its type & the
+ * argument list of every call, so nothing has to be put in a register for
+ * them at the call sites any more.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class IPCP : public Pass
+	{
+	public:
+		void Execute(Module* mod, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(IPCP, ipcp, "[Generic] Propagate constant arguments into internal functions & remove unused parameters");
+
+/*********************************************************************************************************************/
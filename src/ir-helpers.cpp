@@ -7,8 +7,11 @@
 
 /* Internal Project Includes */
 #include "ir-helpers.h"
+#include "function.h"
 
 /* Standard Library Includes */
+#include <algorithm>
+#include <unordered_set>
 #include <vector>
 
 using namespace Helix;
@@ -116,6 +119,438 @@ IR::InsertBefore(Instruction* a, Instruction* b)
 
 /******************************************************************************/
 
+void
+IR::MoveBefore(Instruction* where, Instruction* insn)
+{
+	BasicBlock* from = insn->GetParent();
+	from->Remove(from->Where(insn));
+
+	IR::InsertBefore(where, insn);
+}
+
+/******************************************************************************/
+
+BasicBlock::iterator
+IR::GetFirstNonPhi(BasicBlock* bb)
+{
+	BasicBlock::iterator it = bb->begin();
+
+	while (it != bb->end() && it->GetOpcode() == HLIR::Phi)
+		++it;
+
+	return it;
+}
+
+/******************************************************************************/
+
+BasicBlock*
+IR::SplitEdge(Function* fn, BasicBlock* pred, BasicBlock* succ)
+{
+	BasicBlock* split = BasicBlock::Create();
+	split->Append(Helix::CreateUnconditionalBranch(succ));
+
+	fn->InsertAfter(fn->Where(pred), split);
+
+	IR::RetargetBranch(pred->GetLast(), succ, split);
+
+	for (Instruction& insn : *succ) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+		const size_t index = phi->GetIncomingIndex(pred);
+
+		if (index != SIZE_MAX)
+			phi->SetIncomingBlock(index, split);
+	}
+
+	return split;
+}
+
+/******************************************************************************/
+
+void
+IR::RetargetBranch(Instruction* insn, BasicBlock* from, BasicBlock* to)
+{
+	for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+		if (insn->GetOperand(i) == from->GetBranchTarget())
+			insn->SetOperand(i, to->GetBranchTarget());
+	}
+}
+
+/******************************************************************************/
+
+VirtualRegisterName*
+IR::DemoteToStackSlot(Function* fn, Value* value, Instruction* def)
+{
+	BasicBlock* head = fn->GetHeadBlock();
+
+	VirtualRegisterName* slot = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+	head->InsertBefore(head->begin(), Helix::CreateStackAlloc(slot, value->GetType()));
+
+	if (def->GetOpcode() == HLIR::Phi)
+		IR::InsertBefore(&*IR::GetFirstNonPhi(def->GetParent()), Helix::CreateStore(value, slot));
+	else
+		IR::InsertAfter(def, Helix::CreateStore(value, slot));
+
+	return slot;
+}
+
+/******************************************************************************/
+
+Instruction*
+IR::CloneInstruction(const Instruction* insn)
+{
+	const HLIR::Opcode opcode = (HLIR::Opcode) insn->GetOpcode();
+	Instruction* clone = nullptr;
+
+	if (HLIR::IsBinaryOp(opcode)) {
+		clone = new BinOpInsn(opcode, insn->GetOperand(0), insn->GetOperand(1), insn->GetOperand(2));
+	} else if (HLIR::IsCompare(opcode)) {
+		clone = new CompareInsn(opcode, insn->GetOperand(0), insn->GetOperand(1), insn->GetOperand(2));
+	} else if (opcode == HLIR::Trunc) {
+		clone = new TruncInsn(insn->GetOperand(0), insn->GetOperand(1));
+	} else if (HLIR::IsCast(opcode)) {
+		clone = new CastInsn(opcode, insn->GetOperand(0), insn->GetOperand(1));
+	} else {
+		switch (opcode) {
+		case HLIR::Load:
+			clone = new LoadInsn(insn->GetOperand(0), insn->GetOperand(1));
+			break;
+
+		case HLIR::Store:
+			clone = new StoreInsn(insn->GetOperand(0), insn->GetOperand(1));
+			break;
+
+		case HLIR::StackAlloc:
+			clone = new StackAllocInsn(insn->GetOperand(0), static_cast<const StackAllocInsn*>(insn)->GetAllocatedType());
+			break;
+
+		case HLIR::Set:
+			clone = new SetInsn(insn->GetOperand(0), insn->GetOperand(1));
+			break;
+
+		case HLIR::LoadElementAddress: {
+			const LoadEffectiveAddressInsn* lea = static_cast<const LoadEffectiveAddressInsn*>(insn);
+			clone = new LoadEffectiveAddressInsn(lea->GetBaseType(), lea->GetInputPtr(), lea->GetIndex(), lea->GetOutputPtr());
+			break;
+		}
+
+		case HLIR::LoadFieldAddress: {
+			const LoadFieldAddressInsn* lfa = static_cast<const LoadFieldAddressInsn*>(insn);
+			clone = new LoadFieldAddressInsn(static_cast<const StructType*>(lfa->GetBaseType()), lfa->GetInputPtr(),
+			                                 lfa->GetFieldIndex(), lfa->GetOutputPtr());
+			break;
+		}
+
+		case HLIR::Phi: {
+			const PhiInsn* phi = static_cast<const PhiInsn*>(insn);
+			PhiInsn* clonedPhi = new PhiInsn(phi->GetResult());
+
+			for (size_t i = 0; i < phi->GetCountIncoming(); ++i)
+				clonedPhi->AddIncoming(phi->GetIncomingValue(i), phi->GetIncomingBlock(i));
+
+			clone = clonedPhi;
+			break;
+		}
+
+		case HLIR::ConditionalBranch: {
+			const ConditionalBranchInsn* cbr = static_cast<const ConditionalBranchInsn*>(insn);
+			clone = new ConditionalBranchInsn(cbr->GetTrueBB(), cbr->GetFalseBB(), cbr->GetCond());
+			break;
+		}
+
+		case HLIR::UnconditionalBranch:
+			clone = new UnconditionalBranchInsn(static_cast<const UnconditionalBranchInsn*>(insn)->GetBB());
+			break;
+
+		case HLIR::Return: {
+			const RetInsn* ret = static_cast<const RetInsn*>(insn);
+			clone = ret->HasReturnValue() ? new RetInsn(ret->GetReturnValue()) : new RetInsn();
+			break;
+		}
+
+		case HLIR::Call: {
+			const CallInsn* call = static_cast<const CallInsn*>(insn);
+			ParameterList params;
+
+			for (size_t i = call->GetStartingArgumentIndex(); i < call->GetCountOperands(); ++i)
+				params.push_back(call->GetOperand(i));
+
+			clone = new CallInsn(value_cast<Function>(call->GetFunction()), call->GetReturnValue(), params);
+			break;
+		}
+
+		default:
+			helix_unreachable("can't clone instruction");
+		}
+	}
+
+	clone->SetComment(insn->GetComment());
+	return clone;
+}
+
+/******************************************************************************/
+
+void
+IR::RemapOperands(Instruction* insn, const ValueMap& map)
+{
+	for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+		auto it = map.find(insn->GetOperand(i));
+
+		if (it != map.end())
+			insn->SetOperand(i, it->second);
+	}
+}
+
+/******************************************************************************/
+
+std::vector<BasicBlock*>
+IR::CloneBlocks(const std::vector<BasicBlock*>& blocks, ValueMap& map, Function* fn, BasicBlock* where)
+{
+	std::vector<BasicBlock*> clones;
+	clones.reserve(blocks.size());
+
+	for (BasicBlock* bb : blocks) {
+		BasicBlock* clone = BasicBlock::Create();
+
+		fn->InsertAfter(fn->Where(where), clone);
+		map[bb->GetBranchTarget()] = clone->GetBranchTarget();
+
+		clones.push_back(clone);
+		where = clone;
+	}
+
+	// Every value gets a new register before cloning anything, since values can be
+	// used (by phis) before they are defined.
+	for (BasicBlock* bb : blocks) {
+		for (Instruction& insn : *bb) {
+			for (size_t i = 0; i < insn.GetCountOperands(); ++i) {
+				Value* operand = insn.GetOperand(i);
+
+				if (insn.OperandHasFlags(i, Instruction::OP_WRITE) && value_isa<VirtualRegisterName>(operand))
+					map[operand] = VirtualRegisterName::Create(operand->GetType());
+			}
+		}
+	}
+
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		for (Instruction& insn : *blocks[i]) {
+			Instruction* copy = IR::CloneInstruction(&insn);
+
+			IR::RemapOperands(copy, map);
+			clones[i]->Append(copy);
+		}
+	}
+
+	return clones;
+}
+
+/******************************************************************************/
+
+void
+IR::DeleteBlocks(Function* fn, const std::vector<BasicBlock*>& blocks)
+{
+	// Destroy all the instructions first, so that nothing is still branching to
+	// a block by the time it gets destroyed.
+	for (BasicBlock* bb : blocks) {
+		for (BasicBlock::iterator it = bb->begin(); it != bb->end();) {
+			Instruction* insn = &(*it);
+			++it;
+
+			IR::DestroyInstruction(insn);
+		}
+	}
+
+	for (BasicBlock* bb : blocks) {
+		fn->Remove(fn->Where(bb));
+		BasicBlock::Destroy(bb);
+	}
+}
+
+/******************************************************************************/
+
+bool
+IR::MergeBlockIntoPredecessor(Function* fn, BasicBlock* bb)
+{
+	if (bb == fn->GetHeadBlock())
+		return false;
+
+	const std::vector<BasicBlock*> preds = IR::GetPredecessors(bb);
+
+	if (preds.size() != 1 || preds[0] == bb || preds[0]->GetLast()->GetOpcode() != HLIR::UnconditionalBranch)
+		return false;
+
+	// The tail block (with the return) has to stay at the end of the function,
+	// which the backend relies on.
+	if (bb == fn->GetTailBlock() && preds[0]->get_next() != bb)
+		return false;
+
+	BasicBlock* pred = preds[0];
+	Instruction* branch = pred->GetLast();
+
+	// With only one way in, every phi has to have the same value.
+	while (bb->begin()->GetOpcode() == HLIR::Phi) {
+		PhiInsn* phi = static_cast<PhiInsn*>(&*bb->begin());
+
+		IR::ReplaceAllUsesWith(phi->GetResult(), phi->GetIncomingValue(0));
+		phi->DeleteFromParent();
+	}
+
+	while (!bb->IsEmpty()) {
+		IR::MoveBefore(branch, &*bb->begin());
+	}
+
+	branch->DeleteFromParent();
+
+	for (BasicBlock* succ : pred->GetSuccessors()) {
+		for (Instruction& insn : *succ) {
+			if (insn.GetOpcode() != HLIR::Phi)
+				break;
+
+			PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+			const size_t index = phi->GetIncomingIndex(bb);
+
+			if (index != SIZE_MAX)
+				phi->SetIncomingBlock(index, pred);
+		}
+	}
+
+	fn->Remove(fn->Where(bb));
+	BasicBlock::Destroy(bb);
+
+	return true;
+}
+
+/******************************************************************************/
+
+BasicBlock*
+IR::SplitBlockAfter(Function* fn, Instruction* insn)
+{
+	BasicBlock* bb = insn->GetParent();
+	BasicBlock* tail = BasicBlock::Create();
+
+	fn->InsertAfter(fn->Where(bb), tail);
+
+	for (BasicBlock::iterator it = IR::GetNext(insn); it != bb->end();) {
+		Instruction* next = &*it;
+		++it;
+
+		bb->Remove(bb->Where(next));
+		tail->Append(next);
+	}
+
+	bb->Append(Helix::CreateUnconditionalBranch(tail));
+
+	for (BasicBlock* succ : tail->GetSuccessors()) {
+		for (Instruction& phi : *succ) {
+			if (phi.GetOpcode() != HLIR::Phi)
+				break;
+
+			PhiInsn* phiInsn = static_cast<PhiInsn*>(&phi);
+			const size_t index = phiInsn->GetIncomingIndex(bb);
+
+			if (index != SIZE_MAX)
+				phiInsn->SetIncomingBlock(index, tail);
+		}
+	}
+
+	return tail;
+}
+
+/******************************************************************************/
+
+void
+IR::RemoveIncomingFrom(BasicBlock* bb, BasicBlock* pred)
+{
+	for (BasicBlock::iterator it = bb->begin(); it != bb->end() && it->GetOpcode() == HLIR::Phi;) {
+		PhiInsn* phi = static_cast<PhiInsn*>(&*it);
+		++it;
+
+		const size_t index = phi->GetIncomingIndex(pred);
+
+		if (index == SIZE_MAX)
+			continue;
+
+		phi->RemoveIncoming(index);
+
+		// Only one way into the block, so the phi isn't choosing anything.
+		if (phi->GetCountIncoming() == 1 && phi->GetIncomingValue(0) != phi->GetResult()) {
+			IR::ReplaceAllUsesWith(phi->GetResult(), phi->GetIncomingValue(0));
+			phi->DeleteFromParent();
+		}
+	}
+}
+
+/******************************************************************************/
+
+bool
+IR::RemoveUnreachableBlocks(Function* fn)
+{
+	std::unordered_set<BasicBlock*> reachable;
+	std::vector<BasicBlock*>        worklist = { fn->GetHeadBlock() };
+
+	reachable.insert(fn->GetHeadBlock());
+
+	while (!worklist.empty()) {
+		BasicBlock* bb = worklist.back();
+		worklist.pop_back();
+
+		for (BasicBlock* succ : bb->GetSuccessors()) {
+			if (reachable.insert(succ).second)
+				worklist.push_back(succ);
+		}
+	}
+
+	bool changed = false;
+
+	// The backend expects the `ret` to be in the last block, even in functions that
+	// never get there (because they loop forever), so that block is kept with just
+	// the `ret` in it.
+	BasicBlock* tail = fn->GetTailBlock();
+
+	if (!reachable.count(tail) && tail->GetLast()->GetOpcode() == HLIR::Return) {
+		RetInsn* ret = static_cast<RetInsn*>(tail->GetLast());
+		reachable.insert(tail);
+
+		if (&*tail->begin() != ret || (ret->HasReturnValue() && !value_isa<UndefValue>(ret->GetReturnValue()))) {
+			Value* undef = ret->HasReturnValue() ? UndefValue::Get(ret->GetReturnValue()->GetType()) : nullptr;
+
+			for (BasicBlock::iterator it = tail->begin(); it != tail->end();) {
+				Instruction* insn = &*it;
+				++it;
+
+				IR::DestroyInstruction(insn);
+			}
+
+			tail->Append(undef ? Helix::CreateRet(undef) : Helix::CreateRet());
+			changed = true;
+		}
+	}
+
+	std::vector<BasicBlock*> deadBlocks;
+
+	for (BasicBlock& bb : fn->blocks()) {
+		if (!reachable.count(&bb))
+			deadBlocks.push_back(&bb);
+	}
+
+	if (deadBlocks.empty())
+		return changed;
+
+	for (BasicBlock* bb : deadBlocks) {
+		for (BasicBlock* succ : bb->GetSuccessors()) {
+			if (reachable.count(succ))
+				IR::RemoveIncomingFrom(succ, bb);
+		}
+	}
+
+	IR::DeleteBlocks(fn, deadBlocks);
+	return true;
+}
+
+/******************************************************************************/
+
 bool
 IR::TryGetSingleUser(Instruction* base, Value* v, Use* outUse)
 {
@@ -188,6 +623,125 @@ IR::GetCountWriteUsers(Value* v)
 
 /******************************************************************************/
 
+Instruction*
+IR::GetSingleDefinition(Value* v)
+{
+	Instruction* def = nullptr;
+
+	for (const Use& use : v->uses()) {
+		Instruction* insn = use.GetInstruction();
+
+		if (!insn->OperandHasFlags(use.GetOperandIndex(), Instruction::OP_WRITE))
+			continue;
+
+		if (def)
+			return nullptr;
+
+		def = insn;
+	}
+
+	return def;
+}
+
+/******************************************************************************/
+
+bool
+IR::IsSingleAssignment(Function* fn, Value* v)
+{
+	if (value_isa<ConstantInt>(v) || value_isa<GlobalVariable>(v)
+		|| value_isa<Function>(v) || value_isa<UndefValue>(v)) {
+		return true;
+	}
+
+	if (!value_isa<VirtualRegisterName>(v))
+		return false;
+
+	const size_t nWrites = IR::GetCountWriteUsers(v);
+
+	// Parameters are defined on entry to the function, so any write redefines them.
+	if (std::find(fn->params_begin(), fn->params_end(), v) != fn->params_end())
+		return nWrites == 0;
+
+	return nWrites <= 1;
+}
+
+/******************************************************************************/
+
+bool
+IR::IsSameValue(Value* a, Value* b)
+{
+	if (a == b)
+		return true;
+
+	ConstantInt* intA = value_cast<ConstantInt>(a);
+	ConstantInt* intB = value_cast<ConstantInt>(b);
+
+	return intA && intB && intA->GetType() == intB->GetType() && intA->GetIntegralValue() == intB->GetIntegralValue();
+}
+
+/******************************************************************************/
+
+bool
+IR::IsPure(const Instruction* insn)
+{
+	const HLIR::Opcode opcode = (HLIR::Opcode) insn->GetOpcode();
+
+	if (HLIR::IsBinaryOp(opcode) || HLIR::IsCompare(opcode) || HLIR::IsCast(opcode))
+		return true;
+
+	return opcode == HLIR::LoadElementAddress || opcode == HLIR::LoadFieldAddress;
+}
+
+/******************************************************************************/
+
+bool
+IR::IsSafeToSpeculate(const Instruction* insn)
+{
+	if (!IR::IsPure(insn))
+		return false;
+
+	switch (insn->GetOpcode()) {
+	case HLIR::IUDiv:
+	case HLIR::IURem:
+	case HLIR::ISDiv:
+	case HLIR::ISRem: {
+		const ConstantInt* divisor = value_cast<ConstantInt>(insn->GetOperand(1));
+
+		if (!divisor || divisor->GetIntegralValue() == 0)
+			return false;
+
+		// INT_MIN / -1 overflows.
+		const bool isSigned = insn->GetOpcode() == HLIR::ISDiv || insn->GetOpcode() == HLIR::ISRem;
+		return !isSigned || divisor->GetSignedIntegralValue() != -1;
+	}
+
+	default:
+		return true;
+	}
+}
+
+/******************************************************************************/
+
+Function*
+IR::GetCalledFunction(const Instruction* insn)
+{
+	if (insn->GetOpcode() != HLIR::Call)
+		return nullptr;
+
+	return value_cast<Function>(static_cast<const CallInsn*>(insn)->GetFunction());
+}
+
+/******************************************************************************/
+
+bool
+IR::IsRemovableCall(const Instruction* insn)
+{
+	Function* fn = IR::GetCalledFunction(insn);
+	return fn && fn->DoesNotWriteMemory() && fn->AlwaysReturns();
+}
+
+/******************************************************************************/
+
 std::vector<BasicBlock*>
 IR::GetPredecessors(BasicBlock* bb)
 {
@@ -198,6 +752,11 @@ IR::GetPredecessors(BasicBlock* bb)
 	for (const Use& use : val->uses()) {
 		Instruction* user = use.GetInstruction();
 
+		// Phis refer to the blocks that their incoming values come from, but
+		// don't branch to them.
+		if (user->GetOpcode() == HLIR::Phi)
+			continue;
+
 		preds.push_back(user->GetParent());
 	}
 
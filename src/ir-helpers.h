@@ -12,6 +12,9 @@
 #include "basic-block.h"
 #include "intrusive-list.h"
 
+/* C++ Standard Library Includes */
+#include <unordered_map>
+
 /******************************************************************************/
 
 namespace Helix::IR
@@ -51,6 +54,101 @@ namespace Helix::IR
 	 */
 	void InsertAfter(Instruction* a, Instruction* b);
 
+	/**
+	 * Move instruction 'insn' out of its current block, to just before 'where'
+	 * (which may be in a different block).
+	 */
+	void MoveBefore(Instruction* where, Instruction* insn);
+
+	/**
+	 * Get an iterator to the first instruction in 'bb' that isn't a phi (where
+	 * new instructions can be inserted at the start of the block).
+	 */
+	BasicBlock::iterator GetFirstNonPhi(BasicBlock* bb);
+
+	/**
+	 * Split the edge from 'pred' to 'succ' by inserting a new block (that just
+	 * branches to 'succ') between them, updating any phis in 'succ'. Returns
+	 * the new block.
+	 */
+	BasicBlock* SplitEdge(Function* fn, BasicBlock* pred, BasicBlock* succ);
+
+	/**
+	 * Make every branch in 'insn' to 'from' go to 'to' instead. Phis in either
+	 * block aren't updated.
+	 */
+	void RetargetBranch(Instruction* insn, BasicBlock* from, BasicBlock* to);
+
+	/**
+	 * Give 'value' (written by 'def') a stack slot in the head block of 'fn',
+	 * storing to it straight after it's written (after the last phi, if 'def'
+	 * is one). Returns the slot, which Mem2Reg can promote again once the code
+	 * reading it has been rewritten.
+	 */
+	VirtualRegisterName* DemoteToStackSlot(Function* fn, Value* value, Instruction* def);
+
+	/// Map from the values used by some code to the values that should be used
+	/// instead in a copy of it (see CloneInstruction & RemapOperands).
+	using ValueMap = std::unordered_map<Value*, Value*>;
+
+	/**
+	 * Create a copy of the given instruction with the same operands (& no parent
+	 * block).
+	 */
+	Instruction* CloneInstruction(const Instruction* insn);
+
+	/**
+	 * Replace every operand of 'insn' that has an entry in 'map' with the value
+	 * it maps to (blocks are remapped by mapping their branch targets).
+	 */
+	void RemapOperands(Instruction* insn, const ValueMap& map);
+
+	/**
+	 * Copy 'blocks' into 'fn' (in the same order, straight after 'where'). Each
+	 * block & every register written in them is mapped to its copy in 'map',
+	 * replacing anything that was there, while other entries (e.g. parameters
+	 * mapped to arguments) are used as they are. Returns the copies, in the
+	 * same order as 'blocks'.
+	 */
+	std::vector<BasicBlock*> CloneBlocks(const std::vector<BasicBlock*>& blocks, ValueMap& map,
+	                                     Function* fn, BasicBlock* where);
+
+	/**
+	 * Remove the given blocks from the function & destroy them, along with all
+	 * of their instructions. Nothing outside of these blocks may still branch
+	 * to them or use any of the values they define.
+	 */
+	void DeleteBlocks(Function* fn, const std::vector<BasicBlock*>& blocks);
+
+	/**
+	 * If 'bb' has a single predecessor that unconditionally branches to it, move
+	 * all of the instructions in 'bb' onto the end of the predecessor & delete
+	 * 'bb'. Returns true if the blocks were merged.
+	 */
+	bool MergeBlockIntoPredecessor(Function* fn, BasicBlock* bb);
+
+	/**
+	 * Split the block containing 'insn' in two, moving everything after 'insn'
+	 * into a new block (inserted straight after it) that the original block
+	 * then branches to. Phis in the successors are updated to come from the
+	 * new block. Returns the new block.
+	 */
+	BasicBlock* SplitBlockAfter(Function* fn, Instruction* insn);
+
+	/**
+	 * Remove the incoming values from 'pred' from the phis in 'bb', which 'pred'
+	 * doesn't branch to any more. Phis that are left with only one incoming value
+	 * are replaced by it.
+	 */
+	void RemoveIncomingFrom(BasicBlock* bb, BasicBlock* pred);
+
+	/**
+	 * Delete every block that can't be reached from the head block. The tail block
+	 * is always kept (with just a `ret` in it, if it's unreachable), since the
+	 * backend expects the `ret` to be there. Returns true if anything changed.
+	 */
+	bool RemoveUnreachableBlocks(Function* fn);
+
 	bool TryGetSingleUser(Instruction* base, Value* v, Use* outUse);
 
 	inline BasicBlock::iterator GetNext(Instruction* insn) {
@@ -64,6 +162,38 @@ namespace Helix::IR
 	size_t GetCountReadUsers(Value* v);
 	size_t GetCountWriteUsers(Value* v);
 
+	/// Return the only instruction that writes to 'v', or null if there are
+	/// none or more than one.
+	Instruction* GetSingleDefinition(Value* v);
+
+	/// Return true if 'v' always holds the same value wherever it can be read in
+	/// 'fn', that is it's a constant, global or function, or it's a register that
+	/// is written at most once (parameters must never be written).
+	bool IsSingleAssignment(Function* fn, Value* v);
+
+	/// Return true if 'a' & 'b' are the same value. Integer constants aren't
+	/// unique, so they are compared by value.
+	bool IsSameValue(Value* a, Value* b);
+
+	/// Return true if the instruction only computes a value from its operands
+	/// (arithmetic, comparisons, casts & address calculations), without touching
+	/// memory or having any other side effects.
+	bool IsPure(const Instruction* insn);
+
+	/// Return true if the instruction is pure and can't trap, so it can be executed
+	/// in places that it wouldn't have been before (e.g. hoisted out of a branch).
+	/// Divisions are only safe if the divisor is a constant that can't fault.
+	bool IsSafeToSpeculate(const Instruction* insn);
+
+	/// Return the function that 'insn' calls directly, or null if it isn't a call
+	/// or the function is called through a pointer.
+	Function* GetCalledFunction(const Instruction* insn);
+
+	/// Return true if 'insn' is a call that has no effect other than computing its
+	/// result (the function doesn't write memory & always returns), so it can be
+	/// deleted if the result isn't used.
+	bool IsRemovableCall(const Instruction* insn);
+
 	template <typename T>
 	inline void BuildWorklist(std::vector<ParentedInsn<T>>& insns,
 	                          Function* fn, OpcodeType opcode);
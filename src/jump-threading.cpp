@@ -0,0 +1,453 @@
+/**
+ * @file jump-threading.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in jump-threading.h
+ */
+
+/* Internal Project Includes */
+#include "jump-threading.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "loop-info.h"
+#include "mem2reg.h"
+#include "options.h"
+
+/* C++ Standard Library Includes */
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// How many times --jump-thread-threshold a function may grow by in total, since
+/// a block can be copied into each of its predecessors.
+static constexpr size_t kGrowthBudgetFactor = 4;
+
+/// How deep to look through compares (of compares...) for the branch condition.
+static constexpr size_t kMaxEvaluationDepth = 4;
+
+/*********************************************************************************************************************/
+
+static Value* Lookup(const IR::ValueMap& map, Value* value)
+{
+	auto it = map.find(value);
+	return it == map.end() ? value : it->second;
+}
+
+/*********************************************************************************************************************/
+
+static bool FoldConstantComparison(HLIR::Opcode opc, ConstantInt* lhs, ConstantInt* rhs, bool* result)
+{
+	if (lhs->GetType() != rhs->GetType() || !type_cast<IntegerType>(lhs->GetType()))
+		return false;
+
+	const int64_t a = lhs->GetSignedIntegralValue();
+	const int64_t b = rhs->GetSignedIntegralValue();
+
+	switch (opc) {
+	case HLIR::ICmp_Eq:  *result = a == b; return true;
+	case HLIR::ICmp_Neq: *result = a != b; return true;
+	case HLIR::ICmp_Lt:  *result = a <  b; return true;
+	case HLIR::ICmp_Lte: *result = a <= b; return true;
+	case HLIR::ICmp_Gt:  *result = a >  b; return true;
+	case HLIR::ICmp_Gte: *result = a >= b; return true;
+
+	default:
+		return false;
+	}
+}
+
+/*********************************************************************************************************************/
+
+/// Number of instructions that copying 'bb' would copy (everything but the phis
+/// & the branch at the end).
+static size_t GetBlockSize(BasicBlock* bb)
+{
+	size_t size = 0;
+
+	for (Instruction& insn : *bb) {
+		if (insn.GetOpcode() != HLIR::Phi && !insn.IsTerminator())
+			size++;
+	}
+
+	return size;
+}
+
+/*********************************************************************************************************************/
+
+class JumpThreader
+{
+public:
+	JumpThreader(Function* fn, size_t threshold)
+		: m_Function(fn), m_Threshold(threshold), m_Budget(threshold * kGrowthBudgetFactor) { }
+
+	/// Thread every edge that can be threaded, returning true if anything changed.
+	bool Run(LoopInfo& loopInfo);
+
+private:
+	/// Return true if the branch at the end of 'bb' is worth looking at.
+	bool IsCandidate(BasicBlock* bb, LoopInfo& loopInfo) const;
+
+	/// Return the successor of 'bb' that is always taken when coming from 'pred',
+	/// or null if it isn't known.
+	BasicBlock* GetKnownSuccessor(BasicBlock* pred, BasicBlock* bb) const;
+
+	/// Return the constant that 'value' is (at the end of 'bb') when coming from
+	/// 'pred', or null if it isn't known.
+	ConstantInt* Evaluate(Value* value, BasicBlock* pred, BasicBlock* bb, size_t depth) const;
+
+	/// If 'pred' branches to 'bb' on 'value' (or on the same comparison as 'value'),
+	/// return what 'value' has to be for that branch to have been taken.
+	ConstantInt* GetEdgeCondition(Value* value, BasicBlock* pred, BasicBlock* bb) const;
+
+	/// The copies of 'bb' define the same values as 'bb' does, so anything used
+	/// after it (other than by phis in its successors, which get the value from each
+	/// copy) goes through a stack slot. Mem2Reg puts them back into registers.
+	void DemoteLiveOutValues(BasicBlock* bb);
+
+	/// Give 'pred' its own copy of 'bb', which branches straight to 'succ'.
+	void Thread(BasicBlock* pred, BasicBlock* bb, BasicBlock* succ);
+
+private:
+	Function* m_Function;
+	size_t    m_Threshold;
+	size_t    m_Budget;
+};
+
+/*********************************************************************************************************************/
+
+bool JumpThreader::IsCandidate(BasicBlock* bb, LoopInfo& loopInfo) const
+{
+	if (bb == m_Function->GetHeadBlock() || loopInfo.IsLoopHeader(bb))
+		return false;
+
+	if (bb->GetLast()->GetOpcode() != HLIR::ConditionalBranch)
+		return false;
+
+	const ConditionalBranchInsn* cbr = static_cast<const ConditionalBranchInsn*>(bb->GetLast());
+
+	if (cbr->GetTrueBB() == cbr->GetFalseBB())
+		return false;
+
+	for (Instruction& insn : *bb) {
+		if (insn.GetOpcode() == HLIR::StackAlloc)
+			return false;
+	}
+
+	return GetBlockSize(bb) <= m_Threshold;
+}
+
+/*********************************************************************************************************************/
+
+ConstantInt* JumpThreader::GetEdgeCondition(Value* value, BasicBlock* pred, BasicBlock* bb) const
+{
+	if (pred->GetLast()->GetOpcode() != HLIR::ConditionalBranch)
+		return nullptr;
+
+	const ConditionalBranchInsn* cbr = static_cast<const ConditionalBranchInsn*>(pred->GetLast());
+
+	// Only one way into 'bb' from 'pred', otherwise it doesn't say anything.
+	if ((cbr->GetTrueBB() == bb) == (cbr->GetFalseBB() == bb))
+		return nullptr;
+
+	if (!type_cast<IntegerType>(value->GetType()))
+		return nullptr;
+
+	bool taken = cbr->GetTrueBB() == bb;
+
+	if (cbr->GetCond() != value) {
+		Instruction* lhs = IR::GetSingleDefinition(value);
+		Instruction* rhs = IR::GetSingleDefinition(cbr->GetCond());
+
+		if (!lhs || !rhs || !HLIR::IsCompare((HLIR::Opcode) lhs->GetOpcode()) || !HLIR::IsCompare((HLIR::Opcode) rhs->GetOpcode()))
+			return nullptr;
+
+		const CompareInsn* a = static_cast<const CompareInsn*>(lhs);
+		const CompareInsn* b = static_cast<const CompareInsn*>(rhs);
+
+		if (!IR::IsSameValue(a->GetLHS(), b->GetLHS()) || !IR::IsSameValue(a->GetRHS(), b->GetRHS()))
+			return nullptr;
+
+		// The opposite comparison is known too, just the other way round.
+		if (a->GetOpcode() != b->GetOpcode()) {
+			if (a->GetOpcode() != HLIR::GetInversePredicate((HLIR::Opcode) b->GetOpcode()))
+				return nullptr;
+
+			taken = !taken;
+		}
+	}
+
+	if (!IR::IsSingleAssignment(m_Function, value))
+		return nullptr;
+
+	// Taking the branch only says that the value isn't zero, which is the same as it being
+	// one when it's the result of a compare.
+	if (taken) {
+		Instruction* def = IR::GetSingleDefinition(value);
+
+		if (!def || !HLIR::IsCompare((HLIR::Opcode) def->GetOpcode()))
+			return nullptr;
+	}
+
+	return ConstantInt::Create(value->GetType(), taken ? 1 : 0);
+}
+
+/*********************************************************************************************************************/
+
+ConstantInt* JumpThreader::Evaluate(Value* value, BasicBlock* pred, BasicBlock* bb, size_t depth) const
+{
+	if (ConstantInt* constant = value_cast<ConstantInt>(value))
+		return constant;
+
+	if (ConstantInt* constant = this->GetEdgeCondition(value, pred, bb))
+		return constant;
+
+	Instruction* def = IR::GetSingleDefinition(value);
+
+	if (!def || def->GetParent() != bb || depth >= kMaxEvaluationDepth)
+		return nullptr;
+
+	if (def->GetOpcode() == HLIR::Phi) {
+		Value* incoming = static_cast<PhiInsn*>(def)->GetIncomingValueForBlock(pred);
+
+		if (!incoming)
+			return nullptr;
+
+		if (ConstantInt* constant = value_cast<ConstantInt>(incoming))
+			return constant;
+
+		return this->GetEdgeCondition(incoming, pred, bb);
+	}
+
+	if (!HLIR::IsCompare((HLIR::Opcode) def->GetOpcode()))
+		return nullptr;
+
+	const CompareInsn* compare = static_cast<const CompareInsn*>(def);
+
+	ConstantInt* lhs = this->Evaluate(compare->GetLHS(), pred, bb, depth + 1);
+	ConstantInt* rhs = lhs ? this->Evaluate(compare->GetRHS(), pred, bb, depth + 1) : nullptr;
+
+	bool result = false;
+
+	if (!rhs || !FoldConstantComparison((HLIR::Opcode) compare->GetOpcode(), lhs, rhs, &result))
+		return nullptr;
+
+	return ConstantInt::Create(compare->GetResult()->GetType(), result ? 1 : 0);
+}
+
+/*********************************************************************************************************************/
+
+BasicBlock* JumpThreader::GetKnownSuccessor(BasicBlock* pred, BasicBlock* bb) const
+{
+	const ConditionalBranchInsn* cbr = static_cast<const ConditionalBranchInsn*>(bb->GetLast());
+	ConstantInt* cond = this->Evaluate(cbr->GetCond(), pred, bb, 0);
+
+	if (!cond)
+		return nullptr;
+
+	return cond->GetIntegralValue() != 0 ? cbr->GetTrueBB() : cbr->GetFalseBB();
+}
+
+/*********************************************************************************************************************/
+
+void JumpThreader::DemoteLiveOutValues(BasicBlock* bb)
+{
+	for (Instruction& insn : *bb) {
+		for (size_t i = 0; i < insn.GetCountOperands(); ++i) {
+			Value* value = insn.GetOperand(i);
+
+			if (!insn.OperandHasFlags(i, Instruction::OP_WRITE) || !value_isa<VirtualRegisterName>(value))
+				continue;
+
+			std::vector<Use> uses;
+
+			for (const Use& use : value->uses()) {
+				Instruction* user = use.GetInstruction();
+
+				if (user->GetParent() == bb)
+					continue;
+
+				if (user->GetOpcode() == HLIR::Phi) {
+					const size_t incoming = (use.GetOperandIndex() - 1) / 2;
+
+					if (static_cast<PhiInsn*>(user)->GetIncomingBlock(incoming) == bb)
+						continue;
+				}
+
+				uses.push_back(use);
+			}
+
+			if (uses.empty())
+				continue;
+
+			VirtualRegisterName* slot = IR::DemoteToStackSlot(m_Function, value, &insn);
+
+			for (const Use& use : uses) {
+				Instruction* user = use.GetInstruction();
+				Instruction* where = user;
+
+				if (user->GetOpcode() == HLIR::Phi) {
+					const size_t incoming = (use.GetOperandIndex() - 1) / 2;
+					where = static_cast<PhiInsn*>(user)->GetIncomingBlock(incoming)->GetLast();
+				}
+
+				VirtualRegisterName* reload = VirtualRegisterName::Create(value->GetType());
+
+				IR::InsertBefore(where, Helix::CreateLoad(slot, reload));
+				user->SetOperand(use.GetOperandIndex(), reload);
+			}
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+void JumpThreader::Thread(BasicBlock* pred, BasicBlock* bb, BasicBlock* succ)
+{
+	IR::ValueMap map;
+
+	for (Instruction& insn : *bb) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+		map[phi->GetResult()] = phi->GetIncomingValueForBlock(pred);
+	}
+
+	BasicBlock* copy = BasicBlock::Create();
+	m_Function->InsertAfter(m_Function->Where(pred), copy);
+
+	for (BasicBlock::iterator it = IR::GetFirstNonPhi(bb); it != bb->end() && !it->IsTerminator(); ++it) {
+		Instruction* clone = IR::CloneInstruction(&*it);
+
+		for (size_t i = 0; i < it->GetCountOperands(); ++i) {
+			Value* operand = it->GetOperand(i);
+
+			if (it->OperandHasFlags(i, Instruction::OP_WRITE) && value_isa<VirtualRegisterName>(operand))
+				map[operand] = VirtualRegisterName::Create(operand->GetType());
+		}
+
+		IR::RemapOperands(clone, map);
+		copy->Append(clone);
+	}
+
+	copy->Append(Helix::CreateUnconditionalBranch(succ));
+
+	IR::RetargetBranch(pred->GetLast(), bb, copy);
+
+	for (Instruction& insn : *bb) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+		phi->RemoveIncoming(phi->GetIncomingIndex(pred));
+	}
+
+	for (Instruction& insn : *succ) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+
+		if (Value* value = phi->GetIncomingValueForBlock(bb))
+			phi->AddIncoming(Lookup(map, value), copy);
+	}
+}
+
+/*********************************************************************************************************************/
+
+bool JumpThreader::Run(LoopInfo& loopInfo)
+{
+	std::vector<BasicBlock*> blocks;
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		blocks.push_back(&bb);
+	}
+
+	bool changed = false;
+
+	for (BasicBlock* bb : blocks) {
+		if (!this->IsCandidate(bb, loopInfo))
+			continue;
+
+		const size_t size = GetBlockSize(bb);
+		bool demoted = false;
+
+		for (BasicBlock* pred : IR::GetPredecessors(bb)) {
+			BasicBlock* succ = this->GetKnownSuccessor(pred, bb);
+
+			if (!succ || succ == bb || loopInfo.IsLoopHeader(succ))
+				continue;
+
+			// Both ways out of 'pred' go to 'bb' (with a different condition on each),
+			// so there is nothing to give its own copy to.
+			const std::vector<BasicBlock*> predSuccs = pred->GetSuccessors();
+
+			if (predSuccs.size() == 2 && predSuccs[0] == bb && predSuccs[1] == bb)
+				continue;
+
+			if (size + 1 > m_Budget)
+				continue;
+
+			if (!demoted) {
+				this->DemoteLiveOutValues(bb);
+				demoted = true;
+			}
+
+			this->Thread(pred, bb, succ);
+
+			m_Budget -= size + 1;
+			changed = true;
+		}
+
+		if (!IR::GetPredecessors(bb).empty())
+			continue;
+
+		// Every way in has been threaded, so the original isn't needed any more.
+		for (BasicBlock* succ : bb->GetSuccessors()) {
+			for (Instruction& insn : *succ) {
+				if (insn.GetOpcode() != HLIR::Phi)
+					break;
+
+				PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+				const size_t index = phi->GetIncomingIndex(bb);
+
+				if (index != SIZE_MAX)
+					phi->RemoveIncoming(index);
+			}
+		}
+
+		IR::DeleteBlocks(m_Function, { bb });
+	}
+
+	return changed;
+}
+
+/*********************************************************************************************************************/
+
+void JumpThreading::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	const size_t threshold = Options::GetJumpThreadingThreshold();
+
+	if (threshold == 0)
+		return;
+
+	JumpThreader threader(fn, threshold);
+
+	// Threading one jump can make the next one known (e.g. a chain of tests on the
+	// same flag), but only once the copies have their values back in registers.
+	while (threader.Run(info.Analyses->Get<LoopInfo>(fn))) {
+		info.Analyses->Invalidate(fn);
+
+		Mem2Reg mem2reg;
+		mem2reg.Execute(fn, info);
+
+		info.Analyses->Invalidate(fn);
+	}
+}
+
+/*********************************************************************************************************************/
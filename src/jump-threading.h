@@ -0,0 +1,45 @@
+/**
+ * @file jump-threading.h
+ * @author Barney Wilks
+ *
+ * Jump threading.
+ *
+ * Where a block branches on something that is already known on the way in
+ * from one of its predecessors, that predecessor can skip the test entirely.
+ * The common cases are a condition that is a phi with a constant coming from
+ * that predecessor (a flag set on one path & tested after the paths join, as
+ * in `found = 1; break; ... if (found)`), a comparison of such a phi against a
+ * constant, and a condition that the predecessor itself has just branched on.
+ *
+ *     P1 -> B { cbr c, T, F }        P1 -> B' -> T
+ *     P2 ---^                        P2 -> B { cbr c, T, F }
+ *
+ * The predecessor is given its own copy of the block, which branches straight
+ * to the successor that would have been taken (so the compare & branch are
+ * gone on that path). Values from the block that are used further on no longer
+ * have a single definition, so they go through a stack slot that Mem2Reg turns
+ * back into phis afterwards.
+ *
+ * Only blocks with at most --jump-thread-threshold instructions are copied,
+ * and each function may only grow by a few times that in total. Loop headers
+ * (& edges into them) are left alone, so that loops keep their shape.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class JumpThreading : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(JumpThreading, jumpthread, "[Generic] Thread jumps through blocks whose branch is known on the way in");
+
+/*********************************************************************************************************************/
@@ -0,0 +1,478 @@
+/**
+ * @file licm.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in licm.h
+ */
+
+/* Internal Project Includes */
+#include "licm.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "dominators.h"
+#include "loop-info.h"
+#include "alias-analysis.h"
+#include "mem2reg.h"
+#include "target-info-armv7.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+class LoopInvariantCodeMotion
+{
+public:
+	LoopInvariantCodeMotion(Function* fn, const DominatorTree& domTree, AliasAnalysis& aa)
+		: m_Function(fn), m_DomTree(domTree), m_AliasAnalysis(aa) { }
+
+	/// Hoist, sink & promote what can be in the given loop. Inner loops should be
+	/// processed before the loops that contain them.
+	void ProcessLoop(Loop* loop);
+
+	/// Return true if any globals have been moved into stack slots, which need
+	/// to be promoted to registers with Mem2Reg.
+	bool HasPromotedGlobals() const { return m_PromotedGlobals; }
+
+private:
+	std::vector<BasicBlock*> GetBlocksInDominatorOrder(Loop* loop) const;
+
+	bool CanHoist(Loop* loop, Instruction* insn, const std::vector<Instruction*>& writers);
+	bool CanHoistLoad(Loop* loop, LoadInsn* load, const std::vector<Instruction*>& writers);
+	bool CanHoistCall(Loop* loop, CallInsn* call, const std::vector<Instruction*>& writers);
+	bool IsGuaranteedToExecute(Loop* loop, BasicBlock* bb) const;
+	bool IsDereferenceable(Value* ptr, const Type* type);
+
+	void HoistInstructions(Loop* loop);
+	void SinkInstructions(Loop* loop);
+
+	void PromoteGlobals(Loop* loop);
+	bool CanPromoteGlobal(Loop* loop, GlobalVariable* global, const std::vector<Instruction*>& accesses,
+	                      const Type** accessType);
+
+private:
+	Function*            m_Function;
+	const DominatorTree& m_DomTree;
+	AliasAnalysis&       m_AliasAnalysis;
+	bool                 m_PromotedGlobals = false;
+};
+
+/*********************************************************************************************************************/
+
+/// Return the pointer that a load or store accesses.
+static Value* GetAccessedPointer(Instruction* insn)
+{
+	if (insn->GetOpcode() == HLIR::Load)
+		return static_cast<LoadInsn*>(insn)->GetSrc();
+
+	return static_cast<StoreInsn*>(insn)->GetDst();
+}
+
+/*********************************************************************************************************************/
+
+/// Return the value that an instruction defines (its only written operand), or null
+/// if it doesn't write exactly one virtual register.
+static Value* GetDefinedValue(Instruction* insn)
+{
+	Value* result = nullptr;
+
+	for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+		if (!insn->OperandHasFlags(i, Instruction::OP_WRITE))
+			continue;
+
+		if (result)
+			return nullptr;
+
+		result = insn->GetOperand(i);
+	}
+
+	return value_isa<VirtualRegisterName>(result) ? result : nullptr;
+}
+
+/*********************************************************************************************************************/
+
+std::vector<BasicBlock*> LoopInvariantCodeMotion::GetBlocksInDominatorOrder(Loop* loop) const
+{
+	std::vector<BasicBlock*> blocks;
+
+	for (BasicBlock* bb : m_DomTree.GetPreOrder()) {
+		if (loop->Contains(bb))
+			blocks.push_back(bb);
+	}
+
+	return blocks;
+}
+
+/*********************************************************************************************************************/
+
+bool LoopInvariantCodeMotion::IsDereferenceable(Value* ptr, const Type* type)
+{
+	const AliasAnalysis::DecomposedPointer dp = m_AliasAnalysis.Decompose(ptr);
+
+	if (!dp.HasConstantOffset || dp.Offset < 0)
+		return false;
+
+	const Type* objectType = nullptr;
+
+	if (dp.Kind == AliasAnalysis::kObject_Global) {
+		objectType = value_cast<GlobalVariable>(dp.Object)->GetBaseType();
+	} else if (dp.Kind == AliasAnalysis::kObject_StackSlot) {
+		Instruction* def = IR::GetSingleDefinition(dp.Object);
+
+		if (def && def->GetOpcode() == HLIR::StackAlloc)
+			objectType = static_cast<StackAllocInsn*>(def)->GetAllocatedType();
+	}
+
+	if (!objectType)
+		return false;
+
+	return (size_t) dp.Offset + ARMv7::TypeSize(type) <= ARMv7::TypeSize(objectType);
+}
+
+/*********************************************************************************************************************/
+
+bool LoopInvariantCodeMotion::CanHoistLoad(Loop* loop, LoadInsn* load, const std::vector<Instruction*>& writers)
+{
+	Value* ptr = load->GetSrc();
+
+	if (!loop->IsLoopInvariant(ptr) || !IR::IsSingleAssignment(m_Function, ptr))
+		return false;
+
+	// The load might not have been executed on every iteration (or at all), so
+	// it must be safe to do it anyway.
+	if (!this->IsDereferenceable(ptr, load->GetDst()->GetType()))
+		return false;
+
+	const MemoryLocation location = MemoryLocation::Get(load);
+
+	for (Instruction* writer : writers) {
+		if (m_AliasAnalysis.GetModRefInfo(writer, location) & kMod)
+			return false;
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool LoopInvariantCodeMotion::IsGuaranteedToExecute(Loop* loop, BasicBlock* bb) const
+{
+	// If the block dominates everywhere that the loop can leave from (or go around
+	// again from) then it runs on the first iteration, whichever way that goes.
+	for (BasicBlock* block : loop->GetBlocks()) {
+		bool isExiting = false;
+
+		for (BasicBlock* succ : block->GetSuccessors())
+			isExiting |= !loop->Contains(succ);
+
+		if (isExiting && !m_DomTree.Dominates(bb, block))
+			return false;
+	}
+
+	for (BasicBlock* latch : loop->GetLatches()) {
+		if (!m_DomTree.Dominates(bb, latch))
+			return false;
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool LoopInvariantCodeMotion::CanHoistCall(Loop* loop, CallInsn* call, const std::vector<Instruction*>& writers)
+{
+	if (!IR::IsRemovableCall(call))
+		return false;
+
+	// The function might read something that's written in the loop.
+	if (!IR::GetCalledFunction(call)->DoesNotAccessMemory() && !writers.empty())
+		return false;
+
+	for (size_t i = 0; i < call->GetCountArguments(); ++i) {
+		Value* arg = call->GetOperand(call->GetStartingArgumentIndex() + i);
+
+		if (!loop->IsLoopInvariant(arg) || !IR::IsSingleAssignment(m_Function, arg))
+			return false;
+	}
+
+	// Even a function that always returns could fault with different arguments
+	// (e.g. divide by zero), so only hoist calls that would have been made anyway.
+	return this->IsGuaranteedToExecute(loop, call->GetParent());
+}
+
+/*********************************************************************************************************************/
+
+bool LoopInvariantCodeMotion::CanHoist(Loop* loop, Instruction* insn, const std::vector<Instruction*>& writers)
+{
+	Value* result = GetDefinedValue(insn);
+
+	if (!result || !IR::IsSingleAssignment(m_Function, result))
+		return false;
+
+	if (insn->GetOpcode() == HLIR::Load)
+		return this->CanHoistLoad(loop, static_cast<LoadInsn*>(insn), writers);
+
+	if (insn->GetOpcode() == HLIR::Call)
+		return this->CanHoistCall(loop, static_cast<CallInsn*>(insn), writers);
+
+	if (!IR::IsSafeToSpeculate(insn))
+		return false;
+
+	for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+		if (!insn->OperandHasFlags(i, Instruction::OP_READ))
+			continue;
+
+		Value* operand = insn->GetOperand(i);
+
+		if (!loop->IsLoopInvariant(operand) || !IR::IsSingleAssignment(m_Function, operand))
+			return false;
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+void LoopInvariantCodeMotion::HoistInstructions(Loop* loop)
+{
+	BasicBlock* preheader = loop->GetPreheader();
+
+	std::vector<Instruction*> writers;
+
+	for (BasicBlock* bb : loop->GetBlocks()) {
+		for (Instruction& insn : *bb) {
+			const bool isWritingCall = insn.GetOpcode() == HLIR::Call && !IR::IsRemovableCall(&insn);
+
+			if (insn.GetOpcode() == HLIR::Store || isWritingCall)
+				writers.push_back(&insn);
+		}
+	}
+
+	// Visiting blocks in dominator order means that the operands of an instruction
+	// are hoisted before it is, so whole chains of invariant instructions can be
+	// moved in one go.
+	for (BasicBlock* bb : this->GetBlocksInDominatorOrder(loop)) {
+		for (BasicBlock::iterator it = bb->begin(); it != bb->end();) {
+			Instruction* insn = &*it;
+			++it;
+
+			if (this->CanHoist(loop, insn, writers))
+				IR::MoveBefore(preheader->GetLast(), insn);
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+void LoopInvariantCodeMotion::SinkInstructions(Loop* loop)
+{
+	const std::vector<BasicBlock*>& exits = loop->GetExitBlocks();
+	std::vector<BasicBlock*>        blocks = this->GetBlocksInDominatorOrder(loop);
+
+	// Work backwards, so that an instruction is sunk after everything that uses it
+	// (which might then let it be sunk too).
+	for (auto bbIt = blocks.rbegin(); bbIt != blocks.rend(); ++bbIt) {
+		BasicBlock* bb = *bbIt;
+
+		for (Instruction* insn = bb->IsEmpty() ? nullptr : bb->GetLast(); insn;) {
+			Instruction* prev = insn == &*bb->begin() ? nullptr : &*IR::GetPrev(insn);
+
+			Value* result = GetDefinedValue(insn);
+
+			if (!result || !IR::IsPure(insn) || !IR::IsSingleAssignment(m_Function, result)) {
+				insn = prev;
+				continue;
+			}
+
+			// Only worth doing if every use is in the same exit block (and isn't
+			// a phi, which reads its value at the end of the predecessor).
+			BasicBlock* target = nullptr;
+			bool        canSink = true;
+
+			for (const Use& use : result->uses()) {
+				Instruction* user = use.GetInstruction();
+
+				if (user == insn)
+					continue;
+
+				if (user->GetOpcode() == HLIR::Phi || (target && target != user->GetParent())) {
+					canSink = false;
+					break;
+				}
+
+				target = user->GetParent();
+			}
+
+			canSink = canSink && target
+				&& std::find(exits.begin(), exits.end(), target) != exits.end()
+				&& m_DomTree.Dominates(bb, target);
+
+			if (canSink)
+				IR::MoveBefore(&*IR::GetFirstNonPhi(target), insn);
+
+			insn = prev;
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+bool LoopInvariantCodeMotion::CanPromoteGlobal(Loop* loop, GlobalVariable* global, const std::vector<Instruction*>& accesses,
+                                               const Type** accessType)
+{
+	*accessType = MemoryLocation::Get(accesses[0]).AccessType;
+
+	bool hasStore = false;
+
+	for (Instruction* access : accesses) {
+		if (MemoryLocation::Get(access).AccessType != *accessType)
+			return false;
+
+		hasStore |= access->GetOpcode() == HLIR::Store;
+	}
+
+	// If the global is only read then the loads can just be hoisted.
+	if (!hasStore || !((*accessType)->IsIntegral() || (*accessType)->IsPointer()))
+		return false;
+
+	const MemoryLocation location(global, *accessType);
+
+	for (BasicBlock* bb : loop->GetBlocks()) {
+		for (Instruction& insn : *bb) {
+			switch (insn.GetOpcode()) {
+			case HLIR::Load:
+			case HLIR::Store:
+				if (std::find(accesses.begin(), accesses.end(), &insn) != accesses.end())
+					break;
+
+				if (m_AliasAnalysis.Alias(MemoryLocation::Get(&insn), location) != AliasResult::NoAlias)
+					return false;
+
+				break;
+
+			case HLIR::Call:
+				if (m_AliasAnalysis.GetModRefInfo(&insn, location) != kNoModRef)
+					return false;
+
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	// The value is stored back when leaving the loop, which would be wrong if the
+	// exit block could be reached without going through the loop.
+	for (BasicBlock* exit : loop->GetExitBlocks()) {
+		for (BasicBlock* pred : IR::GetPredecessors(exit)) {
+			if (!loop->Contains(pred))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+void LoopInvariantCodeMotion::PromoteGlobals(Loop* loop)
+{
+	std::vector<GlobalVariable*>              globals;
+	std::vector<std::vector<Instruction*>>    accesses;
+
+	for (BasicBlock* bb : loop->GetBlocks()) {
+		for (Instruction& insn : *bb) {
+			if (insn.GetOpcode() != HLIR::Load && insn.GetOpcode() != HLIR::Store)
+				continue;
+
+			GlobalVariable* global = value_cast<GlobalVariable>(GetAccessedPointer(&insn));
+
+			if (!global)
+				continue;
+
+			auto it = std::find(globals.begin(), globals.end(), global);
+
+			if (it == globals.end()) {
+				globals.push_back(global);
+				accesses.push_back({ &insn });
+			} else {
+				accesses[it - globals.begin()].push_back(&insn);
+			}
+		}
+	}
+
+	BasicBlock* preheader = loop->GetPreheader();
+	BasicBlock* head      = m_Function->GetHeadBlock();
+
+	for (size_t i = 0; i < globals.size(); ++i) {
+		const Type* type = nullptr;
+
+		if (!this->CanPromoteGlobal(loop, globals[i], accesses[i], &type))
+			continue;
+
+		// Move the global into a stack slot for the duration of the loop, which
+		// Mem2Reg can then turn into registers.
+		VirtualRegisterName* slot = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+		head->InsertBefore(head->begin(), Helix::CreateStackAlloc(slot, type));
+
+		VirtualRegisterName* initial = VirtualRegisterName::Create(type);
+		IR::InsertBefore(preheader->GetLast(), Helix::CreateLoad(globals[i], initial));
+		IR::InsertBefore(preheader->GetLast(), Helix::CreateStore(initial, slot));
+
+		for (Instruction* access : accesses[i]) {
+			access->SetOperand(access->GetOpcode() == HLIR::Load ? 0 : 1, slot);
+		}
+
+		for (BasicBlock* exit : loop->GetExitBlocks()) {
+			Instruction* where = &*IR::GetFirstNonPhi(exit);
+			VirtualRegisterName* value = VirtualRegisterName::Create(type);
+
+			IR::InsertBefore(where, Helix::CreateLoad(slot, value));
+			IR::InsertBefore(where, Helix::CreateStore(value, globals[i]));
+		}
+
+		m_PromotedGlobals = true;
+	}
+}
+
+/*********************************************************************************************************************/
+
+void LoopInvariantCodeMotion::ProcessLoop(Loop* loop)
+{
+	if (!loop->GetPreheader())
+		return;
+
+	this->PromoteGlobals(loop);
+	this->HoistInstructions(loop);
+	this->SinkInstructions(loop);
+}
+
+/*********************************************************************************************************************/
+
+void LICM::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	LoopInfo& loopInfo = info.Analyses->Get<LoopInfo>(fn);
+
+	if (loopInfo.IsEmpty())
+		return;
+
+	LoopInvariantCodeMotion licm(fn, info.Analyses->Get<DominatorTree>(fn), info.Analyses->Get<AliasAnalysis>(fn));
+
+	for (Loop* loop : loopInfo.GetLoopsInnermostFirst()) {
+		licm.ProcessLoop(loop);
+	}
+
+	if (licm.HasPromotedGlobals()) {
+		Mem2Reg mem2reg;
+		mem2reg.Execute(fn, info);
+	}
+}
+
+/*********************************************************************************************************************/
@@ -0,0 +1,37 @@
+/**
+ * @file licm.h
+ * @author Barney Wilks
+ *
+ * Loop invariant code motion.
+ *
+ * Working from the innermost loops outwards, pure instructions whose operands
+ * don't change inside the loop are hoisted into the preheader of the loop, as
+ * are loads from memory that nothing in the loop may write to (as long as
+ * the load can't fault) and calls to functions that don't write memory & always
+ * return (as long as the call would have been made on the first trip around
+ * the loop anyway). Pure instructions that are only used after the loop has
+ * finished are sunk into the exit block that uses them instead.
+ *
+ * Globals that are read & written inside a loop (and can't be accessed any
+ * other way inside it) are promoted to registers for the duration of the
+ * loop - loaded once in the preheader and stored back in every exit block.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class LICM : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(LICM, licm, "[Generic] Hoist loop invariant code out of loops & promote globals to registers");
+
+/*********************************************************************************************************************/
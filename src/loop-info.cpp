@@ -0,0 +1,686 @@
+/**
+ * @file loop-info.cpp
+ * @author Barney Wilks
+ *
+ * Implements loop-info.h
+ */
+
+/* Internal Project Includes */
+#include "loop-info.h"
+#include "dominators.h"
+#include "function.h"
+#include "ir-helpers.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+
+using namespace Helix;
+
+/******************************************************************************/
+
+template <typename T>
+static void
+PushUnique(std::vector<T>& list, const T& value)
+{
+	if (std::find(list.begin(), list.end(), value) == list.end())
+		list.push_back(value);
+}
+
+/******************************************************************************/
+
+/// Return true if the stack slot is only ever loaded from & stored to directly,
+/// so nothing else (e.g. a call, or a store through some other pointer) can
+/// change it behind our back.
+static bool
+IsNonEscapingStackSlot(Value* ptr)
+{
+	const Instruction* def = IR::GetSingleDefinition(ptr);
+
+	if (!def || def->GetOpcode() != HLIR::StackAlloc)
+		return false;
+
+	for (const Use& use : ptr->uses()) {
+		const Instruction* insn = use.GetInstruction();
+
+		switch (insn->GetOpcode()) {
+		case HLIR::StackAlloc:
+			break;
+
+		case HLIR::Load:
+			break;
+
+		case HLIR::Store:
+			if (static_cast<const StoreInsn*>(insn)->GetSrc() == ptr)
+				return false;
+
+			break;
+
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/******************************************************************************/
+
+/// Return true if 'a' is before 'b' in their (shared) parent block.
+static bool
+ComesBefore(const Instruction* a, const Instruction* b)
+{
+	for (const Instruction& insn : *a->GetParent()) {
+		if (&insn == a)
+			return true;
+
+		if (&insn == b)
+			return false;
+	}
+
+	return false;
+}
+
+/******************************************************************************/
+
+/// Compute the number of times the test 'x Predicate bound' passes, where 'x'
+/// starts at 'start' and is stepped by 'step' each time. Returns false if the
+/// count can't be determined (or the induction variable would wrap).
+static bool
+ComputeTripCount(HLIR::Opcode predicate, int64_t start, int64_t bound,
+                 int64_t step, size_t width, size_t* tripCount)
+{
+	const int64_t minValue = -((int64_t) 1 << (width - 1));
+	const int64_t maxValue = ((int64_t) 1 << (width - 1)) - 1;
+
+	if (start < minValue || start > maxValue)
+		return false;
+
+	int64_t count = 0;
+
+	switch (predicate) {
+	case HLIR::ICmp_Lt:
+		if (step <= 0)
+			return false;
+
+		count = (start < bound) ? (bound - start + step - 1) / step : 0;
+		break;
+
+	case HLIR::ICmp_Lte:
+		if (step <= 0)
+			return false;
+
+		count = (start <= bound) ? (bound - start) / step + 1 : 0;
+		break;
+
+	case HLIR::ICmp_Gt:
+		if (step >= 0)
+			return false;
+
+		count = (start > bound) ? (start - bound - step - 1) / -step : 0;
+		break;
+
+	case HLIR::ICmp_Gte:
+		if (step >= 0)
+			return false;
+
+		count = (start >= bound) ? (start - bound) / -step + 1 : 0;
+		break;
+
+	case HLIR::ICmp_Neq:
+		if ((bound - start) % step != 0)
+			return false;
+
+		count = (bound - start) / step;
+
+		if (count < 0)
+			return false;
+
+		break;
+
+	case HLIR::ICmp_Eq:
+		count = (start == bound) ? 1 : 0;
+		break;
+
+	default:
+		return false;
+	}
+
+	// The value that fails the test must still be representable, otherwise
+	// the induction variable has wrapped around & the loop might not even
+	// terminate.
+	const int64_t last = start + count * step;
+
+	if (last < minValue || last > maxValue)
+		return false;
+
+	*tripCount = (size_t) count;
+	return true;
+}
+
+/******************************************************************************/
+
+bool
+Loop::Contains(const BasicBlock* bb) const
+{
+	return m_BlockSet.find(bb) != m_BlockSet.end();
+}
+
+/******************************************************************************/
+
+bool
+Loop::Contains(const Instruction* insn) const
+{
+	return Contains(insn->GetParent());
+}
+
+/******************************************************************************/
+
+bool
+Loop::Contains(const Loop* loop) const
+{
+	for (; loop; loop = loop->GetParentLoop()) {
+		if (loop == this)
+			return true;
+	}
+
+	return false;
+}
+
+/******************************************************************************/
+
+bool
+Loop::IsLoopInvariant(Value* value) const
+{
+	if (value_isa<ConstantInt>(value) || value_isa<GlobalVariable>(value))
+		return true;
+
+	if (value_isa<Function>(value) || value_isa<UndefValue>(value))
+		return true;
+
+	if (!value_isa<VirtualRegisterName>(value))
+		return false;
+
+	for (const Use& use : value->uses()) {
+		const Instruction* insn = use.GetInstruction();
+
+		if (insn->OperandHasFlags(use.GetOperandIndex(), Instruction::OP_WRITE) && Contains(insn))
+			return false;
+	}
+
+	return true;
+}
+
+/******************************************************************************/
+
+LoopInfo::LoopInfo(Function* fn, AnalysisManager& am)
+{
+	HELIX_PROFILE_ZONE;
+
+	const DominatorTree& domTree = am.Get<DominatorTree>(fn);
+
+	this->DiscoverLoops(domTree);
+	this->ComputeBlockLists(fn);
+
+	for (Loop* loop : m_TopLevelLoops)
+		loop->m_Depth = 1;
+
+	// Loops are discovered inner first, so walk backwards to set the depth of
+	// parents before children.
+	for (auto it = m_LoopsInnermostFirst.rbegin(); it != m_LoopsInnermostFirst.rend(); ++it) {
+		Loop* loop = *it;
+
+		if (loop->m_Parent)
+			loop->m_Depth = loop->m_Parent->m_Depth + 1;
+	}
+
+	for (Loop* loop : m_LoopsInnermostFirst) {
+		this->ComputeLoopStructure(loop);
+		this->ComputeBounds(loop, domTree);
+	}
+}
+
+/******************************************************************************/
+
+void
+LoopInfo::DiscoverLoops(const DominatorTree& domTree)
+{
+	const std::vector<BasicBlock*> preorder = domTree.GetPreOrder();
+
+	// Visit the dominator tree bottom up, so that inner loops are found before
+	// the loops that contain them.
+	for (auto it = preorder.rbegin(); it != preorder.rend(); ++it) {
+		BasicBlock* header = *it;
+
+		std::vector<BasicBlock*> worklist;
+
+		for (BasicBlock* pred : IR::GetPredecessors(header)) {
+			if (domTree.IsReachable(pred) && domTree.Dominates(header, pred))
+				PushUnique(worklist, pred);
+		}
+
+		if (worklist.empty())
+			continue;
+
+		m_Loops.push_back(std::make_unique<Loop>(header));
+		Loop* loop = m_Loops.back().get();
+
+		m_LoopsInnermostFirst.push_back(loop);
+
+		// Walk backwards from the latches until the header is reached, every
+		// block on the way is in the loop. If a block is already in a loop, it
+		// must be an inner loop so just skip over it (to its header).
+		while (!worklist.empty()) {
+			BasicBlock* bb = worklist.back();
+			worklist.pop_back();
+
+			Loop* existing = this->GetLoopFor(bb);
+
+			if (!existing) {
+				m_BlockToLoop[bb] = loop;
+
+				if (bb == header)
+					continue;
+
+				for (BasicBlock* pred : IR::GetPredecessors(bb)) {
+					if (domTree.IsReachable(pred))
+						worklist.push_back(pred);
+				}
+
+				continue;
+			}
+
+			while (existing->m_Parent)
+				existing = existing->m_Parent;
+
+			if (existing == loop)
+				continue;
+
+			existing->m_Parent = loop;
+			loop->m_SubLoops.push_back(existing);
+
+			for (BasicBlock* pred : IR::GetPredecessors(existing->GetHeader())) {
+				if (domTree.IsReachable(pred) && !existing->m_BlockSet.count(pred))
+					worklist.push_back(pred);
+			}
+		}
+
+		// Until ComputeBlockLists runs, 'm_BlockSet' is used to track every block
+		// in the loop (including sub loops) so that the above can tell whether a
+		// predecessor is inside a sub loop or not.
+		for (const auto& [bb, innermost] : m_BlockToLoop) {
+			if (loop->Contains(innermost))
+				loop->m_BlockSet.insert(bb);
+		}
+	}
+
+	for (Loop* loop : m_LoopsInnermostFirst) {
+		if (!loop->m_Parent)
+			m_TopLevelLoops.push_back(loop);
+	}
+
+	std::reverse(m_TopLevelLoops.begin(), m_TopLevelLoops.end());
+}
+
+/******************************************************************************/
+
+void
+LoopInfo::ComputeBlockLists(Function* fn)
+{
+	for (BasicBlock& bb : fn->blocks()) {
+		for (Loop* loop = this->GetLoopFor(&bb); loop; loop = loop->m_Parent)
+			loop->m_Blocks.push_back(&bb);
+	}
+
+	for (Loop* loop : m_LoopsInnermostFirst) {
+		auto header = std::find(loop->m_Blocks.begin(), loop->m_Blocks.end(), loop->GetHeader());
+		helix_assert(header != loop->m_Blocks.end(), "loop doesn't contain its own header");
+
+		std::rotate(loop->m_Blocks.begin(), header, header + 1);
+	}
+}
+
+/******************************************************************************/
+
+void
+LoopInfo::ComputeLoopStructure(Loop* loop)
+{
+	BasicBlock* header = loop->GetHeader();
+
+	std::vector<BasicBlock*> outsidePreds;
+
+	for (BasicBlock* pred : IR::GetPredecessors(header)) {
+		if (loop->Contains(pred))
+			PushUnique(loop->m_Latches, pred);
+		else
+			PushUnique(outsidePreds, pred);
+	}
+
+	for (BasicBlock* bb : loop->GetBlocks()) {
+		for (BasicBlock* succ : bb->GetSuccessors()) {
+			if (!loop->Contains(succ)) {
+				PushUnique(loop->m_ExitingBlocks, bb);
+				PushUnique(loop->m_ExitBlocks, succ);
+			}
+		}
+	}
+
+	if (outsidePreds.size() == 1) {
+		std::vector<BasicBlock*> succs = outsidePreds[0]->GetSuccessors();
+
+		if (std::all_of(succs.begin(), succs.end(), [header](BasicBlock* bb) { return bb == header; }))
+			loop->m_Preheader = outsidePreds[0];
+	}
+}
+
+/******************************************************************************/
+
+void
+LoopInfo::ComputeBounds(Loop* loop, const DominatorTree& domTree)
+{
+	// Only loops with one way out are considered, which covers everything
+	// the frontend generates for loops without a 'break'.
+	if (loop->GetExitingBlocks().size() != 1)
+		return;
+
+	BasicBlock* exiting = loop->GetExitingBlocks()[0];
+	const Instruction* terminator = exiting->GetTerminator();
+
+	if (!terminator || terminator->GetOpcode() != HLIR::ConditionalBranch)
+		return;
+
+	const ConditionalBranchInsn* cbr = static_cast<const ConditionalBranchInsn*>(terminator);
+
+	Instruction* condDef = IR::GetSingleDefinition(cbr->GetCond());
+
+	if (!condDef || !HLIR::IsCompare((HLIR::Opcode) condDef->GetOpcode()) || condDef->GetParent() != exiting)
+		return;
+
+	CompareInsn* compare = static_cast<CompareInsn*>(condDef);
+
+	HLIR::Opcode predicate = (HLIR::Opcode) compare->GetOpcode();
+
+	// Normalise so that the loop keeps going while the predicate is true.
+	if (!loop->Contains(cbr->GetTrueBB()))
+		predicate = HLIR::GetInversePredicate(predicate);
+
+	Value* ivRead = compare->GetLHS();
+	Value* bound = compare->GetRHS();
+
+	if (!loop->IsLoopInvariant(bound)) {
+		std::swap(ivRead, bound);
+		predicate = HLIR::GetSwappedPredicate(predicate);
+	}
+
+	if (!loop->IsLoopInvariant(bound) || loop->IsLoopInvariant(ivRead) || !value_isa<VirtualRegisterName>(ivRead))
+		return;
+
+	// Now figure out what the variable being compared actually is, either a
+	// phi in the header, a register that is 'set' once inside the loop, or (if
+	// the variable hasn't been promoted to a register) a load from a stack slot
+	// that is stored to once inside the loop.
+	Value*       inductionVariable = nullptr;
+	Instruction* testInsn          = nullptr;
+	Instruction* stepInsn          = nullptr;
+	Value*       nextValue         = nullptr;
+
+	std::vector<Instruction*> writersInLoop;
+
+	for (const Use& use : ivRead->uses()) {
+		Instruction* insn = use.GetInstruction();
+
+		if (insn->OperandHasFlags(use.GetOperandIndex(), Instruction::OP_WRITE) && loop->Contains(insn))
+			writersInLoop.push_back(insn);
+	}
+
+	if (writersInLoop.size() != 1)
+		return;
+
+	// In SSA form the variable is a phi in the header, and the compare either
+	// reads the phi itself or the value stepped from it.
+	PhiInsn* phi = nullptr;
+
+	if (writersInLoop[0]->GetOpcode() == HLIR::Phi) {
+		phi = static_cast<PhiInsn*>(writersInLoop[0]);
+	} else if (writersInLoop[0]->GetOpcode() == HLIR::IAdd || writersInLoop[0]->GetOpcode() == HLIR::ISub) {
+		BinOpInsn* binop = static_cast<BinOpInsn*>(writersInLoop[0]);
+
+		for (Value* operand : { binop->GetLHS(), binop->GetRHS() }) {
+			Instruction* def = IR::GetSingleDefinition(operand);
+
+			if (def && def->GetOpcode() == HLIR::Phi)
+				phi = static_cast<PhiInsn*>(def);
+		}
+	}
+
+	if (phi) {
+		if (phi->GetParent() != loop->GetHeader())
+			return;
+
+		// Every latch has to feed the same next value back around the loop.
+		for (BasicBlock* latch : loop->GetLatches()) {
+			Value* value = phi->GetIncomingValueForBlock(latch);
+
+			if (!value || (nextValue && value != nextValue))
+				return;
+
+			nextValue = value;
+		}
+
+		if (ivRead != phi->GetResult() && ivRead != nextValue)
+			return;
+
+		inductionVariable = phi->GetResult();
+		testInsn          = compare;
+		stepInsn          = IR::GetSingleDefinition(nextValue);
+
+		if (!stepInsn)
+			return;
+	} else if (writersInLoop[0]->GetOpcode() == HLIR::Set) {
+		SetInsn* set = static_cast<SetInsn*>(writersInLoop[0]);
+
+		inductionVariable = ivRead;
+		testInsn          = compare;
+		stepInsn          = set;
+		nextValue         = set->GetNewValue();
+	} else if (writersInLoop[0]->GetOpcode() == HLIR::Load) {
+		LoadInsn* load = static_cast<LoadInsn*>(writersInLoop[0]);
+
+		if (!IsNonEscapingStackSlot(load->GetSrc()))
+			return;
+
+		for (const Use& use : load->GetSrc()->uses()) {
+			Instruction* insn = use.GetInstruction();
+
+			if (insn->GetOpcode() == HLIR::Store && loop->Contains(insn)) {
+				if (stepInsn)
+					return;
+
+				stepInsn = insn;
+			}
+		}
+
+		if (!stepInsn)
+			return;
+
+		inductionVariable = load->GetSrc();
+		testInsn          = load;
+		nextValue         = static_cast<StoreInsn*>(stepInsn)->GetSrc();
+	} else {
+		return;
+	}
+
+	// The next value must be the current value plus or minus a constant. For
+	// stack slots "the current value" is any load of the slot that happens
+	// inside the loop.
+	Instruction* stepDef = IR::GetSingleDefinition(nextValue);
+
+	if (!stepDef || !loop->Contains(stepDef))
+		return;
+
+	if (stepDef->GetOpcode() != HLIR::IAdd && stepDef->GetOpcode() != HLIR::ISub)
+		return;
+
+	BinOpInsn* binop = static_cast<BinOpInsn*>(stepDef);
+
+	auto isCurrentValue = [&](Value* v) -> bool {
+		if (v == inductionVariable)
+			return true;
+
+		if (inductionVariable == ivRead)
+			return false;
+
+		Instruction* def = IR::GetSingleDefinition(v);
+
+		return def && def->GetOpcode() == HLIR::Load && loop->Contains(def)
+			&& static_cast<LoadInsn*>(def)->GetSrc() == inductionVariable;
+	};
+
+	ConstantInt* stepConstant = nullptr;
+	bool negate = false;
+
+	if (isCurrentValue(binop->GetLHS()) && value_isa<ConstantInt>(binop->GetRHS())) {
+		stepConstant = value_cast<ConstantInt>(binop->GetRHS());
+		negate = (binop->GetOpcode() == HLIR::ISub);
+	} else if (binop->GetOpcode() == HLIR::IAdd && value_isa<ConstantInt>(binop->GetLHS()) && isCurrentValue(binop->GetRHS())) {
+		stepConstant = value_cast<ConstantInt>(binop->GetLHS());
+	} else {
+		return;
+	}
+
+	const int64_t step = negate ? -stepConstant->GetSignedIntegralValue() : stepConstant->GetSignedIntegralValue();
+
+	if (step == 0)
+		return;
+
+	// The step has to happen exactly once per iteration, so it can't be in a
+	// sub loop and must happen on every path around the loop.
+	BasicBlock* stepBlock = stepInsn->GetParent();
+
+	if (this->GetLoopFor(stepBlock) != loop)
+		return;
+
+	for (BasicBlock* latch : loop->GetLatches()) {
+		if (!domTree.Dominates(stepBlock, latch))
+			return;
+	}
+
+	// Work out if the test sees the value from before or after the step in the
+	// same iteration.
+	bool testsSteppedValue = false;
+
+	if (phi) {
+		testsSteppedValue = (ivRead == nextValue);
+	} else if (stepBlock == testInsn->GetParent()) {
+		testsSteppedValue = ComesBefore(stepInsn, testInsn);
+	} else if (exiting == loop->GetHeader()) {
+		testsSteppedValue = false;
+	} else if (domTree.Dominates(stepBlock, exiting)) {
+		testsSteppedValue = true;
+	} else if (domTree.Dominates(exiting, stepBlock)) {
+		testsSteppedValue = false;
+	} else {
+		return;
+	}
+
+	LoopBounds& bounds = loop->m_Bounds;
+
+	bounds.InductionVariable = inductionVariable;
+	bounds.StepInstruction   = stepInsn;
+	bounds.Step              = step;
+	bounds.ExitCompare       = compare;
+	bounds.Predicate         = predicate;
+	bounds.Bound             = bound;
+	bounds.TestsSteppedValue = testsSteppedValue;
+
+	loop->m_IsCounted = true;
+
+	// For phis, the initial value is whatever comes in from outside the loop.
+	if (phi) {
+		for (size_t i = 0; i < phi->GetCountIncoming(); ++i) {
+			if (loop->Contains(phi->GetIncomingBlock(i)))
+				continue;
+
+			Value* value = phi->GetIncomingValue(i);
+
+			if (bounds.InitialValue && bounds.InitialValue != value) {
+				bounds.InitialValue = nullptr;
+				break;
+			}
+
+			bounds.InitialValue = value;
+		}
+	}
+
+	// Find the initial value by looking backwards from the preheader for the
+	// last write to the variable, following single predecessor chains.
+	BasicBlock* bb = phi ? nullptr : loop->GetPreheader();
+
+	for (size_t depth = 0; bb && !bounds.InitialValue && depth < 32; ++depth) {
+		for (Instruction& insn : *bb) {
+			if (insn.GetOpcode() == HLIR::Set && static_cast<SetInsn&>(insn).GetRegister() == inductionVariable)
+				bounds.InitialValue = static_cast<SetInsn&>(insn).GetNewValue();
+
+			if (insn.GetOpcode() == HLIR::Store && static_cast<StoreInsn&>(insn).GetDst() == inductionVariable)
+				bounds.InitialValue = static_cast<StoreInsn&>(insn).GetSrc();
+		}
+
+		std::vector<BasicBlock*> preds = IR::GetPredecessors(bb);
+		bb = (preds.size() == 1 && preds[0] != bb) ? preds[0] : nullptr;
+	}
+
+	ConstantInt* initial = value_cast<ConstantInt>(bounds.InitialValue);
+	ConstantInt* boundConstant = value_cast<ConstantInt>(bound);
+
+	// Mem2Reg gives constants that were stored to a slot their own register, so
+	// look through the copy.
+	if (!initial && bounds.InitialValue) {
+		const Instruction* def = IR::GetSingleDefinition(bounds.InitialValue);
+
+		if (def && def->GetOpcode() == HLIR::Set)
+			initial = value_cast<ConstantInt>(static_cast<const SetInsn*>(def)->GetNewValue());
+	}
+
+	if (!initial || !boundConstant)
+		return;
+
+	const IntegerType* ivType = type_cast<IntegerType>(initial->GetType());
+
+	if (!ivType || ivType->GetBitWidth() > 32 || ivType->GetBitWidth() == 0)
+		return;
+
+	const int64_t start = initial->GetSignedIntegralValue() + (testsSteppedValue ? step : 0);
+
+	size_t tripCount = 0;
+
+	if (ComputeTripCount(predicate, start, boundConstant->GetSignedIntegralValue(), step, ivType->GetBitWidth(), &tripCount))
+		loop->m_TripCount = tripCount;
+}
+
+/******************************************************************************/
+
+Loop*
+LoopInfo::GetLoopFor(const BasicBlock* bb) const
+{
+	auto it = m_BlockToLoop.find(bb);
+	return it == m_BlockToLoop.end() ? nullptr : it->second;
+}
+
+/******************************************************************************/
+
+size_t
+LoopInfo::GetLoopDepth(const BasicBlock* bb) const
+{
+	const Loop* loop = this->GetLoopFor(bb);
+	return loop ? loop->GetDepth() : 0;
+}
+
+/******************************************************************************/
+
+bool
+LoopInfo::IsLoopHeader(const BasicBlock* bb) const
+{
+	const Loop* loop = this->GetLoopFor(bb);
+	return loop && loop->GetHeader() == bb;
+}
+
+/******************************************************************************/
@@ -0,0 +1,223 @@
+/**
+ * @file loop-info.h
+ * @author Barney Wilks
+ *
+ * Natural loop analysis.
+ *
+ * Loops are found from back edges (an edge whose target dominates its source)
+ * in the dominator tree, every loop is identified by its header block. Loops
+ * that share a header are merged into one loop with multiple latches.
+ *
+ * Loops are arranged into a loop nest tree, where the parent of a loop is the
+ * innermost loop that contains it.
+ *
+ * For the canonical counted loops that the frontend emits for `for`, `while`
+ * & `do/while` statements (an induction variable stepped by a constant and
+ * compared against a constant or loop invariant bound) the loop bounds are
+ * recognised & a constant trip count is derived where possible.
+ */
+
+#pragma once
+
+/* Internal Project Includes */
+#include "analysis-manager.h"
+#include "value.h"
+#include "opcodes.h"
+
+/* C++ Standard Library Includes */
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Helix
+{
+	class Function;
+	class BasicBlock;
+	class Instruction;
+	class CompareInsn;
+	class DominatorTree;
+
+	/**
+	 * Description of the induction variable & exit condition of a counted
+	 * loop, e.g. `for (i = Init; i < Bound; i += Step)`
+	 */
+	struct LoopBounds
+	{
+		/// The variable that is stepped every iteration, either a virtual
+		/// register (updated with `set`, or the result of a phi in the header
+		/// in SSA form) or the stack slot that holds the variable (updated with
+		/// `store`) if it hasn't been promoted yet.
+		Value* InductionVariable = nullptr;
+
+		/// Value of the induction variable on entry to the loop, null if
+		/// it couldn't be determined.
+		Value* InitialValue = nullptr;
+
+		/// The instruction that writes the next value of the induction
+		/// variable (`set` or `store`, or the `iadd`/`isub` whose result
+		/// goes back into the phi in SSA form)
+		Instruction* StepInstruction = nullptr;
+
+		/// Amount the induction variable changes by every iteration.
+		int64_t Step = 0;
+
+		/// The comparison that decides whether to leave the loop.
+		CompareInsn* ExitCompare = nullptr;
+
+		/// Predicate such that the loop continues while
+		/// `InductionVariable Predicate Bound` holds (independent of
+		/// the operand order & branch targets of the exit condition).
+		HLIR::Opcode Predicate = HLIR::Undefined;
+
+		/// The value the induction variable is compared against, either a
+		/// constant or a loop invariant value.
+		Value* Bound = nullptr;
+
+		/// True if the exit condition sees the induction variable after it
+		/// has been stepped for the current iteration.
+		bool TestsSteppedValue = false;
+	};
+
+	class Loop
+	{
+	public:
+		Loop(BasicBlock* header)
+			: m_Header(header) { }
+
+		HELIX_NO_STEAL(Loop);
+
+		/// Get the header of the loop, the single entry point of the loop
+		/// which dominates every block in the loop.
+		BasicBlock* GetHeader() const { return m_Header; }
+
+		/// Get the innermost loop that contains this loop, or null if this
+		/// is a top level loop.
+		Loop* GetParentLoop() const { return m_Parent; }
+
+		/// Get the loops immediately nested inside this loop.
+		const std::vector<Loop*>& GetSubLoops() const { return m_SubLoops; }
+
+		/// Get every block in this loop (including those in sub loops), the
+		/// header is always first.
+		const std::vector<BasicBlock*>& GetBlocks() const { return m_Blocks; }
+
+		size_t GetCountBlocks() const { return m_Blocks.size(); }
+
+		/// Get the nesting depth of this loop, top level loops have a depth
+		/// of 1.
+		size_t GetDepth() const { return m_Depth; }
+
+		bool IsInnermost() const { return m_SubLoops.empty(); }
+
+		bool Contains(const BasicBlock* bb) const;
+		bool Contains(const Instruction* insn) const;
+		bool Contains(const Loop* loop) const;
+
+		/// Return true if the value can't change while executing the loop,
+		/// that is it's a constant/global/function argument, or a register that
+		/// is never written by an instruction inside the loop.
+		bool IsLoopInvariant(Value* value) const;
+
+		/// Get the block outside of the loop that is the only predecessor of
+		/// the header (& only has the header as a successor), that code can be
+		/// hoisted into. Null if there isn't one.
+		BasicBlock* GetPreheader() const { return m_Preheader; }
+
+		/// Get the blocks inside the loop that branch back to the header.
+		const std::vector<BasicBlock*>& GetLatches() const { return m_Latches; }
+
+		/// Get the latch of the loop if there is only one, otherwise null.
+		BasicBlock* GetLatch() const { return m_Latches.size() == 1 ? m_Latches[0] : nullptr; }
+
+		/// Get the blocks inside the loop that have a successor outside it.
+		const std::vector<BasicBlock*>& GetExitingBlocks() const { return m_ExitingBlocks; }
+
+		/// Get the blocks outside the loop that are branched to from inside
+		/// the loop.
+		const std::vector<BasicBlock*>& GetExitBlocks() const { return m_ExitBlocks; }
+
+		/// Get the exit block of the loop if there is only one, otherwise null.
+		BasicBlock* GetExitBlock() const { return m_ExitBlocks.size() == 1 ? m_ExitBlocks[0] : nullptr; }
+
+		/// Return true if the induction variable & exit condition of the loop
+		/// have been recognised (see GetBounds())
+		bool IsCounted() const { return m_IsCounted; }
+
+		/// Get the bounds of a counted loop. Only valid if IsCounted().
+		const LoopBounds& GetBounds() const { return m_Bounds; }
+
+		/// Return true if the loop is counted and the number of iterations
+		/// is known at compile time.
+		bool HasConstantTripCount() const { return m_TripCount != SIZE_MAX; }
+
+		/// Get the number of times the exit test passes (and so the number of
+		/// times the back edge is taken). For loops tested at the header (`for`
+		/// & `while`) this is the number of times the body executes, loops
+		/// tested at the latch (`do/while`) execute their body once more than
+		/// this. Only valid if HasConstantTripCount().
+		size_t GetConstantTripCount() const { return m_TripCount; }
+
+	private:
+		friend class LoopInfo;
+
+		BasicBlock*                     m_Header;
+		Loop*                           m_Parent    = nullptr;
+		BasicBlock*                     m_Preheader = nullptr;
+		size_t                          m_Depth     = 1;
+
+		std::vector<Loop*>              m_SubLoops;
+		std::vector<BasicBlock*>        m_Blocks;
+		std::unordered_set<const BasicBlock*> m_BlockSet;
+
+		std::vector<BasicBlock*>        m_Latches;
+		std::vector<BasicBlock*>        m_ExitingBlocks;
+		std::vector<BasicBlock*>        m_ExitBlocks;
+
+		bool                            m_IsCounted = false;
+		LoopBounds                      m_Bounds;
+		size_t                          m_TripCount = SIZE_MAX;
+	};
+
+	class LoopInfo : public Analysis
+	{
+	public:
+		LoopInfo(Function* fn, AnalysisManager& am);
+
+		HELIX_NO_STEAL(LoopInfo);
+
+		/// Get the innermost loop that contains the given block, or null
+		/// if the block isn't in a loop.
+		Loop* GetLoopFor(const BasicBlock* bb) const;
+
+		/// Get the loop depth of the given block (0 if it's not in a loop).
+		size_t GetLoopDepth(const BasicBlock* bb) const;
+
+		/// Return true if the given block is the header of a loop.
+		bool IsLoopHeader(const BasicBlock* bb) const;
+
+		/// Get the outermost loops in the function.
+		const std::vector<Loop*>& GetTopLevelLoops() const { return m_TopLevelLoops; }
+
+		/// Get every loop in the function, inner loops always come before the
+		/// loops that contain them (handy for transforms that want to work from
+		/// the inside out).
+		const std::vector<Loop*>& GetLoopsInnermostFirst() const { return m_LoopsInnermostFirst; }
+
+		bool IsEmpty() const { return m_Loops.empty(); }
+
+	private:
+		void DiscoverLoops(const DominatorTree& domTree);
+		void ComputeBlockLists(Function* fn);
+		void ComputeLoopStructure(Loop* loop);
+		void ComputeBounds(Loop* loop, const DominatorTree& domTree);
+
+	private:
+		std::vector<std::unique_ptr<Loop>>             m_Loops;
+		std::vector<Loop*>                             m_TopLevelLoops;
+		std::vector<Loop*>                             m_LoopsInnermostFirst;
+		std::unordered_map<const BasicBlock*, Loop*>   m_BlockToLoop;
+	};
+}
+
+REGISTER_ANALYSIS(LoopInfo, loops, "Natural loops, loop nesting & trip counts");
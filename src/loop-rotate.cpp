@@ -0,0 +1,357 @@
+/**
+ * @file loop-rotate.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in loop-rotate.h
+ */
+
+/* Internal Project Includes */
+#include "loop-rotate.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "loop-info.h"
+#include "mem2reg.h"
+
+/* C++ Standard Library Includes */
+#include <utility>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// Limit on the number of instructions copied from the header (counting every copy),
+/// since the test ends up in front of the loop & at the end of every latch.
+static constexpr size_t kMaxDuplicatedInstructions = 16;
+
+/*********************************************************************************************************************/
+
+struct RotationCandidate
+{
+	BasicBlock* Preheader;
+	BasicBlock* Header;
+
+	/// The successor of the header inside the loop, which becomes the new header.
+	BasicBlock* Body;
+
+	/// The successor of the header outside the loop.
+	BasicBlock* Exit;
+
+	std::vector<BasicBlock*> Latches;
+};
+
+/*********************************************************************************************************************/
+
+static Value* Lookup(const IR::ValueMap& map, Value* value)
+{
+	auto it = map.find(value);
+	return it == map.end() ? value : it->second;
+}
+
+/*********************************************************************************************************************/
+
+class LoopRotator
+{
+public:
+	LoopRotator(Function* fn)
+		: m_Function(fn) { }
+
+	bool Analyse(Loop* loop, RotationCandidate* candidate) const;
+	void Rotate(const RotationCandidate& candidate);
+
+private:
+	/// Values defined in the header that are used outside it are moved into stack
+	/// slots (returned in 'slots'), since there won't be one place that defines them
+	/// any more. Mem2Reg puts them back into registers afterwards.
+	void DemoteHeaderValues(const RotationCandidate& candidate, IR::ValueMap& slots);
+
+	/// Replace the branch at the end of 'bb' (to the header) with a copy of the header,
+	/// where the phis take the values coming from 'bb'. The copy branches to 'inLoop'
+	/// if the loop continues & 'exit' otherwise. Returns the mapping of header values
+	/// to the copy.
+	IR::ValueMap CopyHeader(const RotationCandidate& candidate, BasicBlock* bb, BasicBlock* inLoop,
+	                        BasicBlock* exit, const IR::ValueMap& slots);
+
+private:
+	Function* m_Function;
+};
+
+/*********************************************************************************************************************/
+
+bool LoopRotator::Analyse(Loop* loop, RotationCandidate* candidate) const
+{
+	BasicBlock* header = loop->GetHeader();
+
+	candidate->Preheader = loop->GetPreheader();
+	candidate->Header    = header;
+	candidate->Latches   = loop->GetLatches();
+
+	if (!candidate->Preheader || header->GetLast()->GetOpcode() != HLIR::ConditionalBranch)
+		return false;
+
+	// The header has to be the test at the top of the loop, so one way stays in the
+	// loop & the other leaves it.
+	ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(header->GetLast());
+
+	const bool trueInLoop  = loop->Contains(cbr->GetTrueBB());
+	const bool falseInLoop = loop->Contains(cbr->GetFalseBB());
+
+	if (trueInLoop == falseInLoop)
+		return false;
+
+	candidate->Body = trueInLoop ? cbr->GetTrueBB() : cbr->GetFalseBB();
+	candidate->Exit = trueInLoop ? cbr->GetFalseBB() : cbr->GetTrueBB();
+
+	if (IR::GetPredecessors(candidate->Body).size() != 1 || candidate->Body->begin()->GetOpcode() == HLIR::Phi)
+		return false;
+
+	for (BasicBlock* latch : candidate->Latches) {
+		if (latch == header || latch->GetLast()->GetOpcode() != HLIR::UnconditionalBranch)
+			return false;
+	}
+
+	size_t size = 0;
+
+	for (Instruction& insn : *header) {
+		if (insn.GetOpcode() == HLIR::StackAlloc)
+			return false;
+
+		if (insn.GetOpcode() != HLIR::Phi && !insn.IsTerminator())
+			size++;
+
+		if (insn.GetOpcode() != HLIR::Phi)
+			continue;
+
+		// The value going around the back edge has to be available at the end of
+		// the latch without the header (where it would only be in a stack slot).
+		PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+
+		for (BasicBlock* latch : candidate->Latches) {
+			Instruction* def = IR::GetSingleDefinition(phi->GetIncomingValueForBlock(latch));
+
+			if (def && def->GetParent() == header)
+				return false;
+		}
+	}
+
+	return size * (candidate->Latches.size() + 1) <= kMaxDuplicatedInstructions;
+}
+
+/*********************************************************************************************************************/
+
+void LoopRotator::DemoteHeaderValues(const RotationCandidate& candidate, IR::ValueMap& slots)
+{
+	BasicBlock* head = m_Function->GetHeadBlock();
+
+	for (Instruction& insn : *candidate.Header) {
+		for (size_t i = 0; i < insn.GetCountOperands(); ++i) {
+			Value* value = insn.GetOperand(i);
+
+			if (!insn.OperandHasFlags(i, Instruction::OP_WRITE) || !value_isa<VirtualRegisterName>(value))
+				continue;
+
+			std::vector<Use> uses;
+
+			for (const Use& use : value->uses()) {
+				Instruction* user = use.GetInstruction();
+
+				if (user->GetParent() == candidate.Header)
+					continue;
+
+				// Phis after the loop that take the value straight from the header are
+				// given the value from each copy instead.
+				if (user->GetOpcode() == HLIR::Phi) {
+					const size_t incoming = (use.GetOperandIndex() - 1) / 2;
+
+					if (static_cast<PhiInsn*>(user)->GetIncomingBlock(incoming) == candidate.Header)
+						continue;
+				}
+
+				uses.push_back(use);
+			}
+
+			if (uses.empty())
+				continue;
+
+			VirtualRegisterName* slot = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+			head->InsertBefore(head->begin(), Helix::CreateStackAlloc(slot, value->GetType()));
+
+			slots[value] = slot;
+
+			for (const Use& use : uses) {
+				Instruction* user = use.GetInstruction();
+				Instruction* where = user;
+
+				if (user->GetOpcode() == HLIR::Phi) {
+					const size_t incoming = (use.GetOperandIndex() - 1) / 2;
+					where = static_cast<PhiInsn*>(user)->GetIncomingBlock(incoming)->GetLast();
+				}
+
+				VirtualRegisterName* reload = VirtualRegisterName::Create(value->GetType());
+
+				IR::InsertBefore(where, Helix::CreateLoad(slot, reload));
+				user->SetOperand(use.GetOperandIndex(), reload);
+			}
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+IR::ValueMap LoopRotator::CopyHeader(const RotationCandidate& candidate, BasicBlock* bb, BasicBlock* inLoop,
+                                     BasicBlock* exit, const IR::ValueMap& slots)
+{
+	IR::ValueMap map;
+
+	bb->GetLast()->DeleteFromParent();
+
+	for (Instruction& insn : *candidate.Header) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+		Value* value = phi->GetIncomingValueForBlock(bb);
+
+		map[phi->GetResult()] = value;
+
+		auto it = slots.find(phi->GetResult());
+
+		if (it != slots.end())
+			bb->Append(Helix::CreateStore(value, it->second));
+	}
+
+	for (BasicBlock::iterator it = IR::GetFirstNonPhi(candidate.Header); it != candidate.Header->end(); ++it) {
+		if (it->GetOpcode() == HLIR::ConditionalBranch) {
+			ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(&*it);
+			Value* cond = Lookup(map, cbr->GetCond());
+
+			if (cbr->GetTrueBB() == candidate.Body)
+				bb->Append(Helix::CreateConditionalBranch(inLoop, exit, cond));
+			else
+				bb->Append(Helix::CreateConditionalBranch(exit, inLoop, cond));
+
+			break;
+		}
+
+		Instruction* clone = IR::CloneInstruction(&*it);
+		std::vector<std::pair<Value*, Value*>> defs;
+
+		for (size_t i = 0; i < it->GetCountOperands(); ++i) {
+			Value* operand = it->GetOperand(i);
+
+			if (it->OperandHasFlags(i, Instruction::OP_WRITE) && value_isa<VirtualRegisterName>(operand)) {
+				VirtualRegisterName* copy = VirtualRegisterName::Create(operand->GetType());
+
+				map[operand] = copy;
+				defs.push_back({ operand, copy });
+			}
+		}
+
+		IR::RemapOperands(clone, map);
+		bb->Append(clone);
+
+		for (const auto& [original, copy] : defs) {
+			auto slot = slots.find(original);
+
+			if (slot != slots.end())
+				bb->Append(Helix::CreateStore(copy, slot->second));
+		}
+	}
+
+	return map;
+}
+
+/*********************************************************************************************************************/
+
+void LoopRotator::Rotate(const RotationCandidate& candidate)
+{
+	IR::ValueMap slots;
+	this->DemoteHeaderValues(candidate, slots);
+
+	// The guard in front of the loop gets a new preheader to branch to, so that there
+	// is still somewhere to hoist things out of the loop into.
+	BasicBlock* preheader = BasicBlock::Create();
+	preheader->Append(Helix::CreateUnconditionalBranch(candidate.Body));
+
+	m_Function->InsertAfter(m_Function->Where(candidate.Preheader), preheader);
+
+	// Each copy of the test, along with the block that it leaves the loop from.
+	std::vector<std::pair<BasicBlock*, IR::ValueMap>> copies;
+	copies.push_back({ candidate.Preheader, this->CopyHeader(candidate, candidate.Preheader, preheader, candidate.Exit, slots) });
+
+	// The exit can now be reached without going through the loop, so give the
+	// latches exits of their own that are only reached from inside the loop (for
+	// LICM to store promoted values back in).
+	for (BasicBlock* latch : candidate.Latches) {
+		BasicBlock* exit = BasicBlock::Create();
+		exit->Append(Helix::CreateUnconditionalBranch(candidate.Exit));
+
+		m_Function->InsertAfter(m_Function->Where(latch), exit);
+		copies.push_back({ exit, this->CopyHeader(candidate, latch, candidate.Body, exit, slots) });
+	}
+
+	for (Instruction& insn : *candidate.Exit) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+		const size_t index = phi->GetIncomingIndex(candidate.Header);
+
+		if (index == SIZE_MAX)
+			continue;
+
+		Value* value = phi->GetIncomingValue(index);
+
+		for (const auto& [bb, map] : copies) {
+			phi->AddIncoming(Lookup(map, value), bb);
+		}
+
+		phi->RemoveIncoming(index);
+	}
+
+	IR::DeleteBlocks(m_Function, { candidate.Header });
+}
+
+/*********************************************************************************************************************/
+
+void LoopRotate::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	LoopRotator rotator(fn);
+	bool changed = false;
+
+	// Rotating a loop changes the blocks of the loops around it, so find the loops
+	// again after each one. Rotated loops aren't tested at the top any more, so
+	// they won't be picked again.
+	for (;;) {
+		LoopInfo& loopInfo = info.Analyses->Get<LoopInfo>(fn);
+		RotationCandidate candidate;
+
+		bool found = false;
+
+		for (Loop* loop : loopInfo.GetLoopsInnermostFirst()) {
+			if (rotator.Analyse(loop, &candidate)) {
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+			break;
+
+		rotator.Rotate(candidate);
+		info.Analyses->Invalidate(fn);
+
+		changed = true;
+	}
+
+	if (!changed)
+		return;
+
+	Mem2Reg mem2reg;
+	mem2reg.Execute(fn, info);
+}
+
+/*********************************************************************************************************************/
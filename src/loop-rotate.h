@@ -0,0 +1,46 @@
+/**
+ * @file loop-rotate.h
+ * @author Barney Wilks
+ *
+ * Loop rotation.
+ *
+ * `for` and `while` loops are emitted with the test at the top - the header
+ * checks the condition and either enters the body or leaves, and the end of
+ * the body branches back to the header. That's two branches every iteration.
+ *
+ * Rotating the loop copies the test out of the header to the two places that
+ * used to branch to it: once in front of the loop (as a guard that skips the
+ * loop entirely if it wouldn't run at all) and once at the end of each latch
+ * (so the back edge becomes a single conditional branch). The old header is
+ * then removed, and the first block of the body becomes the new header, with
+ * its own preheader.
+ *
+ *     preheader -> header <-------\            guard ----> exit
+ *                  |    \         |              |          ^
+ *                  v     \-> body -> latch       v          |
+ *                 exit                        preheader -> body -> latch (test)
+ *                                                          ^          |
+ *                                                          \----------/
+ *
+ * Anything already branching out of the body (`break`) or to a latch
+ * (`continue`) is left as it was.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class LoopRotate : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(LoopRotate, rotate, "[Generic] Rotate top tested loops into guarded bottom tested loops");
+
+/*********************************************************************************************************************/
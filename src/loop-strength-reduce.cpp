@@ -0,0 +1,477 @@
+/**
+ * @file loop-strength-reduce.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in loop-strength-reduce.h
+ */
+
+/* Internal Project Includes */
+#include "loop-strength-reduce.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "loop-info.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// Limit on the number of new induction variables created for one loop, since each
+/// one needs a register for the whole of the loop.
+static constexpr size_t kMaxDerivedInductionVariables = 8;
+
+/*********************************************************************************************************************/
+
+struct InductionVariable
+{
+	PhiInsn*     Phi;
+
+	/// The 'iadd'/'isub' that gives the value for the next iteration (coming into the
+	/// phi from the latch)
+	Instruction* Increment;
+
+	/// The value on entry to the loop (coming into the phi from the preheader)
+	Value*       Initial;
+
+	int64_t      Step;
+
+	/// True if this was created by strength reduction (rather than being one of the
+	/// induction variables that was there to begin with)
+	bool         IsDerived;
+};
+
+/*********************************************************************************************************************/
+
+/// Get the bit width of 'type' if it's an integer type that induction variables can
+/// be made from, otherwise zero.
+static unsigned GetInductionWidth(const Type* type)
+{
+	const IntegerType* integerType = type_cast<IntegerType>(type);
+
+	if (!integerType || integerType->GetBitWidth() == 0 || integerType->GetBitWidth() > 32)
+		return 0;
+
+	return (unsigned) integerType->GetBitWidth();
+}
+
+/*********************************************************************************************************************/
+
+/// Wrap 'value' around to a two's complement integer of the given width.
+static int64_t WrapToWidth(int64_t value, unsigned width)
+{
+	const unsigned shift = 64 - width;
+	return (int64_t) ((uint64_t) value << shift) >> shift;
+}
+
+/*********************************************************************************************************************/
+
+/// Create an integer constant of 'type' from a (possibly negative) value.
+static ConstantInt* CreateConstant(const Type* type, int64_t value)
+{
+	const uint64_t mask = (uint64_t(1) << GetInductionWidth(type)) - 1;
+	return ConstantInt::Create(type, (Integer) value & mask);
+}
+
+/*********************************************************************************************************************/
+
+/// Return true if 'value' isn't used (or defined) by anything other than 'users'.
+static bool IsOnlyUsedBy(Value* value, const std::vector<Instruction*>& users)
+{
+	for (const Use& use : value->uses()) {
+		if (std::find(users.begin(), users.end(), use.GetInstruction()) == users.end())
+			return false;
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+/// Compute 'lhs op rhs' at the end of 'bb', or just fold it if both are constants.
+static Value* CreateBinOpAtEnd(BasicBlock* bb, HLIR::Opcode opcode, Value* lhs, Value* rhs)
+{
+	ConstantInt* lhsConstant = value_cast<ConstantInt>(lhs);
+	ConstantInt* rhsConstant = value_cast<ConstantInt>(rhs);
+
+	const Type* type = lhs->GetType();
+
+	if (lhsConstant && rhsConstant) {
+		const int64_t a = lhsConstant->GetSignedIntegralValue();
+		const int64_t b = rhsConstant->GetSignedIntegralValue();
+
+		int64_t result = 0;
+
+		switch (opcode) {
+		case HLIR::IAdd: result = (int64_t) ((uint64_t) a + (uint64_t) b); break;
+		case HLIR::ISub: result = (int64_t) ((uint64_t) a - (uint64_t) b); break;
+		case HLIR::IMul: result = (int64_t) ((uint64_t) a * (uint64_t) b); break;
+		case HLIR::Shl:  result = (int64_t) ((uint64_t) a << b);           break;
+		default:
+			helix_unreachable("Unexpected opcode for induction variable");
+		}
+
+		return CreateConstant(type, result);
+	}
+
+	// Keep constants on the right hand side.
+	if ((opcode == HLIR::IAdd || opcode == HLIR::IMul) && lhsConstant) {
+		std::swap(lhs, rhs);
+		std::swap(lhsConstant, rhsConstant);
+	}
+
+	// Adding zero to the start of a derived induction variable happens a lot (any
+	// loop counting up from zero), so don't bother computing it.
+	if ((opcode == HLIR::IAdd || opcode == HLIR::ISub) && rhsConstant && rhsConstant->GetIntegralValue() == 0)
+		return lhs;
+
+	VirtualRegisterName* result = VirtualRegisterName::Create(type);
+	IR::InsertBefore(bb->GetLast(), Helix::CreateBinOp(opcode, lhs, rhs, result));
+
+	return result;
+}
+
+/*********************************************************************************************************************/
+
+class StrengthReducer
+{
+public:
+	/// Strength reduce the induction variables of 'loop' & replace its exit test
+	/// if possible. Returns true if anything changed.
+	bool ProcessLoop(Loop* loop);
+
+private:
+	void FindBasicInductionVariables(Loop* loop);
+
+	/// Try to replace 'user' (which uses 'iv') with a new induction variable, which
+	/// is returned if it was created.
+	bool TryReduce(Loop* loop, const InductionVariable& iv, Instruction* user, InductionVariable* derived);
+
+	void CreateInductionVariable(Loop* loop, const Type* type, Value* initial, int64_t step,
+	                             InductionVariable* iv);
+
+	/// Rewrite the exit test of the loop to use one of the derived induction variables
+	/// instead of the basic induction variable it currently tests.
+	bool ReplaceExitTest(Loop* loop);
+
+	/// Remove induction variables that nothing uses any more (other than to step
+	/// themselves).
+	bool RemoveDeadInductionVariables();
+
+private:
+	std::vector<InductionVariable> m_InductionVariables;
+};
+
+/*********************************************************************************************************************/
+
+void StrengthReducer::FindBasicInductionVariables(Loop* loop)
+{
+	BasicBlock* preheader = loop->GetPreheader();
+	BasicBlock* latch     = loop->GetLatch();
+
+	for (Instruction& insn : *loop->GetHeader()) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+
+		if (phi->GetCountIncoming() != 2 || !GetInductionWidth(phi->GetResult()->GetType()))
+			continue;
+
+		Value* initial = phi->GetIncomingValueForBlock(preheader);
+		Value* next    = phi->GetIncomingValueForBlock(latch);
+
+		Instruction* increment = IR::GetSingleDefinition(next);
+
+		if (!initial || !increment || !loop->Contains(increment))
+			continue;
+
+		if (increment->GetOpcode() != HLIR::IAdd && increment->GetOpcode() != HLIR::ISub)
+			continue;
+
+		BinOpInsn* binop = static_cast<BinOpInsn*>(increment);
+		ConstantInt* step = nullptr;
+
+		if (binop->GetLHS() == phi->GetResult())
+			step = value_cast<ConstantInt>(binop->GetRHS());
+		else if (binop->GetOpcode() == HLIR::IAdd && binop->GetRHS() == phi->GetResult())
+			step = value_cast<ConstantInt>(binop->GetLHS());
+
+		if (!step || step->GetIntegralValue() == 0)
+			continue;
+
+		const int64_t stepValue = step->GetSignedIntegralValue();
+		m_InductionVariables.push_back({ phi, increment, initial, binop->GetOpcode() == HLIR::ISub ? -stepValue : stepValue, false });
+	}
+}
+
+/*********************************************************************************************************************/
+
+void StrengthReducer::CreateInductionVariable(Loop* loop, const Type* type, Value* initial, int64_t step,
+                                              InductionVariable* iv)
+{
+	BasicBlock* header = loop->GetHeader();
+	BasicBlock* latch  = loop->GetLatch();
+
+	VirtualRegisterName* current = VirtualRegisterName::Create(type);
+	VirtualRegisterName* next    = VirtualRegisterName::Create(type);
+
+	PhiInsn* phi = Helix::CreatePhi(current);
+	phi->AddIncoming(initial, loop->GetPreheader());
+	phi->AddIncoming(next, latch);
+
+	header->InsertBefore(IR::GetFirstNonPhi(header), phi);
+
+	Instruction* increment = Helix::CreateBinOp(HLIR::IAdd, current, CreateConstant(type, step), next);
+	IR::InsertBefore(latch->GetLast(), increment);
+
+	*iv = { phi, increment, initial, step, true };
+}
+
+/*********************************************************************************************************************/
+
+bool StrengthReducer::TryReduce(Loop* loop, const InductionVariable& iv, Instruction* user, InductionVariable* derived)
+{
+	if (user == iv.Increment || !loop->Contains(user) || !HLIR::IsBinaryOp((HLIR::Opcode) user->GetOpcode()))
+		return false;
+
+	BinOpInsn* binop = static_cast<BinOpInsn*>(user);
+
+	Value* value = iv.Phi->GetResult();
+	Value* other = (binop->GetLHS() == value) ? binop->GetRHS() : binop->GetLHS();
+
+	// i * i isn't linear.
+	if (other == value)
+		return false;
+
+	const Type*    type  = value->GetType();
+	const unsigned width = GetInductionWidth(type);
+
+	if (binop->GetResult()->GetType() != type || other->GetType() != type)
+		return false;
+
+	BasicBlock* preheader = loop->GetPreheader();
+	ConstantInt* constant = value_cast<ConstantInt>(other);
+
+	Value*  initial = nullptr;
+	int64_t step    = 0;
+
+	switch (binop->GetOpcode()) {
+	case HLIR::IMul:
+		if (!constant)
+			return false;
+
+		initial = CreateBinOpAtEnd(preheader, HLIR::IMul, iv.Initial, constant);
+		step    = iv.Step * constant->GetSignedIntegralValue();
+		break;
+
+	case HLIR::Shl:
+		if (!constant || binop->GetLHS() != value || constant->GetIntegralValue() >= width)
+			return false;
+
+		initial = CreateBinOpAtEnd(preheader, HLIR::Shl, iv.Initial, constant);
+		step    = (int64_t) ((uint64_t) iv.Step << constant->GetIntegralValue());
+		break;
+
+	// Adding a loop invariant onto an existing induction variable just makes a
+	// copy of it, so only do it when that completes an expression that has already
+	// been reduced (like adding the base address onto 'i * 4').
+	case HLIR::IAdd:
+		if (!iv.IsDerived || !loop->IsLoopInvariant(other))
+			return false;
+
+		initial = CreateBinOpAtEnd(preheader, HLIR::IAdd, iv.Initial, other);
+		step    = iv.Step;
+		break;
+
+	case HLIR::ISub:
+		if (!iv.IsDerived || !loop->IsLoopInvariant(other))
+			return false;
+
+		if (binop->GetLHS() == value) {
+			initial = CreateBinOpAtEnd(preheader, HLIR::ISub, iv.Initial, other);
+			step    = iv.Step;
+		} else {
+			initial = CreateBinOpAtEnd(preheader, HLIR::ISub, other, iv.Initial);
+			step    = -iv.Step;
+		}
+
+		break;
+
+	default:
+		return false;
+	}
+
+	step = WrapToWidth(step, width);
+
+	if (step == 0)
+		return false;
+
+	this->CreateInductionVariable(loop, type, initial, step, derived);
+
+	IR::ReplaceAllUsesWith(binop->GetResult(), derived->Phi->GetResult());
+	binop->DeleteFromParent();
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool StrengthReducer::ReplaceExitTest(Loop* loop)
+{
+	if (!loop->IsCounted() || !loop->HasConstantTripCount())
+		return false;
+
+	const LoopBounds& bounds = loop->GetBounds();
+	CompareInsn* compare = bounds.ExitCompare;
+
+	BasicBlock* exiting = compare->GetParent();
+
+	if (exiting != loop->GetHeader() && exiting != loop->GetLatch())
+		return false;
+
+	Instruction* terminator = exiting->GetLast();
+
+	if (terminator->GetOpcode() != HLIR::ConditionalBranch || !IsOnlyUsedBy(compare->GetResult(), { compare, terminator }))
+		return false;
+
+	ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(terminator);
+
+	if (cbr->GetCond() != compare->GetResult())
+		return false;
+
+	const InductionVariable* counter = nullptr;
+
+	for (const InductionVariable& iv : m_InductionVariables) {
+		if (!iv.IsDerived && iv.Phi->GetResult() == bounds.InductionVariable)
+			counter = &iv;
+	}
+
+	if (!counter)
+		return false;
+
+	// Only worth doing if the counter isn't needed for anything else, since then
+	// it can be removed entirely.
+	const std::vector<Instruction*> counterUsers { counter->Phi, counter->Increment, compare };
+
+	if (!IsOnlyUsedBy(counter->Phi->GetResult(), counterUsers) || !IsOnlyUsedBy(counter->Increment->GetOperand(2), counterUsers))
+		return false;
+
+	// When the test fails (for either the current or stepped value) the counter in the
+	// header is 'Initial + TripCount * Step', so the derived variable is at the same
+	// point in its sequence. Each value of the derived variable before then has to be
+	// different for an (in)equality test to find the right one.
+	const uint64_t tripCount = loop->GetConstantTripCount();
+
+	for (const InductionVariable& iv : m_InductionVariables) {
+		if (!iv.IsDerived || IsOnlyUsedBy(iv.Phi->GetResult(), { iv.Phi, iv.Increment }))
+			continue;
+
+		const unsigned width = GetInductionWidth(iv.Phi->GetResult()->GetType());
+		const uint64_t step  = (uint64_t) (iv.Step < 0 ? -iv.Step : iv.Step);
+
+		if (tripCount != 0 && step > ((uint64_t(1) << width) - 1) / tripCount)
+			continue;
+
+		const Type* type = iv.Phi->GetResult()->GetType();
+		const int64_t distance = WrapToWidth((int64_t) (tripCount * (uint64_t) iv.Step), width);
+
+		Value* limit = CreateBinOpAtEnd(loop->GetPreheader(), HLIR::IAdd, iv.Initial, CreateConstant(type, distance));
+
+		const HLIR::Opcode predicate = loop->Contains(cbr->GetTrueBB()) ? HLIR::ICmp_Neq : HLIR::ICmp_Eq;
+		VirtualRegisterName* cond = VirtualRegisterName::Create(compare->GetResult()->GetType());
+
+		IR::InsertBefore(cbr, Helix::CreateCompare(predicate, iv.Phi->GetResult(), limit, cond));
+		cbr->SetOperand(2, cond);
+
+		compare->DeleteFromParent();
+		return true;
+	}
+
+	return false;
+}
+
+/*********************************************************************************************************************/
+
+bool StrengthReducer::RemoveDeadInductionVariables()
+{
+	bool changed = false;
+
+	for (const InductionVariable& iv : m_InductionVariables) {
+		const std::vector<Instruction*> self { iv.Phi, iv.Increment };
+
+		if (IsOnlyUsedBy(iv.Phi->GetResult(), self) && IsOnlyUsedBy(iv.Increment->GetOperand(2), self)) {
+			iv.Increment->DeleteFromParent();
+			iv.Phi->DeleteFromParent();
+
+			changed = true;
+		}
+	}
+
+	m_InductionVariables.clear();
+	return changed;
+}
+
+/*********************************************************************************************************************/
+
+bool StrengthReducer::ProcessLoop(Loop* loop)
+{
+	if (!loop->GetPreheader() || !loop->GetLatch())
+		return false;
+
+	this->FindBasicInductionVariables(loop);
+
+	bool changed = false;
+	size_t derived = 0;
+
+	// Derived induction variables can have more derived from them, so keep going
+	// until nothing new is found.
+	for (size_t i = 0; i < m_InductionVariables.size() && derived < kMaxDerivedInductionVariables; ++i) {
+		const InductionVariable iv = m_InductionVariables[i];
+		std::vector<Use> uses(iv.Phi->GetResult()->uses().begin(), iv.Phi->GetResult()->uses().end());
+
+		for (const Use& use : uses) {
+			InductionVariable newInductionVariable;
+
+			if (derived < kMaxDerivedInductionVariables && this->TryReduce(loop, iv, use.GetInstruction(), &newInductionVariable)) {
+				m_InductionVariables.push_back(newInductionVariable);
+				derived++;
+			}
+		}
+	}
+
+	changed |= derived > 0;
+	changed |= this->ReplaceExitTest(loop);
+	changed |= this->RemoveDeadInductionVariables();
+
+	return changed;
+}
+
+/*********************************************************************************************************************/
+
+void LoopStrengthReduce::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	LoopInfo& loopInfo = info.Analyses->Get<LoopInfo>(fn);
+
+	if (loopInfo.IsEmpty())
+		return;
+
+	StrengthReducer reducer;
+	bool changed = false;
+
+	// The control flow doesn't change, so the loops stay valid as each is processed
+	// (although their bounds might not be).
+	for (Loop* loop : loopInfo.GetLoopsInnermostFirst()) {
+		changed |= reducer.ProcessLoop(loop);
+	}
+
+	if (changed)
+		info.Analyses->Invalidate(fn);
+}
+
+/*********************************************************************************************************************/
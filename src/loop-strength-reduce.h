@@ -0,0 +1,43 @@
+/**
+ * @file loop-strength-reduce.h
+ * @author Barney Wilks
+ *
+ * Induction variable strength reduction.
+ *
+ * Basic induction variables are phis in the loop header that are stepped
+ * by a constant every iteration (e.g. the 'i' in `for (i = 0; i < n; ++i)`).
+ * Values derived from them by multiplying (or shifting) by a constant, such
+ * as the `i * 4` offset that lowering `lea` produces for every array access,
+ * are replaced by a new induction variable of their own that starts at the
+ * scaled initial value and is stepped by the scaled step instead, turning the
+ * multiply into an add. Adding a loop invariant base address onto one of
+ * these gives another induction variable, so `base + i * 4` ends up as a
+ * pointer that is just incremented by 4 every iteration.
+ *
+ * Afterwards, if the only thing the original counter is still needed for is
+ * the exit test (and the trip count is known) the test is rewritten in terms
+ * of one of the new induction variables (linear function test replacement)
+ * and the counter is removed.
+ *
+ * (as described in Operator Strength Reduction - Cooper, Simpson & Vick and
+ *  Engineering a Compiler, Section 10.7.2 - Cooper & Torczon)
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class LoopStrengthReduce : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(LoopStrengthReduce, lsr, "[Generic] Strength reduce induction variables & replace loop exit tests");
+
+/*********************************************************************************************************************/
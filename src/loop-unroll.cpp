@@ -0,0 +1,505 @@
+/**
+ * @file loop-unroll.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in loop-unroll.h
+ */
+
+/* Internal Project Includes */
+#include "loop-unroll.h"
+#include "loop-info.h"
+#include "dominators.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "options.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// Partially unrolled loops never run more than this many iterations per group.
+static constexpr size_t kMaxUnrollFactor = 8;
+
+/*********************************************************************************************************************/
+
+/// A loop that is simple enough to unroll: it has a single latch and leaves from a single
+/// block (that runs every iteration) to a single exit block.
+struct UnrollCandidate
+{
+	Loop*       TheLoop;
+	BasicBlock* Preheader;
+	BasicBlock* Header;
+	BasicBlock* Latch;
+	BasicBlock* Exiting;
+	BasicBlock* Exit;
+
+	/// Successor of the exiting block that stays inside the loop.
+	BasicBlock* Continue;
+
+	std::vector<PhiInsn*> HeaderPhis;
+
+	/// The loop blocks, in the order they appear in the function.
+	std::vector<BasicBlock*> Blocks;
+
+	/// Blocks that run in the final pass through the loop (from the header to the
+	/// exiting block), i.e. those that can reach the exiting block without going
+	/// around the loop again.
+	std::vector<BasicBlock*> FinalBlocks;
+
+	size_t      Size = 0;
+};
+
+/*********************************************************************************************************************/
+
+static Value* Lookup(const IR::ValueMap& map, Value* value)
+{
+	auto it = map.find(value);
+	return it == map.end() ? value : it->second;
+}
+
+/*********************************************************************************************************************/
+
+/// Get the copy of 'bb' in the iteration described by 'map'.
+static BasicBlock* GetMappedBlock(const IR::ValueMap& map, BasicBlock* bb)
+{
+	return static_cast<BlockBranchTarget*>(map.at(bb->GetBranchTarget()))->GetParent();
+}
+
+/*********************************************************************************************************************/
+
+class Unroller
+{
+public:
+	Unroller(Function* fn, const DominatorTree& domTree, size_t threshold)
+		: m_Function(fn), m_DomTree(domTree), m_Threshold(threshold) { }
+
+	bool Analyse(Loop* loop, UnrollCandidate* candidate) const;
+
+	bool TryFullUnroll(UnrollCandidate& candidate);
+	bool TryPartialUnroll(UnrollCandidate& candidate);
+
+	/// Every copy of a loop is a chain of blocks joined by unconditional branches, so
+	/// fold the copies back into their predecessors wherever there is nothing else
+	/// branching into them.
+	void MergeClonedBlocks();
+
+private:
+	/// Create a copy of 'blocks' (one iteration of the loop), inserted after 'where' and
+	/// returning the last block of the copy. 'map' should already map the results of the
+	/// header phis to their values for this iteration, and is filled in with the values &
+	/// blocks of the copy. The exiting block of the copy branches unconditionally to 'next'
+	/// (or its copy, if it's in the loop), and the back edge goes to the header of the copy.
+	BasicBlock* CloneIteration(const UnrollCandidate& candidate, const std::vector<BasicBlock*>& blocks,
+	                           IR::ValueMap& map, BasicBlock* where, BasicBlock* next);
+
+	/// Get the starting map for the iteration after the one described by 'map', which has
+	/// the header phis mapped to the values they take in that iteration.
+	IR::ValueMap GetNextIterationPhis(const UnrollCandidate& candidate, const IR::ValueMap& map) const;
+
+private:
+	Function*            m_Function;
+	const DominatorTree& m_DomTree;
+	size_t               m_Threshold;
+
+	std::vector<BasicBlock*> m_ClonedBlocks;
+};
+
+/*********************************************************************************************************************/
+
+bool Unroller::Analyse(Loop* loop, UnrollCandidate* candidate) const
+{
+	if (!loop->IsInnermost() || !loop->GetPreheader() || !loop->GetLatch() || !loop->GetExitBlock()
+		|| loop->GetExitingBlocks().size() != 1) {
+		return false;
+	}
+
+	candidate->TheLoop   = loop;
+	candidate->Preheader = loop->GetPreheader();
+	candidate->Header    = loop->GetHeader();
+	candidate->Latch     = loop->GetLatch();
+	candidate->Exiting   = loop->GetExitingBlocks()[0];
+	candidate->Exit      = loop->GetExitBlock();
+
+	// The exit test must happen every time around the loop, for the trip count to
+	// say anything about how many times each block runs.
+	if (!m_DomTree.Dominates(candidate->Exiting, candidate->Latch))
+		return false;
+
+	Instruction* terminator = candidate->Exiting->GetLast();
+
+	if (terminator->GetOpcode() != HLIR::ConditionalBranch)
+		return false;
+
+	ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(terminator);
+	candidate->Continue = loop->Contains(cbr->GetTrueBB()) ? cbr->GetTrueBB() : cbr->GetFalseBB();
+
+	if (candidate->Continue == candidate->Exit)
+		return false;
+
+	for (BasicBlock::iterator it = candidate->Header->begin(); it != IR::GetFirstNonPhi(candidate->Header); ++it) {
+		candidate->HeaderPhis.push_back(static_cast<PhiInsn*>(&*it));
+	}
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (!loop->Contains(&bb))
+			continue;
+
+		candidate->Blocks.push_back(&bb);
+
+		for (Instruction& insn : bb) {
+			if (insn.GetOpcode() == HLIR::StackAlloc)
+				return false;
+
+			// Every iteration gets its own copy of each value, so values can only be
+			// carried from one iteration to the next through the header phis.
+			for (size_t i = 0; i < insn.GetCountOperands(); ++i) {
+				if (insn.OperandHasFlags(i, Instruction::OP_WRITE) && !IR::IsSingleAssignment(m_Function, insn.GetOperand(i)))
+					return false;
+			}
+
+			if (insn.GetOpcode() != HLIR::Phi)
+				candidate->Size++;
+		}
+	}
+
+	std::vector<BasicBlock*> worklist { candidate->Exiting };
+
+	while (!worklist.empty()) {
+		BasicBlock* bb = worklist.back();
+		worklist.pop_back();
+
+		if (std::find(candidate->FinalBlocks.begin(), candidate->FinalBlocks.end(), bb) != candidate->FinalBlocks.end())
+			continue;
+
+		candidate->FinalBlocks.push_back(bb);
+
+		if (bb == candidate->Header)
+			continue;
+
+		for (BasicBlock* pred : IR::GetPredecessors(bb)) {
+			if (loop->Contains(pred))
+				worklist.push_back(pred);
+		}
+	}
+
+	// Keep them in the same order as the rest of the blocks.
+	std::vector<BasicBlock*> finalBlocks;
+
+	for (BasicBlock* bb : candidate->Blocks) {
+		if (std::find(candidate->FinalBlocks.begin(), candidate->FinalBlocks.end(), bb) != candidate->FinalBlocks.end())
+			finalBlocks.push_back(bb);
+	}
+
+	candidate->FinalBlocks = std::move(finalBlocks);
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+BasicBlock* Unroller::CloneIteration(const UnrollCandidate& candidate, const std::vector<BasicBlock*>& blocks,
+                                     IR::ValueMap& map, BasicBlock* where, BasicBlock* next)
+{
+	// The header phis are already mapped to their values coming into this iteration.
+	std::vector<Value*> incoming;
+
+	for (PhiInsn* phi : candidate.HeaderPhis) {
+		incoming.push_back(map.at(phi->GetResult()));
+	}
+
+	const std::vector<BasicBlock*> clones = IR::CloneBlocks(blocks, map, m_Function, where);
+
+	m_ClonedBlocks.insert(m_ClonedBlocks.end(), clones.begin(), clones.end());
+
+	// ... so the copies of the phis are replaced by those values.
+	BasicBlock* header = GetMappedBlock(map, candidate.Header);
+
+	for (size_t i = 0; i < candidate.HeaderPhis.size(); ++i) {
+		PhiInsn* copy = static_cast<PhiInsn*>(&*header->begin());
+		Value* result = copy->GetResult();
+
+		copy->DeleteFromParent();
+		IR::ReplaceAllUsesWith(result, incoming[i]);
+
+		map[candidate.HeaderPhis[i]->GetResult()] = incoming[i];
+	}
+
+	// Which way the exiting block goes is known for each copy, so it always goes to
+	// (the copy of) 'next'.
+	if (std::find(blocks.begin(), blocks.end(), candidate.Exiting) != blocks.end()) {
+		BasicBlock* exiting = GetMappedBlock(map, candidate.Exiting);
+		Instruction* branch = Helix::CreateUnconditionalBranch(next);
+
+		IR::RemapOperands(branch, map);
+		IR::ReplaceInstructionAndDestroyOriginal(exiting->GetLast(), branch);
+	}
+
+	return clones.back();
+}
+
+/*********************************************************************************************************************/
+
+IR::ValueMap Unroller::GetNextIterationPhis(const UnrollCandidate& candidate, const IR::ValueMap& map) const
+{
+	IR::ValueMap next;
+
+	for (PhiInsn* phi : candidate.HeaderPhis) {
+		next[phi->GetResult()] = Lookup(map, phi->GetIncomingValueForBlock(candidate.Latch));
+	}
+
+	// Anything else gets replaced when the next iteration is cloned.
+	next.insert(map.begin(), map.end());
+	return next;
+}
+
+/*********************************************************************************************************************/
+
+bool Unroller::TryFullUnroll(UnrollCandidate& candidate)
+{
+	Loop* loop = candidate.TheLoop;
+
+	if (!loop->HasConstantTripCount())
+		return false;
+
+	// Every pass through the loop that takes the back edge gets its own copy, and
+	// then there's a final pass that leaves through the exiting block.
+	const size_t passes = loop->GetConstantTripCount() + 1;
+
+	if (candidate.Size > m_Threshold / passes)
+		return false;
+
+	IR::ValueMap map;
+
+	for (PhiInsn* phi : candidate.HeaderPhis) {
+		map[phi->GetResult()] = phi->GetIncomingValueForBlock(candidate.Preheader);
+	}
+
+	BasicBlock* where       = candidate.Latch;
+	BasicBlock* firstHeader = nullptr;
+	BasicBlock* prevHeader  = nullptr;
+	BasicBlock* prevLatch   = nullptr;
+
+	for (size_t pass = 0; pass < passes; ++pass) {
+		const bool isFinal = pass == passes - 1;
+
+		if (pass > 0)
+			map = this->GetNextIterationPhis(candidate, map);
+
+		where = this->CloneIteration(candidate, isFinal ? candidate.FinalBlocks : candidate.Blocks, map, where,
+		                             isFinal ? candidate.Exit : candidate.Continue);
+
+		BasicBlock* header = GetMappedBlock(map, candidate.Header);
+
+		if (prevLatch)
+			IR::RetargetBranch(prevLatch->GetLast(), prevHeader, header);
+		else
+			firstHeader = header;
+
+		prevHeader = header;
+		prevLatch  = isFinal ? nullptr : GetMappedBlock(map, candidate.Latch);
+	}
+
+	// Anything after the loop now follows on from the final copy.
+	BasicBlock* finalExiting = GetMappedBlock(map, candidate.Exiting);
+
+	for (Instruction& insn : *candidate.Exit) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+		const size_t index = phi->GetIncomingIndex(candidate.Exiting);
+
+		phi->SetIncomingValue(index, Lookup(map, phi->GetIncomingValue(index)));
+		phi->SetIncomingBlock(index, finalExiting);
+	}
+
+	for (BasicBlock* bb : candidate.Blocks) {
+		for (Instruction& insn : *bb) {
+			for (size_t i = 0; i < insn.GetCountOperands(); ++i) {
+				if (!insn.OperandHasFlags(i, Instruction::OP_WRITE))
+					continue;
+
+				Value* value = insn.GetOperand(i);
+				std::vector<Use> uses(value->uses().begin(), value->uses().end());
+
+				for (const Use& use : uses) {
+					if (!loop->Contains(use.GetInstruction()))
+						use.GetInstruction()->SetOperand(use.GetOperandIndex(), Lookup(map, value));
+				}
+			}
+		}
+	}
+
+	IR::RetargetBranch(candidate.Preheader->GetLast(), candidate.Header, firstHeader);
+	IR::DeleteBlocks(m_Function, candidate.Blocks);
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool Unroller::TryPartialUnroll(UnrollCandidate& candidate)
+{
+	Loop* loop = candidate.TheLoop;
+
+	if (!loop->IsCounted() || candidate.Exiting != candidate.Header || candidate.Size == 0)
+		return false;
+
+	const LoopBounds& bounds = loop->GetBounds();
+
+	size_t factor = std::min(kMaxUnrollFactor, m_Threshold / candidate.Size);
+
+	if (loop->HasConstantTripCount())
+		factor = std::min(factor, loop->GetConstantTripCount());
+
+	if (factor < 2)
+		return false;
+
+	// Each group of iterations only runs if the last iteration in it would, which only
+	// works if the induction variable is heading straight towards the bound.
+	ConstantInt* bound = value_cast<ConstantInt>(bounds.Bound);
+	Instruction* ivDef = IR::GetSingleDefinition(bounds.InductionVariable);
+
+	if (!bound || !ivDef || ivDef->GetOpcode() != HLIR::Phi || ivDef->GetParent() != candidate.Header || bounds.TestsSteppedValue)
+		return false;
+
+	const bool increasing = bounds.Step > 0 && (bounds.Predicate == HLIR::ICmp_Lt || bounds.Predicate == HLIR::ICmp_Lte);
+	const bool decreasing = bounds.Step < 0 && (bounds.Predicate == HLIR::ICmp_Gt || bounds.Predicate == HLIR::ICmp_Gte);
+
+	if (!increasing && !decreasing)
+		return false;
+
+	const IntegerType* ivType = type_cast<IntegerType>(bounds.InductionVariable->GetType());
+
+	if (!ivType || ivType->GetBitWidth() > 32)
+		return false;
+
+	// The last iteration of the group would run if `iv + groupStep` passes the test, which is
+	// checked as `iv` against `bound - groupStep` so that nothing is added to the induction
+	// variable (which could overflow if it starts near the limit of its type).
+	const int64_t groupStep = bounds.Step * (int64_t) (factor - 1);
+	const int64_t limit     = bound->GetSignedIntegralValue() - groupStep;
+	const int64_t maxValue  = (int64_t(1) << (ivType->GetBitWidth() - 1)) - 1;
+
+	if (limit > maxValue || limit < -maxValue - 1)
+		return false;
+
+	// preheader -> group header -> 'factor' copies of the loop -> group header
+	//                           \-> original loop (for the remaining iterations)
+	BasicBlock* groupHeader = BasicBlock::Create();
+	m_Function->InsertAfter(m_Function->Where(candidate.Preheader), groupHeader);
+
+	IR::ValueMap map;
+	std::vector<PhiInsn*> groupPhis;
+
+	for (PhiInsn* phi : candidate.HeaderPhis) {
+		PhiInsn* groupPhi = Helix::CreatePhi(VirtualRegisterName::Create(phi->GetResult()->GetType()));
+
+		groupPhi->AddIncoming(phi->GetIncomingValueForBlock(candidate.Preheader), candidate.Preheader);
+		groupHeader->Append(groupPhi);
+		groupPhis.push_back(groupPhi);
+
+		map[phi->GetResult()] = groupPhi->GetResult();
+	}
+
+	VirtualRegisterName* cond = VirtualRegisterName::Create(bounds.ExitCompare->GetResult()->GetType());
+
+	groupHeader->Append(Helix::CreateCompare(bounds.Predicate, map.at(bounds.InductionVariable), ConstantInt::Create(ivType, (Integer) limit), cond));
+
+	BasicBlock* where      = groupHeader;
+	BasicBlock* prevHeader = nullptr;
+	BasicBlock* prevLatch  = nullptr;
+	BasicBlock* firstCopy  = nullptr;
+
+	for (size_t copy = 0; copy < factor; ++copy) {
+		if (copy > 0)
+			map = this->GetNextIterationPhis(candidate, map);
+
+		where = this->CloneIteration(candidate, candidate.Blocks, map, where, candidate.Continue);
+
+		BasicBlock* header = GetMappedBlock(map, candidate.Header);
+
+		if (prevLatch)
+			IR::RetargetBranch(prevLatch->GetLast(), prevHeader, header);
+		else
+			firstCopy = header;
+
+		prevHeader = header;
+		prevLatch  = GetMappedBlock(map, candidate.Latch);
+	}
+
+	IR::RetargetBranch(prevLatch->GetLast(), prevHeader, groupHeader);
+	groupHeader->Append(Helix::CreateConditionalBranch(firstCopy, candidate.Header, cond));
+
+	for (size_t i = 0; i < groupPhis.size(); ++i) {
+		PhiInsn* phi = candidate.HeaderPhis[i];
+
+		groupPhis[i]->AddIncoming(Lookup(map, phi->GetIncomingValueForBlock(candidate.Latch)), prevLatch);
+
+		// The original loop picks up from wherever the groups got to.
+		const size_t incoming = phi->GetIncomingIndex(candidate.Preheader);
+
+		phi->SetIncomingValue(incoming, groupPhis[i]->GetResult());
+		phi->SetIncomingBlock(incoming, groupHeader);
+	}
+
+	IR::RetargetBranch(candidate.Preheader->GetLast(), candidate.Header, groupHeader);
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+void Unroller::MergeClonedBlocks()
+{
+	for (BasicBlock* bb : m_ClonedBlocks) {
+		IR::MergeBlockIntoPredecessor(m_Function, bb);
+	}
+
+	m_ClonedBlocks.clear();
+}
+
+/*********************************************************************************************************************/
+
+void LoopUnroll::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	const size_t threshold = Options::GetUnrollThreshold();
+
+	if (threshold == 0)
+		return;
+
+	LoopInfo& loopInfo = info.Analyses->Get<LoopInfo>(fn);
+
+	if (loopInfo.IsEmpty())
+		return;
+
+	Unroller unroller(fn, info.Analyses->Get<DominatorTree>(fn), threshold);
+
+	// Work out what to do with every loop up front, since unrolling a loop leaves the
+	// loop info out of date. Only innermost loops are unrolled, so each loop only
+	// touches its own blocks (& the branch into it, and the phis after it).
+	std::vector<UnrollCandidate> candidates;
+
+	for (Loop* loop : loopInfo.GetLoopsInnermostFirst()) {
+		UnrollCandidate candidate;
+
+		if (unroller.Analyse(loop, &candidate))
+			candidates.push_back(std::move(candidate));
+	}
+
+	for (UnrollCandidate& candidate : candidates) {
+		if (!unroller.TryFullUnroll(candidate))
+			unroller.TryPartialUnroll(candidate);
+	}
+
+	unroller.MergeClonedBlocks();
+
+	info.Analyses->Invalidate(fn);
+}
+
+/*********************************************************************************************************************/
@@ -0,0 +1,38 @@
+/**
+ * @file loop-unroll.h
+ * @author Barney Wilks
+ *
+ * Loop unrolling, for innermost counted loops.
+ *
+ * Loops with a small constant trip count are fully unrolled, so every
+ * iteration becomes a straight line copy of the loop body (with the
+ * induction variable replaced by its value in that iteration, which SCCP
+ * can then fold into any address calculations). Nothing is left of the
+ * loop afterwards.
+ *
+ * Other counted loops (stepping towards a constant bound) are partially
+ * unrolled instead. A copy of the loop runs 'factor' iterations at a time,
+ * only testing once per group whether all of those iterations will run,
+ * and then the original loop is left to run whatever iterations remain.
+ *
+ * How much code unrolling may create is limited by --unroll-threshold.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class LoopUnroll : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(LoopUnroll, unroll, "[Generic] Fully & partially unroll small counted loops");
+
+/*********************************************************************************************************************/
@@ -0,0 +1,386 @@
+/**
+ * @file loop-unswitch.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in loop-unswitch.h
+ */
+
+/* Internal Project Includes */
+#include "loop-unswitch.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "loop-info.h"
+#include "mem2reg.h"
+#include "options.h"
+
+/* C++ Standard Library Includes */
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// How many times --unswitch-threshold a function may grow by in total, since
+/// unswitching a loop with several invariant branches doubles it for each one.
+static constexpr size_t kGrowthBudgetFactor = 2;
+
+/*********************************************************************************************************************/
+
+struct UnswitchCandidate
+{
+	Loop*                  TheLoop;
+	BasicBlock*            Preheader;
+
+	/// The branch on a loop invariant condition, & the condition itself.
+	ConditionalBranchInsn* Branch;
+	Value*                 Cond;
+
+	/// If the condition is computed inside the loop (from loop invariant values),
+	/// the instruction computing it, which is moved into the preheader.
+	Instruction*           CondDef;
+
+	/// Number of instructions (other than phis) in the loop.
+	size_t                 Size;
+};
+
+/*********************************************************************************************************************/
+
+class Unswitcher
+{
+public:
+	Unswitcher(Function* fn, size_t threshold)
+		: m_Function(fn), m_Threshold(threshold), m_Budget(threshold * kGrowthBudgetFactor) { }
+
+	bool Analyse(Loop* loop, UnswitchCandidate* candidate) const;
+	void Unswitch(const UnswitchCandidate& candidate);
+
+private:
+	/// Return true if 'cond' has the same value on every iteration of 'loop'. If it's
+	/// only computed inside the loop (from values that are invariant), 'def' is set
+	/// to the instruction computing it.
+	bool IsInvariantCondition(Loop* loop, Value* cond, Instruction** def) const;
+
+	/// Both copies of the loop branch to the same exit blocks, so rather than trying
+	/// to join the values coming out of them with phis, anything used after the loop
+	/// (including the phis in the exit blocks) goes through a stack slot. Mem2Reg puts
+	/// them back into registers afterwards.
+	void DemoteExitPhis(const std::vector<BasicBlock*>& exits);
+	void DemoteLiveOutValues(const UnswitchCandidate& candidate);
+
+	/// Copy every block of the loop (after 'where'), with the copy of the header being
+	/// entered from 'preheader'. Returns the mapping of blocks & values to the copy.
+	IR::ValueMap CloneLoop(const UnswitchCandidate& candidate, BasicBlock* preheader, BasicBlock* where);
+
+	/// Give each copy of the loop exit blocks of its own, that branch on to the
+	/// original exits, so that they are only reached from inside that copy.
+	void CreateDedicatedExits(const std::vector<BasicBlock*>& blocks, const std::vector<BasicBlock*>& exits,
+	                          BasicBlock* where);
+
+private:
+	Function* m_Function;
+	size_t    m_Threshold;
+	size_t    m_Budget;
+};
+
+/*********************************************************************************************************************/
+
+bool Unswitcher::IsInvariantCondition(Loop* loop, Value* cond, Instruction** def) const
+{
+	*def = nullptr;
+
+	if (value_isa<ConstantInt>(cond))
+		return false;
+
+	if (loop->IsLoopInvariant(cond))
+		return true;
+
+	Instruction* insn = IR::GetSingleDefinition(cond);
+
+	if (!insn || !loop->Contains(insn) || !IR::IsSafeToSpeculate(insn))
+		return false;
+
+	for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+		if (!insn->OperandHasFlags(i, Instruction::OP_WRITE) && !loop->IsLoopInvariant(insn->GetOperand(i)))
+			return false;
+	}
+
+	*def = insn;
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool Unswitcher::Analyse(Loop* loop, UnswitchCandidate* candidate) const
+{
+	BasicBlock* preheader = loop->GetPreheader();
+
+	if (!preheader || preheader->GetLast()->GetOpcode() != HLIR::UnconditionalBranch)
+		return false;
+
+	size_t size = 0;
+
+	for (BasicBlock* bb : loop->GetBlocks()) {
+		for (Instruction& insn : *bb) {
+			if (insn.GetOpcode() != HLIR::Phi)
+				size++;
+		}
+	}
+
+	if (size > m_Threshold || size > m_Budget)
+		return false;
+
+	for (BasicBlock* bb : loop->GetBlocks()) {
+		if (bb->GetLast()->GetOpcode() != HLIR::ConditionalBranch)
+			continue;
+
+		ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(bb->GetLast());
+
+		if (cbr->GetTrueBB() == cbr->GetFalseBB())
+			continue;
+
+		Instruction* def = nullptr;
+
+		if (!this->IsInvariantCondition(loop, cbr->GetCond(), &def))
+			continue;
+
+		candidate->TheLoop   = loop;
+		candidate->Preheader = preheader;
+		candidate->Branch    = cbr;
+		candidate->Cond      = cbr->GetCond();
+		candidate->CondDef   = def;
+		candidate->Size      = size;
+
+		return true;
+	}
+
+	return false;
+}
+
+/*********************************************************************************************************************/
+
+void Unswitcher::DemoteExitPhis(const std::vector<BasicBlock*>& exits)
+{
+	for (BasicBlock* exit : exits) {
+		for (BasicBlock::iterator it = exit->begin(); it != exit->end();) {
+			if (it->GetOpcode() != HLIR::Phi)
+				break;
+
+			PhiInsn* phi = static_cast<PhiInsn*>(&*it);
+			++it;
+
+			// The last block before reaching the exit is the one that stores the
+			// value coming from it.
+			VirtualRegisterName* slot = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+
+			BasicBlock* head = m_Function->GetHeadBlock();
+			head->InsertBefore(head->begin(), Helix::CreateStackAlloc(slot, phi->GetResult()->GetType()));
+
+			for (size_t i = 0; i < phi->GetCountIncoming(); ++i) {
+				BasicBlock* incoming = phi->GetIncomingBlock(i);
+				IR::InsertBefore(incoming->GetLast(), Helix::CreateStore(phi->GetIncomingValue(i), slot));
+			}
+
+			IR::InsertBefore(&*IR::GetFirstNonPhi(exit), Helix::CreateLoad(slot, phi->GetResult()));
+			phi->DeleteFromParent();
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+void Unswitcher::DemoteLiveOutValues(const UnswitchCandidate& candidate)
+{
+	Loop* loop = candidate.TheLoop;
+
+	for (BasicBlock* bb : loop->GetBlocks()) {
+		for (Instruction& insn : *bb) {
+			for (size_t i = 0; i < insn.GetCountOperands(); ++i) {
+				Value* value = insn.GetOperand(i);
+
+				if (!insn.OperandHasFlags(i, Instruction::OP_WRITE) || !value_isa<VirtualRegisterName>(value))
+					continue;
+
+				std::vector<Use> uses;
+
+				for (const Use& use : value->uses()) {
+					if (!loop->Contains(use.GetInstruction()))
+						uses.push_back(use);
+				}
+
+				if (uses.empty())
+					continue;
+
+				VirtualRegisterName* slot = IR::DemoteToStackSlot(m_Function, value, &insn);
+
+				for (const Use& use : uses) {
+					Instruction* user = use.GetInstruction();
+					Instruction* where = user;
+
+					if (user->GetOpcode() == HLIR::Phi) {
+						const size_t incoming = (use.GetOperandIndex() - 1) / 2;
+						where = static_cast<PhiInsn*>(user)->GetIncomingBlock(incoming)->GetLast();
+					}
+
+					VirtualRegisterName* reload = VirtualRegisterName::Create(value->GetType());
+
+					IR::InsertBefore(where, Helix::CreateLoad(slot, reload));
+					user->SetOperand(use.GetOperandIndex(), reload);
+				}
+			}
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+IR::ValueMap Unswitcher::CloneLoop(const UnswitchCandidate& candidate, BasicBlock* preheader, BasicBlock* where)
+{
+	IR::ValueMap map;
+	map[candidate.Preheader->GetBranchTarget()] = preheader->GetBranchTarget();
+
+	IR::CloneBlocks(candidate.TheLoop->GetBlocks(), map, m_Function, where);
+	return map;
+}
+
+/*********************************************************************************************************************/
+
+void Unswitcher::CreateDedicatedExits(const std::vector<BasicBlock*>& blocks, const std::vector<BasicBlock*>& exits,
+                                      BasicBlock* where)
+{
+	for (BasicBlock* exit : exits) {
+		BasicBlock* dedicated = BasicBlock::Create();
+		dedicated->Append(Helix::CreateUnconditionalBranch(exit));
+
+		m_Function->InsertAfter(m_Function->Where(where), dedicated);
+
+		for (BasicBlock* bb : blocks) {
+			IR::RetargetBranch(bb->GetLast(), exit, dedicated);
+		}
+
+		where = dedicated;
+	}
+}
+
+/*********************************************************************************************************************/
+
+void Unswitcher::Unswitch(const UnswitchCandidate& candidate)
+{
+	Loop* loop = candidate.TheLoop;
+
+	const std::vector<BasicBlock*> exits = loop->GetExitBlocks();
+
+	this->DemoteExitPhis(exits);
+	this->DemoteLiveOutValues(candidate);
+
+	if (candidate.CondDef)
+		IR::MoveBefore(candidate.Preheader->GetLast(), candidate.CondDef);
+
+	// The copies go after the last block of the loop.
+	BasicBlock* last = nullptr;
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (loop->Contains(&bb))
+			last = &bb;
+	}
+
+	// The preheader now does the test, branching to a new preheader for each copy.
+	BasicBlock* trueEntry  = BasicBlock::Create();
+	BasicBlock* falseEntry = BasicBlock::Create();
+
+	trueEntry->Append(Helix::CreateUnconditionalBranch(loop->GetHeader()));
+	m_Function->InsertAfter(m_Function->Where(candidate.Preheader), trueEntry);
+
+	const Type* condType = candidate.Cond->GetType();
+
+	IR::ValueMap map = this->CloneLoop(candidate, falseEntry, last);
+	BasicBlock* header = static_cast<BlockBranchTarget*>(map.at(loop->GetHeader()->GetBranchTarget()))->GetParent();
+
+	falseEntry->Append(Helix::CreateUnconditionalBranch(header));
+	m_Function->InsertAfter(m_Function->Where(trueEntry), falseEntry);
+
+	// Inside each copy the condition is now known. In the false copy it's exactly zero, but
+	// in the true copy it's only known to be non-zero, so there only the branches on it can
+	// be rewritten (`cbr` doesn't care which non-zero value it gets).
+	const IR::ValueMap trueMap = {
+		{ candidate.Preheader->GetBranchTarget(), trueEntry->GetBranchTarget() }
+	};
+
+	const IR::ValueMap falseMap = {
+		{ candidate.Cond, ConstantInt::Create(condType, 0) }
+	};
+
+	std::vector<BasicBlock*> clones;
+
+	for (BasicBlock* bb : loop->GetBlocks()) {
+		BasicBlock* clone = static_cast<BlockBranchTarget*>(map.at(bb->GetBranchTarget()))->GetParent();
+		clones.push_back(clone);
+
+		for (Instruction& insn : *bb) {
+			IR::RemapOperands(&insn, trueMap);
+
+			if (insn.GetOpcode() == HLIR::ConditionalBranch && static_cast<ConditionalBranchInsn&>(insn).GetCond() == candidate.Cond)
+				insn.SetOperand(2, ConstantInt::Create(condType, 1));
+		}
+
+		for (Instruction& insn : *clone) {
+			IR::RemapOperands(&insn, falseMap);
+		}
+	}
+
+	this->CreateDedicatedExits(loop->GetBlocks(), exits, last);
+	this->CreateDedicatedExits(clones, exits, clones.back());
+
+	candidate.Preheader->GetLast()->DeleteFromParent();
+	candidate.Preheader->Append(Helix::CreateConditionalBranch(trueEntry, falseEntry, candidate.Cond));
+
+	m_Budget -= candidate.Size;
+}
+
+/*********************************************************************************************************************/
+
+void LoopUnswitch::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	const size_t threshold = Options::GetUnswitchThreshold();
+
+	if (threshold == 0)
+		return;
+
+	Unswitcher unswitcher(fn, threshold);
+	bool changed = false;
+
+	// Unswitching duplicates the loop (& changes the loops around it), so find the
+	// loops again after each one. The branch that was unswitched is on a constant in
+	// both copies, so it won't be picked again.
+	for (;;) {
+		LoopInfo& loopInfo = info.Analyses->Get<LoopInfo>(fn);
+		UnswitchCandidate candidate;
+
+		bool found = false;
+
+		for (Loop* loop : loopInfo.GetLoopsInnermostFirst()) {
+			if (unswitcher.Analyse(loop, &candidate)) {
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+			break;
+
+		unswitcher.Unswitch(candidate);
+		info.Analyses->Invalidate(fn);
+
+		changed = true;
+	}
+
+	if (!changed)
+		return;
+
+	Mem2Reg mem2reg;
+	mem2reg.Execute(fn, info);
+}
+
+/*********************************************************************************************************************/
@@ -0,0 +1,39 @@
+/**
+ * @file loop-unswitch.h
+ * @author Barney Wilks
+ *
+ * Loop unswitching.
+ *
+ * A loop that branches on something that doesn't change while the loop runs
+ * (a mode or debug flag passed in as a parameter, say) does the same test &
+ * branch every iteration. Unswitching moves that test in front of the loop
+ * and makes a copy of the loop for each way the branch can go, so inside
+ * each copy the condition is a constant that SCCP can fold away (along with
+ * whichever side of the branch can no longer run).
+ *
+ *                                                 preheader (test)
+ *     preheader -> loop { if (flag) A else B }    /              \
+ *                                              loop { A }     loop { B }
+ *
+ * Only loops with at most --unswitch-threshold instructions are unswitched,
+ * and each function may only grow by a few times that in total.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class LoopUnswitch : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(LoopUnswitch, unswitch, "[Generic] Hoist loop invariant branches out of loops by duplicating the loop");
+
+/*********************************************************************************************************************/
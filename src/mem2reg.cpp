@@ -7,96 +7,304 @@
 #include "mem2reg.h"
 #include "ir-helpers.h"
 #include "function.h"
+#include "dominators.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <unordered_set>
 
 using namespace Helix;
 
 /*********************************************************************************************************************/
 
-void Mem2Reg::Execute(Function* fn, const PassRunInformation&)
+/// Return true if the given stack allocation can be promoted to registers, that is
+/// it's an integer or pointer that is only loaded from or stored to (and its address
+/// is never stored anywhere).
+static bool IsPromotable(StackAllocInsn* insn)
 {
-	std::vector<StackAllocInsn*> stackAllocs;
-	IR::FindAllInstructionsOfType(stackAllocs, fn->GetHeadBlock(), HLIR::StackAlloc);
+	Value* outputPtr = insn->GetOutputPtr();
 
-	std::vector<StackAllocInsn*> promotableStackAllocations;
+	if (outputPtr->GetCountUses() == 0)
+		return true;
 
-	for (StackAllocInsn* insn : stackAllocs) {
-		Value* outputPtr = insn->GetOutputPtr();
+	const Type* allocatedType = insn->GetAllocatedType();
 
-		if (outputPtr->GetCountUses() == 0) {
-			promotableStackAllocations.push_back(insn);
+	if (!allocatedType->IsIntegral() && !allocatedType->IsPointer())
+		return false;
+
+	for (const Use& use : outputPtr->uses()) {
+		if (use.GetInstruction() == insn)
 			continue;
+
+		if (use.GetInstruction()->GetOpcode() != HLIR::Load
+			&& use.GetInstruction()->GetOpcode() != HLIR::Store) {
+			return false;
 		}
 
-		const Type* allocatedType = insn->GetAllocatedType();
+		if (use.GetInstruction()->GetOpcode() == HLIR::Store) {
+			StoreInsn* store = (StoreInsn*)use.GetInstruction();
+
+			if (store->GetSrc() == outputPtr)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
 
-		if (!allocatedType->IsIntegral() && !allocatedType->IsPointer())
+void Mem2Reg::Execute(Function* fn, const PassRunInformation& info)
+{
+	m_Allocas.clear();
+	m_AllocaIndices.clear();
+	m_PhiAllocas.clear();
+
+	std::vector<StackAllocInsn*> stackAllocs;
+	IR::FindAllInstructionsOfType(stackAllocs, fn->GetHeadBlock(), HLIR::StackAlloc);
+
+	for (StackAllocInsn* insn : stackAllocs) {
+		if (!IsPromotable(insn))
 			continue;
 
-		bool toRemove = true;
+		m_AllocaIndices[insn->GetOutputPtr()] = m_Allocas.size();
+		m_Allocas.push_back(insn);
+	}
 
-		for (const Use& use : outputPtr->uses()) {
-			if (use.GetInstruction() == insn)
-				continue;
+	if (m_Allocas.empty())
+		return;
 
-			if (use.GetInstruction()->GetOpcode() != HLIR::Load
-				&& use.GetInstruction()->GetOpcode() != HLIR::Store) {
-				toRemove = false;
-			}
-			else {
-				if (use.GetInstruction()->GetOpcode() == HLIR::Store) {
-					StoreInsn* store = (StoreInsn*)use.GetInstruction();
+	const DominatorTree& domTree = info.Analyses->Get<DominatorTree>(fn);
+
+	this->PlacePhis(fn, domTree);
+	this->Rename(fn, domTree);
+
+	for (StackAllocInsn* stackAlloc : m_Allocas) {
+		stackAlloc->DeleteFromParent();
+	}
+}
+
+/*********************************************************************************************************************/
 
-					if (store->GetSrc() == outputPtr)
-						toRemove = false;
+size_t Mem2Reg::GetAllocaIndex(Value* ptr) const
+{
+	auto it = m_AllocaIndices.find(ptr);
+	return it == m_AllocaIndices.end() ? SIZE_MAX : it->second;
+}
+
+/*********************************************************************************************************************/
+
+void Mem2Reg::PlacePhis(Function* fn, const DominatorTree& domTree)
+{
+	for (size_t index = 0; index < m_Allocas.size(); ++index) {
+		Value* ptr = m_Allocas[index]->GetOutputPtr();
+
+		std::unordered_set<BasicBlock*> defBlocks;
+		std::unordered_set<BasicBlock*> useBlocks;
+
+		for (const Use& use : ptr->uses()) {
+			Instruction* insn = use.GetInstruction();
+
+			if (insn->GetOpcode() == HLIR::Store)
+				defBlocks.insert(insn->GetParent());
+			else if (insn->GetOpcode() == HLIR::Load)
+				useBlocks.insert(insn->GetParent());
+		}
+
+		if (useBlocks.empty())
+			continue;
+
+		// Work out which blocks the value of the slot is live on entry to, starting
+		// from blocks that load from the slot before they store to it (if at all)
+		// and walking backwards until reaching a block that stores to the slot.
+		// Phis are only needed in those blocks.
+		std::unordered_set<BasicBlock*> liveIn;
+		std::vector<BasicBlock*>        worklist;
+
+		for (BasicBlock* bb : useBlocks) {
+			for (Instruction& insn : *bb) {
+				if (insn.GetOpcode() == HLIR::Store && static_cast<StoreInsn&>(insn).GetDst() == ptr)
+					break;
+
+				if (insn.GetOpcode() == HLIR::Load && static_cast<LoadInsn&>(insn).GetSrc() == ptr) {
+					liveIn.insert(bb);
+					worklist.push_back(bb);
+					break;
 				}
 			}
 		}
 
-		if (toRemove) {
-			promotableStackAllocations.push_back(insn);
+		while (!worklist.empty()) {
+			BasicBlock* bb = worklist.back();
+			worklist.pop_back();
+
+			for (BasicBlock* pred : IR::GetPredecessors(bb)) {
+				if (defBlocks.count(pred))
+					continue;
+
+				if (liveIn.insert(pred).second)
+					worklist.push_back(pred);
+			}
+		}
+
+		// Iterated dominance frontier of every store. Walk the blocks of the function
+		// (rather than the set) so that phis are created in a stable order.
+		for (BasicBlock& bb : fn->blocks()) {
+			if (defBlocks.count(&bb) && domTree.IsReachable(&bb))
+				worklist.push_back(&bb);
 		}
-	}
 
-	for (StackAllocInsn* stackAlloc : promotableStackAllocations) {
-		Value* outputPtr = stackAlloc->GetOutputPtr();
+		std::unordered_set<BasicBlock*> visited;
 
-		VirtualRegisterName* replacementRegister = VirtualRegisterName::Create(stackAlloc->GetAllocatedType());
+		while (!worklist.empty()) {
+			BasicBlock* bb = worklist.back();
+			worklist.pop_back();
 
-		std::vector<Instruction*> killList;
+			for (BasicBlock* frontier : domTree.GetDominanceFrontier(bb)) {
+				if (!visited.insert(frontier).second)
+					continue;
 
-		for (const Use& use : outputPtr->uses()) {
-			Instruction* user = use.GetInstruction();
+				if (!liveIn.count(frontier))
+					continue;
 
-			switch (user->GetOpcode()) {
-			case HLIR::Load: {
-				LoadInsn* load = (LoadInsn*)user;
-				killList.push_back(load);
+				// Keep phis in the same order as the slots they're for, after any
+				// phis that are already in the block.
+				BasicBlock::iterator where = IR::GetFirstNonPhi(frontier);
 
-				IR::ReplaceAllUsesWith(load->GetDst(), replacementRegister);
-				break;
+				VirtualRegisterName* result = VirtualRegisterName::Create(m_Allocas[index]->GetAllocatedType());
+				PhiInsn* phi = Helix::CreatePhi(result);
+
+				frontier->InsertBefore(where, phi);
+				m_PhiAllocas[phi] = index;
+
+				if (!defBlocks.count(frontier))
+					worklist.push_back(frontier);
 			}
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+void Mem2Reg::Rename(Function* fn, const DominatorTree& domTree)
+{
+	// The value of each slot on entry to the function is undefined.
+	std::vector<Value*> initialValues;
+
+	for (StackAllocInsn* stackAlloc : m_Allocas) {
+		initialValues.push_back(UndefValue::Get(stackAlloc->GetAllocatedType()));
+	}
+
+	// Walk the dominator tree depth first, with the current value of every slot on
+	// entry to each block.
+	std::vector<std::pair<BasicBlock*, std::vector<Value*>>> worklist;
+	worklist.push_back({ domTree.GetRoot(), initialValues });
+
+	while (!worklist.empty()) {
+		auto [bb, values] = std::move(worklist.back());
+		worklist.pop_back();
 
-			case HLIR::Store: {
-				StoreInsn* store = (StoreInsn*) user;
-				killList.push_back(store);
+		this->RenameBlock(bb, values);
+
+		for (BasicBlock* child : domTree.GetChildren(bb)) {
+			worklist.push_back({ child, values });
+		}
+	}
+
+	// Nothing flows into unreachable blocks, but they still have to be rewritten (and
+	// they might still branch to a reachable block with phis).
+	for (BasicBlock& bb : fn->blocks()) {
+		if (domTree.IsReachable(&bb))
+			continue;
+
+		std::vector<Value*> values = initialValues;
+		this->RenameBlock(&bb, values);
+	}
+}
+
+/*********************************************************************************************************************/
+
+void Mem2Reg::RenameBlock(BasicBlock* bb, std::vector<Value*>& values)
+{
+	for (BasicBlock::iterator it = bb->begin(); it != bb->end();) {
+		Instruction* insn = &*it;
+		++it;
 
-				SetInsn* set = Helix::CreateSetInsn(replacementRegister, store->GetSrc());
-				IR::ReplaceInstructionAndPreserveOriginal(store, set);
+		switch (insn->GetOpcode()) {
+		case HLIR::Phi: {
+			PhiInsn* phi = static_cast<PhiInsn*>(insn);
+			auto phiIt = m_PhiAllocas.find(phi);
 
+			if (phiIt != m_PhiAllocas.end())
+				values[phiIt->second] = phi->GetResult();
+
+			break;
+		}
+
+		case HLIR::Load: {
+			LoadInsn* load = static_cast<LoadInsn*>(insn);
+			const size_t index = this->GetAllocaIndex(load->GetSrc());
+
+			if (index == SIZE_MAX)
 				break;
-			}
-			default:
+
+			// Loading an undefined value leaves the destination undefined as
+			// well, rather than filling instructions with undef operands.
+			if (!value_isa<UndefValue>(values[index]))
+				IR::ReplaceAllUsesWith(load->GetDst(), values[index]);
+
+			load->DeleteFromParent();
+			break;
+		}
+
+		case HLIR::Store: {
+			StoreInsn* store = static_cast<StoreInsn*>(insn);
+			const size_t index = this->GetAllocaIndex(store->GetDst());
+
+			if (index == SIZE_MAX)
 				break;
+
+			Value* src = store->GetSrc();
+
+			if (value_isa<VirtualRegisterName>(src) && IR::IsSingleAssignment(bb->GetParent(), src)) {
+				values[index] = src;
+				store->DeleteFromParent();
+			} else {
+				// Anything else (constants, globals etc...) gets its own register, so
+				// that later passes see the same shape of IR as they would otherwise.
+				VirtualRegisterName* reg = VirtualRegisterName::Create(m_Allocas[index]->GetAllocatedType());
+				IR::ReplaceInstructionAndDestroyOriginal(store, Helix::CreateSetInsn(reg, src));
+
+				values[index] = reg;
 			}
+
+			break;
 		}
 
-		for (Instruction* insn : killList) {
-			insn->DeleteFromParent();
+		default:
+			break;
 		}
+	}
 
-		stackAlloc->DeleteFromParent();
+	std::vector<BasicBlock*> successors;
+
+	for (BasicBlock* succ : bb->GetSuccessors()) {
+		if (std::find(successors.begin(), successors.end(), succ) == successors.end())
+			successors.push_back(succ);
+	}
+
+	for (BasicBlock* succ : successors) {
+		for (Instruction& insn : *succ) {
+			if (insn.GetOpcode() != HLIR::Phi)
+				break;
+
+			PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+			auto phiIt = m_PhiAllocas.find(phi);
+
+			if (phiIt != m_PhiAllocas.end())
+				phi->AddIncoming(values[phiIt->second], bb);
+		}
 	}
 }
 
 /*********************************************************************************************************************/
-
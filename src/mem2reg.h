@@ -1,22 +1,56 @@
 /**
  * @file mem2reg.h
  * @author Barney Wilks
+ *
+ * Promotes stack slots that are only ever loaded from & stored to directly
+ * into virtual registers, constructing SSA form as it goes.
+ *
+ * Phis are placed at the iterated dominance frontier of the blocks that store
+ * to each slot (pruned to the blocks where the slot is live on entry), and then
+ * loads & stores are renamed by walking the dominator tree.
+ *
+ * (as described in Efficiently Computing Static Single Assignment Form and the
+ *  Control Dependence Graph - Cytron, Ferrante, Rosen, Wegman & Zadeck)
  */
 
 #pragma once
 
 #include "pass-manager.h"
 
+/* C++ Standard Library Includes */
+#include <unordered_map>
+#include <vector>
+
 /*********************************************************************************************************************/
 
 namespace Helix
 {
+	class Value;
+	class DominatorTree;
+	class StackAllocInsn;
+	class PhiInsn;
+
 	class Mem2Reg : public FunctionPass
 	{
 	public:
 		void Execute(Function* fn, const PassRunInformation& info) override;
 
 	private:
+		void PlacePhis(Function* fn, const DominatorTree& domTree);
+		void Rename(Function* fn, const DominatorTree& domTree);
+		void RenameBlock(BasicBlock* bb, std::vector<Value*>& values);
+
+		size_t GetAllocaIndex(Value* ptr) const;
+
+	private:
+		/// Stack allocations that are being promoted.
+		std::vector<StackAllocInsn*>         m_Allocas;
+
+		/// Map of the pointer to each promoted slot -> index in m_Allocas
+		std::unordered_map<Value*, size_t>   m_AllocaIndices;
+
+		/// Map of the phis placed by this pass -> index of the slot they're for.
+		std::unordered_map<PhiInsn*, size_t> m_PhiAllocas;
 	};
 }
 
@@ -14,6 +14,9 @@
 #include "system.h"
 #include "print.h"
 
+/* C++ Standard Library Includes */
+#include <algorithm>
+
 /* C Standard Library Includes */
 #include <stdio.h>
 
@@ -52,6 +55,29 @@ Module::RegisterGlobalVariable(GlobalVariable* gvar)
 
 /******************************************************************************/
 
+void
+Module::RemoveFunction(Function* fn)
+{
+	auto it = std::find(m_Functions.begin(), m_Functions.end(), fn);
+	helix_assert(it != m_Functions.end(), "function isn't in this module");
+
+	fn->SetParent(nullptr);
+	m_Functions.erase(it);
+}
+
+/******************************************************************************/
+
+void
+Module::RemoveGlobalVariable(GlobalVariable* gvar)
+{
+	auto it = std::find(m_GlobalVariables.begin(), m_GlobalVariables.end(), gvar);
+	helix_assert(it != m_GlobalVariables.end(), "global variable isn't in this module");
+
+	m_GlobalVariables.erase(it);
+}
+
+/******************************************************************************/
+
 Function*
 Module::FindFunctionByName(const std::string& name) const
 {
@@ -50,6 +50,12 @@ namespace Helix
 		void RegisterStruct(const StructType* ty);
 		void RegisterGlobalVariable(GlobalVariable* gvar);
 
+		/// Remove the function/global variable from this module. This doesn't
+		/// destroy it, or anything that uses it, so it should be unused
+		/// (and a function should have had its body dropped first).
+		void RemoveFunction(Function* fn);
+		void RemoveGlobalVariable(GlobalVariable* gvar);
+
 		Function* FindFunctionByName(const std::string& name) const;
 
 		void DumpControlFlowGraphToFile(const std::string& filepath);
@@ -54,6 +54,36 @@ namespace Helix
 			IMPLEMENT_OPCODE_CATEGORY_IDENTITY(class_name)
 
 		#include "insns.def"
+
+		/// Return the compare opcode that gives the opposite result (Undefined if
+		/// 'opc' isn't a compare).
+		constexpr inline Opcode GetInversePredicate(Opcode opc)
+		{
+			switch (opc) {
+			case ICmp_Eq:  return ICmp_Neq;
+			case ICmp_Neq: return ICmp_Eq;
+			case ICmp_Lt:  return ICmp_Gte;
+			case ICmp_Gte: return ICmp_Lt;
+			case ICmp_Gt:  return ICmp_Lte;
+			case ICmp_Lte: return ICmp_Gt;
+			default:       return Undefined;
+			}
+		}
+
+		/// Return the compare opcode that gives the same result when the operands
+		/// are swapped (Undefined if 'opc' isn't a compare).
+		constexpr inline Opcode GetSwappedPredicate(Opcode opc)
+		{
+			switch (opc) {
+			case ICmp_Eq:  return ICmp_Eq;
+			case ICmp_Neq: return ICmp_Neq;
+			case ICmp_Lt:  return ICmp_Gt;
+			case ICmp_Gt:  return ICmp_Lt;
+			case ICmp_Lte: return ICmp_Gte;
+			case ICmp_Gte: return ICmp_Lte;
+			default:       return Undefined;
+			}
+		}
 	}
 
 	/**************************************************************************/
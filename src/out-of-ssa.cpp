@@ -0,0 +1,214 @@
+/**
+ * @file out-of-ssa.cpp
+ * @author Barney Wilks
+ */
+
+/* Internal Project Includes */
+#include "out-of-ssa.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "dominators.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// A copy of 'Src' into 'Dst', that is one part of a parallel copy.
+struct Copy
+{
+	Value* Dst;
+	Value* Src;
+};
+
+/*********************************************************************************************************************/
+
+/// Insert the given (parallel) copies before 'where' as a sequence of `set`s, ordered such that
+/// every value is read before it's overwritten.
+static void SequentialiseCopies(std::vector<Copy> copies, Instruction* where)
+{
+	// Copying a value to itself doesn't do anything, and there's nothing to copy
+	// from an undefined value.
+	copies.erase(
+		std::remove_if(copies.begin(), copies.end(), [](const Copy& copy) {
+			return copy.Dst == copy.Src || value_isa<UndefValue>(copy.Src);
+		}),
+		copies.end()
+	);
+
+	auto isReadByAnotherCopy = [&copies](const Copy& copy) {
+		return std::any_of(copies.begin(), copies.end(), [&copy](const Copy& other) {
+			return &other != &copy && other.Src == copy.Dst;
+		});
+	};
+
+	while (!copies.empty()) {
+		auto ready = std::find_if(copies.begin(), copies.end(), [&](const Copy& copy) {
+			return !isReadByAnotherCopy(copy);
+		});
+
+		if (ready != copies.end()) {
+			IR::InsertBefore(where, Helix::CreateSetInsn(ready->Dst, ready->Src));
+			copies.erase(ready);
+			continue;
+		}
+
+		// Every destination that's left is still needed by another copy, so there
+		// must be a cycle. Save one of the values to a temporary to break it.
+		Value* saved = copies[0].Dst;
+		VirtualRegisterName* temp = VirtualRegisterName::Create(saved->GetType());
+
+		IR::InsertBefore(where, Helix::CreateSetInsn(temp, saved));
+
+		for (Copy& copy : copies) {
+			if (copy.Src == saved)
+				copy.Src = temp;
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+/// Return true if the value of 'reg' (defined by a phi in 'def') could be read after
+/// reaching 'from', before 'def' gives it a new value.
+static bool IsLiveInto(Value* reg, BasicBlock* from, BasicBlock* def)
+{
+	std::unordered_set<BasicBlock*> useBlocks;
+
+	for (const Use& use : reg->uses()) {
+		Instruction* user = use.GetInstruction();
+
+		if (user->OperandHasFlags(use.GetOperandIndex(), Instruction::OP_WRITE))
+			continue;
+
+		// Phis read their incoming values at the end of the incoming block.
+		if (user->GetOpcode() == HLIR::Phi)
+			useBlocks.insert(static_cast<PhiInsn*>(user)->GetIncomingBlock((use.GetOperandIndex() - 1) / 2));
+		else
+			useBlocks.insert(user->GetParent());
+	}
+
+	std::unordered_set<BasicBlock*> visited;
+	std::vector<BasicBlock*> worklist { from };
+
+	while (!worklist.empty()) {
+		BasicBlock* bb = worklist.back();
+		worklist.pop_back();
+
+		if (bb == def || !visited.insert(bb).second)
+			continue;
+
+		if (useBlocks.count(bb))
+			return true;
+
+		for (BasicBlock* succ : bb->GetSuccessors()) {
+			worklist.push_back(succ);
+		}
+	}
+
+	return false;
+}
+
+/*********************************************************************************************************************/
+
+/// Return true if the copies for the phis in 'bb' can go at the end of 'pred' (before
+/// its terminator) even though 'pred' also branches elsewhere, which is the case as
+/// long as nothing on the other paths needs the old values of the phis.
+static bool CanCopyBeforeBranch(BasicBlock* pred, BasicBlock* bb)
+{
+	Instruction* terminator = pred->GetLast();
+
+	for (Instruction& insn : *bb) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		Value* result = static_cast<PhiInsn&>(insn).GetResult();
+
+		for (size_t i = 0; i < terminator->GetCountOperands(); ++i) {
+			if (terminator->GetOperand(i) == result)
+				return false;
+		}
+
+		for (BasicBlock* succ : pred->GetSuccessors()) {
+			if (succ == bb)
+				continue;
+
+			// A phi in the other successor reads its value for 'pred' on the way out of
+			// 'pred' (after the copies), which IsLiveInto doesn't see from 'succ'.
+			for (Instruction& other : *succ) {
+				if (other.GetOpcode() != HLIR::Phi)
+					break;
+
+				if (static_cast<PhiInsn&>(other).GetIncomingValueForBlock(pred) == result)
+					return false;
+			}
+
+			if (IsLiveInto(result, succ, bb))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+void OutOfSSA::Execute(Function* fn, const PassRunInformation&)
+{
+	std::vector<BasicBlock*> phiBlocks;
+
+	for (BasicBlock& bb : fn->blocks()) {
+		if (!bb.IsEmpty() && bb.begin()->GetOpcode() == HLIR::Phi)
+			phiBlocks.push_back(&bb);
+	}
+
+	if (phiBlocks.empty())
+		return;
+
+	const DominatorTree domTree(fn);
+
+	for (BasicBlock* bb : phiBlocks) {
+		std::vector<BasicBlock*> preds;
+
+		for (BasicBlock* pred : IR::GetPredecessors(bb)) {
+			if (std::find(preds.begin(), preds.end(), pred) == preds.end())
+				preds.push_back(pred);
+		}
+
+		for (BasicBlock* pred : preds) {
+			// Copies can only go at the end of the predecessor if they're not going to
+			// be executed when branching elsewhere. The exception is the back edge of
+			// a loop that's tested at the bottom, where it's better to do the copies
+			// on the way out of the loop too (if that's harmless) than to give the
+			// back edge a block & another branch of its own.
+			const bool isBackEdge = domTree.Dominates(bb, pred);
+
+			if (pred->GetSuccessors().size() > 1 && !(isBackEdge && CanCopyBeforeBranch(pred, bb)))
+				pred = IR::SplitEdge(fn, pred, bb);
+
+			std::vector<Copy> copies;
+
+			for (Instruction& insn : *bb) {
+				if (insn.GetOpcode() != HLIR::Phi)
+					break;
+
+				PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+
+				if (Value* value = phi->GetIncomingValueForBlock(pred))
+					copies.push_back({ phi->GetResult(), value });
+			}
+
+			SequentialiseCopies(copies, pred->GetLast());
+		}
+
+		while (bb->begin()->GetOpcode() == HLIR::Phi) {
+			bb->begin()->DeleteFromParent();
+		}
+	}
+}
+
+/*********************************************************************************************************************/
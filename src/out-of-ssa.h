@@ -0,0 +1,33 @@
+/**
+ * @file out-of-ssa.h
+ * @author Barney Wilks
+ *
+ * Translates out of SSA form, replacing phis with copies (`set`) at the end
+ * of each predecessor block, before the backend (which doesn't know about
+ * phis) sees the IR.
+ *
+ * Critical edges (from a block with several successors to a block with several
+ * predecessors) are split first, so that copies only ever execute on the edge
+ * they're for. The copies for an edge happen "at the same time" (a parallel
+ * copy), so they're ordered such that no value is overwritten before it's
+ * read - cycles (e.g. swapping two values) are broken with a temporary.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class OutOfSSA : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(OutOfSSA, outofssa, "[Generic] Replace phis with copies, translating out of SSA form");
+
+/*********************************************************************************************************************/
@@ -5,6 +5,7 @@
 #include "module.h"
 #include "print.h"
 #include "options.h"
+#include "dominators.h"
 
 /* Pass Internal Project Includes */
 #include "lower.h"
@@ -16,8 +17,24 @@
 #include "arm-split-constants.h"
 #include "peephole-generic.h"
 #include "mem2reg.h"
-#include "scp.h"
+#include "sroa.h"
+#include "inliner.h"
+#include "ipcp.h"
+#include "function-attrs.h"
+#include "sccp.h"
+#include "reassociate.h"
+#include "gvn.h"
+#include "pre.h"
+#include "licm.h"
+#include "loop-unroll.h"
+#include "loop-rotate.h"
+#include "loop-unswitch.h"
+#include "loop-strength-reduce.h"
+#include "simplify-cfg.h"
+#include "jump-threading.h"
 #include "dce.h"
+#include "global-dce.h"
+#include "out-of-ssa.h"
 
 using namespace Helix;
 
@@ -31,11 +48,29 @@ PassManager::PassManager()
 	AddPass<GenericLegalizer>();
 	AddPass<LegaliseStructs>();
 	AddPass<ReturnCombine>();
+	AddPass<SROA>();
 	AddPass<GenericLowering>();
 	AddPass<Mem2Reg>();
+	AddPass<SimplifyCFG>();
 	AddPass<PeepholeGeneric>();
-	AddPass<SCP>();
+	AddPass<Inliner>();
+	AddPass<IPCP>();
+	AddPass<FunctionAttrs>();
+	AddPass<LoopUnroll>();
+	AddPass<LoopRotate>();
+	AddPass<LoopUnswitch>();
+	AddPass<SCCP>();
+	AddPass<SimplifyCFG>();
+	AddPass<Reassociate>();
+	AddPass<GVN>();
+	AddPass<JumpThreading>();
+	AddPass<PRE>();
+	AddPass<LICM>();
+	AddPass<LoopStrengthReduce>();
 	AddPass<DCE>();
+	AddPass<LateSimplifyCFG>();
+	AddPass<GlobalDCE>();
+	AddPass<OutOfSSA>();
 
 	/* ARM Specific Passes */
 	AddPass<CConv>();
@@ -72,9 +107,14 @@ void PassManager::RunPass(const PassData& passData, Module* module)
 
 	PassRunInformation info;
 	info.TestTrace = (Options::GetTestTracePass() == passData.name);
+	info.Analyses = &m_Analyses;
 
 	pass->Execute(module, info);
 
+	// Passes don't (yet) say what they preserve, so assume the worst and
+	// recompute anything that's needed by the next pass.
+	m_Analyses.InvalidateAll();
+
 	if (Options::GetEmitIRPostPass() == passData.name) {
 		Helix::DebugDump(*module);
 	}
@@ -82,6 +122,10 @@ void PassManager::RunPass(const PassData& passData, Module* module)
 	if (Options::GetDumpCFGPost() == passData.name) {
 		module->DumpControlFlowGraphToFile(fmt::format("cfg-{}.dot", passData.name));
 	}
+
+	if (Options::GetDumpDomTree() == passData.name) {
+		Helix::DumpDominatorTreesToFile(module, fmt::format("domtree-{}.dot", passData.name));
+	}
 }
 
 /*********************************************************************************************************************/
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "system.h"
+#include "analysis-manager.h"
 
 #include <vector>
 #include <memory>
@@ -31,6 +32,10 @@ namespace Helix
 	struct PassRunInformation
 	{
 		bool TestTrace = false;
+
+		/// Cache of analyses (dominator trees, loop info etc...) that passes
+		/// can query, see analysis-manager.h
+		AnalysisManager* Analyses = nullptr;
 	};
 
 	class Pass
@@ -96,5 +101,6 @@ namespace Helix
 		}
 
 		std::vector<PassData> m_Passes;
+		AnalysisManager       m_Analyses;
 	};
 }
\ No newline at end of file
@@ -7,50 +7,267 @@
 #include "function.h"
 #include "instructions.h"
 #include "ir-helpers.h"
+#include "value-tracking.h"
+
+#include <algorithm>
+#include <vector>
 
 using namespace Helix;
 
 /*********************************************************************************************************************/
 
-void PeepholeGeneric::Execute(Function* fn, const PassRunInformation&)
+/// What an operand has to be for an identity to apply.
+enum class IdentityMatch
+{
+	LhsZero,
+	RhsZero,
+	LhsOne,
+	RhsOne,
+	SameOperands
+};
+
+/// What the result of an instruction is when an identity applies.
+enum class IdentityResult
+{
+	Lhs,
+	Rhs,
+	Zero,
+	One
+};
+
+struct IdentityPattern
+{
+	HLIR::Opcode   Opcode;
+	IdentityMatch  Match;
+	IdentityResult Result;
+};
+
+/// Algebraic identities that replace an instruction with one of its operands (or
+/// a constant). Commutative operations list the constant on both sides, rather
+/// than shuffling operands around to put it on one side.
+static const IdentityPattern kIdentities[] = {
+	{ HLIR::IAdd,     IdentityMatch::RhsZero,      IdentityResult::Lhs  }, // x + 0 = x
+	{ HLIR::IAdd,     IdentityMatch::LhsZero,      IdentityResult::Rhs  }, // 0 + x = x
+	{ HLIR::ISub,     IdentityMatch::RhsZero,      IdentityResult::Lhs  }, // x - 0 = x
+	{ HLIR::ISub,     IdentityMatch::SameOperands, IdentityResult::Zero }, // x - x = 0
+	{ HLIR::IMul,     IdentityMatch::RhsOne,       IdentityResult::Lhs  }, // x * 1 = x
+	{ HLIR::IMul,     IdentityMatch::LhsOne,       IdentityResult::Rhs  }, // 1 * x = x
+	{ HLIR::IMul,     IdentityMatch::RhsZero,      IdentityResult::Zero }, // x * 0 = 0
+	{ HLIR::IMul,     IdentityMatch::LhsZero,      IdentityResult::Zero }, // 0 * x = 0
+	{ HLIR::IUDiv,    IdentityMatch::RhsOne,       IdentityResult::Lhs  }, // x / 1 = x
+	{ HLIR::ISDiv,    IdentityMatch::RhsOne,       IdentityResult::Lhs  }, // x / 1 = x
+	{ HLIR::IURem,    IdentityMatch::RhsOne,       IdentityResult::Zero }, // x % 1 = 0
+	{ HLIR::ISRem,    IdentityMatch::RhsOne,       IdentityResult::Zero }, // x % 1 = 0
+	{ HLIR::And,      IdentityMatch::RhsZero,      IdentityResult::Zero }, // x & 0 = 0
+	{ HLIR::And,      IdentityMatch::LhsZero,      IdentityResult::Zero }, // 0 & x = 0
+	{ HLIR::And,      IdentityMatch::SameOperands, IdentityResult::Lhs  }, // x & x = x
+	{ HLIR::Or,       IdentityMatch::RhsZero,      IdentityResult::Lhs  }, // x | 0 = x
+	{ HLIR::Or,       IdentityMatch::LhsZero,      IdentityResult::Rhs  }, // 0 | x = x
+	{ HLIR::Or,       IdentityMatch::SameOperands, IdentityResult::Lhs  }, // x | x = x
+	{ HLIR::Xor,      IdentityMatch::RhsZero,      IdentityResult::Lhs  }, // x ^ 0 = x
+	{ HLIR::Xor,      IdentityMatch::LhsZero,      IdentityResult::Rhs  }, // 0 ^ x = x
+	{ HLIR::Xor,      IdentityMatch::SameOperands, IdentityResult::Zero }, // x ^ x = 0
+	{ HLIR::Shl,      IdentityMatch::RhsZero,      IdentityResult::Lhs  }, // x << 0 = x
+	{ HLIR::Shl,      IdentityMatch::LhsZero,      IdentityResult::Zero }, // 0 << x = 0
+	{ HLIR::Shr,      IdentityMatch::RhsZero,      IdentityResult::Lhs  }, // x >> 0 = x
+	{ HLIR::Shr,      IdentityMatch::LhsZero,      IdentityResult::Zero }, // 0 >> x = 0
+	{ HLIR::AShr,     IdentityMatch::RhsZero,      IdentityResult::Lhs  }, // x >> 0 = x
+	{ HLIR::AShr,     IdentityMatch::LhsZero,      IdentityResult::Zero }, // 0 >> x = 0
+	{ HLIR::IMulHS,   IdentityMatch::RhsZero,      IdentityResult::Zero }, // mulh(x, 0) = 0
+	{ HLIR::IMulHS,   IdentityMatch::LhsZero,      IdentityResult::Zero }, // mulh(0, x) = 0
+	{ HLIR::IMulHU,   IdentityMatch::RhsZero,      IdentityResult::Zero }, // mulh(x, 0) = 0
+	{ HLIR::IMulHU,   IdentityMatch::LhsZero,      IdentityResult::Zero }, // mulh(0, x) = 0
+	{ HLIR::ICmp_Eq,  IdentityMatch::SameOperands, IdentityResult::One  }, // x == x
+	{ HLIR::ICmp_Gte, IdentityMatch::SameOperands, IdentityResult::One  }, // x >= x
+	{ HLIR::ICmp_Lte, IdentityMatch::SameOperands, IdentityResult::One  }, // x <= x
+	{ HLIR::ICmp_Neq, IdentityMatch::SameOperands, IdentityResult::Zero }, // x != x
+	{ HLIR::ICmp_Gt,  IdentityMatch::SameOperands, IdentityResult::Zero }, // x > x
+	{ HLIR::ICmp_Lt,  IdentityMatch::SameOperands, IdentityResult::Zero }, // x < x
+};
+
+/*********************************************************************************************************************/
+
+static Integer GetWidthMask(const Type* type)
+{
+	const IntegerType* integerType = type_cast<IntegerType>(type);
+
+	if (!integerType || integerType->GetBitWidth() >= 64)
+		return UINT64_MAX;
+
+	return (Integer(1) << integerType->GetBitWidth()) - 1;
+}
+
+/*********************************************************************************************************************/
+
+/// Return true if 'value' is the constant 'expected' (ignoring any bits above the width of its type).
+static bool IsConstant(Value* value, Integer expected)
 {
-	size_t nPasses = 0;
+	ConstantInt* constant = value_cast<ConstantInt>(value);
+	return constant && (constant->GetIntegralValue() & GetWidthMask(constant->GetType())) == expected;
+}
 
-	for (;;) {
-		bool bFlagChanges = false;
+/*********************************************************************************************************************/
 
-		for (BasicBlock& bb : fn->blocks()) {
-			BasicBlock::iterator input = bb.begin();
+static bool MatchesIdentity(IdentityMatch match, Value* lhs, Value* rhs)
+{
+	switch (match) {
+	case IdentityMatch::LhsZero:      return IsConstant(lhs, 0);
+	case IdentityMatch::RhsZero:      return IsConstant(rhs, 0);
+	case IdentityMatch::LhsOne:       return IsConstant(lhs, 1);
+	case IdentityMatch::RhsOne:       return IsConstant(rhs, 1);
+	case IdentityMatch::SameOperands: return lhs == rhs;
+	}
 
-			while (input != bb.end()) {
-				input = DoInstruction(input, &bFlagChanges);
-			}
+	return false;
+}
+
+/*********************************************************************************************************************/
+
+void PeepholeGeneric::Execute(Function* fn, const PassRunInformation& info)
+{
+	// Every rewrite below replaces a value with an equivalent one, so the facts
+	// computed up front stay true for the whole pass.
+	m_Function      = fn;
+	m_ValueTracking = &info.Analyses->Get<ValueTracking>(fn);
+
+	m_Worklist.clear();
+	m_InWorklist.clear();
+
+	for (BasicBlock& bb : fn->blocks()) {
+		for (Instruction& insn : bb) {
+			this->AddToWorklist(&insn);
 		}
+	}
+
+	// Taken from the back, so reverse it to start at the top of the function
+	// (values are then mostly simplified before their users are looked at).
+	std::reverse(m_Worklist.begin(), m_Worklist.end());
+
+	size_t nVisited = 0;
+	size_t nChanges = 0;
+
+	while (!m_Worklist.empty()) {
+		Instruction* insn = m_Worklist.back();
+		m_Worklist.pop_back();
+
+		// Deleted (or already looked at, if it was added twice) since it was added.
+		if (!m_InWorklist.erase(insn))
+			continue;
+
+		nVisited++;
+
+		if (this->DoInstruction(insn))
+			nChanges++;
+	}
+
+	helix_debug(logs::peepholegeneric, "Generic peephole optimiser made {} changes ({} instructions visited)", nChanges, nVisited);
+}
+
+/*********************************************************************************************************************/
+
+void PeepholeGeneric::AddToWorklist(Instruction* insn)
+{
+	if (m_InWorklist.insert(insn).second)
+		m_Worklist.push_back(insn);
+}
+
+/*********************************************************************************************************************/
 
-		nPasses++;
+void PeepholeGeneric::AddUsersToWorklist(Instruction* insn, Value* value)
+{
+	if (!value_isa<VirtualRegisterName>(value))
+		return;
 
-		if (!bFlagChanges)
-			break;
+	for (const Use& use : value->uses()) {
+		if (use.GetInstruction() != insn)
+			this->AddToWorklist(use.GetInstruction());
 	}
+}
+
+/*********************************************************************************************************************/
+
+void PeepholeGeneric::AddOperandsToWorklist(Instruction* insn)
+{
+	for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+		Value* operand = insn->GetOperand(i);
 
-	helix_debug(logs::peepholegeneric, "Generic peephole optimiser executed in {} passes", nPasses);
+		if (!insn->OperandHasFlags(i, Instruction::OP_READ) || !value_isa<VirtualRegisterName>(operand))
+			continue;
+
+		if (Instruction* def = IR::GetSingleDefinition(operand))
+			this->AddToWorklist(def);
+	}
 }
 
 /*********************************************************************************************************************/
 
-BasicBlock::iterator PeepholeGeneric::DoInstruction(BasicBlock::iterator input, bool* bFlagChanges)
+bool PeepholeGeneric::DoInstruction(Instruction* insn)
 {
-	Instruction* insn = &(*input);
+	const HLIR::Opcode opc = (HLIR::Opcode) insn->GetOpcode();
 
-	if (HLIR::IsBinaryOp((HLIR::Opcode) input->GetOpcode())) {
-		return DoGenericBinOp((BinOpInsn*)insn, bFlagChanges);
+	if (HLIR::IsBinaryOp(opc) || HLIR::IsCompare(opc)) {
+		if (this->DoIdentity(insn))
+			return true;
 	}
 
-	if (input->GetOpcode() == HLIR::IMul) {
-		return DoIMul((BinOpInsn*)insn, bFlagChanges);
+	if (HLIR::IsCompare(opc)) {
+		return DoCompare((CompareInsn*)insn);
 	}
 
-	return input++;
+	if (opc == HLIR::ZExt || opc == HLIR::SExt || opc == HLIR::Trunc) {
+		return DoCast(insn);
+	}
+
+	if (!HLIR::IsBinaryOp(opc))
+		return false;
+
+	BinOpInsn* binop = (BinOpInsn*) insn;
+
+	if (DoGenericBinOp(binop))
+		return true;
+
+	switch (opc) {
+	case HLIR::ISub:
+	case HLIR::Xor:
+		return DoNegation(binop);
+
+	case HLIR::Shl:
+	case HLIR::Shr:
+		return DoShift(binop);
+
+	case HLIR::And:
+		return DoAnd(binop);
+
+	case HLIR::ISDiv:
+	case HLIR::ISRem:
+		return DoDivision(binop);
+
+	default:
+		return false;
+	}
+}
+
+/*********************************************************************************************************************/
+
+bool PeepholeGeneric::DoIdentity(Instruction* insn)
+{
+	Value* lhs = insn->GetOperand(0);
+	Value* rhs = insn->GetOperand(1);
+	Value* dst = insn->GetOperand(2);
+
+	for (const IdentityPattern& pattern : kIdentities) {
+		if (pattern.Opcode != insn->GetOpcode() || !MatchesIdentity(pattern.Match, lhs, rhs))
+			continue;
+
+		switch (pattern.Result) {
+		case IdentityResult::Lhs:  return ReplaceWithValue(insn, dst, lhs);
+		case IdentityResult::Rhs:  return ReplaceWithValue(insn, dst, rhs);
+		case IdentityResult::Zero: return ReplaceWithValue(insn, dst, ConstantInt::Create(dst->GetType(), 0));
+		case IdentityResult::One:  return ReplaceWithValue(insn, dst, ConstantInt::Create(dst->GetType(), 1));
+		}
+	}
+
+	return false;
 }
 
 /*********************************************************************************************************************/
@@ -59,72 +276,305 @@ static ConstantInt* FoldConstantBinaryOperation(HLIR::Opcode opc, ConstantInt* l
 {
 	helix_assert(lhs->GetType() == rhs->GetType(), "LHS and RHS types must be the same in order to fold binop :)");
 
+	const Integer mask = GetWidthMask(lhs->GetType());
+
+	const Integer a = lhs->GetIntegralValue() & mask;
+	const Integer b = rhs->GetIntegralValue() & mask;
+
 	Helix::Integer result = 0;
 
-	/* #FIXME: Handle overflow for differently sized types correctly :) */
 	switch (opc) {
-	case HLIR::IAdd:  result = lhs->GetIntegralValue() + rhs->GetIntegralValue(); break;
-	case HLIR::ISub:  result = lhs->GetIntegralValue() - rhs->GetIntegralValue(); break;
-	case HLIR::IMul:  result = lhs->GetIntegralValue() * rhs->GetIntegralValue(); break;
+	case HLIR::IAdd:  result = a + b; break;
+	case HLIR::ISub:  result = a - b; break;
+	case HLIR::IMul:  result = a * b; break;
+	case HLIR::And:   result = a & b; break;
+	case HLIR::Or:    result = a | b; break;
+	case HLIR::Xor:   result = a ^ b; break;
 
 	/* #FIXME: Add support for signed/unsigned division */
 	default:
 		return nullptr;
 	}
 
-	return ConstantInt::Create(lhs->GetType(), result);
+	return ConstantInt::Create(lhs->GetType(), result & mask);
 }
 
 /*********************************************************************************************************************/
 
-BasicBlock::iterator PeepholeGeneric::DoGenericBinOp(BinOpInsn* binop, bool* bFlagChanges)
+bool PeepholeGeneric::DoGenericBinOp(BinOpInsn* binop)
 {
-	Value* lhs = binop->GetLHS();
-	Value* rhs = binop->GetRHS();
+	ConstantInt* lhs = value_cast<ConstantInt>(binop->GetLHS());
+	ConstantInt* rhs = value_cast<ConstantInt>(binop->GetRHS());
 
-	if (value_isa<ConstantInt>(lhs) && value_isa<ConstantInt>(rhs)) {
-		ConstantInt* lhsIntegerValue = value_cast<ConstantInt>(lhs);
-		ConstantInt* rhsIntegerValue = value_cast<ConstantInt>(rhs);
+	if (!lhs || !rhs)
+		return false;
 
-		ConstantInt* result = FoldConstantBinaryOperation((HLIR::Opcode) binop->GetOpcode(), lhsIntegerValue, rhsIntegerValue);
+	ConstantInt* result = FoldConstantBinaryOperation((HLIR::Opcode) binop->GetOpcode(), lhs, rhs);
 
-		if (result) {
-			IR::ReplaceAllUsesWith(binop->GetResult(), result);
+	if (!result)
+		return false;
 
-			BasicBlock::iterator next = IR::GetNext(binop);
-			binop->DeleteFromParent();
+	return ReplaceWithValue(binop, binop->GetResult(), result);
+}
 
-			*bFlagChanges = true;
+/*********************************************************************************************************************/
 
-			return next;
-		}
+/// Return true if every read of 'dst' can be replaced with 'value'. Both are SSA values, so when 'dst'
+/// only has the one definition (which reads 'value') then 'value' is available wherever 'dst' is read,
+/// in any block.
+static bool CanForwardValue(Function* fn, Value* dst, Value* value)
+{
+	return IR::GetCountWriteUsers(dst) == 1 && IR::IsSingleAssignment(fn, value);
+}
+
+/*********************************************************************************************************************/
+
+bool PeepholeGeneric::ReplaceWithValue(Instruction* insn, Value* dst, Value* value)
+{
+	// Writing a register to itself (e.g. `iadd %a, 0, %a`) doesn't do anything.
+	if (value == dst || !CanForwardValue(m_Function, dst, value))
+		return ReplaceInstruction(insn, value == dst ? nullptr : Helix::CreateSetInsn(dst, value));
+
+	this->AddUsersToWorklist(insn, dst);
+	this->AddOperandsToWorklist(insn);
+
+	m_InWorklist.erase(insn);
+
+	IR::ReplaceAllUsesWith(dst, value);
+	insn->DeleteFromParent();
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool PeepholeGeneric::ReplaceInstruction(Instruction* insn, Instruction* replacement)
+{
+	for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+		if (insn->OperandHasFlags(i, Instruction::OP_WRITE))
+			this->AddUsersToWorklist(insn, insn->GetOperand(i));
+	}
+
+	this->AddOperandsToWorklist(insn);
+
+	m_InWorklist.erase(insn);
+
+	if (!replacement) {
+		insn->DeleteFromParent();
+		return true;
+	}
+
+	IR::ReplaceInstructionAndDestroyOriginal(insn, replacement);
+	this->AddToWorklist(replacement);
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+/// Look through copies of 'value' to find the instruction that originally computed it.
+static Instruction* GetOriginalDefinition(Value* value)
+{
+	Instruction* def = IR::GetSingleDefinition(value);
+
+	while (def && def->GetOpcode() == HLIR::Set) {
+		def = IR::GetSingleDefinition(static_cast<SetInsn*>(def)->GetNewValue());
 	}
 
-	return IR::GetNext(binop);
+	return def;
 }
 
 /*********************************************************************************************************************/
 
-BasicBlock::iterator PeepholeGeneric::DoIMul(BinOpInsn* imul, bool* bFlagChanges)
+bool PeepholeGeneric::DoNegation(BinOpInsn* binop)
 {
-	Value* lhs = imul->GetLHS();
-	Value* rhs = imul->GetRHS();
+	// Negating (0 - x) or inverting (x ^ -1) twice gets back to the original value.
+	const HLIR::Opcode opc  = (HLIR::Opcode) binop->GetOpcode();
+	const Integer      mask = GetWidthMask(binop->GetResult()->GetType());
 
-	if (ConstantInt* integer = value_cast<ConstantInt>(rhs)) {
-		if (integer->GetIntegralValue() == 1) {
-			Value* dst = imul->GetResult();
-			IR::ReplaceAllUsesWith(dst, lhs);
+	auto getNegated = [opc, mask](Instruction* insn) -> Value* {
+		if (insn->GetOpcode() != opc)
+			return nullptr;
 
-			BasicBlock::iterator next = IR::GetNext(imul);
-			imul->DeleteFromParent();
+		BinOpInsn* negation = static_cast<BinOpInsn*>(insn);
 
-			*bFlagChanges = true;
+		if (opc == HLIR::ISub && IsConstant(negation->GetLHS(), 0))
+			return negation->GetRHS();
 
-			return next;
-		}
+		if (opc == HLIR::Xor && IsConstant(negation->GetRHS(), mask))
+			return negation->GetLHS();
+
+		return nullptr;
+	};
+
+	Value* negated = getNegated(binop);
+
+	if (!negated)
+		return false;
+
+	Instruction* def = GetOriginalDefinition(negated);
+
+	if (!def)
+		return false;
+
+	Value* original = getNegated(def);
+
+	// 'original' is read in place of the result, which is fine anywhere that the result
+	// could be read as long as it is an SSA value (written no more than once).
+	if (!original || !IR::IsSingleAssignment(m_Function, original))
+		return false;
+
+	return ReplaceWithValue(binop, binop->GetResult(), original);
+}
+
+/*********************************************************************************************************************/
+
+bool PeepholeGeneric::DoShift(BinOpInsn* shift)
+{
+	// Shifting the result of a shift (the same way) by constant amounts is the same
+	// as doing a single shift by both amounts added together.
+	ConstantInt* outerAmount = value_cast<ConstantInt>(shift->GetRHS());
+
+	if (!outerAmount)
+		return false;
+
+	Instruction* def = GetOriginalDefinition(shift->GetLHS());
+
+	if (!def || def->GetOpcode() != shift->GetOpcode())
+		return false;
+
+	BinOpInsn*   inner       = static_cast<BinOpInsn*>(def);
+	ConstantInt* innerAmount = value_cast<ConstantInt>(inner->GetRHS());
+
+	Value* original = inner->GetLHS();
+	Value* dst      = shift->GetResult();
+
+	const IntegerType* type = type_cast<IntegerType>(dst->GetType());
+
+	if (!innerAmount || !type || original->GetType() != type)
+		return false;
+
+	// Shifting by the width of the type (or more) is undefined, so leave it alone.
+	const Integer width = (Integer) type->GetBitWidth();
+	const Integer a     = innerAmount->GetIntegralValue();
+	const Integer b     = outerAmount->GetIntegralValue();
+
+	if (a >= width || b >= width)
+		return false;
+
+	if (!IR::IsSingleAssignment(m_Function, original))
+		return false;
+
+	// Between them the two shifts move every bit out of the value.
+	if (a + b >= width)
+		return ReplaceWithValue(shift, dst, ConstantInt::Create(type, 0));
+
+	const HLIR::Opcode opc = (HLIR::Opcode) shift->GetOpcode();
+	return ReplaceInstruction(shift, Helix::CreateBinOp(opc, original, ConstantInt::Create(type, a + b), dst));
+}
+
+/*********************************************************************************************************************/
+
+bool PeepholeGeneric::DoCompare(CompareInsn* compare)
+{
+	bool result = false;
+
+	if (!m_ValueTracking->TryEvaluateCompare((HLIR::Opcode) compare->GetOpcode(), compare->GetLHS(), compare->GetRHS(), &result))
+		return false;
+
+	Value* dst = compare->GetResult();
+	return ReplaceWithValue(compare, dst, ConstantInt::Create(dst->GetType(), result));
+}
+
+/*********************************************************************************************************************/
+
+bool PeepholeGeneric::DoAnd(BinOpInsn* andInsn)
+{
+	Value* lhs = andInsn->GetLHS();
+	Value* dst = andInsn->GetResult();
+
+	ConstantInt* mask = value_cast<ConstantInt>(andInsn->GetRHS());
+
+	if (!mask || value_isa<ConstantInt>(lhs))
+		return false;
+
+	const KnownBits bits       = m_ValueTracking->GetKnownBits(lhs);
+	const uint64_t  maskValue  = (uint64_t) mask->GetIntegralValue() & bits.GetMask();
+	const uint64_t  maybeOne   = ~bits.Zero & bits.GetMask();
+
+	// Masking off bits that are already known to be zero doesn't do anything...
+	if ((maybeOne & ~maskValue) == 0)
+		return ReplaceWithValue(andInsn, dst, lhs);
+
+	// ... and if none of the bits that are kept can be one then the result is zero.
+	if ((maybeOne & maskValue) == 0)
+		return ReplaceWithValue(andInsn, dst, ConstantInt::Create(dst->GetType(), 0));
+
+	return false;
+}
+
+/*********************************************************************************************************************/
+
+bool PeepholeGeneric::DoDivision(BinOpInsn* division)
+{
+	Value* lhs = division->GetLHS();
+	Value* rhs = division->GetRHS();
+
+	// Signed & unsigned division give the same result when neither operand is
+	// negative, and unsigned division is never any more expensive.
+	if (!m_ValueTracking->IsKnownNonNegative(lhs) || !m_ValueTracking->IsKnownNonNegative(rhs))
+		return false;
+
+	const HLIR::Opcode opc = division->GetOpcode() == HLIR::ISDiv ? HLIR::IUDiv : HLIR::IURem;
+	return ReplaceInstruction(division, Helix::CreateBinOp(opc, lhs, rhs, division->GetResult()));
+}
+
+/*********************************************************************************************************************/
+
+bool PeepholeGeneric::DoCast(Instruction* cast)
+{
+	Value* src = cast->GetOperand(0);
+	Value* dst = cast->GetOperand(1);
+
+	Instruction* def = GetOriginalDefinition(src);
+
+	if (!def)
+		return false;
+
+	const HLIR::Opcode opc    = (HLIR::Opcode) cast->GetOpcode();
+	const HLIR::Opcode defOpc = (HLIR::Opcode) def->GetOpcode();
+
+	// Look for an extension of a truncation (or the other way around) that gets
+	// back to the original value.
+	Value* original = def->GetOperand(0);
+
+	if (original->GetType() != dst->GetType())
+		return false;
+
+	if (opc == HLIR::Trunc) {
+		// Truncating an extended value always gives back the value that was extended.
+		if (defOpc != HLIR::ZExt && defOpc != HLIR::SExt)
+			return false;
+	} else {
+		if (defOpc != HLIR::Trunc)
+			return false;
+
+		// Extending a truncated value only gives back the original value if the
+		// truncation didn't throw away anything.
+		const unsigned   width = (unsigned) type_cast<IntegerType>(src->GetType())->GetBitWidth();
+		const ValueRange range = m_ValueTracking->GetRange(original);
+
+		if (opc == HLIR::ZExt && !range.FitsInUnsigned(width))
+			return false;
+
+		if (opc == HLIR::SExt && !range.FitsInSigned(width))
+			return false;
 	}
 
-	return IR::GetNext(imul);
+	if (!IR::IsSingleAssignment(m_Function, original))
+		return false;
+
+	return ReplaceWithValue(cast, dst, original);
 }
 
 /*********************************************************************************************************************/
@@ -1,14 +1,32 @@
 /**
  * @file peephole-generic.h
  * @author Barney Wilks
+ *
+ * Generic (target independent) peephole optimisations.
+ *
+ * Every instruction in the function starts off on a worklist. Each one taken
+ * off the worklist is checked against a table of algebraic identities (x + 0,
+ * x * 1, x & 0, x ^ x, comparing a value with itself...) & a handful of more
+ * involved folds (constant folding, double negation, shifts of shifts, and
+ * anything that known bits/value ranges can prove). When an instruction is
+ * rewritten only the instructions that could be affected (the users of its
+ * result & the definitions of its operands) go back on the worklist, so a
+ * fold deep in a chain doesn't mean looking at the whole function again.
  */
 
+#pragma once
+
 #include "pass-manager.h"
 #include "basic-block.h"
 
+/* C++ Standard Library Includes */
+#include <unordered_set>
+#include <vector>
+
 namespace Helix
 {
 	class Instruction;
+	class ValueTracking;
 
 	class PeepholeGeneric : public FunctionPass
 	{
@@ -16,9 +34,40 @@ namespace Helix
 		void Execute(Function* fn, const PassRunInformation& info) override;
 
 	private:
-		BasicBlock::iterator DoInstruction(BasicBlock::iterator input, bool* bFlagChanges);
-		BasicBlock::iterator DoIMul(BinOpInsn* imul, bool* bFlagChanges);
-		BasicBlock::iterator DoGenericBinOp(BinOpInsn* binop, bool* bFlagChanges);
+		/// Try to simplify 'insn', returning true if it was changed (or removed).
+		bool DoInstruction(Instruction* insn);
+
+		bool DoIdentity(Instruction* insn);
+		bool DoGenericBinOp(BinOpInsn* binop);
+		bool DoNegation(BinOpInsn* binop);
+		bool DoShift(BinOpInsn* shift);
+		bool DoAnd(BinOpInsn* andInsn);
+		bool DoDivision(BinOpInsn* division);
+		bool DoCompare(CompareInsn* compare);
+		bool DoCast(Instruction* cast);
+
+		/// Replace 'insn' (which writes 'dst') with the equivalent 'value'. Either by
+		/// forwarding 'value' to every use of 'dst' (if that's safe) or by replacing
+		/// 'insn' with a copy.
+		bool ReplaceWithValue(Instruction* insn, Value* dst, Value* value);
+
+		/// Replace 'insn' with 'replacement' (which writes the same register).
+		bool ReplaceInstruction(Instruction* insn, Instruction* replacement);
+
+		void AddToWorklist(Instruction* insn);
+		void AddUsersToWorklist(Instruction* insn, Value* value);
+		void AddOperandsToWorklist(Instruction* insn);
+
+	private:
+		Function*                        m_Function      = nullptr;
+		ValueTracking*                   m_ValueTracking = nullptr;
+
+		/// Instructions still to look at, the back is taken first.
+		std::vector<Instruction*>        m_Worklist;
+
+		/// Everything that is on m_Worklist. An instruction that is deleted while on
+		/// the worklist is taken out of here, and skipped when it comes off the list.
+		std::unordered_set<Instruction*> m_InWorklist;
 	};
 }
 
@@ -0,0 +1,536 @@
+/**
+ * @file pre.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in pre.h
+ */
+
+/* Internal Project Includes */
+#include "pre.h"
+#include "gvn.h"
+#include "mem2reg.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "dominators.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// A set of expressions, indexed by their position in the expression table.
+class ExpressionSet
+{
+public:
+	ExpressionSet() = default;
+
+	ExpressionSet(size_t size, bool value)
+		: m_Bits(size, value) { }
+
+	bool Has(size_t index) const { return m_Bits[index]; }
+	void Add(size_t index)       { m_Bits[index] = true; }
+
+	ExpressionSet operator~() const
+	{
+		ExpressionSet result = *this;
+		result.m_Bits.flip();
+		return result;
+	}
+
+	ExpressionSet operator&(const ExpressionSet& other) const
+	{
+		ExpressionSet result = *this;
+
+		for (size_t i = 0; i < m_Bits.size(); ++i)
+			result.m_Bits[i] = m_Bits[i] && other.m_Bits[i];
+
+		return result;
+	}
+
+	ExpressionSet operator|(const ExpressionSet& other) const
+	{
+		ExpressionSet result = *this;
+
+		for (size_t i = 0; i < m_Bits.size(); ++i)
+			result.m_Bits[i] = m_Bits[i] || other.m_Bits[i];
+
+		return result;
+	}
+
+	bool operator==(const ExpressionSet& other) const { return m_Bits == other.m_Bits; }
+	bool operator!=(const ExpressionSet& other) const { return m_Bits != other.m_Bits; }
+
+private:
+	std::vector<bool> m_Bits;
+};
+
+/*********************************************************************************************************************/
+
+/// Every instruction in the function that computes the same (lexically equal) expression.
+struct ExpressionOccurrences
+{
+	const Type*               ResultType;
+	std::vector<Instruction*> Occurrences;
+};
+
+/// The local properties of a block & the results of the dataflow problems for it.
+struct BlockInfo
+{
+	BasicBlock*         Block = nullptr;
+
+	/// Indices of the edges (in LazyCodeMotion::m_Edges) into & out of the block.
+	std::vector<size_t> InEdges {};
+	std::vector<size_t> OutEdges {};
+
+	/// Expressions computed in the block...
+	ExpressionSet       Comp {};
+
+	/// ... that aren't preceded by a definition of one of their operands.
+	ExpressionSet       AntLoc {};
+
+	/// Expressions that have an operand defined in the block (not transparent).
+	ExpressionSet       Kill {};
+
+	ExpressionSet       AntIn {}, AntOut {};
+	ExpressionSet       AvIn {}, AvOut {};
+	ExpressionSet       LaterIn {};
+};
+
+struct Edge
+{
+	size_t        From = 0;
+	size_t        To = 0;
+
+	ExpressionSet Earliest {};
+	ExpressionSet Later {};
+};
+
+/*********************************************************************************************************************/
+
+/// Return the index of the operand that the (pure) instruction writes its result to.
+static size_t GetResultIndex(Instruction* insn)
+{
+	for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+		if (insn->OperandHasFlags(i, Instruction::OP_WRITE))
+			return i;
+	}
+
+	helix_unreachable("pure instruction without a result");
+}
+
+/*********************************************************************************************************************/
+
+/// Where code is inserted along an edge, either at the end of the source block or at
+/// the start of the target block.
+struct InsertionPoint
+{
+	BasicBlock* Block;
+	bool        AtEnd;
+};
+
+/*********************************************************************************************************************/
+
+class LazyCodeMotion
+{
+public:
+	LazyCodeMotion(Function* fn, const DominatorTree& domTree)
+		: m_Function(fn), m_DomTree(domTree) { }
+
+	/// Returns true if any expressions have been moved (into stack slots, that
+	/// then need promoting to registers).
+	bool Run();
+
+	bool HasSplitEdges() const { return m_SplitEdges; }
+
+private:
+	void BuildCFG();
+	void CollectExpressions();
+
+	void ComputeAnticipated();
+	void ComputeAvailable();
+	void ComputeLater();
+
+	Instruction* GetInsertionPoint(const Edge& edge);
+
+	bool Transform();
+
+private:
+	Function*                                                    m_Function;
+	const DominatorTree&                                         m_DomTree;
+
+	std::vector<BlockInfo>                                       m_Blocks;
+	std::vector<Edge>                                            m_Edges;
+	std::unordered_map<BasicBlock*, size_t>                      m_BlockIndices;
+
+	std::vector<ExpressionOccurrences>                           m_Expressions;
+	std::unordered_map<GVNExpression, size_t, GVNExpressionHash> m_ExpressionIndices;
+
+	/// Where to insert code along each edge, once it's been worked out.
+	std::map<std::pair<size_t, size_t>, InsertionPoint>          m_InsertionPoints;
+
+	bool                                                         m_SplitEdges = false;
+};
+
+/*********************************************************************************************************************/
+
+void LazyCodeMotion::BuildCFG()
+{
+	// Nothing gets moved in or out of unreachable code, so leave it out of the
+	// graph entirely.
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (!m_DomTree.IsReachable(&bb))
+			continue;
+
+		m_BlockIndices[&bb] = m_Blocks.size();
+		m_Blocks.push_back({ &bb });
+	}
+
+	for (size_t from = 0; from < m_Blocks.size(); ++from) {
+		std::vector<size_t> successors;
+
+		for (BasicBlock* succ : m_Blocks[from].Block->GetSuccessors()) {
+			const size_t to = m_BlockIndices.at(succ);
+
+			if (std::find(successors.begin(), successors.end(), to) != successors.end())
+				continue;
+
+			successors.push_back(to);
+
+			m_Blocks[from].OutEdges.push_back(m_Edges.size());
+			m_Blocks[to].InEdges.push_back(m_Edges.size());
+
+			m_Edges.push_back({ from, to });
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+void LazyCodeMotion::CollectExpressions()
+{
+	std::unordered_map<Value*, size_t> definingBlocks;
+	std::vector<std::pair<size_t, GVNExpression>> expressions;
+
+	for (size_t i = 0; i < m_Blocks.size(); ++i) {
+		for (Instruction& insn : *m_Blocks[i].Block) {
+			for (size_t op = 0; op < insn.GetCountOperands(); ++op) {
+				if (insn.OperandHasFlags(op, Instruction::OP_WRITE))
+					definingBlocks[insn.GetOperand(op)] = i;
+			}
+
+			// Computations get inserted on paths that didn't compute them before,
+			// so only consider those that can't trap.
+			GVNExpression expr;
+			Value*        result = nullptr;
+
+			if (!IR::IsSafeToSpeculate(&insn) || !GVNExpression::Build(m_Function, &insn, &expr, &result))
+				continue;
+
+			auto [it, inserted] = m_ExpressionIndices.insert({ expr, m_Expressions.size() });
+
+			if (inserted) {
+				m_Expressions.push_back({ result->GetType(), {} });
+				expressions.push_back({ i, std::move(expr) });
+			}
+
+			m_Expressions[it->second].Occurrences.push_back(&insn);
+		}
+	}
+
+	const size_t nExpressions = m_Expressions.size();
+
+	for (BlockInfo& block : m_Blocks) {
+		block.Comp = ExpressionSet(nExpressions, false);
+		block.Kill = ExpressionSet(nExpressions, false);
+	}
+
+	for (size_t e = 0; e < nExpressions; ++e) {
+		for (Instruction* insn : m_Expressions[e].Occurrences) {
+			m_Blocks[m_BlockIndices.at(insn->GetParent())].Comp.Add(e);
+		}
+	}
+
+	for (const auto& [first, expr] : expressions) {
+		const size_t e = m_ExpressionIndices.at(expr);
+
+		for (Value* operand : expr.Operands) {
+			auto it = definingBlocks.find(operand);
+
+			if (it != definingBlocks.end())
+				m_Blocks[it->second].Kill.Add(e);
+		}
+	}
+
+	// Operands are only ever written once and must be defined before they are
+	// read, so any computation in a block that defines one of its operands must
+	// come after that definition (i.e. it isn't upwards exposed).
+	for (BlockInfo& block : m_Blocks) {
+		block.AntLoc = block.Comp & ~block.Kill;
+	}
+}
+
+/*********************************************************************************************************************/
+
+void LazyCodeMotion::ComputeAnticipated()
+{
+	const size_t nExpressions = m_Expressions.size();
+
+	for (BlockInfo& block : m_Blocks) {
+		block.AntIn = ExpressionSet(nExpressions, true);
+	}
+
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+
+		for (auto it = m_Blocks.rbegin(); it != m_Blocks.rend(); ++it) {
+			BlockInfo& block = *it;
+
+			block.AntOut = ExpressionSet(nExpressions, !block.OutEdges.empty());
+
+			for (size_t edge : block.OutEdges) {
+				block.AntOut = block.AntOut & m_Blocks[m_Edges[edge].To].AntIn;
+			}
+
+			ExpressionSet antIn = block.AntLoc | (block.AntOut & ~block.Kill);
+
+			if (antIn != block.AntIn) {
+				block.AntIn = std::move(antIn);
+				changed = true;
+			}
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+void LazyCodeMotion::ComputeAvailable()
+{
+	const size_t nExpressions = m_Expressions.size();
+
+	for (BlockInfo& block : m_Blocks) {
+		block.AvOut = ExpressionSet(nExpressions, true);
+	}
+
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+
+		for (size_t i = 0; i < m_Blocks.size(); ++i) {
+			BlockInfo& block = m_Blocks[i];
+
+			// Nothing is available on entry to the function, even if the first block
+			// is also the target of a branch.
+			const bool isEntry = block.Block == m_Function->GetHeadBlock();
+			block.AvIn = ExpressionSet(nExpressions, !isEntry && !block.InEdges.empty());
+
+			for (size_t edge : block.InEdges) {
+				block.AvIn = block.AvIn & m_Blocks[m_Edges[edge].From].AvOut;
+			}
+
+			ExpressionSet avOut = block.Comp | (block.AvIn & ~block.Kill);
+
+			if (avOut != block.AvOut) {
+				block.AvOut = std::move(avOut);
+				changed = true;
+			}
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+void LazyCodeMotion::ComputeLater()
+{
+	const size_t nExpressions = m_Expressions.size();
+
+	// The earliest points that each expression could be computed at, which are
+	// edges where the expression is anticipated but not yet available, and it
+	// couldn't have been computed any earlier (because either one of its
+	// operands is defined in the predecessor or it's not anticipated there).
+	for (Edge& edge : m_Edges) {
+		const BlockInfo& from = m_Blocks[edge.From];
+		const BlockInfo& to   = m_Blocks[edge.To];
+
+		edge.Earliest = to.AntIn & ~from.AvOut & (from.Kill | ~from.AntOut);
+	}
+
+	for (BlockInfo& block : m_Blocks) {
+		block.LaterIn = ExpressionSet(nExpressions, true);
+	}
+
+	// Then push those points forward as far as possible, through blocks that don't
+	// use the expression themselves.
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+
+		for (Edge& edge : m_Edges) {
+			const BlockInfo& from = m_Blocks[edge.From];
+			edge.Later = edge.Earliest | (from.LaterIn & ~from.AntLoc);
+		}
+
+		for (BlockInfo& block : m_Blocks) {
+			ExpressionSet laterIn(nExpressions, true);
+
+			// There is an implicit edge into the first block of the function, and
+			// anything anticipated there can't be computed any earlier.
+			if (block.Block == m_Function->GetHeadBlock())
+				laterIn = block.AntIn;
+
+			for (size_t edge : block.InEdges) {
+				laterIn = laterIn & m_Edges[edge].Later;
+			}
+
+			if (laterIn != block.LaterIn) {
+				block.LaterIn = std::move(laterIn);
+				changed = true;
+			}
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+Instruction* LazyCodeMotion::GetInsertionPoint(const Edge& edge)
+{
+	auto it = m_InsertionPoints.find({ edge.From, edge.To });
+
+	if (it == m_InsertionPoints.end()) {
+		BasicBlock* from = m_Blocks[edge.From].Block;
+		BasicBlock* to   = m_Blocks[edge.To].Block;
+
+		InsertionPoint point;
+
+		// Critical edges have to be split to get somewhere that's only executed
+		// along that edge.
+		if (m_Blocks[edge.From].OutEdges.size() == 1) {
+			point = { from, true };
+		} else if (m_Blocks[edge.To].InEdges.size() == 1 && to != m_Function->GetHeadBlock()) {
+			point = { to, false };
+		} else {
+			point = { IR::SplitEdge(m_Function, from, to), true };
+			m_SplitEdges = true;
+		}
+
+		it = m_InsertionPoints.insert({ { edge.From, edge.To }, point }).first;
+	}
+
+	// Instructions at the start of the block may have been replaced since, so
+	// don't hang onto them.
+	const InsertionPoint& point = it->second;
+	return point.AtEnd ? point.Block->GetLast() : &*IR::GetFirstNonPhi(point.Block);
+}
+
+/*********************************************************************************************************************/
+
+bool LazyCodeMotion::Transform()
+{
+	bool changed = false;
+
+	BasicBlock* head = m_Function->GetHeadBlock();
+
+	for (size_t e = 0; e < m_Expressions.size(); ++e) {
+		ExpressionOccurrences& expr = m_Expressions[e];
+
+		std::vector<size_t> insertions;
+
+		for (size_t i = 0; i < m_Edges.size(); ++i) {
+			if (m_Edges[i].Later.Has(e) && !m_Blocks[m_Edges[i].To].LaterIn.Has(e))
+				insertions.push_back(i);
+		}
+
+		auto isDeleted = [&](BasicBlock* bb) {
+			const BlockInfo& block = m_Blocks[m_BlockIndices.at(bb)];
+			return block.AntLoc.Has(e) && !block.LaterIn.Has(e);
+		};
+
+		if (std::none_of(expr.Occurrences.begin(), expr.Occurrences.end(), [&](Instruction* insn) { return isDeleted(insn->GetParent()); }))
+			continue;
+
+		// Every computation of the expression that's kept saves its result in a
+		// stack slot, and the redundant ones load it from there instead. Once
+		// Mem2Reg has turned the slot into registers (adding phis where needed)
+		// this all disappears again.
+		VirtualRegisterName* slot = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+		head->InsertBefore(head->begin(), Helix::CreateStackAlloc(slot, expr.ResultType));
+
+		for (size_t edge : insertions) {
+			Instruction* where = this->GetInsertionPoint(m_Edges[edge]);
+			VirtualRegisterName* result = VirtualRegisterName::Create(expr.ResultType);
+
+			Instruction* computation = IR::CloneInstruction(expr.Occurrences.front());
+			computation->SetOperand(GetResultIndex(computation), result);
+
+			IR::InsertBefore(where, computation);
+			IR::InsertBefore(where, Helix::CreateStore(result, slot));
+		}
+
+		BasicBlock* previousBlock = nullptr;
+
+		for (Instruction* insn : expr.Occurrences) {
+			BasicBlock* bb = insn->GetParent();
+			Value* result = insn->GetOperand(GetResultIndex(insn));
+
+			// Only the first computation in each block can be partially redundant,
+			// anything after that is fully redundant with the first.
+			if (bb == previousBlock || isDeleted(bb)) {
+				IR::ReplaceInstructionAndDestroyOriginal(insn, Helix::CreateLoad(slot, result));
+			} else {
+				IR::InsertAfter(insn, Helix::CreateStore(result, slot));
+			}
+
+			previousBlock = bb;
+		}
+
+		changed = true;
+	}
+
+	return changed;
+}
+
+/*********************************************************************************************************************/
+
+bool LazyCodeMotion::Run()
+{
+	this->BuildCFG();
+	this->CollectExpressions();
+
+	if (m_Expressions.empty())
+		return false;
+
+	this->ComputeAnticipated();
+	this->ComputeAvailable();
+	this->ComputeLater();
+
+	return this->Transform();
+}
+
+/*********************************************************************************************************************/
+
+void PRE::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	LazyCodeMotion lcm(fn, info.Analyses->Get<DominatorTree>(fn));
+
+	if (!lcm.Run())
+		return;
+
+	if (lcm.HasSplitEdges())
+		info.Analyses->Invalidate(fn);
+
+	Mem2Reg mem2reg;
+	mem2reg.Execute(fn, info);
+}
+
+/*********************************************************************************************************************/
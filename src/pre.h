@@ -0,0 +1,41 @@
+/**
+ * @file pre.h
+ * @author Barney Wilks
+ *
+ * Partial redundancy elimination, using lazy code motion.
+ *
+ * An expression is partially redundant when it has already been computed
+ * along some (but not all) of the paths that reach it, for example after an
+ * if/else where only one side computes it. Copies of the expression are
+ * inserted along the paths that are missing it, which makes the original
+ * fully redundant so it can be removed.
+ *
+ * Where to insert is found with the anticipated & available expressions
+ * dataflow problems, which give the earliest points that the expression could
+ * be computed at. These are then pushed as late as possible (without
+ * introducing any new redundancy) so that the results aren't kept in
+ * registers for any longer than they have to be.
+ *
+ * (as described in Lazy Code Motion - Knoop, Ruthing & Steffen, using the
+ *  edge based formulation from A Variation of Knoop, Ruthing, and Steffen's
+ *  Lazy Code Motion - Drechsler & Stadel)
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class PRE : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(PRE, pre, "[Generic] Partial redundancy elimination (lazy code motion)");
+
+/*********************************************************************************************************************/
@@ -260,9 +260,17 @@ void Helix::Print(SlotTracker& slots, TextOutputStream& out, const Instruction&
 		out.Write("[%s -> %s], ", GetTypeName(castInsn.GetSrcType()), GetTypeName(castInsn.GetDstType()));
 	}
 
+	// Phis print their incoming values grouped as `[value, block]` pairs after the
+	// result (e.g. `phi %0:i32, [1:i32, .1], [%2:i32, .3]`)
+	const bool isPhi = insn.GetOpcode() == HLIR::Phi;
+
 	for (size_t i = 0; i < nOperands; ++i) {
 		Value* pValue = insn.GetOperand(i);
 
+		if (isPhi && i > 0 && (i % 2) == 1) {
+			out.Write("[");
+		}
+
 		if (pValue) {
 			Print(slots, out, *pValue);
 		}
@@ -270,6 +278,10 @@ void Helix::Print(SlotTracker& slots, TextOutputStream& out, const Instruction&
 			out.Write("?");
 		}
 
+		if (isPhi && i > 0 && (i % 2) == 0) {
+			out.Write("]");
+		}
+
 		if (i < nOperands - 1) {
 			out.Write(", ");
 		}
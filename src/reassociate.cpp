@@ -0,0 +1,445 @@
+/**
+ * @file reassociate.cpp
+ * @author Barney Wilks
+ */
+
+#include "reassociate.h"
+#include "alias-analysis.h"
+#include "dominators.h"
+#include "function.h"
+#include "instructions.h"
+#include "ir-helpers.h"
+#include "loop-info.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+static bool IsAssociative(HLIR::Opcode opcode)
+{
+	switch (opcode) {
+	case HLIR::IAdd:
+	case HLIR::IMul:
+	case HLIR::And:
+	case HLIR::Or:
+	case HLIR::Xor:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+/*********************************************************************************************************************/
+
+/// The constants that an operation ignores (x + 0) and that decide the result on their own (x * 0),
+/// for integers whose bits are all in 'mask'. Returns false if nothing decides the result.
+static bool GetConstantIdentities(HLIR::Opcode opcode, Integer mask, Integer* identity, Integer* absorbing)
+{
+	switch (opcode) {
+	case HLIR::IAdd: *identity = 0;    return false;
+	case HLIR::Xor:  *identity = 0;    return false;
+	case HLIR::IMul: *identity = 1;    *absorbing = 0;    return true;
+	case HLIR::And:  *identity = mask; *absorbing = 0;    return true;
+	case HLIR::Or:   *identity = 0;    *absorbing = mask; return true;
+
+	default:
+		helix_unreachable("not an associative operation");
+	}
+}
+
+/*********************************************************************************************************************/
+
+static Integer FoldConstants(HLIR::Opcode opcode, Integer a, Integer b)
+{
+	switch (opcode) {
+	case HLIR::IAdd: return a + b;
+	case HLIR::IMul: return a * b;
+	case HLIR::And:  return a & b;
+	case HLIR::Or:   return a | b;
+	case HLIR::Xor:  return a ^ b;
+
+	default:
+		helix_unreachable("not an associative operation");
+	}
+}
+
+/*********************************************************************************************************************/
+
+class Reassociator
+{
+public:
+	Reassociator(Function* fn, const DominatorTree& domTree, const LoopInfo& loopInfo, AliasAnalysis& aliasAnalysis)
+		: m_Function(fn), m_DomTree(domTree), m_LoopInfo(loopInfo), m_AliasAnalysis(aliasAnalysis) { }
+
+	/// Rewrite every tree in the function, returning true if anything changed.
+	bool Run();
+
+private:
+	/// Number every value in the order that it's defined.
+	void ComputeRanks();
+
+	size_t GetRank(Value* value) const;
+
+	/// Return true if 'value' either doesn't change inside 'loop' or is computed by something
+	/// that LICM should be able to hoist out of it.
+	bool IsLikelyInvariant(const Loop* loop, Value* value);
+
+	/// Get the instructions in 'loop' that may write to memory.
+	const std::vector<Instruction*>& GetWriters(const Loop* loop);
+
+	bool RunOnBlock(BasicBlock* bb);
+
+	/// If 'operand' is computed by an instruction that can be folded into the tree for
+	/// 'root', return that instruction.
+	BinOpInsn* GetInnerNode(Value* operand, BinOpInsn* root) const;
+
+	/// Add the leaves of the tree under 'node' to 'leaves' (left to right), and each of
+	/// the instructions in it other than 'root' to 'inner'.
+	void CollectLeaves(BinOpInsn* node, BinOpInsn* root, std::vector<Value*>* leaves, std::vector<Instruction*>* inner, bool* isLeftLinear) const;
+
+	bool RewriteTree(BinOpInsn* root);
+
+private:
+	Function*                                 m_Function;
+	const DominatorTree&                      m_DomTree;
+	const LoopInfo&                           m_LoopInfo;
+	AliasAnalysis&                            m_AliasAnalysis;
+
+	std::unordered_map<Value*, size_t>        m_Ranks;
+
+	std::map<std::pair<const Loop*, Value*>, bool>               m_Invariance;
+	std::unordered_map<const Loop*, std::vector<Instruction*>>   m_Writers;
+
+	std::unordered_set<Instruction*>          m_Removed;
+};
+
+/*********************************************************************************************************************/
+
+void Reassociator::ComputeRanks()
+{
+	// Zero is kept for values that aren't defined anywhere in the function (globals), which are
+	// just as invariant as the parameters.
+	size_t rank = 1;
+
+	for (size_t i = 0; i < m_Function->GetCountParameters(); ++i) {
+		m_Ranks[m_Function->GetParameter(i)] = rank++;
+	}
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		for (Instruction& insn : bb) {
+			for (size_t i = 0; i < insn.GetCountOperands(); ++i) {
+				Value* operand = insn.GetOperand(i);
+
+				if (insn.OperandHasFlags(i, Instruction::OP_WRITE) && value_isa<VirtualRegisterName>(operand))
+					m_Ranks.insert({ operand, rank++ });
+			}
+		}
+	}
+}
+
+/*********************************************************************************************************************/
+
+size_t Reassociator::GetRank(Value* value) const
+{
+	auto it = m_Ranks.find(value);
+	return it == m_Ranks.end() ? 0 : it->second;
+}
+
+/*********************************************************************************************************************/
+
+const std::vector<Instruction*>& Reassociator::GetWriters(const Loop* loop)
+{
+	auto [it, inserted] = m_Writers.insert({ loop, {} });
+
+	if (!inserted)
+		return it->second;
+
+	for (BasicBlock* bb : loop->GetBlocks()) {
+		for (Instruction& insn : *bb) {
+			const bool isWritingCall = insn.GetOpcode() == HLIR::Call && !IR::IsRemovableCall(&insn);
+
+			if (insn.GetOpcode() == HLIR::Store || isWritingCall)
+				it->second.push_back(&insn);
+		}
+	}
+
+	return it->second;
+}
+
+/*********************************************************************************************************************/
+
+bool Reassociator::IsLikelyInvariant(const Loop* loop, Value* value)
+{
+	if (loop->IsLoopInvariant(value))
+		return true;
+
+	Instruction* def = IR::GetSingleDefinition(value);
+
+	if (!def)
+		return false;
+
+	auto [it, inserted] = m_Invariance.insert({ { loop, value }, false });
+
+	if (!inserted)
+		return it->second;
+
+	bool invariant = false;
+
+	// Much the same rules as LICM uses to decide what can be hoisted, so that the parts of
+	// the tree that are grouped together can be hoisted with it.
+	if (def->GetOpcode() == HLIR::Load) {
+		invariant = this->IsLikelyInvariant(loop, def->GetOperand(0));
+
+		const MemoryLocation location = MemoryLocation::Get(def);
+
+		for (Instruction* writer : this->GetWriters(loop)) {
+			if (!invariant)
+				break;
+
+			invariant = !(m_AliasAnalysis.GetModRefInfo(writer, location) & kMod);
+		}
+	}
+	else if (IR::IsSafeToSpeculate(def)) {
+		invariant = true;
+
+		for (size_t i = 0; i < def->GetCountOperands() && invariant; ++i) {
+			if (def->OperandHasFlags(i, Instruction::OP_READ))
+				invariant = this->IsLikelyInvariant(loop, def->GetOperand(i));
+		}
+	}
+
+	m_Invariance[{ loop, value }] = invariant;
+	return invariant;
+}
+
+/*********************************************************************************************************************/
+
+BinOpInsn* Reassociator::GetInnerNode(Value* operand, BinOpInsn* root) const
+{
+	// The value has to be used by the tree & nothing else (one write & one read), or it'd still
+	// have to be computed afterwards.
+	if (!value_isa<VirtualRegisterName>(operand) || operand->GetCountUses() != 2)
+		return nullptr;
+
+	Instruction* def = IR::GetSingleDefinition(operand);
+
+	if (!def || def->GetOpcode() != root->GetOpcode())
+		return nullptr;
+
+	// The definition can be in any block, as long as it dominates 'root'. Each operand of it is
+	// then only written once (before it), so the rebuilt tree can read them just before 'root'.
+	if (!m_DomTree.Dominates(def, root))
+		return nullptr;
+
+	return static_cast<BinOpInsn*>(def);
+}
+
+/*********************************************************************************************************************/
+
+void Reassociator::CollectLeaves(BinOpInsn* node, BinOpInsn* root, std::vector<Value*>* leaves, std::vector<Instruction*>* inner, bool* isLeftLinear) const
+{
+	if (BinOpInsn* lhs = this->GetInnerNode(node->GetLHS(), root)) {
+		inner->push_back(lhs);
+		this->CollectLeaves(lhs, root, leaves, inner, isLeftLinear);
+	}
+	else {
+		leaves->push_back(node->GetLHS());
+	}
+
+	if (BinOpInsn* rhs = this->GetInnerNode(node->GetRHS(), root)) {
+		*isLeftLinear = false;
+
+		inner->push_back(rhs);
+		this->CollectLeaves(rhs, root, leaves, inner, isLeftLinear);
+	}
+	else {
+		leaves->push_back(node->GetRHS());
+	}
+}
+
+/*********************************************************************************************************************/
+
+bool Reassociator::RewriteTree(BinOpInsn* root)
+{
+	const HLIR::Opcode opcode = (HLIR::Opcode) root->GetOpcode();
+
+	Value*             dst  = root->GetResult();
+	const IntegerType* type = type_cast<IntegerType>(dst->GetType());
+
+	if (!type)
+		return false;
+
+	std::vector<Value*>       leaves;
+	std::vector<Instruction*> inner;
+	bool                      isLeftLinear = true;
+
+	this->CollectLeaves(root, root, &leaves, &inner, &isLeftLinear);
+
+	const Integer mask = type->GetBitWidth() >= 64 ? UINT64_MAX : (Integer(1) << type->GetBitWidth()) - 1;
+
+	Integer identity = 0, absorbing = 0;
+	const bool hasAbsorbing = GetConstantIdentities(opcode, mask, &identity, &absorbing);
+
+	// Put every constant together, & everything else in the order that it was defined.
+	std::vector<Value*> values;
+	Integer             constant = identity;
+
+	for (Value* leaf : leaves) {
+		if (ConstantInt* ci = value_cast<ConstantInt>(leaf))
+			constant = FoldConstants(opcode, constant, ci->GetIntegralValue()) & mask;
+		else
+			values.push_back(leaf);
+	}
+
+	std::stable_sort(values.begin(), values.end(), [this](Value* a, Value* b) {
+		return this->GetRank(a) < this->GetRank(b);
+	});
+
+	// x & x = x, x | x = x & x ^ x = 0. Equal values are next to each other after sorting.
+	if (opcode == HLIR::And || opcode == HLIR::Or || opcode == HLIR::Xor) {
+		std::vector<Value*> unique;
+
+		for (Value* value : values) {
+			if (unique.empty() || unique.back() != value)
+				unique.push_back(value);
+			else if (opcode == HLIR::Xor)
+				unique.pop_back();
+		}
+
+		values = std::move(unique);
+	}
+
+	// In a loop, values that don't change in the loop go first (with the constant) so that
+	// LICM can hoist that part of the tree out of the loop.
+	auto firstVariant = values.end();
+
+	if (const Loop* loop = m_LoopInfo.GetLoopFor(root->GetParent())) {
+		firstVariant = std::stable_partition(values.begin(), values.end(), [this, loop](Value* value) {
+			return this->IsLikelyInvariant(loop, value);
+		});
+
+		if (firstVariant == values.begin())
+			firstVariant = values.end();
+	}
+
+	std::vector<Value*> sequence;
+
+	if (hasAbsorbing && constant == absorbing) {
+		sequence.push_back(ConstantInt::Create(type, constant));
+	}
+	else {
+		sequence.insert(sequence.end(), values.begin(), firstVariant);
+
+		if (constant != identity || values.empty())
+			sequence.push_back(ConstantInt::Create(type, constant));
+
+		sequence.insert(sequence.end(), firstVariant, values.end());
+	}
+
+	// Already in canonical form.
+	if (isLeftLinear && std::equal(sequence.begin(), sequence.end(), leaves.begin(), leaves.end(), IR::IsSameValue))
+		return false;
+
+	if (sequence.size() == 1 && IR::IsSingleAssignment(m_Function, dst) && IR::IsSingleAssignment(m_Function, sequence[0])) {
+		IR::ReplaceAllUsesWith(dst, sequence[0]);
+	}
+	else if (sequence.size() == 1) {
+		Instruction* set = Helix::CreateSetInsn(dst, sequence[0]);
+
+		IR::InsertBefore(root, set);
+	}
+	else {
+		Value* accumulator = sequence[0];
+
+		for (size_t i = 1; i < sequence.size(); ++i) {
+			Value* result = (i == sequence.size() - 1) ? dst : VirtualRegisterName::Create(type);
+
+			Instruction* insn = Helix::CreateBinOp(opcode, accumulator, sequence[i], result);
+
+			IR::InsertBefore(root, insn);
+
+			accumulator = result;
+		}
+	}
+
+	helix_debug(logs::reassociate, "Reassociated tree of {} leaves into {} operands", leaves.size(), sequence.size());
+
+	m_Removed.insert(root);
+	root->DeleteFromParent();
+
+	// Each of these was only used by the tree, which is now gone.
+	for (Instruction* insn : inner) {
+		m_Removed.insert(insn);
+		insn->DeleteFromParent();
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool Reassociator::RunOnBlock(BasicBlock* bb)
+{
+	std::vector<Instruction*> insns;
+
+	m_Removed.clear();
+
+	for (Instruction& insn : *bb) {
+		insns.push_back(&insn);
+	}
+
+	bool changed = false;
+
+	// Bottom up, so that a tree is found from its root (rather than one of the
+	// instructions part way up it).
+	for (auto it = insns.rbegin(); it != insns.rend(); ++it) {
+		Instruction* insn = *it;
+
+		if (m_Removed.count(insn) || !IsAssociative((HLIR::Opcode) insn->GetOpcode()))
+			continue;
+
+		if (this->RewriteTree(static_cast<BinOpInsn*>(insn)))
+			changed = true;
+	}
+
+	return changed;
+}
+
+/*********************************************************************************************************************/
+
+bool Reassociator::Run()
+{
+	this->ComputeRanks();
+
+	bool changed = false;
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (this->RunOnBlock(&bb))
+			changed = true;
+	}
+
+	return changed;
+}
+
+/*********************************************************************************************************************/
+
+void Reassociate::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	Reassociator reassociator(fn, info.Analyses->Get<DominatorTree>(fn), info.Analyses->Get<LoopInfo>(fn), info.Analyses->Get<AliasAnalysis>(fn));
+
+	if (reassociator.Run())
+		info.Analyses->Invalidate(fn);
+}
+
+/*********************************************************************************************************************/
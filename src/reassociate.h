@@ -0,0 +1,41 @@
+/**
+ * @file reassociate.h
+ * @author Barney Wilks
+ *
+ * Reassociation of commutative & associative integer operations.
+ *
+ * Expressions are lowered left to right, so `a + 1 + b + 2` becomes
+ * `((a + 1) + b) + 2`, which has its constants in different instructions
+ * that nothing can fold together. This finds trees of the same operation
+ * (`iadd`, `imul`, `and`, `or` & `xor`) where each inner value is only used
+ * by the next operation up, and rebuilds each one as a chain in a canonical
+ * order - values in the order that they are defined (parameters first),
+ * then a single constant with every constant in the tree folded into it.
+ *
+ * Inside a loop the values that don't change in the loop (or that LICM will
+ * be able to hoist) come first instead, followed by the constant, so that
+ * LICM can hoist that part of the tree as well.
+ *
+ * Besides folding constants this means that the same sum written two
+ * different ways (`a + b + c` & `c + a + b`) comes out the same, for GVN to
+ * find.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class Reassociate : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(Reassociate, reassociate, "[Generic] Reassociate commutative expressions & fold their constants");
+
+/*********************************************************************************************************************/
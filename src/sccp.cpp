@@ -0,0 +1,705 @@
+/**
+ * @file sccp.cpp
+ * @author Barney Wilks
+ *
+ * Implementation of Wegman & Zadeck's Sparse Conditional Constant (SCC)
+ * algorithm for constant propagation
+ *
+ * (as described in Constant Propagation with Conditional Branches - MARK N. WEGMAN and F. KENNETH ZADECK)
+ *
+ * Implementation for interface defined in sccp.h
+ */
+
+/* Internal Project Includes */
+#include "sccp.h"
+#include "value.h"
+#include "system.h"
+#include "function.h"
+#include "ir-helpers.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+class LatticeCell
+{
+public:
+	enum Type
+	{
+		/// Value may be some (as yet) undetermined constant.
+		kTop,
+
+		/// Value is known to be this integral constant.
+		kConstant,
+
+		/// Constant value cannot be guaranteed.
+		kBottom
+	};
+
+	static LatticeCell GetTop()    { return LatticeCell(kTop, nullptr);    }
+	static LatticeCell GetBottom() { return LatticeCell(kBottom, nullptr); }
+
+	static LatticeCell GetValue(ConstantInt* constantInteger)
+		{ return LatticeCell(kConstant, constantInteger); }
+
+	ConstantInt* GetConstant() const { return m_ConstantInteger; }
+
+	bool IsTop()      const { return m_Type == kTop;      }
+	bool IsBottom()   const { return m_Type == kBottom;   }
+	bool IsConstant() const { return m_Type == kConstant; }
+
+	bool operator==(const LatticeCell& other) const
+		{ return m_Type == other.m_Type && m_ConstantInteger == other.m_ConstantInteger; }
+
+	bool operator!=(const LatticeCell& other) const
+		{ return !operator==(other); }
+
+private:
+	LatticeCell(Type type, ConstantInt* c)
+		: m_Type(type), m_ConstantInteger(c) { }
+
+private:
+	Type         m_Type;
+	ConstantInt* m_ConstantInteger;
+};
+
+/*********************************************************************************************************************/
+
+static LatticeCell Meet(const LatticeCell& a, const LatticeCell& b)
+{
+	if (a.IsTop())
+		return b;
+
+	if (b.IsTop())
+		return a;
+
+	return (a == b) ? a : LatticeCell::GetBottom();
+}
+
+/*********************************************************************************************************************/
+
+/// Return the width (in bits) of the given type if it's an integer, or 0 otherwise.
+static unsigned GetIntegerWidth(const Type* type)
+{
+	if (const IntegerType* integerType = type_cast<IntegerType>(type))
+		return (unsigned) integerType->GetBitWidth();
+
+	return 0;
+}
+
+/*********************************************************************************************************************/
+
+static Integer GetWidthMask(unsigned width)
+{
+	return width >= 64 ? ~Integer(0) : (Integer(1) << width) - 1;
+}
+
+/*********************************************************************************************************************/
+
+static ConstantInt* FoldConstantBinaryOperation(HLIR::Opcode opc, ConstantInt* lhs, ConstantInt* rhs)
+{
+	if (lhs->GetType() != rhs->GetType())
+		return nullptr;
+
+	const unsigned width = GetIntegerWidth(lhs->GetType());
+
+	if (width == 0)
+		return nullptr;
+
+	const Integer mask = GetWidthMask(width);
+
+	const Integer a = lhs->GetIntegralValue() & mask;
+	const Integer b = rhs->GetIntegralValue() & mask;
+
+	const int64_t sa = lhs->GetSignedIntegralValue();
+	const int64_t sb = rhs->GetSignedIntegralValue();
+
+	Integer result = 0;
+
+	switch (opc) {
+	case HLIR::IAdd: result = a + b; break;
+	case HLIR::ISub: result = a - b; break;
+	case HLIR::IMul: result = a * b; break;
+	case HLIR::And:  result = a & b; break;
+	case HLIR::Or:   result = a | b; break;
+	case HLIR::Xor:  result = a ^ b; break;
+
+	// Dividing by zero (or overflowing a signed division) is undefined, so leave
+	// it for the program to do at runtime.
+	case HLIR::IUDiv:
+	case HLIR::IURem:
+		if (b == 0)
+			return nullptr;
+
+		result = (opc == HLIR::IUDiv) ? a / b : a % b;
+		break;
+
+	case HLIR::ISDiv:
+	case HLIR::ISRem:
+		if (sb == 0 || (sb == -1 && sa == std::numeric_limits<int64_t>::min()))
+			return nullptr;
+
+		result = (Integer) ((opc == HLIR::ISDiv) ? sa / sb : sa % sb);
+		break;
+
+	case HLIR::Shl:
+	case HLIR::Shr:
+		if (b >= width)
+			return nullptr;
+
+		result = (opc == HLIR::Shl) ? a << b : a >> b;
+		break;
+
+	case HLIR::AShr:
+		if (b >= width)
+			return nullptr;
+
+		result = (Integer) (sa >> b);
+		break;
+
+	// The top half of the double width product (which only fits in 64 bits for
+	// types up to 32 bits wide).
+	case HLIR::IMulHS:
+	case HLIR::IMulHU:
+		if (width > 32)
+			return nullptr;
+
+		result = (opc == HLIR::IMulHU) ? (a * b) >> width : (Integer) ((sa * sb) >> width);
+		break;
+
+	default:
+		return nullptr;
+	}
+
+	return ConstantInt::Create(lhs->GetType(), result & mask);
+}
+
+/*********************************************************************************************************************/
+
+static bool FoldConstantComparison(HLIR::Opcode opc, ConstantInt* lhs, ConstantInt* rhs, bool* result)
+{
+	if (lhs->GetType() != rhs->GetType())
+		return false;
+
+	const unsigned width = GetIntegerWidth(lhs->GetType());
+
+	if (width == 0)
+		return false;
+
+	const int64_t a = lhs->GetSignedIntegralValue();
+	const int64_t b = rhs->GetSignedIntegralValue();
+
+	switch (opc) {
+	case HLIR::ICmp_Eq:  *result = a == b; return true;
+	case HLIR::ICmp_Neq: *result = a != b; return true;
+	case HLIR::ICmp_Lt:  *result = a <  b; return true;
+	case HLIR::ICmp_Lte: *result = a <= b; return true;
+	case HLIR::ICmp_Gt:  *result = a >  b; return true;
+	case HLIR::ICmp_Gte: *result = a >= b; return true;
+
+	default:
+		return false;
+	}
+}
+
+/*********************************************************************************************************************/
+
+static ConstantInt* FoldConstantCast(HLIR::Opcode opc, ConstantInt* src, const Type* dstType)
+{
+	const unsigned srcWidth = GetIntegerWidth(src->GetType());
+	const unsigned dstWidth = GetIntegerWidth(dstType);
+
+	if (srcWidth == 0 || dstWidth == 0)
+		return nullptr;
+
+	const Integer mask = GetWidthMask(dstWidth);
+
+	switch (opc) {
+	case HLIR::ZExt:
+	case HLIR::Trunc:
+		return ConstantInt::Create(dstType, src->GetIntegralValue() & GetWidthMask(srcWidth) & mask);
+
+	case HLIR::SExt:
+		return ConstantInt::Create(dstType, ((Integer) src->GetSignedIntegralValue()) & mask);
+
+	default:
+		return nullptr;
+	}
+}
+
+/*********************************************************************************************************************/
+
+/// Solves the lattice values of every value in a function (and which edges in the CFG
+/// can ever be taken) and then rewrites the function with the results.
+class ConstantPropagation
+{
+public:
+	ConstantPropagation(Function* fn)
+		: m_Function(fn) { }
+
+	void Solve();
+	void Rewrite();
+
+private:
+	LatticeCell GetCell(Value* value) const;
+
+	void Lower(Value* value, const LatticeCell& cell);
+
+	void MarkEdgeExecutable(BasicBlock* from, BasicBlock* to);
+	bool IsEdgeExecutable(BasicBlock* from, BasicBlock* to) const;
+	bool IsBlockExecutable(BasicBlock* bb) const;
+
+	void VisitInstruction(Instruction* insn);
+	void VisitPhi(PhiInsn* phi);
+	void VisitConditionalBranch(ConditionalBranchInsn* cbr);
+
+	bool ResolveUndefinedBranches();
+
+	void RemoveUnexecutableEdges();
+	void RemoveUnexecutableBlocks();
+
+private:
+	Function*                                      m_Function;
+
+	/// Lattice cell of each virtual register, anything that isn't in here is Top.
+	std::unordered_map<Value*, LatticeCell>        m_Cells;
+
+	std::unordered_set<BasicBlock*>                m_ExecutableBlocks;
+	std::set<std::pair<BasicBlock*, BasicBlock*>>  m_ExecutableEdges;
+
+	std::vector<BasicBlock*>                       m_BlockWorklist;
+	std::vector<Value*>                            m_ValueWorklist;
+};
+
+/*********************************************************************************************************************/
+
+LatticeCell ConstantPropagation::GetCell(Value* value) const
+{
+	if (ConstantInt* c = value_cast<ConstantInt>(value))
+		return LatticeCell::GetValue(c);
+
+	if (value_isa<UndefValue>(value))
+		return LatticeCell::GetTop();
+
+	if (!value_isa<VirtualRegisterName>(value))
+		return LatticeCell::GetBottom();
+
+	auto it = m_Cells.find(value);
+	return it == m_Cells.end() ? LatticeCell::GetTop() : it->second;
+}
+
+/*********************************************************************************************************************/
+
+void ConstantPropagation::Lower(Value* value, const LatticeCell& cell)
+{
+	if (!value_isa<VirtualRegisterName>(value))
+		return;
+
+	// Registers that are defined more than once (i.e. before the function is in SSA
+	// form) meet the values of every definition, so the cell holds for all of them.
+	const LatticeCell current = this->GetCell(value);
+	const LatticeCell lowered = Meet(current, cell);
+
+	if (lowered == current)
+		return;
+
+	m_Cells.insert_or_assign(value, lowered);
+	m_ValueWorklist.push_back(value);
+}
+
+/*********************************************************************************************************************/
+
+void ConstantPropagation::MarkEdgeExecutable(BasicBlock* from, BasicBlock* to)
+{
+	if (!m_ExecutableEdges.insert({ from, to }).second)
+		return;
+
+	if (m_ExecutableBlocks.insert(to).second) {
+		m_BlockWorklist.push_back(to);
+		return;
+	}
+
+	// The block has already been visited, but there's a new value flowing into
+	// any phis.
+	for (Instruction& insn : *to) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		this->VisitPhi(static_cast<PhiInsn*>(&insn));
+	}
+}
+
+/*********************************************************************************************************************/
+
+bool ConstantPropagation::IsEdgeExecutable(BasicBlock* from, BasicBlock* to) const
+{
+	return m_ExecutableEdges.count({ from, to }) > 0;
+}
+
+/*********************************************************************************************************************/
+
+bool ConstantPropagation::IsBlockExecutable(BasicBlock* bb) const
+{
+	return m_ExecutableBlocks.count(bb) > 0;
+}
+
+/*********************************************************************************************************************/
+
+void ConstantPropagation::VisitPhi(PhiInsn* phi)
+{
+	LatticeCell cell = LatticeCell::GetTop();
+
+	for (size_t i = 0; i < phi->GetCountIncoming(); ++i) {
+		if (!this->IsEdgeExecutable(phi->GetIncomingBlock(i), phi->GetParent()))
+			continue;
+
+		cell = Meet(cell, this->GetCell(phi->GetIncomingValue(i)));
+
+		if (cell.IsBottom())
+			break;
+	}
+
+	this->Lower(phi->GetResult(), cell);
+}
+
+/*********************************************************************************************************************/
+
+void ConstantPropagation::VisitConditionalBranch(ConditionalBranchInsn* cbr)
+{
+	BasicBlock* bb = cbr->GetParent();
+	const LatticeCell cond = this->GetCell(cbr->GetCond());
+
+	// Don't know which way the branch goes yet.
+	if (cond.IsTop())
+		return;
+
+	if (cond.IsConstant()) {
+		const bool taken = cond.GetConstant()->GetIntegralValue() != 0;
+		this->MarkEdgeExecutable(bb, taken ? cbr->GetTrueBB() : cbr->GetFalseBB());
+		return;
+	}
+
+	this->MarkEdgeExecutable(bb, cbr->GetTrueBB());
+	this->MarkEdgeExecutable(bb, cbr->GetFalseBB());
+}
+
+/*********************************************************************************************************************/
+
+void ConstantPropagation::VisitInstruction(Instruction* insn)
+{
+	const HLIR::Opcode opcode = (HLIR::Opcode) insn->GetOpcode();
+
+	switch (opcode) {
+	case HLIR::Phi:
+		this->VisitPhi(static_cast<PhiInsn*>(insn));
+		return;
+
+	case HLIR::ConditionalBranch:
+		this->VisitConditionalBranch(static_cast<ConditionalBranchInsn*>(insn));
+		return;
+
+	case HLIR::UnconditionalBranch: {
+		UnconditionalBranchInsn* br = static_cast<UnconditionalBranchInsn*>(insn);
+		this->MarkEdgeExecutable(br->GetParent(), br->GetBB());
+		return;
+	}
+
+	case HLIR::Set: {
+		SetInsn* set = static_cast<SetInsn*>(insn);
+		this->Lower(set->GetRegister(), this->GetCell(set->GetNewValue()));
+		return;
+	}
+
+	default:
+		break;
+	}
+
+	// Try and evaluate the instruction, given the current value of its operands.
+	// If any are Top then the result is Top too (for now), if any are Bottom (or the
+	// result can't be folded) then so is the result.
+	auto evaluate = [this](Value* lhs, Value* rhs, ConstantInt** outLHS, ConstantInt** outRHS) {
+		const LatticeCell a = this->GetCell(lhs);
+		const LatticeCell b = rhs ? this->GetCell(rhs) : a;
+
+		if (a.IsBottom() || b.IsBottom())
+			return LatticeCell::GetBottom();
+
+		if (a.IsTop() || b.IsTop())
+			return LatticeCell::GetTop();
+
+		*outLHS = a.GetConstant();
+		*outRHS = b.GetConstant();
+
+		return LatticeCell::GetValue(a.GetConstant());
+	};
+
+	ConstantInt* lhs = nullptr;
+	ConstantInt* rhs = nullptr;
+
+	if (HLIR::IsBinaryOp(opcode)) {
+		BinOpInsn* binop = static_cast<BinOpInsn*>(insn);
+		LatticeCell cell = evaluate(binop->GetLHS(), binop->GetRHS(), &lhs, &rhs);
+
+		if (cell.IsConstant()) {
+			ConstantInt* result = FoldConstantBinaryOperation(opcode, lhs, rhs);
+			cell = result ? LatticeCell::GetValue(result) : LatticeCell::GetBottom();
+		}
+
+		this->Lower(binop->GetResult(), cell);
+		return;
+	}
+
+	if (HLIR::IsCompare(opcode)) {
+		CompareInsn* compare = static_cast<CompareInsn*>(insn);
+		LatticeCell cell = evaluate(compare->GetLHS(), compare->GetRHS(), &lhs, &rhs);
+
+		if (cell.IsConstant()) {
+			bool result = false;
+
+			if (GetIntegerWidth(compare->GetResult()->GetType()) != 0 && FoldConstantComparison(opcode, lhs, rhs, &result))
+				cell = LatticeCell::GetValue(ConstantInt::Create(compare->GetResult()->GetType(), result ? 1 : 0));
+			else
+				cell = LatticeCell::GetBottom();
+		}
+
+		this->Lower(compare->GetResult(), cell);
+		return;
+	}
+
+	if (opcode == HLIR::ZExt || opcode == HLIR::SExt || opcode == HLIR::Trunc) {
+		CastInsn* cast = static_cast<CastInsn*>(insn);
+		LatticeCell cell = evaluate(cast->GetSrc(), nullptr, &lhs, &rhs);
+
+		if (cell.IsConstant()) {
+			ConstantInt* result = FoldConstantCast(opcode, lhs, cast->GetDstType());
+			cell = result ? LatticeCell::GetValue(result) : LatticeCell::GetBottom();
+		}
+
+		this->Lower(cast->GetDst(), cell);
+		return;
+	}
+
+	// Nothing is known about anything else that's written.
+	for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+		if (insn->OperandHasFlags(i, Instruction::OP_WRITE))
+			this->Lower(insn->GetOperand(i), LatticeCell::GetBottom());
+	}
+}
+
+/*********************************************************************************************************************/
+
+bool ConstantPropagation::ResolveUndefinedBranches()
+{
+	// A branch on a condition that's still Top once everything has been solved
+	// (e.g. it's undefined) could go either way, so assume that both edges can be
+	// taken rather than treating both targets as unreachable.
+	bool changed = false;
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (!this->IsBlockExecutable(&bb) || bb.IsEmpty())
+			continue;
+
+		if (bb.GetLast()->GetOpcode() != HLIR::ConditionalBranch)
+			continue;
+
+		ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(bb.GetLast());
+
+		if (!this->GetCell(cbr->GetCond()).IsTop())
+			continue;
+
+		if (this->IsEdgeExecutable(&bb, cbr->GetTrueBB()) && this->IsEdgeExecutable(&bb, cbr->GetFalseBB()))
+			continue;
+
+		this->MarkEdgeExecutable(&bb, cbr->GetTrueBB());
+		this->MarkEdgeExecutable(&bb, cbr->GetFalseBB());
+
+		changed = true;
+	}
+
+	return changed;
+}
+
+/*********************************************************************************************************************/
+
+void ConstantPropagation::Solve()
+{
+	// Parameters are defined on entry to the function, so could be anything.
+	for (auto it = m_Function->params_begin(); it != m_Function->params_end(); ++it)
+		this->Lower(*it, LatticeCell::GetBottom());
+
+	BasicBlock* entry = m_Function->GetHeadBlock();
+
+	m_ExecutableBlocks.insert(entry);
+	m_BlockWorklist.push_back(entry);
+
+	do {
+		while (!m_BlockWorklist.empty() || !m_ValueWorklist.empty()) {
+			// Process values first, since they are likely to be cheaper and might
+			// mean less of each block has to be revisited.
+			while (!m_ValueWorklist.empty()) {
+				Value* value = m_ValueWorklist.back();
+				m_ValueWorklist.pop_back();
+
+				for (const Use& use : value->uses()) {
+					Instruction* user = use.GetInstruction();
+
+					if (!user->OperandHasFlags(use.GetOperandIndex(), Instruction::OP_READ))
+						continue;
+
+					if (this->IsBlockExecutable(user->GetParent()))
+						this->VisitInstruction(user);
+				}
+			}
+
+			if (!m_BlockWorklist.empty()) {
+				BasicBlock* bb = m_BlockWorklist.back();
+				m_BlockWorklist.pop_back();
+
+				for (Instruction& insn : *bb)
+					this->VisitInstruction(&insn);
+			}
+		}
+	} while (this->ResolveUndefinedBranches());
+}
+
+/*********************************************************************************************************************/
+
+void ConstantPropagation::RemoveUnexecutableEdges()
+{
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (!this->IsBlockExecutable(&bb))
+			continue;
+
+		// Phis don't need values for edges that are never taken.
+		for (BasicBlock::iterator it = bb.begin(); it != bb.end() && it->GetOpcode() == HLIR::Phi;) {
+			PhiInsn* phi = static_cast<PhiInsn*>(&*it);
+			++it;
+
+			for (size_t i = phi->GetCountIncoming(); i > 0; --i) {
+				if (!this->IsEdgeExecutable(phi->GetIncomingBlock(i - 1), &bb))
+					phi->RemoveIncoming(i - 1);
+			}
+
+			// Only one way into the block, so the phi isn't choosing anything.
+			if (phi->GetCountIncoming() == 1 && phi->GetIncomingValue(0) != phi->GetResult()) {
+				IR::ReplaceAllUsesWith(phi->GetResult(), phi->GetIncomingValue(0));
+				phi->DeleteFromParent();
+			}
+		}
+
+		if (bb.IsEmpty() || bb.GetLast()->GetOpcode() != HLIR::ConditionalBranch)
+			continue;
+
+		ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(bb.GetLast());
+
+		const bool trueTaken  = this->IsEdgeExecutable(&bb, cbr->GetTrueBB());
+		const bool falseTaken = this->IsEdgeExecutable(&bb, cbr->GetFalseBB());
+
+		if (trueTaken && falseTaken)
+			continue;
+
+		helix_assert(trueTaken || falseTaken, "executable conditional branch doesn't go anywhere");
+
+		BasicBlock* target = trueTaken ? cbr->GetTrueBB() : cbr->GetFalseBB();
+		IR::ReplaceInstructionAndDestroyOriginal(cbr, Helix::CreateUnconditionalBranch(target));
+	}
+}
+
+/*********************************************************************************************************************/
+
+void ConstantPropagation::RemoveUnexecutableBlocks()
+{
+	std::vector<BasicBlock*> deadBlocks;
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (!this->IsBlockExecutable(&bb))
+			deadBlocks.push_back(&bb);
+	}
+
+	IR::DeleteBlocks(m_Function, deadBlocks);
+}
+
+/*********************************************************************************************************************/
+
+void ConstantPropagation::Rewrite()
+{
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (!this->IsBlockExecutable(&bb))
+			continue;
+
+		for (BasicBlock::iterator it = bb.begin(); it != bb.end();) {
+			Instruction* insn = &*it;
+			++it;
+
+			// Incoming values of phis are only read when coming from that block.
+			if (insn->GetOpcode() == HLIR::Phi) {
+				PhiInsn* phi = static_cast<PhiInsn*>(insn);
+
+				for (size_t i = 0; i < phi->GetCountIncoming(); ++i) {
+					const LatticeCell cell = this->GetCell(phi->GetIncomingValue(i));
+
+					if (cell.IsConstant())
+						phi->SetIncomingValue(i, cell.GetConstant());
+				}
+
+				continue;
+			}
+
+			const HLIR::Opcode opcode = (HLIR::Opcode) insn->GetOpcode();
+
+			// Anything that computes a constant can just be replaced by that constant
+			// (and then cleaned up by DCE if it's no longer needed).
+			if (HLIR::IsBinaryOp(opcode) || HLIR::IsCompare(opcode)
+				|| opcode == HLIR::ZExt || opcode == HLIR::SExt || opcode == HLIR::Trunc) {
+				Value* result = insn->GetOperand(insn->GetCountOperands() - 1);
+				const LatticeCell cell = this->GetCell(result);
+
+				if (cell.IsConstant()) {
+					IR::ReplaceInstructionAndDestroyOriginal(insn, Helix::CreateSetInsn(result, cell.GetConstant()));
+					continue;
+				}
+			}
+
+			for (size_t i = 0; i < insn->GetCountOperands(); ++i) {
+				if (!insn->OperandHasFlags(i, Instruction::OP_READ))
+					continue;
+
+				Value* operand = insn->GetOperand(i);
+
+				if (!value_isa<VirtualRegisterName>(operand))
+					continue;
+
+				const LatticeCell cell = this->GetCell(operand);
+
+				if (cell.IsConstant())
+					insn->SetOperand(i, cell.GetConstant());
+			}
+		}
+	}
+
+	this->RemoveUnexecutableEdges();
+	this->RemoveUnexecutableBlocks();
+}
+
+/*********************************************************************************************************************/
+
+void SCCP::Execute(Function* fn, const PassRunInformation&)
+{
+	if (!fn->HasBody())
+		return;
+
+	ConstantPropagation propagation(fn);
+
+	propagation.Solve();
+	propagation.Rewrite();
+}
+
+/*********************************************************************************************************************/
@@ -1,9 +1,14 @@
 /**
- * @file scp.h
+ * @file sccp.h
  * @author Barney Wilks
  *
- * Implementation of Kildalls Simple Constant (SC) algorithm for constant
- * propagation
+ * Implementation of Wegman & Zadeck's Sparse Conditional Constant (SCC)
+ * algorithm for constant propagation.
+ *
+ * Keeps a single lattice cell per value (rather than one per variable per
+ * instruction) and only evaluates instructions in blocks that have been proven
+ * to be executable, so constant conditional branches are folded & the blocks
+ * they can never reach are deleted.
  *
  * (as described in Constant Propagation with Conditional Branches - MARK N. WEGMAN and F. KENNETH ZADECK)
  */
@@ -16,13 +21,13 @@
 
 namespace Helix
 {
-	class SCP : public FunctionPass
+	class SCCP : public FunctionPass
 	{
 	public:
 		void Execute(Function* fn, const PassRunInformation& info) override;
 	};
 }
 
-REGISTER_PASS(SCP, scp, "[Generic] (Simple) Constant Propagation");
+REGISTER_PASS(SCCP, sccp, "[Generic] Sparse Conditional Constant Propagation");
 
 /*********************************************************************************************************************/
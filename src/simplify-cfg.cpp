@@ -0,0 +1,222 @@
+/**
+ * @file simplify-cfg.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in simplify-cfg.h
+ */
+
+/* Internal Project Includes */
+#include "simplify-cfg.h"
+#include "function.h"
+#include "ir-helpers.h"
+#include "loop-info.h"
+
+/* C++ Standard Library Includes */
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+class CFGSimplifier
+{
+public:
+	/// 'loopInfo' is null if the empty blocks around loops don't need to be kept.
+	CFGSimplifier(Function* fn, const LoopInfo* loopInfo)
+		: m_Function(fn), m_LoopInfo(loopInfo) { }
+
+	/// Fold `cbr`s that only go one way into `br`s.
+	bool FoldBranches();
+
+	/// Send branches to blocks that only contain a `br` to where that goes instead.
+	bool ForwardEmptyBlocks();
+
+	/// Merge blocks into their predecessor, where that is the only way in.
+	bool MergeBlocks();
+
+private:
+	/// Return true if the empty block 'bb' isn't needed by the shape of the loops
+	/// around it, so that its predecessors can branch to 'target' instead.
+	bool CanForward(BasicBlock* bb, BasicBlock* target) const;
+
+	/// Return true if 'pred' can branch straight to 'target' instead of going through
+	/// the empty block 'bb', without the phis in 'target' needing two different
+	/// values from 'pred'.
+	bool CanRedirect(BasicBlock* pred, BasicBlock* bb, BasicBlock* target) const;
+
+private:
+	Function*       m_Function;
+	const LoopInfo* m_LoopInfo;
+};
+
+/*********************************************************************************************************************/
+
+bool CFGSimplifier::FoldBranches()
+{
+	bool changed = false;
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (bb.IsEmpty() || bb.GetLast()->GetOpcode() != HLIR::ConditionalBranch)
+			continue;
+
+		ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(bb.GetLast());
+		BasicBlock* target = nullptr;
+
+		if (cbr->GetTrueBB() == cbr->GetFalseBB()) {
+			target = cbr->GetTrueBB();
+		} else if (ConstantInt* cond = value_cast<ConstantInt>(cbr->GetCond())) {
+			const bool taken = cond->GetIntegralValue() != 0;
+
+			target = taken ? cbr->GetTrueBB() : cbr->GetFalseBB();
+			IR::RemoveIncomingFrom(taken ? cbr->GetFalseBB() : cbr->GetTrueBB(), &bb);
+		}
+
+		if (!target)
+			continue;
+
+		IR::ReplaceInstructionAndDestroyOriginal(cbr, Helix::CreateUnconditionalBranch(target));
+		changed = true;
+	}
+
+	return changed;
+}
+
+/*********************************************************************************************************************/
+
+bool CFGSimplifier::CanForward(BasicBlock* bb, BasicBlock* target) const
+{
+	if (!m_LoopInfo)
+		return true;
+
+	// Keep preheaders & latches (the empty blocks that branch to a header).
+	Loop* targetLoop = m_LoopInfo->GetLoopFor(target);
+
+	if (targetLoop && targetLoop->GetHeader() == target)
+		return false;
+
+	// ... and blocks that are the way into or out of a loop.
+	Loop* loop = m_LoopInfo->GetLoopFor(bb);
+
+	for (BasicBlock* pred : IR::GetPredecessors(bb)) {
+		if (m_LoopInfo->GetLoopFor(pred) != loop)
+			return false;
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool CFGSimplifier::CanRedirect(BasicBlock* pred, BasicBlock* bb, BasicBlock* target) const
+{
+	for (Instruction& insn : *target) {
+		if (insn.GetOpcode() != HLIR::Phi)
+			break;
+
+		PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+		const size_t index = phi->GetIncomingIndex(pred);
+
+		if (index != SIZE_MAX && !IR::IsSameValue(phi->GetIncomingValue(index), phi->GetIncomingValueForBlock(bb)))
+			return false;
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+bool CFGSimplifier::ForwardEmptyBlocks()
+{
+	std::vector<BasicBlock*> blocks;
+
+	for (BasicBlock& bb : m_Function->blocks()) {
+		if (&bb != m_Function->GetHeadBlock() && !bb.IsEmpty() && bb.begin()->GetOpcode() == HLIR::UnconditionalBranch)
+			blocks.push_back(&bb);
+	}
+
+	bool changed = false;
+
+	for (BasicBlock* bb : blocks) {
+		BasicBlock* target = static_cast<UnconditionalBranchInsn*>(bb->GetLast())->GetBB();
+
+		if (target == bb || !this->CanForward(bb, target))
+			continue;
+
+		const std::vector<BasicBlock*> preds = IR::GetPredecessors(bb);
+
+		if (preds.empty())
+			continue;
+
+		bool forwardedAll = true;
+
+		for (BasicBlock* pred : preds) {
+			if (!this->CanRedirect(pred, bb, target)) {
+				forwardedAll = false;
+				continue;
+			}
+
+			for (Instruction& insn : *target) {
+				if (insn.GetOpcode() != HLIR::Phi)
+					break;
+
+				PhiInsn* phi = static_cast<PhiInsn*>(&insn);
+
+				if (phi->GetIncomingIndex(pred) == SIZE_MAX)
+					phi->AddIncoming(phi->GetIncomingValueForBlock(bb), pred);
+			}
+
+			IR::RetargetBranch(pred->GetLast(), bb, target);
+
+			changed = true;
+		}
+
+		if (!forwardedAll)
+			continue;
+
+		IR::RemoveIncomingFrom(target, bb);
+		IR::DeleteBlocks(m_Function, { bb });
+	}
+
+	return changed;
+}
+
+/*********************************************************************************************************************/
+
+bool CFGSimplifier::MergeBlocks()
+{
+	std::vector<BasicBlock*> blocks;
+
+	for (BasicBlock& bb : m_Function->blocks())
+		blocks.push_back(&bb);
+
+	bool changed = false;
+
+	// A block is only deleted when it is merged into its predecessor on its own
+	// turn, so the blocks that haven't been visited yet are all still there.
+	for (BasicBlock* bb : blocks)
+		changed |= IR::MergeBlockIntoPredecessor(m_Function, bb);
+
+	return changed;
+}
+
+/*********************************************************************************************************************/
+
+void SimplifyCFG::Execute(Function* fn, const PassRunInformation& info)
+{
+	if (!fn->HasBody())
+		return;
+
+	for (bool changed = true; changed;) {
+		CFGSimplifier simplifier(fn, m_KeepLoopBlocks ? &info.Analyses->Get<LoopInfo>(fn) : nullptr);
+
+		changed = simplifier.ForwardEmptyBlocks();
+		changed |= simplifier.FoldBranches();
+		changed |= IR::RemoveUnreachableBlocks(fn);
+		changed |= simplifier.MergeBlocks();
+
+		if (changed)
+			info.Analyses->Invalidate(fn);
+	}
+}
+
+/*********************************************************************************************************************/
@@ -0,0 +1,65 @@
+/**
+ * @file simplify-cfg.h
+ * @author Barney Wilks
+ *
+ * Control flow graph simplification.
+ *
+ * The frontend creates a block for every part of every statement (the
+ * condition, body & tail of a `for`, an `else` that may be empty...), and
+ * passes like SCCP, the inliner & loop unrolling leave behind more blocks that
+ * only branch to one another. Each one costs a label & usually a branch in
+ * the generated code, and a little time in every later pass.
+ *
+ * Until nothing changes:
+ *   - `cbr` with a constant condition, or with both targets the same, is
+ *     replaced with `br`
+ *   - blocks that can't be reached from the entry block are deleted
+ *   - branches to a block that does nothing but branch somewhere else are
+ *     sent straight there instead
+ *   - a block with a single predecessor that unconditionally branches to it
+ *     is merged into that predecessor
+ *
+ * Empty blocks in front of loop headers & on the way out of loops are kept,
+ * since the loop passes rely on preheaders & exit blocks of their own. The
+ * last run (LateSimplifyCFG) comes after every loop pass, so it removes those
+ * as well.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class SimplifyCFG : public FunctionPass
+	{
+	public:
+		SimplifyCFG() = default;
+
+		void Execute(Function* fn, const PassRunInformation& info) override;
+
+	protected:
+		explicit SimplifyCFG(bool keepLoopBlocks)
+			: m_KeepLoopBlocks(keepLoopBlocks) { }
+
+	private:
+		/// Keep the empty preheaders, latches & exit blocks of loops.
+		bool m_KeepLoopBlocks = true;
+	};
+
+	/// SimplifyCFG for after the loop passes have run, which doesn't need to keep
+	/// the shape of the loops.
+	class LateSimplifyCFG : public SimplifyCFG
+	{
+	public:
+		LateSimplifyCFG()
+			: SimplifyCFG(false) { }
+	};
+}
+
+REGISTER_PASS(SimplifyCFG, simplifycfg, "[Generic] Fold constant branches, merge blocks & remove empty & unreachable blocks");
+REGISTER_PASS(LateSimplifyCFG, latesimplifycfg, "[Generic] SimplifyCFG, also removing the empty blocks around loops");
+
+/*********************************************************************************************************************/
@@ -0,0 +1,209 @@
+/**
+ * @file sroa.cpp
+ * @author Barney Wilks
+ *
+ * Implementation for interface defined in sroa.h
+ */
+
+/* Internal Project Includes */
+#include "sroa.h"
+#include "function.h"
+#include "ir-helpers.h"
+
+/* C++ Standard Library Includes */
+#include <utility>
+#include <vector>
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+/// Structs & arrays with more fields (or elements) than this are left alone, since
+/// they'd just be spread out over lots of slots that can't all be registers anyway.
+static constexpr size_t kMaxCountFields = 16;
+
+/*********************************************************************************************************************/
+
+/// Return the number of fields (or elements) in 'type', or zero if it can't be split.
+static size_t GetCountFields(const Type* type)
+{
+	if (const StructType* structType = type_cast<StructType>(type))
+		return structType->GetCountFields();
+
+	if (const ArrayType* arrayType = type_cast<ArrayType>(type))
+		return arrayType->GetCountElements();
+
+	return 0;
+}
+
+/*********************************************************************************************************************/
+
+static const Type* GetFieldType(const Type* type, size_t index)
+{
+	if (const StructType* structType = type_cast<StructType>(type))
+		return structType->GetField(index);
+
+	return type_cast<ArrayType>(type)->GetBaseType();
+}
+
+/*********************************************************************************************************************/
+
+/// An `lfa` or `lea` that gives the address of one field of a stack slot.
+struct FieldAddress
+{
+	Instruction* Insn;
+	Value*       Address;
+	size_t       Index;
+};
+
+/*********************************************************************************************************************/
+
+/// Return true if the address of a field is only used to load or store the field
+/// itself (or, for a struct field, to get the address of one of its own fields).
+static bool IsOnlyAccessed(Value* address, const Type* fieldType)
+{
+	for (const Use& use : address->uses()) {
+		Instruction* insn = use.GetInstruction();
+
+		// The `lfa` or `lea` giving the address.
+		if (insn->OperandHasFlags(use.GetOperandIndex(), Instruction::OP_WRITE))
+			continue;
+
+		switch (insn->GetOpcode()) {
+		case HLIR::Load:
+			break;
+
+		case HLIR::Store:
+			if (static_cast<StoreInsn*>(insn)->GetSrc() == address)
+				return false;
+
+			break;
+
+		case HLIR::LoadFieldAddress:
+			if (!type_cast<StructType>(fieldType))
+				return false;
+
+			break;
+
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+/// Find the field addresses that 'alloc' is used by, returning false if the slot is
+/// used in any other way (so it can't be split).
+static bool FindFieldAddresses(Function* fn, StackAllocInsn* alloc, std::vector<FieldAddress>& fields)
+{
+	const Type* type = alloc->GetAllocatedType();
+	const size_t countFields = GetCountFields(type);
+
+	if (countFields == 0 || countFields > kMaxCountFields)
+		return false;
+
+	for (const Use& use : alloc->GetOutputPtr()->uses()) {
+		Instruction* insn = use.GetInstruction();
+
+		if (insn == alloc)
+			continue;
+
+		FieldAddress field = { insn, nullptr, 0 };
+
+		if (insn->GetOpcode() == HLIR::LoadFieldAddress) {
+			LoadFieldAddressInsn* lfa = static_cast<LoadFieldAddressInsn*>(insn);
+
+			if (lfa->GetInputPtr() != alloc->GetOutputPtr() || lfa->GetBaseType() != type)
+				return false;
+
+			field.Address = lfa->GetOutputPtr();
+			field.Index   = lfa->GetFieldIndex();
+		}
+		else if (insn->GetOpcode() == HLIR::LoadElementAddress) {
+			LoadEffectiveAddressInsn* lea = static_cast<LoadEffectiveAddressInsn*>(insn);
+			ConstantInt* index = value_cast<ConstantInt>(lea->GetIndex());
+
+			if (!type_cast<ArrayType>(type) || lea->GetInputPtr() != alloc->GetOutputPtr() || !index)
+				return false;
+
+			if (lea->GetBaseType() != type_cast<ArrayType>(type)->GetBaseType())
+				return false;
+
+			// Anything out of bounds is undefined, but leave it be rather than guess
+			// what was meant.
+			if (index->GetSignedIntegralValue() < 0 || (size_t) index->GetSignedIntegralValue() >= countFields)
+				return false;
+
+			field.Address = lea->GetOutputPtr();
+			field.Index   = (size_t) index->GetSignedIntegralValue();
+		}
+		else {
+			return false;
+		}
+
+		if (!value_isa<VirtualRegisterName>(field.Address) || !IR::IsSingleAssignment(fn, field.Address))
+			return false;
+
+		if (!IsOnlyAccessed(field.Address, GetFieldType(type, field.Index)))
+			return false;
+
+		fields.push_back(field);
+	}
+
+	return true;
+}
+
+/*********************************************************************************************************************/
+
+void SROA::Execute(Function* fn, const PassRunInformation&)
+{
+	if (!fn->HasBody())
+		return;
+
+	BasicBlock* head = fn->GetHeadBlock();
+
+	std::vector<StackAllocInsn*> worklist;
+	IR::FindAllInstructionsOfType(worklist, head, HLIR::StackAlloc);
+
+	while (!worklist.empty()) {
+		StackAllocInsn* alloc = worklist.back();
+		worklist.pop_back();
+
+		std::vector<FieldAddress> fields;
+
+		if (!FindFieldAddresses(fn, alloc, fields))
+			continue;
+
+		const Type* type = alloc->GetAllocatedType();
+		std::vector<Value*> slots(GetCountFields(type), nullptr);
+
+		// Only the fields that are used get a slot.
+		for (const FieldAddress& field : fields) {
+			if (slots[field.Index])
+				continue;
+
+			const Type* fieldType = GetFieldType(type, field.Index);
+			VirtualRegisterName* slot = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+
+			StackAllocInsn* fieldAlloc = Helix::CreateStackAlloc(slot, fieldType);
+			IR::InsertBefore(alloc, fieldAlloc);
+
+			slots[field.Index] = slot;
+
+			if (GetCountFields(fieldType) > 0)
+				worklist.push_back(fieldAlloc);
+		}
+
+		for (const FieldAddress& field : fields) {
+			field.Insn->DeleteFromParent();
+			IR::ReplaceAllUsesWith(field.Address, slots[field.Index]);
+		}
+
+		alloc->DeleteFromParent();
+	}
+}
+
+/*********************************************************************************************************************/
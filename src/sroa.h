@@ -0,0 +1,39 @@
+/**
+ * @file sroa.h
+ * @author Barney Wilks
+ *
+ * Scalar replacement of aggregates.
+ *
+ * Mem2Reg can only promote stack slots of integers & pointers, so local
+ * structs and arrays always live in memory, even when every access to them
+ * is to a known field (`p.x`, `range[0]`).
+ *
+ * SROA splits a struct or small array `stack_alloc` into one `stack_alloc`
+ * per field (or element) where the only uses of the aggregate are `lfa`s or
+ * `lea`s with a constant index, and the addresses they give are only loaded
+ * from or stored to. Each address is then replaced by the slot for its field,
+ * which Mem2Reg can promote like any other. Fields that are structs
+ * themselves are split again in turn.
+ *
+ * This has to run before GenericLowering, which turns `lfa` & `lea` into
+ * pointer arithmetic.
+ */
+
+#pragma once
+
+#include "pass-manager.h"
+
+/*********************************************************************************************************************/
+
+namespace Helix
+{
+	class SROA : public FunctionPass
+	{
+	public:
+		void Execute(Function* fn, const PassRunInformation& info) override;
+	};
+}
+
+REGISTER_PASS(SROA, sroa, "[Generic] Split struct & array stack allocations into one per field");
+
+/*********************************************************************************************************************/
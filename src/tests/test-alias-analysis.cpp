@@ -0,0 +1,286 @@
+/**
+ * @file test-alias-analysis.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../alias-analysis.h"
+#include "../function.h"
+#include "../target-info-armv7.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static MemoryLocation Int32At(Value* ptr)
+{
+	return MemoryLocation(ptr, BuiltinTypes::GetInt32());
+}
+
+/******************************************************************************/
+
+TEST_CASE("AliasAnalysis (Stack Slots)", "[AliasAnalysis]")
+{
+	BasicBlock* bb = nullptr;
+	Function* fn = CreateFunction(bb);
+
+	VirtualRegisterName* a = Ptr();
+	VirtualRegisterName* b = Ptr();
+
+	bb->Append(Helix::CreateStackAlloc(a, BuiltinTypes::GetInt32()));
+	bb->Append(Helix::CreateStackAlloc(b, BuiltinTypes::GetInt32()));
+
+	StoreInsn* storeA = Helix::CreateStore(Int32(1), a);
+	LoadInsn*  loadA  = Helix::CreateLoad(a, Reg());
+	StoreInsn* storeB = Helix::CreateStore(Int32(2), b);
+
+	bb->Append(storeA);
+	bb->Append(storeB);
+	bb->Append(loadA);
+	bb->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	AliasAnalysis& aa = am.Get<AliasAnalysis>(fn);
+
+	REQUIRE(aa.Alias(storeA, storeB) == AliasResult::NoAlias);
+	REQUIRE(aa.Alias(storeA, loadA) == AliasResult::MustAlias);
+	REQUIRE(aa.Alias(storeB, loadA) == AliasResult::NoAlias);
+
+	REQUIRE(aa.Decompose(a).Kind == AliasAnalysis::kObject_StackSlot);
+	REQUIRE_FALSE(aa.IsEscaped(a));
+
+	REQUIRE(aa.GetModRefInfo(loadA, Int32At(a)) == kRef);
+	REQUIRE(aa.GetModRefInfo(storeB, Int32At(a)) == kNoModRef);
+}
+
+/******************************************************************************/
+
+TEST_CASE("AliasAnalysis (Array Elements)", "[AliasAnalysis]")
+{
+	// stack_alloc [i32 x 4], a
+	// lea a, 1, a1
+	// lea a, 2, a2
+	// lea a, i, ai
+	BasicBlock* bb = nullptr;
+	VirtualRegisterName* i = Reg();
+	Function* fn = CreateFunction(bb, { i });
+
+	const Type* i32 = BuiltinTypes::GetInt32();
+
+	VirtualRegisterName* a  = Ptr();
+	VirtualRegisterName* a1 = Ptr();
+	VirtualRegisterName* a2 = Ptr();
+	VirtualRegisterName* ai = Ptr();
+	VirtualRegisterName* b1 = Ptr();
+
+	bb->Append(Helix::CreateStackAlloc(a, ArrayType::Create(4, i32)));
+	bb->Append(Helix::CreateLoadEffectiveAddress(i32, a, Int32(1), a1));
+	bb->Append(Helix::CreateLoadEffectiveAddress(i32, a, Int32(2), a2));
+	bb->Append(Helix::CreateLoadEffectiveAddress(i32, a, i, ai));
+	bb->Append(Helix::CreateLoadEffectiveAddress(i32, a, Int32(1), b1));
+	bb->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	AliasAnalysis& aa = am.Get<AliasAnalysis>(fn);
+
+	REQUIRE(aa.Alias(Int32At(a1), Int32At(a2)) == AliasResult::NoAlias);
+	REQUIRE(aa.Alias(Int32At(a1), Int32At(b1)) == AliasResult::MustAlias);
+	REQUIRE(aa.Alias(Int32At(a1), Int32At(ai)) == AliasResult::MayAlias);
+
+	// A 64 bit access at a[1] overlaps one at a[2], an 8 bit access at a[0] doesn't
+	// touch a[1] at all.
+	REQUIRE(aa.Alias(MemoryLocation(a1, BuiltinTypes::GetInt64()), MemoryLocation(a2, BuiltinTypes::GetInt64())) == AliasResult::MayAlias);
+	REQUIRE(aa.Alias(MemoryLocation(a, BuiltinTypes::GetInt8()), Int32At(a1)) == AliasResult::NoAlias);
+
+	AliasAnalysis::DecomposedPointer dp = aa.Decompose(a2);
+
+	REQUIRE(dp.Object == a);
+	REQUIRE(dp.HasConstantOffset);
+	REQUIRE(dp.Offset == 8);
+}
+
+/******************************************************************************/
+
+TEST_CASE("AliasAnalysis (Lowered Address Arithmetic)", "[AliasAnalysis]")
+{
+	// What genlower produces for `lfa` & `lea`
+	//
+	// stack_alloc [S:i32,i32,i32], s
+	// ptrtoint s, t0
+	// iadd t0, 8, t1
+	// inttoptr t1, f2
+	// ptrtoint s, t2
+	// imul i, 4, t3
+	// iadd t2, t3, t4
+	// inttoptr t4, fi
+	BasicBlock* bb = nullptr;
+	VirtualRegisterName* i = Reg();
+	Function* fn = CreateFunction(bb, { i });
+
+	const Type* i32 = BuiltinTypes::GetInt32();
+	const Type* ptrInt = ARMv7::PointerType();
+
+	const StructType* structType = StructType::Create("S", { i32, i32, i32 });
+
+	VirtualRegisterName* s  = Ptr();
+	VirtualRegisterName* f2 = Ptr();
+	VirtualRegisterName* fi = Ptr();
+	VirtualRegisterName* t0 = VirtualRegisterName::Create(ptrInt);
+	VirtualRegisterName* t1 = VirtualRegisterName::Create(ptrInt);
+	VirtualRegisterName* t2 = VirtualRegisterName::Create(ptrInt);
+	VirtualRegisterName* t3 = VirtualRegisterName::Create(ptrInt);
+	VirtualRegisterName* t4 = VirtualRegisterName::Create(ptrInt);
+
+	bb->Append(Helix::CreateStackAlloc(s, structType));
+	bb->Append(Helix::CreatePtrToInt(s, t0));
+	bb->Append(Helix::CreateBinOp(HLIR::IAdd, t0, ConstantInt::Create(ptrInt, 8), t1));
+	bb->Append(Helix::CreateIntToPtr(t1, f2));
+	bb->Append(Helix::CreatePtrToInt(s, t2));
+	bb->Append(Helix::CreateBinOp(HLIR::IMul, i, ConstantInt::Create(ptrInt, 4), t3));
+	bb->Append(Helix::CreateBinOp(HLIR::IAdd, t3, t2, t4));
+	bb->Append(Helix::CreateIntToPtr(t4, fi));
+	bb->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	AliasAnalysis& aa = am.Get<AliasAnalysis>(fn);
+
+	AliasAnalysis::DecomposedPointer dp = aa.Decompose(f2);
+
+	REQUIRE(dp.Object == s);
+	REQUIRE(dp.Kind == AliasAnalysis::kObject_StackSlot);
+	REQUIRE(dp.HasConstantOffset);
+	REQUIRE(dp.Offset == 8);
+
+	dp = aa.Decompose(fi);
+
+	REQUIRE(dp.Object == s);
+	REQUIRE_FALSE(dp.HasConstantOffset);
+
+	REQUIRE(aa.Alias(Int32At(s), Int32At(f2)) == AliasResult::NoAlias);
+	REQUIRE(aa.Alias(Int32At(fi), Int32At(f2)) == AliasResult::MayAlias);
+
+	// Address arithmetic alone doesn't make the slot escape.
+	REQUIRE_FALSE(aa.IsEscaped(s));
+}
+
+/******************************************************************************/
+
+TEST_CASE("AliasAnalysis (Globals & Parameters)", "[AliasAnalysis]")
+{
+	BasicBlock* bb = nullptr;
+
+	VirtualRegisterName* p = Ptr();
+	VirtualRegisterName* q = Ptr();
+	VirtualRegisterName* r = Ptr();
+
+	Function* fn = CreateFunction(bb, { p, q, r });
+	fn->SetNoAliasParameter(2);
+
+	GlobalVariable* g = GlobalVariable::Create("g", BuiltinTypes::GetInt32());
+	GlobalVariable* h = GlobalVariable::Create("h", BuiltinTypes::GetInt32());
+
+	VirtualRegisterName* slot = Ptr();
+
+	bb->Append(Helix::CreateStackAlloc(slot, BuiltinTypes::GetInt32()));
+	bb->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	AliasAnalysis& aa = am.Get<AliasAnalysis>(fn);
+
+	REQUIRE(aa.Alias(Int32At(g), Int32At(h)) == AliasResult::NoAlias);
+	REQUIRE(aa.Alias(Int32At(g), Int32At(g)) == AliasResult::MustAlias);
+
+	// Plain pointer parameters could point anywhere other than this function's
+	// stack slots.
+	REQUIRE(aa.Alias(Int32At(p), Int32At(g)) == AliasResult::MayAlias);
+	REQUIRE(aa.Alias(Int32At(p), Int32At(q)) == AliasResult::MayAlias);
+	REQUIRE(aa.Alias(Int32At(p), Int32At(slot)) == AliasResult::NoAlias);
+
+	// 'r' is restrict
+	REQUIRE(aa.Alias(Int32At(r), Int32At(p)) == AliasResult::NoAlias);
+	REQUIRE(aa.Alias(Int32At(r), Int32At(g)) == AliasResult::NoAlias);
+}
+
+/******************************************************************************/
+
+TEST_CASE("AliasAnalysis (Escaping Stack Slots)", "[AliasAnalysis]")
+{
+	// stack_alloc i32, a
+	// stack_alloc i32, b
+	// stack_alloc ptr, pp
+	// store a, pp          ; a escapes
+	// call f, x, b         ; b escapes
+	// load pp, loaded
+	BasicBlock* bb = nullptr;
+	Function* fn = CreateFunction(bb);
+
+	const FunctionType* calleeType = FunctionType::Create(BuiltinTypes::GetVoidType(), { BuiltinTypes::GetPointer() });
+	Function* callee = Function::Create(calleeType, "f", { Ptr() });
+
+	VirtualRegisterName* a      = Ptr();
+	VirtualRegisterName* b      = Ptr();
+	VirtualRegisterName* c      = Ptr();
+	VirtualRegisterName* pp     = Ptr();
+	VirtualRegisterName* loaded = Ptr();
+
+	bb->Append(Helix::CreateStackAlloc(a, BuiltinTypes::GetInt32()));
+	bb->Append(Helix::CreateStackAlloc(b, BuiltinTypes::GetInt32()));
+	bb->Append(Helix::CreateStackAlloc(c, BuiltinTypes::GetInt32()));
+	bb->Append(Helix::CreateStackAlloc(pp, BuiltinTypes::GetPointer()));
+	bb->Append(Helix::CreateStore(a, pp));
+
+	CallInsn* call = Helix::CreateCall(callee, { b });
+
+	bb->Append(call);
+	bb->Append(Helix::CreateLoad(pp, loaded));
+	bb->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	AliasAnalysis& aa = am.Get<AliasAnalysis>(fn);
+
+	REQUIRE(aa.IsEscaped(a));
+	REQUIRE(aa.IsEscaped(b));
+	REQUIRE_FALSE(aa.IsEscaped(c));
+	REQUIRE_FALSE(aa.IsEscaped(pp));
+
+	REQUIRE(aa.Alias(Int32At(loaded), Int32At(a)) == AliasResult::MayAlias);
+	REQUIRE(aa.Alias(Int32At(loaded), Int32At(c)) == AliasResult::NoAlias);
+
+	REQUIRE(aa.GetModRefInfo(call, Int32At(b)) == kModRef);
+	REQUIRE(aa.GetModRefInfo(call, Int32At(c)) == kNoModRef);
+}
+
+/******************************************************************************/
+
+TEST_CASE("AliasAnalysis (Type Based)", "[AliasAnalysis]")
+{
+	BasicBlock* bb = nullptr;
+
+	VirtualRegisterName* p = Ptr();
+	VirtualRegisterName* q = Ptr();
+
+	Function* fn = CreateFunction(bb, { p, q });
+	bb->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	AliasAnalysis& aa = am.Get<AliasAnalysis>(fn);
+
+	const Type* i8  = BuiltinTypes::GetInt8();
+	const Type* i16 = BuiltinTypes::GetInt16();
+	const Type* i32 = BuiltinTypes::GetInt32();
+	const Type* ptr = BuiltinTypes::GetPointer();
+
+	REQUIRE(aa.Alias(MemoryLocation(p, i32), MemoryLocation(q, i32)) == AliasResult::MayAlias);
+	REQUIRE(aa.Alias(MemoryLocation(p, i32), MemoryLocation(q, i16)) == AliasResult::NoAlias);
+	REQUIRE(aa.Alias(MemoryLocation(p, i32), MemoryLocation(q, ptr)) == AliasResult::NoAlias);
+
+	// char can alias anything
+	REQUIRE(aa.Alias(MemoryLocation(p, i8), MemoryLocation(q, i32)) == AliasResult::MayAlias);
+	REQUIRE(aa.Alias(MemoryLocation(p, ptr), MemoryLocation(q, i8)) == AliasResult::MayAlias);
+}
+
+/******************************************************************************/
@@ -0,0 +1,57 @@
+/**
+ * @file test-arm-multiply.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../arm-multiply.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+
+using namespace Helix;
+
+/*********************************************************************************************************************/
+
+TEST_CASE("Multiplication by constant sequences", "[ARM]")
+{
+	static const uint32_t values[] = { 0, 1, 2, 7, 100, 12345678, 0x7fffffff, 0x80000000, 0xfffffffe, 0xffffffff };
+
+	SECTION("Common multipliers don't need a mul")
+	{
+		const uint32_t multiplier = GENERATE(0u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u, 10u, 12u, 15u, 16u, 17u, 20u, 24u,
+		                                     31u, 40u, 48u, 0xffffffffu /* -1 */, 0xfffffffbu /* -5 */);
+
+		ARMv7::MultiplySequence sequence;
+
+		REQUIRE(ARMv7::FindMultiplySequence(multiplier, &sequence));
+		REQUIRE(sequence.Steps.size() <= 2);
+		REQUIRE(sequence.Latency <= 3);
+
+		for (uint32_t x : values) {
+			REQUIRE(ARMv7::EvaluateMultiplySequence(sequence, x) == x * multiplier);
+		}
+	}
+
+	SECTION("Powers of two are a single shift")
+	{
+		const unsigned shift = GENERATE(1u, 2u, 3u, 16u, 31u);
+
+		ARMv7::MultiplySequence sequence;
+
+		REQUIRE(ARMv7::FindMultiplySequence(1u << shift, &sequence));
+		REQUIRE(sequence.Steps.size() == 1);
+		REQUIRE(sequence.Steps[0].Op == ARMv7::MultiplyStep::Lsl);
+		REQUIRE(sequence.Steps[0].Shift == shift);
+	}
+
+	SECTION("Multipliers that are quicker with a mul")
+	{
+		const uint32_t multiplier = GENERATE(1u, 11u, 100u, 12345u, 0x12345678u);
+
+		ARMv7::MultiplySequence sequence;
+		REQUIRE(!ARMv7::FindMultiplySequence(multiplier, &sequence));
+	}
+}
+
+/*********************************************************************************************************************/
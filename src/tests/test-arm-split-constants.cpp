@@ -0,0 +1,48 @@
+/**
+ * @file test-arm-split-constants.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../arm-split-constants.h"
+#include "../function.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+TEST_CASE("ArmSplitConstants (Shift amounts)", "[ARM]")
+{
+	BasicBlock* bb = nullptr;
+
+	VirtualRegisterName* x = Reg();
+	Function* fn = CreateFunction(bb, { x });
+
+	const HLIR::Opcode opc = GENERATE(HLIR::Shl, HLIR::Shr, HLIR::AShr);
+	const Integer amount = GENERATE(0, 1, 31);
+
+	VirtualRegisterName* y = Reg();
+	Instruction* shift = Helix::CreateBinOp(opc, x, Int32(amount), y);
+
+	bb->Append(shift);
+	bb->Append(Helix::CreateRet(y));
+
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	ArmSplitConstants pass;
+	pass.Execute(fn, info);
+
+	// There is no `lsr #0` or `asr #0`, so those need the amount in a register.
+	const bool immediate = opc == HLIR::Shl || amount != 0;
+
+	REQUIRE(value_isa<ConstantInt>(shift->GetOperand(1)) == immediate);
+}
+
+/******************************************************************************/
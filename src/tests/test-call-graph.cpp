@@ -0,0 +1,263 @@
+/**
+ * @file test-call-graph.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../call-graph.h"
+#include "../global-dce.h"
+#include "../module.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static bool Contains(Module& mod, Function* fn)
+{
+	for (Function* other : mod.functions()) {
+		if (other == fn)
+			return true;
+	}
+
+	return false;
+}
+
+static bool Contains(Module& mod, GlobalVariable* gvar)
+{
+	for (GlobalVariable* other : mod.globals()) {
+		if (other == gvar)
+			return true;
+	}
+
+	return false;
+}
+
+/******************************************************************************/
+
+TEST_CASE("CallGraph (Calls & References)", "[CallGraph]")
+{
+	Module mod("test.c");
+
+	BasicBlock* mainBB = nullptr;
+	BasicBlock* aBB    = nullptr;
+
+	Function* main     = CreateFunction(mod, "main", &mainBB);
+	Function* a        = CreateFunction(mod, "a", &aBB);
+	Function* b        = CreateFunction(mod, "b", nullptr);
+	Function* callback = CreateFunction(mod, "callback", nullptr);
+	Function* table    = CreateFunction(mod, "table", nullptr);
+
+	GlobalVariable* counter = GlobalVariable::Create("counter", BuiltinTypes::GetInt32());
+	mod.RegisterGlobalVariable(counter);
+
+	const ArrayType* tableType = ArrayType::Create(1, BuiltinTypes::GetPointer());
+	GlobalVariable* functions = GlobalVariable::Create("functions", tableType, ConstantArray::Create({ table }, tableType));
+	mod.RegisterGlobalVariable(functions);
+
+	mainBB->Append(Helix::CreateCall(a, {}));
+	mainBB->Append(Helix::CreateCall(a, {}));
+	mainBB->Append(Helix::CreateCall(b, { callback }));
+	mainBB->Append(Helix::CreateStore(ConstantInt::Create(BuiltinTypes::GetInt32(), 1), counter));
+	mainBB->Append(Helix::CreateRet());
+
+	aBB->Append(Helix::CreateCall(b, {}));
+	aBB->Append(Helix::CreateRet());
+
+	CallGraph callGraph(&mod);
+
+	SECTION("Callees & callers are only listed once")
+	{
+		REQUIRE(callGraph.GetNode(main)->GetCallees() == std::vector<Function*> { a, b });
+		REQUIRE(callGraph.GetNode(a)->GetCallees() == std::vector<Function*> { b });
+		REQUIRE(callGraph.GetNode(b)->GetCallers() == std::vector<Function*> { main, a });
+		REQUIRE(callGraph.GetNode(main)->GetCallers().empty());
+	}
+
+	SECTION("Every call site is recorded")
+	{
+		REQUIRE(callGraph.GetNode(a)->GetCallSites().size() == 2);
+		REQUIRE(callGraph.GetNode(b)->GetCallSites().size() == 2);
+		REQUIRE(callGraph.GetNode(a)->GetCountReferences() == 2);
+		REQUIRE(!callGraph.GetNode(a)->IsAddressTaken());
+	}
+
+	SECTION("Passing a function as an argument takes its address")
+	{
+		REQUIRE(callGraph.GetNode(callback)->IsAddressTaken());
+		REQUIRE(callGraph.GetNode(callback)->GetCallSites().empty());
+		REQUIRE(callGraph.GetNode(callback)->GetCallers().empty());
+	}
+
+	SECTION("Global initialisers take the address of functions")
+	{
+		REQUIRE(callGraph.GetNode(table)->GetCountAddressTaken() == 1);
+		REQUIRE(callGraph.GetInitialiserReferences(functions) == std::vector<Value*> { table });
+		REQUIRE(callGraph.GetInitialiserReferences(counter).empty());
+	}
+
+	SECTION("Globals referenced by functions")
+	{
+		REQUIRE(callGraph.GetNode(main)->GetReferences() == std::vector<Value*> { callback, counter });
+		REQUIRE(callGraph.GetCountReferences(counter) == 1);
+		REQUIRE(callGraph.GetCountReferences(functions) == 0);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("CallGraph (Bottom Up SCCs)", "[CallGraph]")
+{
+	Module mod("test.c");
+
+	BasicBlock* mainBB = nullptr;
+	BasicBlock* evenBB = nullptr;
+	BasicBlock* oddBB  = nullptr;
+	BasicBlock* selfBB = nullptr;
+	BasicBlock* leafBB = nullptr;
+
+	// main -> even <-> odd -> leaf, main -> self -> self
+	Function* main = CreateFunction(mod, "main", &mainBB);
+	Function* even = CreateFunction(mod, "even", &evenBB);
+	Function* odd  = CreateFunction(mod, "odd", &oddBB);
+	Function* self = CreateFunction(mod, "self", &selfBB);
+	Function* leaf = CreateFunction(mod, "leaf", &leafBB);
+
+	mainBB->Append(Helix::CreateCall(even, {}));
+	mainBB->Append(Helix::CreateCall(self, {}));
+	mainBB->Append(Helix::CreateRet());
+
+	evenBB->Append(Helix::CreateCall(odd, {}));
+	evenBB->Append(Helix::CreateRet());
+
+	oddBB->Append(Helix::CreateCall(even, {}));
+	oddBB->Append(Helix::CreateCall(leaf, {}));
+	oddBB->Append(Helix::CreateRet());
+
+	selfBB->Append(Helix::CreateCall(self, {}));
+	selfBB->Append(Helix::CreateRet());
+
+	leafBB->Append(Helix::CreateRet());
+
+	CallGraph callGraph(&mod);
+
+	const std::vector<std::vector<Function*>>& sccs = callGraph.GetSCCs();
+
+	auto position = [&sccs](Function* fn) {
+		for (size_t i = 0; i < sccs.size(); ++i) {
+			if (std::find(sccs[i].begin(), sccs[i].end(), fn) != sccs[i].end())
+				return i;
+		}
+
+		return SIZE_MAX;
+	};
+
+	REQUIRE(sccs.size() == 4);
+
+	SECTION("Functions that call each other are in the same component")
+	{
+		REQUIRE(position(even) == position(odd));
+		REQUIRE(sccs[position(even)].size() == 2);
+	}
+
+	SECTION("Callees come before callers")
+	{
+		REQUIRE(position(leaf) < position(odd));
+		REQUIRE(position(even) < position(main));
+		REQUIRE(position(self) < position(main));
+	}
+
+	SECTION("Recursion")
+	{
+		REQUIRE(callGraph.IsRecursive(even));
+		REQUIRE(callGraph.IsRecursive(odd));
+		REQUIRE(callGraph.IsRecursive(self));
+		REQUIRE(!callGraph.IsRecursive(main));
+		REQUIRE(!callGraph.IsRecursive(leaf));
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("GlobalDCE", "[CallGraph]")
+{
+	Module mod("test.c");
+
+	BasicBlock* mainBB  = nullptr;
+	BasicBlock* usedBB  = nullptr;
+	BasicBlock* deadABB = nullptr;
+	BasicBlock* deadBBB = nullptr;
+	BasicBlock* unusedBB = nullptr;
+
+	Function* main   = CreateFunction(mod, "main", &mainBB);
+	Function* used   = CreateFunction(mod, "used", &usedBB, {}, Linkage::Internal);
+	Function* deadA  = CreateFunction(mod, "dead_a", &deadABB, {}, Linkage::Internal);
+	Function* deadB  = CreateFunction(mod, "dead_b", &deadBBB, {}, Linkage::Internal);
+	Function* unused = CreateFunction(mod, "unused", &unusedBB);
+	Function* puts   = CreateFunction(mod, "puts", nullptr);
+
+	const Type* i32 = BuiltinTypes::GetInt32();
+	const ArrayType* tableType = ArrayType::Create(1, BuiltinTypes::GetPointer());
+
+	GlobalVariable* usedGlobal = GlobalVariable::Create("used_global", i32);
+	GlobalVariable* deadGlobal = GlobalVariable::Create("dead_global", i32);
+	GlobalVariable* indirect   = GlobalVariable::Create("indirect", i32);
+	GlobalVariable* external   = GlobalVariable::Create("external", tableType, ConstantArray::Create({ indirect }, tableType));
+
+	usedGlobal->SetLinkage(Linkage::Internal);
+	deadGlobal->SetLinkage(Linkage::Internal);
+	indirect->SetLinkage(Linkage::Internal);
+
+	mod.RegisterGlobalVariable(usedGlobal);
+	mod.RegisterGlobalVariable(deadGlobal);
+	mod.RegisterGlobalVariable(indirect);
+	mod.RegisterGlobalVariable(external);
+
+	mainBB->Append(Helix::CreateCall(used, {}));
+	mainBB->Append(Helix::CreateRet());
+
+	usedBB->Append(Helix::CreateStore(ConstantInt::Create(i32, 1), usedGlobal));
+	usedBB->Append(Helix::CreateRet());
+
+	// Internal functions that only call each other are still dead
+	deadABB->Append(Helix::CreateCall(deadB, {}));
+	deadABB->Append(Helix::CreateStore(ConstantInt::Create(i32, 2), deadGlobal));
+	deadABB->Append(Helix::CreateRet());
+
+	deadBBB->Append(Helix::CreateCall(deadA, {}));
+	deadBBB->Append(Helix::CreateCall(puts, {}));
+	deadBBB->Append(Helix::CreateRet());
+
+	unusedBB->Append(Helix::CreateRet());
+
+	GlobalDCE pass;
+	pass.Execute(&mod, {});
+
+	REQUIRE(Contains(mod, main));
+	REQUIRE(Contains(mod, used));
+	REQUIRE(Contains(mod, puts));
+
+	// External functions could be called from other translation units.
+	REQUIRE(Contains(mod, unused));
+
+	REQUIRE(!Contains(mod, deadA));
+	REQUIRE(!Contains(mod, deadB));
+	REQUIRE(mod.GetCountFunctions() == 4);
+
+	REQUIRE(Contains(mod, usedGlobal));
+	REQUIRE(Contains(mod, indirect));
+	REQUIRE(Contains(mod, external));
+	REQUIRE(!Contains(mod, deadGlobal));
+
+	// Nothing removed should still be using anything.
+	REQUIRE(deadGlobal->GetCountUses() == 0);
+	REQUIRE(puts->GetCountUses() == 0);
+}
+
+/******************************************************************************/
@@ -0,0 +1,149 @@
+/**
+ * @file test-dce.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../dce.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunDCE(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	DCE pass;
+	pass.Execute(fn, info);
+}
+
+/******************************************************************************/
+
+TEST_CASE("DCE (Dead chains & branches)", "[DCE]")
+{
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* p = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { x, p });
+
+	const bool storeInThen = GENERATE(false, true);
+
+	// entry: a = iadd x, 1; b = imul a, 2; c = icmp_lt x, 0; cbr c, then, join
+	// then:  d = isub 0, x; (store d, p;) br join
+	// join:  r = phi [b, then], [0, entry]   (unused)
+	//        ret x
+	// dead:  ret x                           (unreachable)
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* d = Reg();
+	VirtualRegisterName* r = Reg();
+
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, x, Int32(1), a));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IMul, a, Int32(2), b));
+	bbs[0]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, x, Int32(0), c));
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[3], c));
+
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::ISub, Int32(0), x, d));
+
+	if (storeInThen)
+		bbs[1]->Append(Helix::CreateStore(d, p));
+
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	bbs[2]->Append(Helix::CreateRet(x));
+
+	PhiInsn* phi = Helix::CreatePhi(r);
+	phi->AddIncoming(b, bbs[1]);
+	phi->AddIncoming(Int32(0), bbs[0]);
+
+	bbs[3]->Append(phi);
+	bbs[3]->Append(Helix::CreateRet(x));
+
+	RunDCE(fn);
+
+	// The whole chain goes in one run.
+	REQUIRE(CountInstructions(fn, HLIR::Phi) == 0);
+	REQUIRE(CountInstructions(fn, HLIR::IMul) == 0);
+	REQUIRE(CountInstructions(fn, HLIR::IAdd) == 0);
+
+	// ... & so does the block nothing branches to.
+	REQUIRE(CountInstructions(fn, HLIR::Return) == 1);
+
+	if (storeInThen) {
+		REQUIRE(bbs[0]->GetLast()->GetOpcode() == HLIR::ConditionalBranch);
+		REQUIRE(CountInstructions(fn, HLIR::ISub) == 1);
+		REQUIRE(CountInstructions(fn, HLIR::Store) == 1);
+	}
+	else {
+		REQUIRE(bbs[0]->GetLast()->GetOpcode() == HLIR::UnconditionalBranch);
+		REQUIRE(bbs[0]->GetSuccessors()[0] == bbs[3]);
+		REQUIRE(bbs[0]->begin()->GetOpcode() == HLIR::UnconditionalBranch);
+
+		REQUIRE(CountInstructions(fn, HLIR::ISub) == 0);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("DCE (Loops that compute nothing)", "[DCE]")
+{
+	VirtualRegisterName* n = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { n });
+
+	const bool constantBound = GENERATE(false, true);
+
+	// entry:  br header
+	// header: i = phi [0, entry], [i2, body]; c = icmp_lt i, <10 or n>; cbr c, body, exit
+	// body:   i2 = iadd i, 1; br header
+	// exit:   ret 0
+	VirtualRegisterName* i  = Reg();
+	VirtualRegisterName* c  = Reg();
+	VirtualRegisterName* i2 = Reg();
+
+	PhiInsn* phi = Helix::CreatePhi(i);
+	phi->AddIncoming(Int32(0), bbs[0]);
+	phi->AddIncoming(i2, bbs[2]);
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(phi);
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i, constantBound ? (Value*) Int32(10) : n, c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), i2));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[3]->Append(Helix::CreateRet(Int32(0)));
+
+	RunDCE(fn);
+
+	if (constantBound) {
+		// Always finishes, so it can go.
+		REQUIRE(CountInstructions(fn, HLIR::ConditionalBranch) == 0);
+		REQUIRE(CountInstructions(fn, HLIR::Phi) == 0);
+		REQUIRE(CountInstructions(fn, HLIR::IAdd) == 0);
+		REQUIRE(bbs[1]->GetSuccessors()[0] == bbs[3]);
+	}
+	else {
+		// The trip count isn't known, so it's kept in case it never finishes.
+		REQUIRE(CountInstructions(fn, HLIR::ConditionalBranch) == 1);
+		REQUIRE(CountInstructions(fn, HLIR::Phi) == 1);
+		REQUIRE(CountInstructions(fn, HLIR::IAdd) == 1);
+	}
+}
+
+/******************************************************************************/
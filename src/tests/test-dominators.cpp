@@ -0,0 +1,260 @@
+/**
+ * @file test-dominators.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../dominators.h"
+#include "../function.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void Branch(BasicBlock* from, BasicBlock* to)
+{
+	from->Append(Helix::CreateUnconditionalBranch(to));
+}
+
+static void CondBranch(BasicBlock* from, BasicBlock* t, BasicBlock* f)
+{
+	from->Append(Helix::CreateConditionalBranch(t, f, Reg()));
+}
+
+static void Return(BasicBlock* from)
+{
+	from->Append(Helix::CreateRet());
+}
+
+static bool Contains(const std::vector<BasicBlock*>& blocks, BasicBlock* bb)
+{
+	return std::find(blocks.begin(), blocks.end(), bb) != blocks.end();
+}
+
+/******************************************************************************/
+
+TEST_CASE("DominatorTree (Single Block)", "[DominatorTree]")
+{
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 1);
+
+	Return(bbs[0]);
+
+	DominatorTree domTree(fn);
+
+	REQUIRE(domTree.GetRoot() == bbs[0]);
+	REQUIRE(domTree.GetImmediateDominator(bbs[0]) == nullptr);
+	REQUIRE(domTree.Dominates(bbs[0], bbs[0]));
+	REQUIRE_FALSE(domTree.StrictlyDominates(bbs[0], bbs[0]));
+	REQUIRE(domTree.GetDominanceFrontier(bbs[0]).empty());
+	REQUIRE(domTree.GetLevel(bbs[0]) == 0);
+}
+
+/******************************************************************************/
+
+TEST_CASE("DominatorTree (Diamond)", "[DominatorTree]")
+{
+	// 0 -> 1, 0 -> 2
+	// 1 -> 3, 2 -> 3
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4);
+
+	CondBranch(bbs[0], bbs[1], bbs[2]);
+	Branch(bbs[1], bbs[3]);
+	Branch(bbs[2], bbs[3]);
+	Return(bbs[3]);
+
+	DominatorTree domTree(fn);
+
+	REQUIRE(domTree.GetImmediateDominator(bbs[1]) == bbs[0]);
+	REQUIRE(domTree.GetImmediateDominator(bbs[2]) == bbs[0]);
+	REQUIRE(domTree.GetImmediateDominator(bbs[3]) == bbs[0]);
+
+	REQUIRE(domTree.Dominates(bbs[0], bbs[3]));
+	REQUIRE_FALSE(domTree.Dominates(bbs[1], bbs[3]));
+	REQUIRE_FALSE(domTree.Dominates(bbs[1], bbs[2]));
+
+	REQUIRE(domTree.GetDominanceFrontier(bbs[1]).size() == 1);
+	REQUIRE(domTree.GetDominanceFrontier(bbs[1])[0] == bbs[3]);
+	REQUIRE(domTree.GetDominanceFrontier(bbs[2]).size() == 1);
+	REQUIRE(domTree.GetDominanceFrontier(bbs[2])[0] == bbs[3]);
+	REQUIRE(domTree.GetDominanceFrontier(bbs[0]).empty());
+	REQUIRE(domTree.GetDominanceFrontier(bbs[3]).empty());
+
+	REQUIRE(domTree.GetChildren(bbs[0]).size() == 3);
+	REQUIRE(domTree.FindNearestCommonDominator(bbs[1], bbs[2]) == bbs[0]);
+	REQUIRE(domTree.GetLevel(bbs[3]) == 1);
+}
+
+/******************************************************************************/
+
+TEST_CASE("DominatorTree (Loop)", "[DominatorTree]")
+{
+	// 0 -> 1 (header) -> 2 (body) -> 1
+	//      1 -> 3 (exit)
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4);
+
+	Branch(bbs[0], bbs[1]);
+	CondBranch(bbs[1], bbs[2], bbs[3]);
+	Branch(bbs[2], bbs[1]);
+	Return(bbs[3]);
+
+	DominatorTree domTree(fn);
+
+	REQUIRE(domTree.GetImmediateDominator(bbs[1]) == bbs[0]);
+	REQUIRE(domTree.GetImmediateDominator(bbs[2]) == bbs[1]);
+	REQUIRE(domTree.GetImmediateDominator(bbs[3]) == bbs[1]);
+
+	REQUIRE(domTree.Dominates(bbs[1], bbs[2]));
+	REQUIRE(domTree.Dominates(bbs[0], bbs[2]));
+	REQUIRE_FALSE(domTree.Dominates(bbs[2], bbs[1]));
+
+	// The loop body's frontier is the header (where the back edge goes), and
+	// the header is in its own frontier.
+	REQUIRE(Contains(domTree.GetDominanceFrontier(bbs[2]), bbs[1]));
+	REQUIRE(Contains(domTree.GetDominanceFrontier(bbs[1]), bbs[1]));
+
+	const std::vector<BasicBlock*>& rpo = domTree.GetReversePostOrder();
+	REQUIRE(rpo.size() == 4);
+	REQUIRE(rpo[0] == bbs[0]);
+	REQUIRE(rpo[1] == bbs[1]);
+
+	const std::vector<BasicBlock*> preorder = domTree.GetPreOrder();
+	REQUIRE(preorder.size() == 4);
+	REQUIRE(preorder[0] == bbs[0]);
+	REQUIRE(preorder[1] == bbs[1]);
+}
+
+/******************************************************************************/
+
+TEST_CASE("DominatorTree (Unreachable Block)", "[DominatorTree]")
+{
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 3);
+
+	Branch(bbs[0], bbs[2]);
+	Branch(bbs[1], bbs[2]);
+	Return(bbs[2]);
+
+	DominatorTree domTree(fn);
+
+	REQUIRE_FALSE(domTree.IsReachable(bbs[1]));
+	REQUIRE(domTree.GetImmediateDominator(bbs[1]) == nullptr);
+	REQUIRE(domTree.GetImmediateDominator(bbs[2]) == bbs[0]);
+	REQUIRE_FALSE(domTree.Dominates(bbs[1], bbs[2]));
+	REQUIRE_FALSE(domTree.Dominates(bbs[0], bbs[1]));
+	REQUIRE(domTree.GetReversePostOrder().size() == 2);
+}
+
+/******************************************************************************/
+
+TEST_CASE("DominatorTree (Post Dominators)", "[DominatorTree]")
+{
+	// 0 -> 1, 0 -> 2
+	// 1 -> 3 (ret)
+	// 2 -> 3 (ret), 2 -> 4 (ret)
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 5);
+
+	CondBranch(bbs[0], bbs[1], bbs[2]);
+	Branch(bbs[1], bbs[3]);
+	CondBranch(bbs[2], bbs[3], bbs[4]);
+	Return(bbs[3]);
+	Return(bbs[4]);
+
+	DominatorTree postDomTree(fn, DominatorTree::kPostDominators);
+
+	REQUIRE(postDomTree.IsPostDominatorTree());
+	REQUIRE(postDomTree.GetRoot() == nullptr);
+
+	REQUIRE(postDomTree.GetImmediateDominator(bbs[1]) == bbs[3]);
+	REQUIRE(postDomTree.GetImmediateDominator(bbs[3]) == nullptr);
+	REQUIRE(postDomTree.GetImmediateDominator(bbs[2]) == nullptr);
+	REQUIRE(postDomTree.GetImmediateDominator(bbs[0]) == nullptr);
+
+	REQUIRE(postDomTree.Dominates(bbs[3], bbs[1]));
+	REQUIRE_FALSE(postDomTree.Dominates(bbs[3], bbs[0]));
+	REQUIRE(postDomTree.Dominates(nullptr, bbs[0]));
+
+	REQUIRE(postDomTree.GetChildren(nullptr).size() == 4);
+
+	// Block 1 is control dependent on the branch in block 0, block 3
+	// on the branch in block 2.
+	REQUIRE(postDomTree.GetDominanceFrontier(bbs[1]).size() == 1);
+	REQUIRE(postDomTree.GetDominanceFrontier(bbs[1])[0] == bbs[0]);
+	REQUIRE(Contains(postDomTree.GetDominanceFrontier(bbs[3]), bbs[2]));
+}
+
+/******************************************************************************/
+
+TEST_CASE("DominatorTree (Post Dominators, Infinite Loop)", "[DominatorTree]")
+{
+	// 0 -> 1 (header) -> 2, 1 -> 3
+	// 2 -> 4 (latch), 3 -> 4 (latch)
+	// 4 -> 1
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 5);
+
+	Branch(bbs[0], bbs[1]);
+	CondBranch(bbs[1], bbs[2], bbs[3]);
+	Branch(bbs[2], bbs[4]);
+	Branch(bbs[3], bbs[4]);
+	Branch(bbs[4], bbs[1]);
+
+	DominatorTree postDomTree(fn, DominatorTree::kPostDominators);
+
+	for (BasicBlock* bb : bbs) {
+		REQUIRE(postDomTree.IsReachable(bb));
+	}
+
+	// The header stands in as the exit of the loop.
+	REQUIRE(postDomTree.GetImmediateDominator(bbs[1]) == nullptr);
+	REQUIRE(postDomTree.GetImmediateDominator(bbs[0]) == bbs[1]);
+	REQUIRE(postDomTree.GetImmediateDominator(bbs[4]) == bbs[1]);
+	REQUIRE(postDomTree.GetImmediateDominator(bbs[2]) == bbs[4]);
+	REQUIRE(postDomTree.GetImmediateDominator(bbs[3]) == bbs[4]);
+
+	// Both arms are control dependent on the branch in the header.
+	REQUIRE(Contains(postDomTree.GetDominanceFrontier(bbs[2]), bbs[1]));
+	REQUIRE(Contains(postDomTree.GetDominanceFrontier(bbs[3]), bbs[1]));
+}
+
+/******************************************************************************/
+
+TEST_CASE("DominatorTree (Instruction Dominance)", "[DominatorTree]")
+{
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 2);
+
+	VirtualRegisterName* a = VirtualRegisterName::Create(BuiltinTypes::GetInt32());
+	VirtualRegisterName* b = VirtualRegisterName::Create(BuiltinTypes::GetInt32());
+
+	Instruction* first = Helix::CreateBinOp(HLIR::IAdd, a, a, b);
+	Instruction* second = Helix::CreateBinOp(HLIR::IAdd, b, b, a);
+
+	bbs[0]->Append(first);
+	bbs[0]->Append(second);
+	Branch(bbs[0], bbs[1]);
+	Return(bbs[1]);
+
+	DominatorTree domTree(fn);
+
+	REQUIRE(domTree.Dominates(first, second));
+	REQUIRE_FALSE(domTree.Dominates(second, first));
+	REQUIRE(domTree.Dominates(second, bbs[1]->GetLast()));
+
+	DominatorTree postDomTree(fn, DominatorTree::kPostDominators);
+
+	REQUIRE(postDomTree.Dominates(second, first));
+	REQUIRE_FALSE(postDomTree.Dominates(first, second));
+}
+
+/******************************************************************************/
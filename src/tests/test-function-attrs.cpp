@@ -0,0 +1,222 @@
+/**
+ * @file test-function-attrs.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../function-attrs.h"
+#include "../dce.h"
+#include "../gvn.h"
+#include "../module.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunFunctionAttrs(Module& mod, AnalysisManager& am)
+{
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	FunctionAttrs pass;
+	pass.Execute(&mod, info);
+}
+
+/// Create `sq(x) = x * x`, going through a stack slot of its own on the way.
+static Function* CreateSquareFunction(Module& mod)
+{
+	VirtualRegisterName* x    = Reg();
+	VirtualRegisterName* slot = Ptr();
+	VirtualRegisterName* y    = Reg();
+	VirtualRegisterName* r    = Reg();
+
+	BasicBlock* bb = nullptr;
+	Function* fn = CreateFunction(mod, "sq", &bb, { x });
+
+	bb->Append(Helix::CreateStackAlloc(slot, BuiltinTypes::GetInt32()));
+	bb->Append(Helix::CreateStore(x, slot));
+	bb->Append(Helix::CreateLoad(slot, y));
+	bb->Append(Helix::CreateBinOp(HLIR::IMul, y, y, r));
+	bb->Append(Helix::CreateRet(r));
+
+	return fn;
+}
+
+/******************************************************************************/
+
+TEST_CASE("FunctionAttrs (Inference)", "[FunctionAttrs]")
+{
+	Module mod("test.c");
+	AnalysisManager am;
+
+	GlobalVariable* g = GlobalVariable::Create("g", BuiltinTypes::GetInt32());
+
+	Function* sq = CreateSquareFunction(mod);
+
+	// get() = g
+	VirtualRegisterName* v = Reg();
+
+	BasicBlock* getBB = nullptr;
+	Function* get = CreateFunction(mod, "get", &getBB, {});
+
+	getBB->Append(Helix::CreateLoad(g, v));
+	getBB->Append(Helix::CreateRet(v));
+
+	// bump() = g = g + 1
+	VirtualRegisterName* w  = Reg();
+	VirtualRegisterName* w1 = Reg();
+
+	BasicBlock* bumpBB = nullptr;
+	Function* bump = CreateFunction(mod, "bump", &bumpBB, {});
+
+	bumpBB->Append(Helix::CreateLoad(g, w));
+	bumpBB->Append(Helix::CreateBinOp(HLIR::IAdd, w, Int32(1), w1));
+	bumpBB->Append(Helix::CreateStore(w1, g));
+	bumpBB->Append(Helix::CreateRet(w1));
+
+	// Declarations, one of which is `__attribute__((const))`
+	Function* ext    = CreateFunction(mod, "ext", nullptr, {});
+	Function* extAbs = CreateFunction(mod, "abs", nullptr, { Reg() });
+
+	extAbs->SetMemoryEffects(MemoryEffects::ReadNone);
+	extAbs->SetAlwaysReturns(true);
+
+	SECTION("Functions that only do arithmetic (& use their own stack) don't access memory")
+	{
+		RunFunctionAttrs(mod, am);
+
+		REQUIRE(sq->GetMemoryEffects() == MemoryEffects::ReadNone);
+		REQUIRE(sq->AlwaysReturns());
+	}
+
+	SECTION("Loads & stores to globals are read & written memory")
+	{
+		RunFunctionAttrs(mod, am);
+
+		REQUIRE(get->GetMemoryEffects() == MemoryEffects::ReadOnly);
+		REQUIRE(get->AlwaysReturns());
+
+		REQUIRE(bump->GetMemoryEffects() == MemoryEffects::ReadWrite);
+	}
+
+	SECTION("Declarations are left as they are")
+	{
+		RunFunctionAttrs(mod, am);
+
+		REQUIRE(ext->GetMemoryEffects() == MemoryEffects::ReadWrite);
+		REQUIRE(!ext->AlwaysReturns());
+
+		REQUIRE(extAbs->GetMemoryEffects() == MemoryEffects::ReadNone);
+		REQUIRE(extAbs->AlwaysReturns());
+	}
+
+	SECTION("Callers get the effects of their callees")
+	{
+		// caller(x) = abs(sq(x)) + get() (+ ext(), maybe)
+		const bool callsExt = GENERATE(false, true);
+
+		VirtualRegisterName* x = Reg();
+		VirtualRegisterName* a = Reg();
+		VirtualRegisterName* b = Reg();
+		VirtualRegisterName* c = Reg();
+		VirtualRegisterName* r = Reg();
+
+		BasicBlock* bb = nullptr;
+		Function* caller = CreateFunction(mod, "caller", &bb, { x });
+
+		bb->Append(Helix::CreateCall(sq, a, { x }));
+		bb->Append(Helix::CreateCall(extAbs, b, { a }));
+		bb->Append(Helix::CreateCall(get, c, {}));
+		bb->Append(Helix::CreateBinOp(HLIR::IAdd, b, c, r));
+
+		if (callsExt)
+			bb->Append(Helix::CreateCall(ext, Reg(), {}));
+
+		bb->Append(Helix::CreateRet(r));
+
+		RunFunctionAttrs(mod, am);
+
+		REQUIRE(caller->GetMemoryEffects() == (callsExt ? MemoryEffects::ReadWrite : MemoryEffects::ReadOnly));
+		REQUIRE(caller->AlwaysReturns() == !callsExt);
+	}
+
+	SECTION("Recursive functions might not return")
+	{
+		// rec(n) = rec(n - 1)
+		VirtualRegisterName* n  = Reg();
+		VirtualRegisterName* n1 = Reg();
+		VirtualRegisterName* r  = Reg();
+
+		BasicBlock* bb = nullptr;
+		Function* rec = CreateFunction(mod, "rec", &bb, { n });
+
+		bb->Append(Helix::CreateBinOp(HLIR::ISub, n, Int32(1), n1));
+		bb->Append(Helix::CreateCall(rec, r, { n1 }));
+		bb->Append(Helix::CreateRet(r));
+
+		RunFunctionAttrs(mod, am);
+
+		REQUIRE(rec->GetMemoryEffects() == MemoryEffects::ReadNone);
+		REQUIRE(!rec->AlwaysReturns());
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("FunctionAttrs (Optimising calls)", "[FunctionAttrs]")
+{
+	Module mod("test.c");
+	AnalysisManager am;
+
+	Function* sq  = CreateSquareFunction(mod);
+	Function* ext = CreateFunction(mod, "ext", nullptr, { Reg() });
+
+	// a = sq(x); b = sq(x); c = sq(3) (unused); d = ext(x) (unused); ret a + b
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* r = Reg();
+
+	BasicBlock* bb = nullptr;
+	Function* fn = CreateFunction(mod, "test", &bb, { x });
+
+	BinOpInsn* add = Helix::CreateBinOp(HLIR::IAdd, a, b, r);
+
+	bb->Append(Helix::CreateCall(sq, a, { x }));
+	bb->Append(Helix::CreateCall(sq, b, { x }));
+	bb->Append(Helix::CreateCall(sq, Reg(), { Int32(3) }));
+	bb->Append(Helix::CreateCall(ext, Reg(), { x }));
+	bb->Append(add);
+	bb->Append(Helix::CreateRet(r));
+
+	RunFunctionAttrs(mod, am);
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	SECTION("Calls whose results aren't used are deleted (if they don't write memory)")
+	{
+		DCE dce;
+		dce.Execute(fn, info);
+
+		REQUIRE(CountInstructions(fn, HLIR::Call) == 3);
+		REQUIRE(bb->GetLast()->GetOpcode() == HLIR::Return);
+	}
+
+	SECTION("Calls to functions that don't access memory are numbered like any other expression")
+	{
+		GVN gvn;
+		gvn.Execute(fn, info);
+
+		REQUIRE(CountInstructions(fn, HLIR::Call) == 3);
+		REQUIRE(add->GetLHS() == a);
+		REQUIRE(add->GetRHS() == a);
+	}
+}
+
+/******************************************************************************/
@@ -0,0 +1,136 @@
+/**
+ * @file test-genlower.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../genlower.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+/* C++ Standard Library Includes */
+#include <cstdint>
+#include <unordered_map>
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunGenericLowering(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	GenericLowering pass;
+	pass.Execute(fn, info);
+}
+
+/// Run a block of 32 bit binary operations (ending with a `ret`) with 'param' set to 'x'.
+static uint32_t Evaluate(BasicBlock* bb, Value* param, uint32_t x)
+{
+	std::unordered_map<Value*, uint32_t> values = { { param, x } };
+
+	auto get = [&values](Value* value) -> uint32_t {
+		if (ConstantInt* constant = value_cast<ConstantInt>(value))
+			return (uint32_t) constant->GetIntegralValue();
+
+		REQUIRE(values.count(value));
+		return values[value];
+	};
+
+	for (Instruction& insn : *bb) {
+		if (insn.GetOpcode() == HLIR::Return)
+			return get(insn.GetOperand(0));
+
+		BinOpInsn& binop = static_cast<BinOpInsn&>(insn);
+
+		const uint32_t a = get(binop.GetLHS());
+		const uint32_t b = get(binop.GetRHS());
+
+		uint32_t result = 0;
+
+		switch (binop.GetOpcode()) {
+		case HLIR::IAdd:   result = a + b; break;
+		case HLIR::ISub:   result = a - b; break;
+		case HLIR::IMul:   result = a * b; break;
+		case HLIR::And:    result = a & b; break;
+		case HLIR::Shl:    result = a << b; break;
+		case HLIR::Shr:    result = a >> b; break;
+		case HLIR::AShr:   result = (uint32_t) ((int32_t) a >> b); break;
+		case HLIR::IMulHU: result = (uint32_t) (((uint64_t) a * b) >> 32); break;
+		case HLIR::IMulHS: result = (uint32_t) (((int64_t) (int32_t) a * (int32_t) b) >> 32); break;
+
+		default:
+			FAIL("unexpected instruction after lowering");
+			break;
+		}
+
+		values[binop.GetResult()] = result;
+	}
+
+	FAIL("block doesn't return");
+	return 0;
+}
+
+/******************************************************************************/
+
+TEST_CASE("Generic lowering (Division by constants)", "[GenericLowering]")
+{
+	static const uint32_t values[] = {
+		0, 1, 2, 3, 7, 9, 10, 11, 99, 100, 101, 12345678, 0x55555555,
+		0x7fffffff, 0x80000000, 0x80000001, 0xfffffc18, 0xfffffff6, 0xfffffffe, 0xffffffff
+	};
+
+	const HLIR::Opcode opc = GENERATE(HLIR::IUDiv, HLIR::ISDiv, HLIR::IURem, HLIR::ISRem);
+
+	const uint32_t divisor = GENERATE(
+		2u, 3u, 7u, 10u, 16u, 100u, 641u, 0x7fffffffu, 0x80000000u, 0x80000001u,
+		0xffffffffu /* -1 */, 0xfffffffdu /* -3 */, 0xfffffff0u /* -16 */, 0xfffffff9u /* -7 */
+	);
+
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* r = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 1, { x });
+
+	bbs[0]->Append(Helix::CreateBinOp(opc, x, Int32(divisor), r));
+	bbs[0]->Append(Helix::CreateRet(r));
+
+	RunGenericLowering(fn);
+
+	// Nothing is left that needs a divide instruction.
+	for (Instruction& insn : *bbs[0]) {
+		REQUIRE(insn.GetOpcode() != HLIR::IUDiv);
+		REQUIRE(insn.GetOpcode() != HLIR::ISDiv);
+	}
+
+	for (uint32_t value : values) {
+		const int32_t sx = (int32_t) value;
+		const int32_t sd = (int32_t) divisor;
+
+		// INT_MIN / -1 overflows
+		if (sx == INT32_MIN && sd == -1)
+			continue;
+
+		uint32_t expected = 0;
+
+		switch (opc) {
+		case HLIR::IUDiv: expected = value / divisor; break;
+		case HLIR::IURem: expected = value % divisor; break;
+		case HLIR::ISDiv: expected = (uint32_t) (sx / sd); break;
+		case HLIR::ISRem: expected = (uint32_t) (sx % sd); break;
+		default: break;
+		}
+
+		REQUIRE(Evaluate(bbs[0], x, value) == expected);
+	}
+}
+
+/******************************************************************************/
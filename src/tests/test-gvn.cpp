@@ -0,0 +1,149 @@
+/**
+ * @file test-gvn.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../gvn.h"
+#include "../function.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunGVN(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	GVN pass;
+	pass.Execute(fn, info);
+}
+
+/******************************************************************************/
+
+TEST_CASE("GVN (Redundant arithmetic)", "[GVN]")
+{
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* y = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 3, { x, y });
+
+	// entry: a = iadd x, y; cbr a, then, tail
+	// then:  b = iadd y, x; c = isub x, y; br tail
+	// tail:  d = iadd x, y; e = isub x, y; ret ...
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* d = Reg();
+	VirtualRegisterName* e = Reg();
+	VirtualRegisterName* f = Reg();
+	VirtualRegisterName* g = Reg();
+
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, x, y, a));
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], a));
+
+	BinOpInsn* useB = Helix::CreateBinOp(HLIR::IMul, b, c, f);
+
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::IAdd, y, x, b));
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::ISub, x, y, c));
+	bbs[1]->Append(useB);
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[2]));
+
+	BinOpInsn* useD = Helix::CreateBinOp(HLIR::IMul, d, e, g);
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, x, y, d));
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::ISub, x, y, e));
+	bbs[2]->Append(useD);
+	bbs[2]->Append(Helix::CreateRet(g));
+
+	RunGVN(fn);
+
+	SECTION("Expressions computed in a dominator are reused (in either order)")
+	{
+		REQUIRE(bbs[1]->GetCountInstructions() == 3);
+		REQUIRE(useB->GetLHS() == a);
+
+		REQUIRE(useD->GetLHS() == a);
+	}
+
+	SECTION("Expressions computed in a block that doesn't dominate aren't reused")
+	{
+		REQUIRE(bbs[2]->GetCountInstructions() == 3);
+		REQUIRE(useD->GetRHS() == e);
+		REQUIRE(useB->GetRHS() == c);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("GVN (Redundant loads)", "[GVN]")
+{
+	VirtualRegisterName* p = Ptr();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 3, { p });
+
+	VirtualRegisterName* slot = Ptr();
+
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* d = Reg();
+	VirtualRegisterName* e = Reg();
+
+	VirtualRegisterName* r0 = Reg();
+	VirtualRegisterName* r1 = Reg();
+	VirtualRegisterName* r2 = Reg();
+
+	// entry: slot = stack_alloc i32
+	//        a = load p; store 1, slot; b = load p     (slot doesn't alias p)
+	//        store 2, p; c = load p                    (forwarded from the store)
+	//        cbr a, then, tail
+	// then:  d = load p; br tail
+	// tail:  e = load p                                (two ways in, so not available)
+	bbs[0]->Append(Helix::CreateStackAlloc(slot, BuiltinTypes::GetInt32()));
+	bbs[0]->Append(Helix::CreateLoad(p, a));
+	bbs[0]->Append(Helix::CreateStore(Int32(1), slot));
+	bbs[0]->Append(Helix::CreateLoad(p, b));
+	bbs[0]->Append(Helix::CreateStore(Int32(2), p));
+	bbs[0]->Append(Helix::CreateLoad(p, c));
+
+	BinOpInsn* use0 = Helix::CreateBinOp(HLIR::IAdd, a, b, r0);
+
+	bbs[0]->Append(use0);
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	BinOpInsn* use1 = Helix::CreateBinOp(HLIR::IAdd, d, d, r1);
+
+	bbs[1]->Append(Helix::CreateLoad(p, d));
+	bbs[1]->Append(use1);
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[2]));
+
+	BinOpInsn* use2 = Helix::CreateBinOp(HLIR::IAdd, e, e, r2);
+
+	bbs[2]->Append(Helix::CreateLoad(p, e));
+	bbs[2]->Append(use2);
+	bbs[2]->Append(Helix::CreateRet(r2));
+
+	ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(bbs[0]->GetLast());
+
+	RunGVN(fn);
+
+	REQUIRE(use0->GetLHS() == a);
+	REQUIRE(use0->GetRHS() == a);
+	REQUIRE(cbr->GetCond() == Int32(2));
+	REQUIRE(use1->GetLHS() == Int32(2));
+
+	REQUIRE(bbs[2]->begin()->GetOpcode() == HLIR::Load);
+	REQUIRE(use2->GetLHS() == e);
+}
+
+/******************************************************************************/
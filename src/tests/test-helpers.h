@@ -0,0 +1,127 @@
+/**
+ * @file test-helpers.h
+ * @author Barney Wilks
+ *
+ * Helpers for building small functions by hand in the IR tests.
+ */
+
+#pragma once
+
+/* Helix Core Includes */
+#include "../function.h"
+#include "../module.h"
+
+/* C++ Standard Library Includes */
+#include <string>
+#include <vector>
+
+/******************************************************************************/
+
+/// Create a function called "test" returning i32 with the given parameters &
+/// 'nBlocks' empty basic blocks (which are added to 'blocks').
+inline Helix::Function* CreateFunction(std::vector<Helix::BasicBlock*>& blocks, size_t nBlocks, const Helix::Function::ParamList& params = {})
+{
+	using namespace Helix;
+
+	FunctionType::ParametersList types;
+
+	for (Value* param : params) {
+		types.push_back(param->GetType());
+	}
+
+	const FunctionType* type
+		= FunctionType::Create(BuiltinTypes::GetInt32(), types);
+
+	Function* fn = Function::Create(type, "test", params);
+
+	for (size_t i = 0; i < nBlocks; ++i) {
+		BasicBlock* bb = BasicBlock::Create();
+		fn->Append(bb);
+		blocks.push_back(bb);
+	}
+
+	return fn;
+}
+
+/// Create a function called "test" returning i32 with the given parameters &
+/// a single empty basic block (returned in 'bb').
+inline Helix::Function* CreateFunction(Helix::BasicBlock*& bb, const Helix::Function::ParamList& params = {})
+{
+	std::vector<Helix::BasicBlock*> blocks;
+	Helix::Function* fn = CreateFunction(blocks, 1, params);
+
+	bb = blocks[0];
+	return fn;
+}
+
+/// Create a function in 'mod' returning i32 with the given parameters & a single
+/// empty basic block (returned in 'bb'), or no body at all if 'bb' is null.
+inline Helix::Function* CreateFunction(Helix::Module& mod, const std::string& name, Helix::BasicBlock** bb,
+                                       const Helix::Function::ParamList& params = {},
+                                       Helix::Linkage linkage = Helix::Linkage::External)
+{
+	using namespace Helix;
+
+	FunctionType::ParametersList types;
+
+	for (Value* param : params) {
+		types.push_back(param->GetType());
+	}
+
+	const FunctionType* type
+		= FunctionType::Create(BuiltinTypes::GetInt32(), types);
+
+	Function* fn = Function::Create(type, name, params);
+	fn->SetLinkage(linkage);
+
+	if (bb) {
+		*bb = BasicBlock::Create();
+		fn->Append(*bb);
+	}
+
+	mod.RegisterFunction(fn);
+
+	return fn;
+}
+
+inline Helix::ConstantInt* Int32(Helix::Integer value)
+{
+	return Helix::ConstantInt::Create(Helix::BuiltinTypes::GetInt32(), value);
+}
+
+inline Helix::VirtualRegisterName* Reg(const Helix::Type* type = Helix::BuiltinTypes::GetInt32())
+{
+	return Helix::VirtualRegisterName::Create(type);
+}
+
+inline Helix::VirtualRegisterName* Ptr()
+{
+	return Reg(Helix::BuiltinTypes::GetPointer());
+}
+
+/// Count the instructions in 'bb' with the given opcode.
+inline size_t CountInstructions(Helix::BasicBlock* bb, Helix::HLIR::Opcode opcode)
+{
+	size_t count = 0;
+
+	for (Helix::Instruction& insn : *bb) {
+		if (insn.GetOpcode() == opcode)
+			count++;
+	}
+
+	return count;
+}
+
+/// Count the instructions in every block of 'fn' with the given opcode.
+inline size_t CountInstructions(Helix::Function* fn, Helix::HLIR::Opcode opcode)
+{
+	size_t count = 0;
+
+	for (Helix::BasicBlock& bb : fn->blocks()) {
+		count += CountInstructions(&bb, opcode);
+	}
+
+	return count;
+}
+
+/******************************************************************************/
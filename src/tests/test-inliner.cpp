@@ -0,0 +1,166 @@
+/**
+ * @file test-inliner.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../inliner.h"
+#include "../module.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunInliner(Module& mod)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	Inliner pass;
+	pass.Execute(&mod, info);
+}
+
+/// Create a function that returns its parameter plus one, 'n' times over.
+static Function* CreateAddFunction(Module& mod, const std::string& name, size_t n, Linkage linkage = Linkage::External)
+{
+	VirtualRegisterName* x = Reg();
+
+	BasicBlock* bb = nullptr;
+	Function* fn = CreateFunction(mod, name, &bb, { x }, linkage);
+
+	Value* value = x;
+
+	for (size_t i = 0; i < n; ++i) {
+		VirtualRegisterName* next = Reg();
+		bb->Append(Helix::CreateBinOp(HLIR::IAdd, value, Int32(1), next));
+
+		value = next;
+	}
+
+	bb->Append(Helix::CreateRet(value));
+	return fn;
+}
+
+/// Create a function that calls 'callee' with 'arg' & returns the result.
+static Function* CreateCaller(Module& mod, const std::string& name, Function* callee, Value* arg, RetInsn** ret)
+{
+	BasicBlock* bb = nullptr;
+	Function* fn = CreateFunction(mod, name, &bb, {});
+
+	VirtualRegisterName* result = Reg();
+
+	bb->Append(Helix::CreateCall(callee, result, { arg }));
+
+	*ret = Helix::CreateRet(result);
+	bb->Append(*ret);
+
+	return fn;
+}
+
+/******************************************************************************/
+
+TEST_CASE("Inliner (Small function)", "[Inliner]")
+{
+	Module mod("test.c");
+
+	Function* add = CreateAddFunction(mod, "add", 1);
+
+	RetInsn* ret = nullptr;
+	Function* main = CreateCaller(mod, "main", add, Int32(41), &ret);
+
+	RunInliner(mod);
+
+	REQUIRE(CountInstructions(main, HLIR::Call) == 0);
+	REQUIRE(main->GetCountBlocks() == 1);
+
+	// The body is copied with the argument in place of the parameter...
+	Instruction* def = IR::GetSingleDefinition(ret->GetReturnValue());
+
+	REQUIRE(def->GetOpcode() == HLIR::IAdd);
+	REQUIRE(def->GetParent() == main->GetHeadBlock());
+	REQUIRE(value_cast<ConstantInt>(def->GetOperand(0))->GetIntegralValue() == 41);
+
+	// ... and the callee is left as it was.
+	REQUIRE(CountInstructions(add, HLIR::IAdd) == 1);
+}
+
+/******************************************************************************/
+
+TEST_CASE("Inliner (Cost model & attributes)", "[Inliner]")
+{
+	Module mod("test.c");
+	RetInsn* ret = nullptr;
+
+	SECTION("Functions that are too big aren't inlined")
+	{
+		Function* big  = CreateAddFunction(mod, "big", 100);
+		Function* main = CreateCaller(mod, "main", big, Int32(1), &ret);
+
+		RunInliner(mod);
+
+		REQUIRE(CountInstructions(main, HLIR::Call) == 1);
+	}
+
+	SECTION("always_inline is inlined whatever the size")
+	{
+		Function* big  = CreateAddFunction(mod, "big", 100);
+		Function* main = CreateCaller(mod, "main", big, Int32(1), &ret);
+
+		big->SetInlineHint(InlineHint::AlwaysInline);
+
+		RunInliner(mod);
+
+		REQUIRE(CountInstructions(main, HLIR::Call) == 0);
+		REQUIRE(CountInstructions(main, HLIR::IAdd) == 100);
+	}
+
+	SECTION("noinline is never inlined")
+	{
+		Function* add  = CreateAddFunction(mod, "add", 1);
+		Function* main = CreateCaller(mod, "main", add, Int32(1), &ret);
+
+		add->SetInlineHint(InlineHint::NoInline);
+
+		RunInliner(mod);
+
+		REQUIRE(CountInstructions(main, HLIR::Call) == 1);
+	}
+
+	SECTION("The only call to an internal function is inlined whatever the size")
+	{
+		Function* big  = CreateAddFunction(mod, "big", 100, Linkage::Internal);
+		Function* main = CreateCaller(mod, "main", big, Int32(1), &ret);
+
+		RunInliner(mod);
+
+		REQUIRE(CountInstructions(main, HLIR::Call) == 0);
+	}
+
+	SECTION("Recursive functions aren't inlined")
+	{
+		VirtualRegisterName* x = Reg();
+		VirtualRegisterName* y = Reg();
+
+		BasicBlock* bb = nullptr;
+		Function* recursive = CreateFunction(mod, "recursive", &bb, { x });
+
+		bb->Append(Helix::CreateCall(recursive, y, { x }));
+		bb->Append(Helix::CreateRet(y));
+
+		Function* main = CreateCaller(mod, "main", recursive, Int32(1), &ret);
+
+		RunInliner(mod);
+
+		REQUIRE(CountInstructions(main, HLIR::Call) == 1);
+		REQUIRE(CountInstructions(recursive, HLIR::Call) == 1);
+	}
+}
+
+/******************************************************************************/
@@ -72,6 +72,19 @@ TEST_CASE("Operand flags", "[Instruction]")
 		REQUIRE(stack_alloc->GetOperandFlags(1024) == Instruction::OP_NONE);
 	}
 
+	SECTION("HLIR::LoadFieldAddress") {
+		const StructType* type = StructType::Create({ BuiltinTypes::GetInt32(), BuiltinTypes::GetInt32() });
+
+		VirtualRegisterName* base  = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+		VirtualRegisterName* field = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+
+		LoadFieldAddressInsn* lfa = Helix::CreateLoadFieldAddress(type, base, 1, field);
+
+		REQUIRE(lfa->GetOperandFlags(0) == Instruction::OP_READ);
+		REQUIRE(lfa->GetOperandFlags(1) == Instruction::OP_WRITE);
+		REQUIRE(lfa->GetOperandFlags(2) == Instruction::OP_NONE);
+	}
+
 	SECTION("HLIR::Cbr") {
 		ConditionalBranchInsn* cbr = Helix::CreateConditionalBranch(bb0, bb1, reg);
 
@@ -0,0 +1,116 @@
+/**
+ * @file test-ipcp.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../ipcp.h"
+#include "../module.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunIPCP(Module& mod)
+{
+	PassRunInformation info;
+
+	IPCP pass;
+	pass.Execute(&mod, info);
+}
+
+/******************************************************************************/
+
+TEST_CASE("IPCP (Constant & unused parameters)", "[IPCP]")
+{
+	Module mod("test.c");
+
+	// f(x, k, unused) = x * k, always called with k = 3
+	VirtualRegisterName* x      = Reg();
+	VirtualRegisterName* k      = Reg();
+	VirtualRegisterName* unused = Reg();
+	VirtualRegisterName* xk     = Reg();
+
+	BasicBlock* fBB = nullptr;
+	Function* f = CreateFunction(mod, "f", &fBB, { x, k, unused }, Linkage::Internal);
+
+	BinOpInsn* mul = Helix::CreateBinOp(HLIR::IMul, x, k, xk);
+
+	fBB->Append(mul);
+	fBB->Append(Helix::CreateRet(xk));
+
+	VirtualRegisterName* arg = Reg();
+	VirtualRegisterName* a   = Reg();
+	VirtualRegisterName* b   = Reg();
+
+	BasicBlock* mainBB = nullptr;
+	CreateFunction(mod, "main", &mainBB, { arg });
+
+	CallInsn* first  = Helix::CreateCall(f, a, { arg, Int32(3), Int32(1) });
+	CallInsn* second = Helix::CreateCall(f, b, { Int32(10), Int32(3), Int32(2) });
+
+	mainBB->Append(first);
+	mainBB->Append(second);
+	mainBB->Append(Helix::CreateRet(a));
+
+	RunIPCP(mod);
+
+	// Only 'x' is left, & 'k' is replaced with the constant.
+	REQUIRE(f->GetCountParameters() == 1);
+	REQUIRE(f->GetParameter(0) == x);
+	REQUIRE(type_cast<FunctionType>(f->GetType())->GetParameters().size() == 1);
+
+	REQUIRE(mul->GetLHS() == x);
+	REQUIRE(value_cast<ConstantInt>(mul->GetRHS())->GetIntegralValue() == 3);
+
+	REQUIRE(first->GetCountArguments() == 1);
+	REQUIRE(first->GetOperand(first->GetStartingArgumentIndex()) == arg);
+
+	REQUIRE(second->GetCountArguments() == 1);
+	REQUIRE(value_cast<ConstantInt>(second->GetOperand(second->GetStartingArgumentIndex()))->GetIntegralValue() == 10);
+}
+
+/******************************************************************************/
+
+TEST_CASE("IPCP (Nothing to propagate)", "[IPCP]")
+{
+	Module mod("test.c");
+
+	VirtualRegisterName* x  = Reg();
+	VirtualRegisterName* x1 = Reg();
+
+	// An internal function called with different constants, or an external
+	// function (that could be called from anywhere) with the same one.
+	const bool internal = GENERATE(true, false);
+
+	BasicBlock* fBB = nullptr;
+	Function* f = CreateFunction(mod, "f", &fBB, { x }, internal ? Linkage::Internal : Linkage::External);
+
+	BinOpInsn* add = Helix::CreateBinOp(HLIR::IAdd, x, Int32(1), x1);
+
+	fBB->Append(add);
+	fBB->Append(Helix::CreateRet(x1));
+
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+
+	BasicBlock* mainBB = nullptr;
+	CreateFunction(mod, "main", &mainBB, {});
+
+	mainBB->Append(Helix::CreateCall(f, a, { Int32(1) }));
+	mainBB->Append(Helix::CreateCall(f, b, { Int32(internal ? 2 : 1) }));
+	mainBB->Append(Helix::CreateRet(a));
+
+	RunIPCP(mod);
+
+	REQUIRE(f->GetCountParameters() == 1);
+	REQUIRE(add->GetLHS() == x);
+	REQUIRE(type_cast<FunctionType>(f->GetType())->GetParameters().size() == 1);
+}
+
+/******************************************************************************/
@@ -5,6 +5,7 @@
 
  /* Helix Core Includes */
 #include "..\ir-helpers.h"
+#include "..\function.h"
 
 /* Testing Library Includes */
 #include "catch.hpp"
@@ -242,3 +243,109 @@ TEST_CASE("IR::ReplaceInstructionAndDestroyOriginal (Seq Size = 0, BB Size = n)"
 
 /******************************************************************************/
 
+TEST_CASE("IR::RetargetBranch", "[IRHelpers]")
+{
+	BasicBlock* a = BasicBlock::Create();
+	BasicBlock* b = BasicBlock::Create();
+	BasicBlock* c = BasicBlock::Create();
+
+	VirtualRegisterName* cond = VirtualRegisterName::Create(BuiltinTypes::GetInt32());
+	ConditionalBranchInsn* cbr = Helix::CreateConditionalBranch(a, b, cond);
+
+	IR::RetargetBranch(cbr, b, c);
+
+	REQUIRE(cbr->GetTrueBB() == a);
+	REQUIRE(cbr->GetFalseBB() == c);
+
+	IR::RetargetBranch(cbr, a, c);
+
+	REQUIRE(cbr->GetTrueBB() == c);
+	REQUIRE(cbr->GetFalseBB() == c);
+}
+
+/******************************************************************************/
+
+TEST_CASE("IR::IsSameValue", "[IRHelpers]")
+{
+	ConstantInt* a = ConstantInt::Create(BuiltinTypes::GetInt32(), 5);
+	ConstantInt* b = ConstantInt::Create(BuiltinTypes::GetInt32(), 5);
+	ConstantInt* c = ConstantInt::Create(BuiltinTypes::GetInt32(), 6);
+	ConstantInt* d = ConstantInt::Create(BuiltinTypes::GetInt8(), 5);
+
+	VirtualRegisterName* reg = VirtualRegisterName::Create(BuiltinTypes::GetInt32());
+
+	REQUIRE(IR::IsSameValue(a, b));
+	REQUIRE(IR::IsSameValue(reg, reg));
+	REQUIRE_FALSE(IR::IsSameValue(a, c));
+	REQUIRE_FALSE(IR::IsSameValue(a, d));
+	REQUIRE_FALSE(IR::IsSameValue(a, reg));
+}
+
+/******************************************************************************/
+
+TEST_CASE("IR::CloneBlocks", "[IRHelpers]")
+{
+	VirtualRegisterName* param = VirtualRegisterName::Create(BuiltinTypes::GetInt32());
+
+	Function* fn = Function::Create(
+		FunctionType::Create(BuiltinTypes::GetVoidType(), { BuiltinTypes::GetInt32() }),
+		"test",
+		{ param }
+	);
+
+	BasicBlock* entry = BasicBlock::Create();
+	BasicBlock* loop  = BasicBlock::Create();
+	BasicBlock* exit  = BasicBlock::Create();
+
+	fn->Append(entry);
+	fn->Append(loop);
+	fn->Append(exit);
+
+	// loop: i = phi [0, entry], [next, loop]; next = iadd i, param; cbr next, loop, exit
+	VirtualRegisterName* i    = VirtualRegisterName::Create(BuiltinTypes::GetInt32());
+	VirtualRegisterName* next = VirtualRegisterName::Create(BuiltinTypes::GetInt32());
+
+	PhiInsn* phi = Helix::CreatePhi(i);
+	phi->AddIncoming(ConstantInt::Create(BuiltinTypes::GetInt32(), 0), entry);
+	phi->AddIncoming(next, loop);
+
+	entry->Append(Helix::CreateUnconditionalBranch(loop));
+
+	loop->Append(phi);
+	loop->Append(Helix::CreateBinOp(HLIR::IAdd, i, param, next));
+	loop->Append(Helix::CreateConditionalBranch(loop, exit, next));
+
+	exit->Append(Helix::CreateRet());
+
+	VirtualRegisterName* argument = VirtualRegisterName::Create(BuiltinTypes::GetInt32());
+
+	IR::ValueMap map;
+	map[param] = argument;
+
+	const std::vector<BasicBlock*> clones = IR::CloneBlocks({ loop }, map, fn, loop);
+
+	REQUIRE(clones.size() == 1);
+	REQUIRE(fn->GetCountBlocks() == 4);
+
+	BasicBlock* clone = clones[0];
+
+	REQUIRE(map.at(loop->GetBranchTarget()) == clone->GetBranchTarget());
+	REQUIRE(map.at(i) != i);
+	REQUIRE(map.at(next) != next);
+
+	PhiInsn* clonedPhi = static_cast<PhiInsn*>(&*clone->begin());
+	REQUIRE(clonedPhi->GetResult() == map.at(i));
+	REQUIRE(clonedPhi->GetIncomingValueForBlock(clone) == map.at(next));
+	REQUIRE(clonedPhi->GetIncomingIndex(entry) != SIZE_MAX);
+
+	BinOpInsn* add = static_cast<BinOpInsn*>(clonedPhi->get_next());
+	REQUIRE(add->GetOperand(0) == map.at(i));
+	REQUIRE(add->GetOperand(1) == argument);
+	REQUIRE(add->GetOperand(2) == map.at(next));
+
+	ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(clone->GetLast());
+	REQUIRE(cbr->GetTrueBB() == clone);
+	REQUIRE(cbr->GetFalseBB() == exit);
+}
+
+/******************************************************************************/
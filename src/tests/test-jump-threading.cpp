@@ -0,0 +1,189 @@
+/**
+ * @file test-jump-threading.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../jump-threading.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunJumpThreading(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	JumpThreading pass;
+	pass.Execute(fn, info);
+}
+
+/******************************************************************************/
+
+TEST_CASE("JumpThreading (Flag set on each path)", "[JumpThreading]")
+{
+	VirtualRegisterName* x = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 7, { x });
+
+	// entry: c = icmp_lt x, 0; cbr c, set, clear
+	// set:   br test
+	// clear: br test
+	// test:  f = phi [1, set], [0, clear]; cbr f, yes, no
+	// yes:   br exit
+	// no:    br exit
+	// exit:  r = phi [10, yes], [20, no]; ret r
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* f = Reg();
+	VirtualRegisterName* r = Reg();
+
+	bbs[0]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, x, Int32(0), c));
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	PhiInsn* flag = Helix::CreatePhi(f);
+	flag->AddIncoming(Int32(1), bbs[1]);
+	flag->AddIncoming(Int32(0), bbs[2]);
+
+	bbs[3]->Append(flag);
+	bbs[3]->Append(Helix::CreateConditionalBranch(bbs[4], bbs[5], f));
+
+	bbs[4]->Append(Helix::CreateUnconditionalBranch(bbs[6]));
+	bbs[5]->Append(Helix::CreateUnconditionalBranch(bbs[6]));
+
+	PhiInsn* result = Helix::CreatePhi(r);
+	result->AddIncoming(Int32(10), bbs[4]);
+	result->AddIncoming(Int32(20), bbs[5]);
+
+	bbs[6]->Append(result);
+	bbs[6]->Append(Helix::CreateRet(r));
+
+	RunJumpThreading(fn);
+
+	// Both ways into the test were threaded, so it's gone.
+	REQUIRE(CountInstructions(fn, HLIR::ConditionalBranch) == 1);
+	REQUIRE(CountInstructions(fn, HLIR::Phi) == 1);
+
+	REQUIRE(bbs[1]->GetSuccessors()[0]->GetSuccessors()[0] == bbs[4]);
+	REQUIRE(bbs[2]->GetSuccessors()[0]->GetSuccessors()[0] == bbs[5]);
+
+	REQUIRE(fn->GetTailBlock() == bbs[6]);
+}
+
+/******************************************************************************/
+
+TEST_CASE("JumpThreading (Condition tested again after a join)", "[JumpThreading]")
+{
+	VirtualRegisterName* x = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 5, { x });
+
+	// entry: c = icmp_lt x, 0; cbr c, neg, join
+	// neg:   a = isub 0, x; br join
+	// join:  y = phi [a, neg], [x, entry]; t = iadd y, 1; d = icmp_gte x, 0; cbr d, exit, big
+	// big:   w = imul t, 2; br exit
+	// exit:  r = phi [t, join], [w, big]; ret r
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* y = Reg();
+	VirtualRegisterName* t = Reg();
+	VirtualRegisterName* d = Reg();
+	VirtualRegisterName* w = Reg();
+	VirtualRegisterName* r = Reg();
+
+	bbs[0]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, x, Int32(0), c));
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::ISub, Int32(0), x, a));
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[2]));
+
+	PhiInsn* phi = Helix::CreatePhi(y);
+	phi->AddIncoming(a, bbs[1]);
+	phi->AddIncoming(x, bbs[0]);
+
+	bbs[2]->Append(phi);
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, y, Int32(1), t));
+	bbs[2]->Append(Helix::CreateCompare(HLIR::ICmp_Gte, x, Int32(0), d));
+	bbs[2]->Append(Helix::CreateConditionalBranch(bbs[4], bbs[3], d));
+
+	bbs[3]->Append(Helix::CreateBinOp(HLIR::IMul, t, Int32(2), w));
+	bbs[3]->Append(Helix::CreateUnconditionalBranch(bbs[4]));
+
+	PhiInsn* result = Helix::CreatePhi(r);
+	result->AddIncoming(t, bbs[2]);
+	result->AddIncoming(w, bbs[3]);
+
+	bbs[4]->Append(result);
+	bbs[4]->Append(Helix::CreateRet(r));
+
+	RunJumpThreading(fn);
+
+	// Coming straight from the entry 'x >= 0' is already known, so that way
+	// goes to its own copy of 'join', which goes straight to the exit.
+	ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(bbs[0]->GetLast());
+	BasicBlock* copy = cbr->GetFalseBB();
+
+	REQUIRE(cbr->GetTrueBB() == bbs[1]);
+	REQUIRE(copy != bbs[2]);
+	REQUIRE(copy->GetSuccessors().size() == 1);
+	REQUIRE(copy->GetSuccessors()[0] == bbs[4]);
+
+	// ... & the original is only reached from 'neg'.
+	REQUIRE(IR::GetPredecessors(bbs[2]) == std::vector<BasicBlock*> { bbs[1] });
+
+	REQUIRE(result->GetCountIncoming() == 3);
+	REQUIRE(result->GetIncomingValueForBlock(copy) != t);
+
+	// The value used by 'big' went through a stack slot, which is gone again.
+	REQUIRE(CountInstructions(fn, HLIR::StackAlloc) == 0);
+	REQUIRE(CountInstructions(fn, HLIR::Load) == 0);
+	REQUIRE(CountInstructions(fn, HLIR::Store) == 0);
+}
+
+/******************************************************************************/
+
+TEST_CASE("JumpThreading (Branch on a value that isn't a compare)", "[JumpThreading]")
+{
+	VirtualRegisterName* flag = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 5, { flag });
+
+	// entry: cbr flag, join, other
+	// other: br join
+	// join:  e = icmp_eq flag, 5; cbr e, yes, no
+	// yes:   ret 100
+	// no:    ret 200
+	VirtualRegisterName* e = Reg();
+
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[1], flag));
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[2]));
+
+	bbs[2]->Append(Helix::CreateCompare(HLIR::ICmp_Eq, flag, Int32(5), e));
+	bbs[2]->Append(Helix::CreateConditionalBranch(bbs[3], bbs[4], e));
+
+	bbs[3]->Append(Helix::CreateRet(Int32(100)));
+	bbs[4]->Append(Helix::CreateRet(Int32(200)));
+
+	RunJumpThreading(fn);
+
+	// Coming straight from the entry only says that 'flag' isn't zero (it could still
+	// be five), so that way still has to do the compare.
+	REQUIRE(static_cast<ConditionalBranchInsn*>(bbs[0]->GetLast())->GetTrueBB() == bbs[2]);
+	REQUIRE(static_cast<ConditionalBranchInsn*>(bbs[2]->GetLast())->GetCond() == e);
+}
+
+/******************************************************************************/
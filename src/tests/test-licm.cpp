@@ -0,0 +1,185 @@
+/**
+ * @file test-licm.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../licm.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunLICM(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	LICM pass;
+	pass.Execute(fn, info);
+}
+
+/// Build a loop counting from 0 to 'n', returns the blocks
+///   entry:  br header
+///   header: i = phi [0, entry], [i2, body]; c = icmp_lt i, n; cbr c, body, exit
+///   body:   ... i2 = iadd i, 1; br header
+///   exit:   ...
+static Function* CreateLoop(std::vector<BasicBlock*>& bbs, VirtualRegisterName* n, VirtualRegisterName* k,
+                            VirtualRegisterName** i)
+{
+	Function* fn = CreateFunction(bbs, 4, { n, k });
+
+	*i = Reg();
+
+	VirtualRegisterName* i2 = Reg();
+	VirtualRegisterName* c = Reg();
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	PhiInsn* phi = Helix::CreatePhi(*i);
+	phi->AddIncoming(Int32(0), bbs[0]);
+	phi->AddIncoming(i2, bbs[2]);
+
+	bbs[1]->Append(phi);
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, *i, n, c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, *i, Int32(1), i2));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	return fn;
+}
+
+/******************************************************************************/
+
+TEST_CASE("LICM (Hoisting invariant computations)", "[LICM]")
+{
+	VirtualRegisterName* n = Reg();
+	VirtualRegisterName* k = Reg();
+	VirtualRegisterName* i = nullptr;
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateLoop(bbs, n, k, &i);
+
+	// header: ... f = imul i, 2 ...
+	// body:   a = imul k, 3; b = iadd a, 1; d = iadd b, i; e = isdiv n, k; ...
+	// exit:   r = iadd f, k; ret r
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* d = Reg();
+	VirtualRegisterName* e = Reg();
+	VirtualRegisterName* f = Reg();
+
+	BinOpInsn* invariant0 = Helix::CreateBinOp(HLIR::IMul, k, Int32(3), a);
+	BinOpInsn* invariant1 = Helix::CreateBinOp(HLIR::IAdd, a, Int32(1), b);
+	BinOpInsn* variant    = Helix::CreateBinOp(HLIR::IAdd, b, i, d);
+	BinOpInsn* division   = Helix::CreateBinOp(HLIR::ISDiv, n, k, e);
+	BinOpInsn* exitOnly   = Helix::CreateBinOp(HLIR::IMul, i, Int32(2), f);
+
+	Instruction* first = &*bbs[2]->begin();
+
+	IR::InsertBefore(first, invariant0);
+	IR::InsertBefore(first, invariant1);
+	IR::InsertBefore(first, variant);
+	IR::InsertBefore(first, division);
+
+	IR::InsertBefore(bbs[1]->GetLast(), exitOnly);
+
+	VirtualRegisterName* r = Reg();
+
+	bbs[3]->Append(Helix::CreateBinOp(HLIR::IAdd, f, k, r));
+	bbs[3]->Append(Helix::CreateRet(r));
+
+	RunLICM(fn);
+
+	SECTION("Chains of invariant instructions are hoisted into the preheader")
+	{
+		REQUIRE(invariant0->GetParent() == bbs[0]);
+		REQUIRE(invariant1->GetParent() == bbs[0]);
+		REQUIRE(bbs[0]->GetLast()->GetOpcode() == HLIR::UnconditionalBranch);
+	}
+
+	SECTION("Anything that changes each iteration stays in the loop")
+	{
+		REQUIRE(variant->GetParent() == bbs[2]);
+	}
+
+	SECTION("Instructions that could trap aren't hoisted")
+	{
+		REQUIRE(division->GetParent() == bbs[2]);
+	}
+
+	SECTION("Instructions only used after the loop are sunk out of it")
+	{
+		REQUIRE(exitOnly->GetParent() == bbs[3]);
+		REQUIRE(&*bbs[3]->begin() == exitOnly);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("LICM (Promoting globals to registers)", "[LICM]")
+{
+	VirtualRegisterName* n = Reg();
+	VirtualRegisterName* k = Reg();
+	VirtualRegisterName* i = nullptr;
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateLoop(bbs, n, k, &i);
+
+	GlobalVariable* counter = GlobalVariable::Create("counter", BuiltinTypes::GetInt32(), Int32(0));
+	GlobalVariable* limit   = GlobalVariable::Create("limit", BuiltinTypes::GetInt32(), Int32(0));
+
+	// body: a = load counter; l = load limit; b = iadd a, l; store b, counter
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* l = Reg();
+	VirtualRegisterName* b = Reg();
+
+	LoadInsn* loadLimit = Helix::CreateLoad(limit, l);
+
+	Instruction* first = &*bbs[2]->begin();
+
+	IR::InsertBefore(first, Helix::CreateLoad(counter, a));
+	IR::InsertBefore(first, loadLimit);
+	IR::InsertBefore(first, Helix::CreateBinOp(HLIR::IAdd, a, l, b));
+	IR::InsertBefore(first, Helix::CreateStore(b, counter));
+
+	bbs[3]->Append(Helix::CreateRet(Int32(0)));
+
+	RunLICM(fn);
+
+	auto countAccesses = [](BasicBlock* bb, HLIR::Opcode opcode) {
+		size_t count = 0;
+
+		for (Instruction& insn : *bb) {
+			if (insn.GetOpcode() == opcode)
+				count++;
+		}
+
+		return count;
+	};
+
+	// Loads of globals that aren't written in the loop are hoisted.
+	REQUIRE(loadLimit->GetParent() == bbs[0]);
+
+	// The counter is loaded once before the loop & stored once after it.
+	REQUIRE(countAccesses(bbs[0], HLIR::Load) == 2);
+	REQUIRE(countAccesses(bbs[1], HLIR::Load) == 0);
+	REQUIRE(countAccesses(bbs[2], HLIR::Load) == 0);
+	REQUIRE(countAccesses(bbs[2], HLIR::Store) == 0);
+	REQUIRE(countAccesses(bbs[3], HLIR::Store) == 1);
+
+	// ... and held in a register (a phi in the header) in between.
+	REQUIRE(bbs[1]->GetCountInstructions() == 4);
+	REQUIRE(countAccesses(fn->GetHeadBlock(), HLIR::StackAlloc) == 0);
+}
+
+/******************************************************************************/
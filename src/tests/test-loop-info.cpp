@@ -0,0 +1,365 @@
+/**
+ * @file test-loop-info.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../loop-info.h"
+#include "../dominators.h"
+#include "../function.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+TEST_CASE("LoopInfo (No Loops)", "[LoopInfo]")
+{
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 2);
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+	bbs[1]->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+	REQUIRE(loops.IsEmpty());
+	REQUIRE(loops.GetLoopFor(bbs[0]) == nullptr);
+	REQUIRE(loops.GetLoopDepth(bbs[1]) == 0);
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopInfo (Counted For Loop, Registers)", "[LoopInfo]")
+{
+	// entry: set i, 0; br cond
+	// cond:  c = icmp_lt i, 10; cbr c, body, tail
+	// body:  n = iadd i, 1; set i, n; br cond
+	// tail:  ret
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4);
+
+	VirtualRegisterName* i = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* n = Reg();
+
+	bbs[0]->Append(Helix::CreateSetInsn(i, Int32(0)));
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i, Int32(10), c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), n));
+	bbs[2]->Append(Helix::CreateSetInsn(i, n));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[3]->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+	REQUIRE(loops.GetTopLevelLoops().size() == 1);
+
+	Loop* loop = loops.GetTopLevelLoops()[0];
+
+	REQUIRE(loop->GetHeader() == bbs[1]);
+	REQUIRE(loop->GetBlocks().size() == 2);
+	REQUIRE(loop->GetBlocks()[0] == bbs[1]);
+	REQUIRE(loop->Contains(bbs[2]));
+	REQUIRE_FALSE(loop->Contains(bbs[3]));
+	REQUIRE(loop->GetDepth() == 1);
+	REQUIRE(loop->GetPreheader() == bbs[0]);
+	REQUIRE(loop->GetLatch() == bbs[2]);
+	REQUIRE(loop->GetExitBlock() == bbs[3]);
+	REQUIRE(loop->GetExitingBlocks().size() == 1);
+	REQUIRE(loop->GetExitingBlocks()[0] == bbs[1]);
+
+	REQUIRE(loops.IsLoopHeader(bbs[1]));
+	REQUIRE(loops.GetLoopFor(bbs[2]) == loop);
+	REQUIRE(loops.GetLoopDepth(bbs[2]) == 1);
+
+	REQUIRE(loop->IsLoopInvariant(Int32(10)));
+	REQUIRE_FALSE(loop->IsLoopInvariant(i));
+
+	REQUIRE(loop->IsCounted());
+	REQUIRE(loop->GetBounds().InductionVariable == i);
+	REQUIRE(loop->GetBounds().InitialValue == Int32(0));
+	REQUIRE(loop->GetBounds().Step == 1);
+	REQUIRE(loop->GetBounds().Predicate == HLIR::ICmp_Lt);
+	REQUIRE_FALSE(loop->GetBounds().TestsSteppedValue);
+
+	REQUIRE(loop->HasConstantTripCount());
+	REQUIRE(loop->GetConstantTripCount() == 10);
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopInfo (Counted For Loop, SSA)", "[LoopInfo]")
+{
+	// entry: br cond
+	// cond:  i = phi [0, entry], [n, body]; c = icmp_lt i, 10; cbr c, body, tail
+	// body:  n = iadd i, 2; br cond
+	// tail:  ret
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4);
+
+	VirtualRegisterName* i = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* n = Reg();
+
+	PhiInsn* phi = Helix::CreatePhi(i);
+	phi->AddIncoming(Int32(0), bbs[0]);
+	phi->AddIncoming(n, bbs[2]);
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(phi);
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i, Int32(10), c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(2), n));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[3]->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+	REQUIRE(loops.GetTopLevelLoops().size() == 1);
+
+	Loop* loop = loops.GetTopLevelLoops()[0];
+
+	// The phi doesn't make the header a predecessor of the latch.
+	REQUIRE(loop->GetLatch() == bbs[2]);
+	REQUIRE(loop->GetPreheader() == bbs[0]);
+
+	REQUIRE(loop->IsCounted());
+	REQUIRE(loop->GetBounds().InductionVariable == i);
+	REQUIRE(loop->GetBounds().InitialValue == Int32(0));
+	REQUIRE(loop->GetBounds().StepInstruction == &*bbs[2]->begin());
+	REQUIRE(loop->GetBounds().Step == 2);
+	REQUIRE_FALSE(loop->GetBounds().TestsSteppedValue);
+
+	REQUIRE(loop->HasConstantTripCount());
+	REQUIRE(loop->GetConstantTripCount() == 5);
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopInfo (Counted For Loop, Stack Slot)", "[LoopInfo]")
+{
+	// As the frontend generates it, before mem2reg:
+	//
+	// entry: p = stack_alloc i32; store 20, p; br cond
+	// cond:  t = load p; c = icmp_gt t, 5; cbr c, body, tail
+	// body:  t2 = load p; n = isub t2, 3; store n, p; br cond
+	// tail:  ret
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4);
+
+	VirtualRegisterName* p = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+	VirtualRegisterName* t = Reg();
+	VirtualRegisterName* t2 = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* n = Reg();
+
+	bbs[0]->Append(Helix::CreateStackAlloc(p, BuiltinTypes::GetInt32()));
+	bbs[0]->Append(Helix::CreateStore(Int32(20), p));
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(Helix::CreateLoad(p, t));
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Gt, t, Int32(5), c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	bbs[2]->Append(Helix::CreateLoad(p, t2));
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::ISub, t2, Int32(3), n));
+	bbs[2]->Append(Helix::CreateStore(n, p));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[3]->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+	REQUIRE(loops.GetTopLevelLoops().size() == 1);
+
+	Loop* loop = loops.GetTopLevelLoops()[0];
+
+	REQUIRE(loop->IsCounted());
+	REQUIRE(loop->GetBounds().InductionVariable == p);
+	REQUIRE(loop->GetBounds().Step == -3);
+
+	// 20, 17, 14, 11, 8 pass the test, 5 doesn't.
+	REQUIRE(loop->HasConstantTripCount());
+	REQUIRE(loop->GetConstantTripCount() == 5);
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopInfo (Do While Loop)", "[LoopInfo]")
+{
+	// entry: set i, 0; br body
+	// body:  n = iadd i, 1; set i, n; c = icmp_lt i, 10; cbr c, body, tail
+	// tail:  ret
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 3);
+
+	VirtualRegisterName* i = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* n = Reg();
+
+	bbs[0]->Append(Helix::CreateSetInsn(i, Int32(0)));
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), n));
+	bbs[1]->Append(Helix::CreateSetInsn(i, n));
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i, Int32(10), c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	bbs[2]->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+	REQUIRE(loops.GetTopLevelLoops().size() == 1);
+
+	Loop* loop = loops.GetTopLevelLoops()[0];
+
+	REQUIRE(loop->GetHeader() == bbs[1]);
+	REQUIRE(loop->GetLatch() == bbs[1]);
+	REQUIRE(loop->IsCounted());
+	REQUIRE(loop->GetBounds().TestsSteppedValue);
+
+	// The test sees 1..9 pass (so the body runs 10 times).
+	REQUIRE(loop->HasConstantTripCount());
+	REQUIRE(loop->GetConstantTripCount() == 9);
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopInfo (Nested Loops)", "[LoopInfo]")
+{
+	// 0 -> 1 (outer header) -> 2 (inner header) -> 3 (inner latch) -> 2
+	//                          2 -> 4 (outer latch) -> 1
+	//      1 -> 5 (exit)
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 6);
+
+	VirtualRegisterName* c = Reg();
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[5], c));
+	bbs[2]->Append(Helix::CreateConditionalBranch(bbs[3], bbs[4], c));
+	bbs[3]->Append(Helix::CreateUnconditionalBranch(bbs[2]));
+	bbs[4]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+	bbs[5]->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+	REQUIRE(loops.GetTopLevelLoops().size() == 1);
+
+	Loop* outer = loops.GetTopLevelLoops()[0];
+	Loop* inner = loops.GetLoopFor(bbs[3]);
+
+	REQUIRE(outer->GetHeader() == bbs[1]);
+	REQUIRE(inner->GetHeader() == bbs[2]);
+
+	REQUIRE(inner->GetParentLoop() == outer);
+	REQUIRE(outer->GetSubLoops().size() == 1);
+	REQUIRE(outer->GetSubLoops()[0] == inner);
+	REQUIRE(outer->Contains(inner));
+	REQUIRE_FALSE(inner->Contains(outer));
+
+	REQUIRE(outer->GetDepth() == 1);
+	REQUIRE(inner->GetDepth() == 2);
+	REQUIRE(loops.GetLoopDepth(bbs[3]) == 2);
+	REQUIRE(loops.GetLoopDepth(bbs[4]) == 1);
+
+	REQUIRE(outer->GetBlocks().size() == 4);
+	REQUIRE(inner->GetBlocks().size() == 2);
+	REQUIRE(outer->Contains(bbs[3]));
+
+	REQUIRE(inner->GetPreheader() == nullptr);
+	REQUIRE(outer->GetPreheader() == bbs[0]);
+	REQUIRE(inner->GetExitBlock() == bbs[4]);
+
+	REQUIRE(loops.GetLoopsInnermostFirst().size() == 2);
+	REQUIRE(loops.GetLoopsInnermostFirst()[0] == inner);
+	REQUIRE(loops.GetLoopsInnermostFirst()[1] == outer);
+
+	REQUIRE_FALSE(outer->IsCounted());
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopInfo (Bound Not Invariant)", "[LoopInfo]")
+{
+	// entry: set i, 0; set b, 10; br cond
+	// cond:  c = icmp_lt i, b; cbr c, body, tail
+	// body:  n = iadd i, 1; set i, n; set b, n; br cond
+	// tail:  ret
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4);
+
+	VirtualRegisterName* i = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* n = Reg();
+
+	bbs[0]->Append(Helix::CreateSetInsn(i, Int32(0)));
+	bbs[0]->Append(Helix::CreateSetInsn(b, Int32(10)));
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i, b, c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), n));
+	bbs[2]->Append(Helix::CreateSetInsn(i, n));
+	bbs[2]->Append(Helix::CreateSetInsn(b, n));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[3]->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+	REQUIRE(loops.GetTopLevelLoops().size() == 1);
+	REQUIRE_FALSE(loops.GetTopLevelLoops()[0]->IsCounted());
+	REQUIRE_FALSE(loops.GetTopLevelLoops()[0]->HasConstantTripCount());
+}
+
+/******************************************************************************/
+
+TEST_CASE("AnalysisManager caches & invalidates results", "[LoopInfo]")
+{
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 1);
+
+	bbs[0]->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+
+	REQUIRE_FALSE(am.IsCached<LoopInfo>(fn));
+
+	LoopInfo* first = &am.Get<LoopInfo>(fn);
+
+	REQUIRE(am.IsCached<LoopInfo>(fn));
+	REQUIRE(am.IsCached<DominatorTree>(fn));
+	REQUIRE(&am.Get<LoopInfo>(fn) == first);
+
+	am.Invalidate<LoopInfo>(fn);
+
+	REQUIRE_FALSE(am.IsCached<LoopInfo>(fn));
+	REQUIRE(am.IsCached<DominatorTree>(fn));
+
+	am.Invalidate(fn);
+
+	REQUIRE_FALSE(am.IsCached<DominatorTree>(fn));
+}
+
+/******************************************************************************/
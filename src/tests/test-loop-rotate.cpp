@@ -0,0 +1,192 @@
+/**
+ * @file test-loop-rotate.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../loop-rotate.h"
+#include "../loop-info.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunLoopRotate(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	LoopRotate pass;
+	pass.Execute(fn, info);
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopRotate (Top tested for loop)", "[LoopRotate]")
+{
+	VirtualRegisterName* n = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { n });
+
+	// entry:  br header
+	// header: i = phi [0, entry], [i2, body]; c = icmp_lt i, n; cbr c, body, exit
+	// body:   i2 = iadd i, 1; br header
+	// exit:   ret i
+	VirtualRegisterName* i  = Reg();
+	VirtualRegisterName* c  = Reg();
+	VirtualRegisterName* i2 = Reg();
+
+	PhiInsn* phi = Helix::CreatePhi(i);
+	phi->AddIncoming(Int32(0), bbs[0]);
+	phi->AddIncoming(i2, bbs[2]);
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(phi);
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i, n, c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), i2));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	RetInsn* ret = Helix::CreateRet(i);
+	bbs[3]->Append(ret);
+
+	RunLoopRotate(fn);
+
+	AnalysisManager am;
+	LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+	REQUIRE(loops.GetTopLevelLoops().size() == 1);
+
+	Loop* loop = loops.GetTopLevelLoops()[0];
+
+	SECTION("The body is the new header, and the test is at the bottom")
+	{
+		REQUIRE(loop->GetHeader() == bbs[2]);
+		REQUIRE(loop->GetCountBlocks() == 1);
+		REQUIRE(loop->GetLatch() == bbs[2]);
+		REQUIRE(bbs[2]->GetLast()->GetOpcode() == HLIR::ConditionalBranch);
+
+		REQUIRE(loop->IsCounted());
+		REQUIRE(loop->GetBounds().TestsSteppedValue);
+	}
+
+	SECTION("The loop is guarded by a copy of the test")
+	{
+		REQUIRE(bbs[0]->GetLast()->GetOpcode() == HLIR::ConditionalBranch);
+		REQUIRE(bbs[0]->GetSuccessors()[1] == bbs[3]);
+
+		// ... which goes to a new preheader.
+		BasicBlock* preheader = loop->GetPreheader();
+
+		REQUIRE(preheader);
+		REQUIRE(bbs[0]->GetSuccessors()[0] == preheader);
+	}
+
+	SECTION("The value after the loop comes from either the guard or the latch")
+	{
+		Instruction* def = IR::GetSingleDefinition(ret->GetReturnValue());
+
+		REQUIRE(def->GetOpcode() == HLIR::Phi);
+		REQUIRE(def->GetParent() == bbs[3]);
+		REQUIRE(static_cast<PhiInsn*>(def)->GetCountIncoming() == 2);
+
+		// The initial value (set by Mem2Reg in the guard).
+		Value* initial = static_cast<PhiInsn*>(def)->GetIncomingValueForBlock(bbs[0]);
+
+		REQUIRE(initial);
+		REQUIRE(IR::GetSingleDefinition(initial)->GetParent() == bbs[0]);
+	}
+
+	SECTION("The latch leaves the loop through a block of its own")
+	{
+		REQUIRE(loop->GetExitBlocks().size() == 1);
+
+		BasicBlock* exit = loop->GetExitBlock();
+
+		REQUIRE(exit != bbs[3]);
+		REQUIRE(IR::GetPredecessors(exit).size() == 1);
+		REQUIRE(exit->GetSuccessors()[0] == bbs[3]);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopRotate (While loop with a continue)", "[LoopRotate]")
+{
+	VirtualRegisterName* n = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 6, { n });
+
+	// entry:  br header
+	// header: i = phi [0, entry], [a, odd], [b, even]; c = icmp_lt i, n; cbr c, body, exit
+	// body:   t = and i, 1; cbr t, odd, even
+	// odd:    a = iadd i, 1; br header        (continue)
+	// even:   b = iadd i, 3; br header
+	// exit:   ret i
+	VirtualRegisterName* i = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* t = Reg();
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+
+	PhiInsn* phi = Helix::CreatePhi(i);
+	phi->AddIncoming(Int32(0), bbs[0]);
+	phi->AddIncoming(a, bbs[3]);
+	phi->AddIncoming(b, bbs[4]);
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(phi);
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i, n, c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[5], c));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::And, i, Int32(1), t));
+	bbs[2]->Append(Helix::CreateConditionalBranch(bbs[3], bbs[4], t));
+
+	bbs[3]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), a));
+	bbs[3]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[4]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(3), b));
+	bbs[4]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	RetInsn* ret = Helix::CreateRet(i);
+	bbs[5]->Append(ret);
+
+	RunLoopRotate(fn);
+
+	AnalysisManager am;
+	LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+	REQUIRE(loops.GetTopLevelLoops().size() == 1);
+
+	Loop* loop = loops.GetTopLevelLoops()[0];
+
+	// Both latches test the condition themselves.
+	REQUIRE(loop->GetHeader() == bbs[2]);
+	REQUIRE(loop->GetLatches().size() == 2);
+	REQUIRE(bbs[3]->GetLast()->GetOpcode() == HLIR::ConditionalBranch);
+	REQUIRE(bbs[4]->GetLast()->GetOpcode() == HLIR::ConditionalBranch);
+	REQUIRE(loop->GetExitBlocks().size() == 2);
+
+	REQUIRE(bbs[2]->begin()->GetOpcode() == HLIR::Phi);
+	REQUIRE(static_cast<PhiInsn*>(&*bbs[2]->begin())->GetCountIncoming() == 3);
+
+	PhiInsn* result = static_cast<PhiInsn*>(IR::GetSingleDefinition(ret->GetReturnValue()));
+
+	REQUIRE(result->GetOpcode() == HLIR::Phi);
+	REQUIRE(result->GetCountIncoming() == 3);
+}
+
+/******************************************************************************/
@@ -0,0 +1,145 @@
+/**
+ * @file test-loop-strength-reduce.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../loop-strength-reduce.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunLoopStrengthReduce(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	LoopStrengthReduce pass;
+	pass.Execute(fn, info);
+}
+
+/// Build a loop summing 'a[i]' for 'i' from 0 up to 'bound', where 'base' is the
+/// address of 'a' (as lowering 'lea' would). Returns the 'inttoptr' of the address.
+static CastInsn* BuildArraySumLoop(std::vector<BasicBlock*>& bbs, Value* base, Value* bound)
+{
+	// entry:  br header
+	// header: i = phi [0, entry], [i2, body]; s = phi [0, entry], [s2, body]
+	//         c = icmp_lt i, bound; cbr c, body, exit
+	// body:   off = imul i, 4; addr = iadd base, off; p = inttoptr addr; v = load p
+	//         s2 = iadd s, v; i2 = iadd i, 1; br header
+	// exit:   ret s
+	VirtualRegisterName* i    = Reg();
+	VirtualRegisterName* s    = Reg();
+	VirtualRegisterName* c    = Reg();
+	VirtualRegisterName* off  = Reg();
+	VirtualRegisterName* addr = Reg();
+	VirtualRegisterName* v    = Reg();
+	VirtualRegisterName* s2   = Reg();
+	VirtualRegisterName* i2   = Reg();
+	VirtualRegisterName* p    = VirtualRegisterName::Create(BuiltinTypes::GetPointer());
+
+	PhiInsn* iPhi = Helix::CreatePhi(i);
+	iPhi->AddIncoming(Int32(0), bbs[0]);
+	iPhi->AddIncoming(i2, bbs[2]);
+
+	PhiInsn* sPhi = Helix::CreatePhi(s);
+	sPhi->AddIncoming(Int32(0), bbs[0]);
+	sPhi->AddIncoming(s2, bbs[2]);
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(iPhi);
+	bbs[1]->Append(sPhi);
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i, bound, c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	CastInsn* cast = Helix::CreateIntToPtr(addr, p);
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IMul, i, Int32(4), off));
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, base, off, addr));
+	bbs[2]->Append(cast);
+	bbs[2]->Append(Helix::CreateLoad(p, v));
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, s, v, s2));
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), i2));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[3]->Append(Helix::CreateRet(s));
+
+	return cast;
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopStrengthReduce (Array indexing with a constant trip count)", "[LoopStrengthReduce]")
+{
+	VirtualRegisterName* base = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { base });
+
+	CastInsn* cast = BuildArraySumLoop(bbs, base, Int32(50));
+
+	RunLoopStrengthReduce(fn);
+
+	SECTION("The address is stepped instead of computed from the index")
+	{
+		REQUIRE(CountInstructions(bbs[2], HLIR::IMul) == 0);
+
+		Instruction* def = IR::GetSingleDefinition(cast->GetSrc());
+
+		REQUIRE(def->GetOpcode() == HLIR::Phi);
+		REQUIRE(def->GetParent() == bbs[1]);
+
+		PhiInsn* phi = static_cast<PhiInsn*>(def);
+
+		REQUIRE(phi->GetIncomingValueForBlock(bbs[0]) == base);
+	}
+
+	SECTION("The exit test uses the address, and the index is removed")
+	{
+		REQUIRE(CountInstructions(bbs[1], HLIR::Phi) == 2);
+		REQUIRE(CountInstructions(bbs[1], HLIR::ICmp_Lt) == 0);
+		REQUIRE(CountInstructions(bbs[1], HLIR::ICmp_Neq) == 1);
+
+		// s2 = iadd s, v & the address increment.
+		REQUIRE(CountInstructions(bbs[2], HLIR::IAdd) == 2);
+
+		// The limit is 'base + 50 * 4', computed before the loop.
+		REQUIRE(CountInstructions(bbs[0], HLIR::IAdd) == 1);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopStrengthReduce (Array indexing with an unknown trip count)", "[LoopStrengthReduce]")
+{
+	VirtualRegisterName* base = Reg();
+	VirtualRegisterName* n    = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { base, n });
+
+	CastInsn* cast = BuildArraySumLoop(bbs, base, n);
+
+	RunLoopStrengthReduce(fn);
+
+	REQUIRE(CountInstructions(bbs[2], HLIR::IMul) == 0);
+	REQUIRE(IR::GetSingleDefinition(cast->GetSrc())->GetOpcode() == HLIR::Phi);
+
+	// Without a trip count the test can't be rewritten, so the index is still
+	// needed for it.
+	REQUIRE(CountInstructions(bbs[1], HLIR::Phi) == 3);
+	REQUIRE(CountInstructions(bbs[1], HLIR::ICmp_Lt) == 1);
+	REQUIRE(CountInstructions(bbs[0], HLIR::IAdd) == 0);
+}
+
+/******************************************************************************/
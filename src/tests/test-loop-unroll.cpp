@@ -0,0 +1,189 @@
+/**
+ * @file test-loop-unroll.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../loop-unroll.h"
+#include "../loop-info.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunLoopUnroll(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	LoopUnroll pass;
+	pass.Execute(fn, info);
+}
+
+/// Build a 'for (i = start; i < bound; ++i) s += i' loop, with 'extra' additional
+/// instructions in the body to make it bigger. Returns the 'ret s' at the end.
+static RetInsn* BuildSumLoop(std::vector<BasicBlock*>& bbs, Value* start, Value* bound, size_t extra)
+{
+	// entry:  br header
+	// header: i = phi [start, entry], [i2, body]; s = phi [0, entry], [s2, body]
+	//         c = icmp_lt i, bound; cbr c, body, exit
+	// body:   s2 = iadd s, i; i2 = iadd i, 1; br header
+	// exit:   ret s
+	VirtualRegisterName* i  = Reg();
+	VirtualRegisterName* s  = Reg();
+	VirtualRegisterName* c  = Reg();
+	VirtualRegisterName* i2 = Reg();
+	VirtualRegisterName* s2 = Reg();
+
+	PhiInsn* iPhi = Helix::CreatePhi(i);
+	iPhi->AddIncoming(start, bbs[0]);
+	iPhi->AddIncoming(i2, bbs[2]);
+
+	PhiInsn* sPhi = Helix::CreatePhi(s);
+	sPhi->AddIncoming(Int32(0), bbs[0]);
+	sPhi->AddIncoming(s2, bbs[2]);
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(iPhi);
+	bbs[1]->Append(sPhi);
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i, bound, c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	for (size_t n = 0; n < extra; ++n) {
+		bbs[2]->Append(Helix::CreateBinOp(HLIR::IMul, i, Int32(3), Reg()));
+	}
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, s, i, s2));
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), i2));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	RetInsn* ret = Helix::CreateRet(s);
+	bbs[3]->Append(ret);
+
+	return ret;
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopUnroll (Full unroll of a constant trip count)", "[LoopUnroll]")
+{
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { });
+
+	RetInsn* ret = BuildSumLoop(bbs, Int32(0), Int32(4), 0);
+
+	RunLoopUnroll(fn);
+
+	SECTION("Nothing is left of the loop")
+	{
+		AnalysisManager am;
+
+		REQUIRE(am.Get<LoopInfo>(fn).IsEmpty());
+		REQUIRE(CountInstructions(fn, HLIR::Phi) == 0);
+		REQUIRE(CountInstructions(fn, HLIR::ConditionalBranch) == 0);
+	}
+
+	SECTION("The body is repeated once per iteration")
+	{
+		REQUIRE(CountInstructions(fn, HLIR::IAdd) == 8);
+
+		// ... with the copies merged into a straight line in front of the exit.
+		REQUIRE(fn->GetCountBlocks() == 2);
+		REQUIRE(ret->GetParent() == bbs[3]);
+	}
+
+	SECTION("The induction variable is known in each copy")
+	{
+		BinOpInsn* first = nullptr;
+
+		for (Instruction& insn : *bbs[0]) {
+			if (insn.GetOpcode() == HLIR::IAdd) {
+				first = static_cast<BinOpInsn*>(&insn);
+				break;
+			}
+		}
+
+		REQUIRE(first);
+		REQUIRE(first->GetLHS() == Int32(0));
+		REQUIRE(first->GetRHS() == Int32(0));
+
+		// The result after the loop is the sum from the last copy.
+		REQUIRE(ret->GetOperand(0) != first->GetResult());
+		REQUIRE(IR::GetSingleDefinition(ret->GetOperand(0))->GetOpcode() == HLIR::IAdd);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopUnroll (Partial unroll with an unknown start)", "[LoopUnroll]")
+{
+	VirtualRegisterName* start = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { start });
+
+	BuildSumLoop(bbs, start, Int32(100), 0);
+
+	RunLoopUnroll(fn);
+
+	AnalysisManager am;
+	LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+	// The groups of iterations run in a loop of their own, & the original loop
+	// is kept around to run any that are left over.
+	REQUIRE(loops.GetTopLevelLoops().size() == 2);
+	REQUIRE(loops.IsLoopHeader(bbs[1]));
+
+	BasicBlock* groupHeader = bbs[0]->GetSuccessors()[0];
+
+	REQUIRE(groupHeader != bbs[1]);
+	REQUIRE(loops.IsLoopHeader(groupHeader));
+
+	// The group header checks that the last iteration of the group would run, and
+	// otherwise falls back to the original loop.
+	REQUIRE(groupHeader->GetSuccessors().size() == 2);
+	REQUIRE(groupHeader->GetSuccessors()[1] == bbs[1]);
+
+	// ... comparing the induction variable against the bound less the group's step,
+	// rather than adding the step to it (which could overflow).
+	CompareInsn* test = static_cast<CompareInsn*>(&*IR::GetPrev(groupHeader->GetLast()));
+
+	REQUIRE(test->GetOpcode() == HLIR::ICmp_Lt);
+	REQUIRE(test->GetLHS() == static_cast<PhiInsn*>(&*groupHeader->begin())->GetResult());
+	REQUIRE(value_cast<ConstantInt>(test->GetRHS())->GetIntegralValue() == 100 - 7);
+
+	PhiInsn* iPhi = static_cast<PhiInsn*>(&*bbs[1]->begin());
+
+	REQUIRE(iPhi->GetIncomingIndex(groupHeader) != SIZE_MAX);
+	REQUIRE(iPhi->GetIncomingIndex(bbs[0]) == SIZE_MAX);
+
+	// 8 copies of the body, plus the original body.
+	REQUIRE(CountInstructions(fn, HLIR::IAdd) == 8 * 2 + 2);
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopUnroll (Loops that are too big are left alone)", "[LoopUnroll]")
+{
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { });
+
+	BuildSumLoop(bbs, Int32(0), Int32(4), 200);
+
+	RunLoopUnroll(fn);
+
+	REQUIRE(fn->GetCountBlocks() == 4);
+	REQUIRE(bbs[2]->GetCountInstructions() == 203);
+	REQUIRE(CountInstructions(fn, HLIR::Phi) == 2);
+}
+
+/******************************************************************************/
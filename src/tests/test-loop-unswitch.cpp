@@ -0,0 +1,191 @@
+/**
+ * @file test-loop-unswitch.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../loop-unswitch.h"
+#include "../loop-info.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunLoopUnswitch(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	LoopUnswitch pass;
+	pass.Execute(fn, info);
+}
+
+/// Build a loop summing either 'i' or '0 - i' for 'i' from 0 up to 'n', depending
+/// on 'cond'. Returns the 'ret' of the sum.
+static RetInsn* BuildSwitchedLoop(std::vector<BasicBlock*>& bbs, Value* n, Value* cond)
+{
+	// entry:  br header
+	// header: i = phi [0, entry], [i2, latch]; s = phi [0, entry], [s3, latch]
+	//         c = icmp_lt i, n; cbr c, body, exit
+	// body:   cbr cond, add, sub
+	// add:    s1 = iadd s, i; br latch
+	// sub:    s2 = isub s, i; br latch
+	// latch:  s3 = phi [s1, add], [s2, sub]; i2 = iadd i, 1; br header
+	// exit:   ret s
+	VirtualRegisterName* i  = Reg();
+	VirtualRegisterName* s  = Reg();
+	VirtualRegisterName* c  = Reg();
+	VirtualRegisterName* s1 = Reg();
+	VirtualRegisterName* s2 = Reg();
+	VirtualRegisterName* s3 = Reg();
+	VirtualRegisterName* i2 = Reg();
+
+	PhiInsn* iPhi = Helix::CreatePhi(i);
+	iPhi->AddIncoming(Int32(0), bbs[0]);
+	iPhi->AddIncoming(i2, bbs[5]);
+
+	PhiInsn* sPhi = Helix::CreatePhi(s);
+	sPhi->AddIncoming(Int32(0), bbs[0]);
+	sPhi->AddIncoming(s3, bbs[5]);
+
+	PhiInsn* joinPhi = Helix::CreatePhi(s3);
+	joinPhi->AddIncoming(s1, bbs[3]);
+	joinPhi->AddIncoming(s2, bbs[4]);
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(iPhi);
+	bbs[1]->Append(sPhi);
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i, n, c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[6], c));
+
+	bbs[2]->Append(Helix::CreateConditionalBranch(bbs[3], bbs[4], cond));
+
+	bbs[3]->Append(Helix::CreateBinOp(HLIR::IAdd, s, i, s1));
+	bbs[3]->Append(Helix::CreateUnconditionalBranch(bbs[5]));
+
+	bbs[4]->Append(Helix::CreateBinOp(HLIR::ISub, s, i, s2));
+	bbs[4]->Append(Helix::CreateUnconditionalBranch(bbs[5]));
+
+	bbs[5]->Append(joinPhi);
+	bbs[5]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), i2));
+	bbs[5]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	RetInsn* ret = Helix::CreateRet(s);
+	bbs[6]->Append(ret);
+
+	return ret;
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopUnswitch (Branch on a parameter)", "[LoopUnswitch]")
+{
+	VirtualRegisterName* n    = Reg();
+	VirtualRegisterName* flag = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 7, { n, flag });
+
+	RetInsn* ret = BuildSwitchedLoop(bbs, n, flag);
+
+	RunLoopUnswitch(fn);
+
+	SECTION("The flag is tested once, before the loop")
+	{
+		REQUIRE(bbs[0]->GetLast()->GetOpcode() == HLIR::ConditionalBranch);
+		REQUIRE(static_cast<ConditionalBranchInsn*>(bbs[0]->GetLast())->GetCond() == flag);
+
+		for (Instruction& insn : *bbs[2]) {
+			REQUIRE(insn.GetOpcode() == HLIR::ConditionalBranch);
+			REQUIRE(value_isa<ConstantInt>(static_cast<ConditionalBranchInsn*>(&insn)->GetCond()));
+		}
+	}
+
+	SECTION("There is a copy of the loop for each way the flag can go")
+	{
+		AnalysisManager am;
+		LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+		REQUIRE(loops.GetTopLevelLoops().size() == 2);
+
+		for (Loop* loop : loops.GetTopLevelLoops()) {
+			REQUIRE(loop->GetPreheader());
+			REQUIRE(loop->GetCountBlocks() == 5);
+			REQUIRE(loop->GetExitBlocks().size() == 1);
+
+			// Only reached from inside that copy.
+			for (BasicBlock* pred : IR::GetPredecessors(loop->GetExitBlock())) {
+				REQUIRE(loop->Contains(pred));
+			}
+		}
+	}
+
+	SECTION("The result is joined from both copies")
+	{
+		Instruction* def = IR::GetSingleDefinition(ret->GetReturnValue());
+
+		REQUIRE(def->GetOpcode() == HLIR::Phi);
+		REQUIRE(static_cast<PhiInsn*>(def)->GetCountIncoming() == 2);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopUnswitch (Branch on a value computed in the loop)", "[LoopUnswitch]")
+{
+	VirtualRegisterName* n = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 7, { n });
+
+	// The condition depends on the induction variable, so it can't be unswitched.
+	VirtualRegisterName* odd = Reg();
+	BuildSwitchedLoop(bbs, n, odd);
+
+	Value* i = static_cast<PhiInsn*>(&*bbs[1]->begin())->GetResult();
+	IR::InsertBefore(bbs[2]->GetLast(), Helix::CreateBinOp(HLIR::And, i, Int32(1), odd));
+
+	const size_t blocks = fn->GetCountBlocks();
+
+	RunLoopUnswitch(fn);
+
+	REQUIRE(fn->GetCountBlocks() == blocks);
+	REQUIRE(bbs[0]->GetLast()->GetOpcode() == HLIR::UnconditionalBranch);
+	REQUIRE(static_cast<ConditionalBranchInsn*>(bbs[2]->GetLast())->GetCond() == odd);
+}
+
+/******************************************************************************/
+
+TEST_CASE("LoopUnswitch (Condition used as a value)", "[LoopUnswitch]")
+{
+	VirtualRegisterName* n    = Reg();
+	VirtualRegisterName* flag = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 7, { n, flag });
+
+	BuildSwitchedLoop(bbs, n, flag);
+
+	// add: s1 = iadd s, flag
+	BinOpInsn* add = static_cast<BinOpInsn*>(&*bbs[3]->begin());
+	add->SetOperand(1, flag);
+
+	RunLoopUnswitch(fn);
+
+	// The branch only says that 'flag' isn't zero, not that it's one, so the copy
+	// of the loop for the taken branch still has to add the real value.
+	REQUIRE(bbs[0]->GetLast()->GetOpcode() == HLIR::ConditionalBranch);
+	REQUIRE(value_isa<ConstantInt>(static_cast<ConditionalBranchInsn*>(bbs[2]->GetLast())->GetCond()));
+	REQUIRE(add->GetRHS() == flag);
+}
+
+/******************************************************************************/
@@ -0,0 +1,176 @@
+/**
+ * @file test-peephole-generic.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../peephole-generic.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunPeephole(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	PeepholeGeneric pass;
+	pass.Execute(fn, info);
+}
+
+static size_t CountInstructions(Function* fn)
+{
+	size_t count = 0;
+
+	for (BasicBlock& bb : fn->blocks()) {
+		count += bb.GetCountInstructions();
+	}
+
+	return count;
+}
+
+static Value* GetReturnValue(BasicBlock* bb)
+{
+	return static_cast<RetInsn*>(bb->GetLast())->GetReturnValue();
+}
+
+/******************************************************************************/
+
+TEST_CASE("Peephole (Algebraic identities)", "[Peephole]")
+{
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* y = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 1, { x, y });
+
+	// Each identity only applies once the one before it has been folded.
+	//
+	// a = iadd x, 0; b = imul a, 1; z = xor y, y; c = or b, z; t = icmp_eq c, x
+	// d = imul c, t; m = and y, z; r = iadd d, m; ret r
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* z = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* t = Reg();
+	VirtualRegisterName* d = Reg();
+	VirtualRegisterName* m = Reg();
+	VirtualRegisterName* r = Reg();
+
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, x, Int32(0), a));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IMul, a, Int32(1), b));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::Xor, y, y, z));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::Or, b, z, c));
+	bbs[0]->Append(Helix::CreateCompare(HLIR::ICmp_Eq, c, x, t));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IMul, c, t, d));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::And, y, z, m));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, d, m, r));
+	bbs[0]->Append(Helix::CreateRet(r));
+
+	RunPeephole(fn);
+
+	REQUIRE(CountInstructions(fn) == 1);
+	REQUIRE(GetReturnValue(bbs[0]) == x);
+}
+
+/******************************************************************************/
+
+TEST_CASE("Peephole (Negation & shifts)", "[Peephole]")
+{
+	VirtualRegisterName* x = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 1, { x });
+
+	SECTION("Double negation")
+	{
+		// a = isub 0, x; b = isub 0, a; ret b
+		VirtualRegisterName* a = Reg();
+		VirtualRegisterName* b = Reg();
+
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::ISub, Int32(0), x, a));
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::ISub, Int32(0), a, b));
+		bbs[0]->Append(Helix::CreateRet(b));
+
+		RunPeephole(fn);
+
+		REQUIRE(GetReturnValue(bbs[0]) == x);
+	}
+
+	SECTION("Double negation (original value changed in between)")
+	{
+		// a = isub 0, x; x = iadd x, 1; b = isub 0, a; ret b
+		VirtualRegisterName* a = Reg();
+		VirtualRegisterName* b = Reg();
+
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::ISub, Int32(0), x, a));
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, x, Int32(1), x));
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::ISub, Int32(0), a, b));
+		bbs[0]->Append(Helix::CreateRet(b));
+
+		RunPeephole(fn);
+
+		REQUIRE(GetReturnValue(bbs[0]) == b);
+		REQUIRE(CountInstructions(fn) == 4);
+	}
+
+	SECTION("Double negation across blocks")
+	{
+		// bb0: a = isub 0, x; br bb1
+		// bb1: b = isub 0, a; ret b
+		BasicBlock* next = BasicBlock::Create();
+		fn->Append(next);
+
+		VirtualRegisterName* a = Reg();
+		VirtualRegisterName* b = Reg();
+
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::ISub, Int32(0), x, a));
+		bbs[0]->Append(Helix::CreateUnconditionalBranch(next));
+		next->Append(Helix::CreateBinOp(HLIR::ISub, Int32(0), a, b));
+		next->Append(Helix::CreateRet(b));
+
+		RunPeephole(fn);
+
+		REQUIRE(GetReturnValue(next) == x);
+		REQUIRE(next->GetCountInstructions() == 1);
+	}
+
+	SECTION("Shifts of shifts")
+	{
+		const Integer second = GENERATE(2, 29);
+
+		// a = shl x, 3; b = shl a, <second>; ret b
+		VirtualRegisterName* a = Reg();
+		VirtualRegisterName* b = Reg();
+
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::Shl, x, Int32(3), a));
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::Shl, a, Int32(second), b));
+		bbs[0]->Append(Helix::CreateRet(b));
+
+		RunPeephole(fn);
+
+		if (second == 2) {
+			BinOpInsn* shift = static_cast<BinOpInsn*>(&*IR::GetPrev(bbs[0]->GetLast()));
+
+			REQUIRE(shift->GetOpcode() == HLIR::Shl);
+			REQUIRE(shift->GetLHS() == x);
+			REQUIRE(shift->GetResult() == b);
+			REQUIRE(value_cast<ConstantInt>(shift->GetRHS())->GetIntegralValue() == 5);
+		}
+		else {
+			// Every bit is shifted out.
+			REQUIRE(value_cast<ConstantInt>(GetReturnValue(bbs[0]))->GetIntegralValue() == 0);
+		}
+	}
+}
+
+/******************************************************************************/
@@ -0,0 +1,169 @@
+/**
+ * @file test-pre.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../pre.h"
+#include "../function.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunPRE(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	PRE pass;
+	pass.Execute(fn, info);
+}
+
+/******************************************************************************/
+
+TEST_CASE("PRE (Partially redundant expression after an if/else)", "[PRE]")
+{
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* y = Reg();
+	VirtualRegisterName* c = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { x, y, c });
+
+	// entry: cbr c, then, else
+	// then:  a = iadd x, y; b = imul a, 2; br join
+	// else:  d = isub x, y; br join
+	// join:  e = iadd x, y; f = iadd e, 1; ret f
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* d = Reg();
+	VirtualRegisterName* e = Reg();
+	VirtualRegisterName* f = Reg();
+
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::IAdd, x, y, a));
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::IMul, a, Int32(2), b));
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::ISub, x, y, d));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	BinOpInsn* use = Helix::CreateBinOp(HLIR::IAdd, e, Int32(1), f);
+
+	bbs[3]->Append(Helix::CreateBinOp(HLIR::IAdd, x, y, e));
+	bbs[3]->Append(use);
+	bbs[3]->Append(Helix::CreateRet(f));
+
+	RunPRE(fn);
+
+	SECTION("The expression is inserted along the path that didn't compute it")
+	{
+		REQUIRE(bbs[2]->GetCountInstructions() == 3);
+		REQUIRE(CountInstructions(bbs[2], HLIR::IAdd) == 1);
+
+		// ... but not along the path that already did.
+		REQUIRE(bbs[1]->GetCountInstructions() == 3);
+	}
+
+	SECTION("The redundant computation is replaced with a phi")
+	{
+		REQUIRE(bbs[3]->GetCountInstructions() == 3);
+		REQUIRE(bbs[3]->begin()->GetOpcode() == HLIR::Phi);
+
+		PhiInsn* phi = static_cast<PhiInsn*>(&*bbs[3]->begin());
+
+		REQUIRE(use->GetLHS() == phi->GetResult());
+		REQUIRE(phi->GetCountIncoming() == 2);
+		REQUIRE(phi->GetIncomingValue(phi->GetIncomingIndex(bbs[1])) == a);
+	}
+
+	SECTION("No stack slots are left behind")
+	{
+		REQUIRE(CountInstructions(bbs[0], HLIR::StackAlloc) == 0);
+		REQUIRE(fn->GetCountBlocks() == 4);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("PRE (Insertion along a critical edge)", "[PRE]")
+{
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* y = Reg();
+	VirtualRegisterName* c = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 3, { x, y, c });
+
+	// entry: cbr c, then, join
+	// then:  a = isub x, y; br join
+	// join:  b = isub x, y; ret b
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::ISub, x, y, a));
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[2]));
+
+	RetInsn* ret = Helix::CreateRet(b);
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::ISub, x, y, b));
+	bbs[2]->Append(ret);
+
+	RunPRE(fn);
+
+	// The edge from entry to join gets its own block to compute the expression in.
+	REQUIRE(fn->GetCountBlocks() == 4);
+	REQUIRE(CountInstructions(bbs[0], HLIR::ISub) == 0);
+	REQUIRE(CountInstructions(bbs[2], HLIR::ISub) == 0);
+
+	BasicBlock* split = bbs[0]->GetSuccessors()[1];
+
+	REQUIRE(split != bbs[2]);
+	REQUIRE(CountInstructions(split, HLIR::ISub) == 1);
+	REQUIRE(ret->GetOperand(0) != b);
+}
+
+/******************************************************************************/
+
+TEST_CASE("PRE (Expressions that aren't redundant on any path)", "[PRE]")
+{
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* y = Reg();
+	VirtualRegisterName* c = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 3, { x, y, c });
+
+	// entry: cbr c, then, join
+	// then:  a = isdiv x, y; br join
+	// join:  b = isdiv x, y; ret b     (can't be inserted on the other path, since it may trap)
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::ISDiv, x, y, a));
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[2]));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::ISDiv, x, y, b));
+	bbs[2]->Append(Helix::CreateRet(b));
+
+	RunPRE(fn);
+
+	REQUIRE(fn->GetCountBlocks() == 3);
+	REQUIRE(bbs[0]->GetCountInstructions() == 1);
+	REQUIRE(bbs[1]->GetCountInstructions() == 2);
+	REQUIRE(bbs[2]->GetCountInstructions() == 2);
+}
+
+/******************************************************************************/
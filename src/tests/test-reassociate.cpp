@@ -0,0 +1,173 @@
+/**
+ * @file test-reassociate.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../reassociate.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunReassociate(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	Reassociate pass;
+	pass.Execute(fn, info);
+}
+
+static Integer GetConstant(Value* value)
+{
+	ConstantInt* constant = value_cast<ConstantInt>(value);
+
+	REQUIRE(constant);
+	return constant->GetIntegralValue();
+}
+
+/******************************************************************************/
+
+TEST_CASE("Reassociate (Constant chains)", "[Reassociate]")
+{
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 1, { a, b });
+
+	// s1 = iadd a, 1; s2 = iadd s1, b; s3 = iadd s2, 2
+	// m1 = imul a, 4; m2 = imul m1, 8
+	// r  = xor s3, m2; ret r
+	VirtualRegisterName* s1 = Reg();
+	VirtualRegisterName* s2 = Reg();
+	VirtualRegisterName* s3 = Reg();
+	VirtualRegisterName* m1 = Reg();
+	VirtualRegisterName* m2 = Reg();
+	VirtualRegisterName* r  = Reg();
+
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, a, Int32(1), s1));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, s1, b, s2));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, s2, Int32(2), s3));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IMul, a, Int32(4), m1));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IMul, m1, Int32(8), m2));
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::Xor, s3, m2, r));
+	bbs[0]->Append(Helix::CreateRet(r));
+
+	RunReassociate(fn);
+
+	// iadd a, b, t; iadd t, 3, s3; imul a, 32, m2; xor s3, m2, r; ret r
+	REQUIRE(bbs[0]->GetCountInstructions() == 5);
+
+	BinOpInsn* sum = static_cast<BinOpInsn*>(&*bbs[0]->begin());
+
+	REQUIRE(sum->GetOpcode() == HLIR::IAdd);
+	REQUIRE(sum->GetLHS() == a);
+	REQUIRE(sum->GetRHS() == b);
+
+	BinOpInsn* sumConstant = static_cast<BinOpInsn*>(&*IR::GetNext(sum));
+
+	REQUIRE(sumConstant->GetLHS() == sum->GetResult());
+	REQUIRE(GetConstant(sumConstant->GetRHS()) == 3);
+	REQUIRE(sumConstant->GetResult() == s3);
+
+	BinOpInsn* product = static_cast<BinOpInsn*>(&*IR::GetNext(sumConstant));
+
+	REQUIRE(product->GetOpcode() == HLIR::IMul);
+	REQUIRE(product->GetLHS() == a);
+	REQUIRE(GetConstant(product->GetRHS()) == 32);
+	REQUIRE(product->GetResult() == m2);
+}
+
+/******************************************************************************/
+
+TEST_CASE("Reassociate (Canonical order)", "[Reassociate]")
+{
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* c = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 1, { a, b, c });
+
+	SECTION("Same sum written differently")
+	{
+		// x1 = iadd c, a; x2 = iadd x1, b
+		// y1 = iadd b, c; y2 = iadd a, y1
+		// r  = isub x2, y2; ret r
+		VirtualRegisterName* x1 = Reg();
+		VirtualRegisterName* x2 = Reg();
+		VirtualRegisterName* y1 = Reg();
+		VirtualRegisterName* y2 = Reg();
+		VirtualRegisterName* r  = Reg();
+
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, c, a, x1));
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, x1, b, x2));
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, b, c, y1));
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, a, y1, y2));
+		bbs[0]->Append(Helix::CreateBinOp(HLIR::ISub, x2, y2, r));
+		bbs[0]->Append(Helix::CreateRet(r));
+
+		RunReassociate(fn);
+
+		// Both come out as (a + b) + c.
+		for (Value* result : { x2, y2 }) {
+			BinOpInsn* outer = static_cast<BinOpInsn*>(IR::GetSingleDefinition(result));
+			BinOpInsn* inner = static_cast<BinOpInsn*>(IR::GetSingleDefinition(outer->GetLHS()));
+
+			REQUIRE(outer->GetRHS() == c);
+			REQUIRE(inner->GetLHS() == a);
+			REQUIRE(inner->GetRHS() == b);
+		}
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("Reassociate (Tree across blocks)", "[Reassociate]")
+{
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 2, { a, b });
+
+	// bb0: t = iadd a, 1; br bb1
+	// bb1: s = iadd t, b; r = iadd s, 2; ret r
+	VirtualRegisterName* t = Reg();
+	VirtualRegisterName* s = Reg();
+	VirtualRegisterName* r = Reg();
+
+	bbs[0]->Append(Helix::CreateBinOp(HLIR::IAdd, a, Int32(1), t));
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::IAdd, t, b, s));
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::IAdd, s, Int32(2), r));
+	bbs[1]->Append(Helix::CreateRet(r));
+
+	RunReassociate(fn);
+
+	// 't' is defined in a block that dominates the root, so it is part of the tree
+	// & the whole thing becomes (a + b) + 3.
+	REQUIRE(IR::GetSingleDefinition(t) == nullptr);
+
+	BinOpInsn* outer = static_cast<BinOpInsn*>(IR::GetSingleDefinition(r));
+	BinOpInsn* inner = static_cast<BinOpInsn*>(IR::GetSingleDefinition(outer->GetLHS()));
+
+	REQUIRE(outer->GetParent() == bbs[1]);
+	REQUIRE(inner->GetLHS() == a);
+	REQUIRE(inner->GetRHS() == b);
+	REQUIRE(GetConstant(outer->GetRHS()) == 3);
+	REQUIRE(bbs[0]->begin()->GetOpcode() == HLIR::UnconditionalBranch);
+}
+
+/******************************************************************************/
@@ -0,0 +1,176 @@
+/**
+ * @file test-sccp.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../sccp.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static bool HasBlock(Function* fn, BasicBlock* bb)
+{
+	for (BasicBlock& other : fn->blocks()) {
+		if (&other == bb)
+			return true;
+	}
+
+	return false;
+}
+
+/******************************************************************************/
+
+TEST_CASE("SCCP (Constant branches)", "[SCCP]")
+{
+	// entry: c = icmp_eq 3, 3; cbr c, then, else
+	// then:  a = iadd p, 1; br join
+	// else:  b = imul p, 7; br join
+	// join:  r = phi [a, then], [b, else]; ret r
+	VirtualRegisterName* p = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { p });
+
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* r = Reg();
+
+	bbs[0]->Append(Helix::CreateCompare(HLIR::ICmp_Eq, Int32(3), Int32(3), c));
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::IAdd, p, Int32(1), a));
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IMul, p, Int32(7), b));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	PhiInsn* phi = Helix::CreatePhi(r);
+	phi->AddIncoming(a, bbs[1]);
+	phi->AddIncoming(b, bbs[2]);
+
+	RetInsn* ret = Helix::CreateRet(r);
+
+	bbs[3]->Append(phi);
+	bbs[3]->Append(ret);
+
+	SCCP pass;
+	pass.Execute(fn, {});
+
+	// The false side can never be taken, so is removed entirely.
+	REQUIRE(fn->GetCountBlocks() == 3);
+	REQUIRE(!HasBlock(fn, bbs[2]));
+
+	REQUIRE(bbs[0]->GetLast()->GetOpcode() == HLIR::UnconditionalBranch);
+	REQUIRE(bbs[0]->GetSuccessors() == std::vector<BasicBlock*> { bbs[1] });
+
+	// Only one value can reach the join, so it doesn't need a phi.
+	REQUIRE(bbs[3]->GetCountInstructions() == 1);
+	REQUIRE(ret->GetReturnValue() == a);
+}
+
+/******************************************************************************/
+
+TEST_CASE("SCCP (Values around loops)", "[SCCP]")
+{
+	// entry: br loop
+	// loop:  k = phi [5, entry], [k2, latch]
+	//        i = phi [0, entry], [i2, latch]
+	//        c = icmp_neq k, 5; cbr c, never, latch
+	// never: br latch
+	// latch: k2 = phi [k, loop], [9, never]
+	//        i2 = iadd i, 1; d = icmp_lt i2, p; cbr d, loop, tail
+	// tail:  ret k
+	VirtualRegisterName* p = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 5, { p });
+
+	VirtualRegisterName* k  = Reg();
+	VirtualRegisterName* k2 = Reg();
+	VirtualRegisterName* i  = Reg();
+	VirtualRegisterName* i2 = Reg();
+	VirtualRegisterName* c  = Reg();
+	VirtualRegisterName* d  = Reg();
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	PhiInsn* phiK = Helix::CreatePhi(k);
+	phiK->AddIncoming(Int32(5), bbs[0]);
+	phiK->AddIncoming(k2, bbs[3]);
+
+	PhiInsn* phiI = Helix::CreatePhi(i);
+	phiI->AddIncoming(Int32(0), bbs[0]);
+	phiI->AddIncoming(i2, bbs[3]);
+
+	bbs[1]->Append(phiK);
+	bbs[1]->Append(phiI);
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Neq, k, Int32(5), c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	PhiInsn* phiK2 = Helix::CreatePhi(k2);
+	phiK2->AddIncoming(k, bbs[1]);
+	phiK2->AddIncoming(Int32(9), bbs[2]);
+
+	BinOpInsn* add = Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), i2);
+
+	bbs[3]->Append(phiK2);
+	bbs[3]->Append(add);
+	bbs[3]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i2, p, d));
+	bbs[3]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[4], d));
+
+	RetInsn* ret = Helix::CreateRet(k);
+	bbs[4]->Append(ret);
+
+	SCCP pass;
+	pass.Execute(fn, {});
+
+	SECTION("Only executable edges contribute to phis")
+	{
+		REQUIRE(!HasBlock(fn, bbs[2]));
+		REQUIRE(ret->GetReturnValue() == Int32(5));
+	}
+
+	SECTION("Values that change each iteration are not constant")
+	{
+		REQUIRE(phiI->GetParent() == bbs[1]);
+		REQUIRE(add->GetParent() == bbs[3]);
+		REQUIRE(add->GetLHS() == i);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("SCCP (Undefined branch conditions)", "[SCCP]")
+{
+	// entry: cbr undef, a, b
+	// a:     ret 1
+	// b:     ret 2
+	VirtualRegisterName* p = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 3, { p });
+
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], UndefValue::Get(BuiltinTypes::GetInt32())));
+	bbs[1]->Append(Helix::CreateRet(Int32(1)));
+	bbs[2]->Append(Helix::CreateRet(Int32(2)));
+
+	SCCP pass;
+	pass.Execute(fn, {});
+
+	// Nothing is known about the condition, so either side could still run.
+	REQUIRE(fn->GetCountBlocks() == 3);
+	REQUIRE(bbs[0]->GetLast()->GetOpcode() == HLIR::ConditionalBranch);
+}
+
+/******************************************************************************/
@@ -0,0 +1,216 @@
+/**
+ * @file test-simplify-cfg.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../simplify-cfg.h"
+#include "../loop-info.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+template <typename Pass = SimplifyCFG>
+static void RunSimplifyCFG(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	Pass pass;
+	pass.Execute(fn, info);
+}
+
+static size_t CountBlocks(Function* fn)
+{
+	size_t count = 0;
+
+	for (BasicBlock& bb : fn->blocks()) {
+		(void) bb;
+		count++;
+	}
+
+	return count;
+}
+
+/******************************************************************************/
+
+TEST_CASE("SimplifyCFG (Branches & empty blocks)", "[SimplifyCFG]")
+{
+	VirtualRegisterName* n = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { n });
+
+	// entry: cbr cond, then, else
+	// then:  x = iadd n, 1; br tail
+	// else:  br tail
+	// tail:  r = phi [x, then], [n, else]; ret r
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* r = Reg();
+
+	PhiInsn* phi = Helix::CreatePhi(r);
+	phi->AddIncoming(x, bbs[1]);
+	phi->AddIncoming(n, bbs[2]);
+
+	bbs[1]->Append(Helix::CreateBinOp(HLIR::IAdd, n, Int32(1), x));
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	RetInsn* ret = Helix::CreateRet(r);
+
+	bbs[3]->Append(phi);
+	bbs[3]->Append(ret);
+
+	SECTION("Branches to an empty block go straight to where it goes")
+	{
+		VirtualRegisterName* c = Reg();
+
+		bbs[0]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, n, Int32(10), c));
+		bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+		RunSimplifyCFG(fn);
+
+		REQUIRE(CountBlocks(fn) == 3);
+
+		ConditionalBranchInsn* cbr = static_cast<ConditionalBranchInsn*>(bbs[0]->GetLast());
+
+		REQUIRE(cbr->GetOpcode() == HLIR::ConditionalBranch);
+		REQUIRE(cbr->GetTrueBB() == bbs[1]);
+		REQUIRE(cbr->GetFalseBB() == bbs[3]);
+
+		// The value that came through the empty block now comes from the entry.
+		REQUIRE(phi->GetCountIncoming() == 2);
+		REQUIRE(phi->GetIncomingValueForBlock(bbs[0]) == n);
+		REQUIRE(phi->GetIncomingValueForBlock(bbs[1]) == x);
+	}
+
+	SECTION("Constant branches are folded & what's left is merged into one block")
+	{
+		bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], Int32(GENERATE(0, 1))));
+
+		RunSimplifyCFG(fn);
+
+		REQUIRE(CountBlocks(fn) == 1);
+		REQUIRE(fn->GetHeadBlock()->GetLast() == ret);
+
+		if (ret->GetReturnValue() != n) {
+			Instruction* def = IR::GetSingleDefinition(ret->GetReturnValue());
+
+			REQUIRE(def->GetOpcode() == HLIR::IAdd);
+			REQUIRE(def->GetParent() == fn->GetHeadBlock());
+		}
+	}
+
+	SECTION("A branch with both targets the same is unconditional")
+	{
+		VirtualRegisterName* c = Reg();
+
+		phi->RemoveIncoming(0);
+		bbs[1]->GetLast()->DeleteFromParent();
+		bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[2]));
+
+		bbs[0]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, n, Int32(10), c));
+		bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[1], c));
+
+		RunSimplifyCFG(fn);
+
+		REQUIRE(CountBlocks(fn) == 1);
+		REQUIRE(fn->GetHeadBlock()->GetLast() == ret);
+		REQUIRE(ret->GetReturnValue() == n);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("SimplifyCFG (Empty blocks around loops)", "[SimplifyCFG]")
+{
+	VirtualRegisterName* n = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 6, { n });
+
+	// entry:     c = icmp_gt n, 0; cbr c, preheader, tail
+	// preheader: br header
+	// header:    i = phi [0, preheader], [i2, header]; i2 = iadd i, 1; d = icmp_lt i2, n; cbr d, header, exit
+	// exit:      br tail
+	// tail:      ret 0
+	// dead:      br tail
+	VirtualRegisterName* c  = Reg();
+	VirtualRegisterName* i  = Reg();
+	VirtualRegisterName* i2 = Reg();
+	VirtualRegisterName* d  = Reg();
+
+	bbs[0]->Append(Helix::CreateCompare(HLIR::ICmp_Gt, n, Int32(0), c));
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[4], c));
+
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[2]));
+
+	PhiInsn* phi = Helix::CreatePhi(i);
+	phi->AddIncoming(Int32(0), bbs[1]);
+	phi->AddIncoming(i2, bbs[2]);
+
+	bbs[2]->Append(phi);
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), i2));
+	bbs[2]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, i2, n, d));
+	bbs[2]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], d));
+
+	bbs[3]->Append(Helix::CreateUnconditionalBranch(bbs[4]));
+
+	bbs[5]->Append(Helix::CreateUnconditionalBranch(bbs[4]));
+
+	// The tail has to stay at the end.
+	fn->Remove(fn->Where(bbs[4]));
+	fn->Append(bbs[4]);
+	bbs[4]->Append(Helix::CreateRet(Int32(0)));
+
+	SECTION("The loop passes still get their preheader & exit block")
+	{
+		RunSimplifyCFG(fn);
+
+		// Only the unreachable block is gone.
+		REQUIRE(CountBlocks(fn) == 5);
+		REQUIRE(fn->GetTailBlock() == bbs[4]);
+
+		AnalysisManager am;
+		LoopInfo& loops = am.Get<LoopInfo>(fn);
+
+		REQUIRE(loops.GetTopLevelLoops().size() == 1);
+
+		Loop* loop = loops.GetTopLevelLoops()[0];
+
+		REQUIRE(loop->GetPreheader() == bbs[1]);
+		REQUIRE(loop->GetExitBlock() == bbs[3]);
+	}
+
+	SECTION("Once the loop passes are done, the empty blocks around the loop go too")
+	{
+		RunSimplifyCFG<LateSimplifyCFG>(fn);
+
+		REQUIRE(CountBlocks(fn) == 3);
+		REQUIRE(fn->GetTailBlock() == bbs[4]);
+
+		ConditionalBranchInsn* guard = static_cast<ConditionalBranchInsn*>(bbs[0]->GetLast());
+		ConditionalBranchInsn* latch = static_cast<ConditionalBranchInsn*>(bbs[2]->GetLast());
+
+		REQUIRE(guard->GetTrueBB() == bbs[2]);
+		REQUIRE(guard->GetFalseBB() == bbs[4]);
+		REQUIRE(latch->GetTrueBB() == bbs[2]);
+		REQUIRE(latch->GetFalseBB() == bbs[4]);
+
+		REQUIRE(phi->GetCountIncoming() == 2);
+		REQUIRE(IR::IsSameValue(phi->GetIncomingValueForBlock(bbs[0]), Int32(0)));
+		REQUIRE(phi->GetIncomingValueForBlock(bbs[2]) == i2);
+	}
+}
+
+/******************************************************************************/
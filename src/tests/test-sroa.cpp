@@ -0,0 +1,144 @@
+/**
+ * @file test-sroa.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../sroa.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunSROA(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	SROA pass;
+	pass.Execute(fn, info);
+}
+
+/******************************************************************************/
+
+TEST_CASE("SROA (Structs)", "[SROA]")
+{
+	const StructType* point = StructType::Create({ BuiltinTypes::GetInt32(), BuiltinTypes::GetInt32() });
+	const StructType* line  = StructType::Create({ point, point, BuiltinTypes::GetInt32() });
+
+	VirtualRegisterName* x = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 1, { x });
+
+	// s = stack_alloc line
+	// a = lfa s, line, 0;  ax = lfa a, point, 0; store x, ax
+	// c = lfa s, line, 2;  store 3, c
+	// b = lfa s, line, 0;  bx = lfa b, point, 0; r = load bx
+	// ret r
+	VirtualRegisterName* s  = Ptr();
+	VirtualRegisterName* a  = Ptr();
+	VirtualRegisterName* ax = Ptr();
+	VirtualRegisterName* c  = Ptr();
+	VirtualRegisterName* b  = Ptr();
+	VirtualRegisterName* bx = Ptr();
+	VirtualRegisterName* r  = Reg();
+
+	LoadInsn* load = Helix::CreateLoad(bx, r);
+
+	bbs[0]->Append(Helix::CreateStackAlloc(s, line));
+	bbs[0]->Append(Helix::CreateLoadFieldAddress(line, s, 0, a));
+	bbs[0]->Append(Helix::CreateLoadFieldAddress(point, a, 0, ax));
+	bbs[0]->Append(Helix::CreateStore(x, ax));
+	bbs[0]->Append(Helix::CreateLoadFieldAddress(line, s, 2, c));
+	bbs[0]->Append(Helix::CreateStore(Int32(3), c));
+	bbs[0]->Append(Helix::CreateLoadFieldAddress(line, s, 0, b));
+	bbs[0]->Append(Helix::CreateLoadFieldAddress(point, b, 0, bx));
+	bbs[0]->Append(load);
+	bbs[0]->Append(Helix::CreateRet(r));
+
+	RunSROA(fn);
+
+	// Only 'x' of the first point & the last field are used, so they're the only
+	// slots left (& both are integers that Mem2Reg can promote).
+	REQUIRE(CountInstructions(fn, HLIR::LoadFieldAddress) == 0);
+	REQUIRE(CountInstructions(fn, HLIR::StackAlloc) == 2);
+
+	for (Instruction& insn : *bbs[0]) {
+		if (insn.GetOpcode() == HLIR::StackAlloc)
+			REQUIRE(static_cast<StackAllocInsn&>(insn).GetAllocatedType() == BuiltinTypes::GetInt32());
+	}
+
+	// The load & store of 'x' go to the same slot.
+	Instruction* def = IR::GetSingleDefinition(load->GetSrc());
+
+	REQUIRE(def);
+	REQUIRE(def->GetOpcode() == HLIR::StackAlloc);
+
+	for (Instruction& insn : *bbs[0]) {
+		if (insn.GetOpcode() == HLIR::Store && static_cast<StoreInsn&>(insn).GetSrc() == x)
+			REQUIRE(static_cast<StoreInsn&>(insn).GetDst() == load->GetSrc());
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("SROA (Arrays)", "[SROA]")
+{
+	const ArrayType* array = ArrayType::Create(4, BuiltinTypes::GetInt32());
+
+	VirtualRegisterName* x = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 1, { x });
+
+	const FunctionType* externType = FunctionType::Create(BuiltinTypes::GetVoidType(), { BuiltinTypes::GetPointer() });
+	Function* ext = Function::Create(externType, "ext", { Ptr() });
+
+	enum Kind { ConstantIndices, VariableIndex, Escapes };
+	const Kind kind = GENERATE(ConstantIndices, VariableIndex, Escapes);
+
+	// s = stack_alloc [i32 x 4]
+	// p = lea s, 1, i32; store x, p
+	// q = lea s, <3 or x>, i32; r = load q
+	// (call ext, p)
+	// ret r
+	VirtualRegisterName* s = Ptr();
+	VirtualRegisterName* p = Ptr();
+	VirtualRegisterName* q = Ptr();
+	VirtualRegisterName* r = Reg();
+
+	bbs[0]->Append(Helix::CreateStackAlloc(s, array));
+	bbs[0]->Append(Helix::CreateLoadEffectiveAddress(BuiltinTypes::GetInt32(), s, Int32(1), p));
+	bbs[0]->Append(Helix::CreateStore(x, p));
+	bbs[0]->Append(Helix::CreateLoadEffectiveAddress(BuiltinTypes::GetInt32(), s, kind == VariableIndex ? (Value*) x : Int32(3), q));
+	bbs[0]->Append(Helix::CreateLoad(q, r));
+
+	if (kind == Escapes)
+		bbs[0]->Append(Helix::CreateCall(ext, { p }));
+
+	bbs[0]->Append(Helix::CreateRet(r));
+
+	RunSROA(fn);
+
+	if (kind == ConstantIndices) {
+		REQUIRE(CountInstructions(fn, HLIR::LoadElementAddress) == 0);
+		REQUIRE(CountInstructions(fn, HLIR::StackAlloc) == 2);
+	}
+	else {
+		// Either which element is used isn't known, or the array can be reached
+		// through a pointer to one of its elements.
+		REQUIRE(CountInstructions(fn, HLIR::LoadElementAddress) == 2);
+		REQUIRE(CountInstructions(fn, HLIR::StackAlloc) == 1);
+	}
+}
+
+/******************************************************************************/
@@ -0,0 +1,314 @@
+/**
+ * @file test-ssa.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../mem2reg.h"
+#include "../out-of-ssa.h"
+#include "../function.h"
+#include "../ir-helpers.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+
+using namespace Helix;
+
+/******************************************************************************/
+
+static void RunMem2Reg(Function* fn)
+{
+	AnalysisManager am;
+
+	PassRunInformation info;
+	info.Analyses = &am;
+
+	Mem2Reg pass;
+	pass.Execute(fn, info);
+}
+
+/******************************************************************************/
+
+TEST_CASE("Mem2Reg (Phis at joins)", "[SSA]")
+{
+	// entry: x = stack_alloc; cbr c, then, else
+	// then:  store 1, x; br join
+	// else:  store p, x; br join
+	// join:  r = load x; ret r
+	VirtualRegisterName* p = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { p });
+
+	VirtualRegisterName* x = Reg(BuiltinTypes::GetPointer());
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* r = Reg();
+
+	bbs[0]->Append(Helix::CreateStackAlloc(x, BuiltinTypes::GetInt32()));
+	bbs[0]->Append(Helix::CreateCompare(HLIR::ICmp_Gt, p, Int32(5), c));
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	bbs[1]->Append(Helix::CreateStore(Int32(1), x));
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	bbs[2]->Append(Helix::CreateStore(p, x));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[3]));
+
+	bbs[3]->Append(Helix::CreateLoad(x, r));
+	RetInsn* ret = Helix::CreateRet(r);
+	bbs[3]->Append(ret);
+
+	RunMem2Reg(fn);
+
+	REQUIRE(CountInstructions(fn, HLIR::StackAlloc) == 0);
+	REQUIRE(CountInstructions(fn, HLIR::Load) == 0);
+	REQUIRE(CountInstructions(fn, HLIR::Store) == 0);
+	REQUIRE(CountInstructions(fn, HLIR::Phi) == 1);
+
+	REQUIRE(bbs[3]->begin()->GetOpcode() == HLIR::Phi);
+	PhiInsn* phi = static_cast<PhiInsn*>(&*bbs[3]->begin());
+
+	REQUIRE(ret->GetReturnValue() == phi->GetResult());
+	REQUIRE(phi->GetCountIncoming() == 2);
+
+	// Constants are copied into their own register, registers are used directly.
+	SetInsn* set = static_cast<SetInsn*>(&*bbs[1]->begin());
+
+	REQUIRE(set->GetOpcode() == HLIR::Set);
+	REQUIRE(set->GetNewValue() == Int32(1));
+	REQUIRE(phi->GetIncomingValueForBlock(bbs[1]) == set->GetRegister());
+	REQUIRE(phi->GetIncomingValueForBlock(bbs[2]) == p);
+
+	// Phis don't count as branching to the blocks that they refer to.
+	REQUIRE(IR::GetPredecessors(bbs[1]) == std::vector<BasicBlock*> { bbs[0] });
+}
+
+/******************************************************************************/
+
+TEST_CASE("Mem2Reg (Phis only where the value is live)", "[SSA]")
+{
+	// entry: x = stack_alloc; cbr c, then, join
+	// then:  store p, x; r = load x; ret r
+	// join:  ret 0
+	VirtualRegisterName* p = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 3, { p });
+
+	VirtualRegisterName* x = Reg(BuiltinTypes::GetPointer());
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* r = Reg();
+
+	bbs[0]->Append(Helix::CreateStackAlloc(x, BuiltinTypes::GetInt32()));
+	bbs[0]->Append(Helix::CreateStore(Int32(0), x));
+	bbs[0]->Append(Helix::CreateCompare(HLIR::ICmp_Gt, p, Int32(5), c));
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	bbs[1]->Append(Helix::CreateStore(p, x));
+	bbs[1]->Append(Helix::CreateLoad(x, r));
+	RetInsn* ret = Helix::CreateRet(r);
+	bbs[1]->Append(ret);
+
+	bbs[2]->Append(Helix::CreateRet(Int32(0)));
+
+	RunMem2Reg(fn);
+
+	REQUIRE(CountInstructions(fn, HLIR::Phi) == 0);
+	REQUIRE(CountInstructions(fn, HLIR::Load) == 0);
+	REQUIRE(ret->GetReturnValue() == p);
+}
+
+/******************************************************************************/
+
+TEST_CASE("Mem2Reg (Loops)", "[SSA]")
+{
+	// entry: i = stack_alloc; store 0, i; br cond
+	// cond:  a = load i; c = icmp_lt a, n; cbr c, body, tail
+	// body:  b = load i; d = iadd b, 1; store d, i; br cond
+	// tail:  r = load i; ret r
+	VirtualRegisterName* n = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { n });
+
+	VirtualRegisterName* i = Reg(BuiltinTypes::GetPointer());
+	VirtualRegisterName* a = Reg();
+	VirtualRegisterName* b = Reg();
+	VirtualRegisterName* c = Reg();
+	VirtualRegisterName* d = Reg();
+	VirtualRegisterName* r = Reg();
+
+	bbs[0]->Append(Helix::CreateStackAlloc(i, BuiltinTypes::GetInt32()));
+	bbs[0]->Append(Helix::CreateStore(Int32(0), i));
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	CompareInsn* compare = Helix::CreateCompare(HLIR::ICmp_Lt, a, n, c);
+
+	bbs[1]->Append(Helix::CreateLoad(i, a));
+	bbs[1]->Append(compare);
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[2], bbs[3], c));
+
+	BinOpInsn* add = Helix::CreateBinOp(HLIR::IAdd, b, Int32(1), d);
+
+	bbs[2]->Append(Helix::CreateLoad(i, b));
+	bbs[2]->Append(add);
+	bbs[2]->Append(Helix::CreateStore(d, i));
+	bbs[2]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	RetInsn* ret = Helix::CreateRet(r);
+
+	bbs[3]->Append(Helix::CreateLoad(i, r));
+	bbs[3]->Append(ret);
+
+	RunMem2Reg(fn);
+
+	REQUIRE(CountInstructions(fn, HLIR::Phi) == 1);
+
+	PhiInsn* phi = static_cast<PhiInsn*>(&*bbs[1]->begin());
+
+	REQUIRE(phi->GetOpcode() == HLIR::Phi);
+	REQUIRE(phi->GetIncomingValueForBlock(bbs[2]) == d);
+
+	// Every load of the variable now reads the phi.
+	REQUIRE(compare->GetLHS() == phi->GetResult());
+	REQUIRE(add->GetLHS() == phi->GetResult());
+	REQUIRE(ret->GetReturnValue() == phi->GetResult());
+}
+
+/******************************************************************************/
+
+TEST_CASE("OutOfSSA (Swapping values around a loop)", "[SSA]")
+{
+	// entry: br loop
+	// loop:  x = phi [1, entry], [y, loop]; y = phi [2, entry], [x, loop]
+	//        c = icmp_lt x, n; cbr c, loop, tail
+	// tail:  ret y
+	VirtualRegisterName* n = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 3, { n });
+
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* y = Reg();
+	VirtualRegisterName* c = Reg();
+
+	PhiInsn* phiX = Helix::CreatePhi(x);
+	PhiInsn* phiY = Helix::CreatePhi(y);
+
+	phiX->AddIncoming(Int32(1), bbs[0]);
+	phiX->AddIncoming(y, bbs[1]);
+	phiY->AddIncoming(Int32(2), bbs[0]);
+	phiY->AddIncoming(x, bbs[1]);
+
+	bbs[0]->Append(Helix::CreateUnconditionalBranch(bbs[1]));
+
+	bbs[1]->Append(phiX);
+	bbs[1]->Append(phiY);
+	bbs[1]->Append(Helix::CreateCompare(HLIR::ICmp_Lt, x, n, c));
+	bbs[1]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[2], c));
+
+	bbs[2]->Append(Helix::CreateRet(y));
+
+	OutOfSSA pass;
+	pass.Execute(fn, {});
+
+	REQUIRE(CountInstructions(fn, HLIR::Phi) == 0);
+
+	SECTION("Copies for the entry edge go at the end of the entry block")
+	{
+		REQUIRE(bbs[0]->GetCountInstructions() == 3);
+		REQUIRE(IR::GetCountWriteUsers(x) == 2);
+	}
+
+	SECTION("The back edge is critical, so it gets split")
+	{
+		REQUIRE(fn->GetCountBlocks() == 4);
+
+		std::vector<BasicBlock*> preds = IR::GetPredecessors(bbs[1]);
+		REQUIRE(preds.size() == 2);
+
+		BasicBlock* split = preds[0] == bbs[0] ? preds[1] : preds[0];
+
+		REQUIRE(split->GetSuccessors() == std::vector<BasicBlock*> { bbs[1] });
+
+		// Swapping needs a temporary to hold one of the values.
+		REQUIRE(split->GetCountInstructions() == 4);
+
+		std::vector<SetInsn*> sets;
+
+		for (Instruction& insn : *split) {
+			if (insn.GetOpcode() == HLIR::Set)
+				sets.push_back(static_cast<SetInsn*>(&insn));
+		}
+
+		REQUIRE(sets.size() == 3);
+
+		Value* temp = sets[0]->GetRegister();
+
+		REQUIRE(temp != x);
+		REQUIRE(temp != y);
+		REQUIRE(sets[0]->GetNewValue() == x);
+		REQUIRE(sets[1]->GetRegister() == x);
+		REQUIRE(sets[1]->GetNewValue() == y);
+		REQUIRE(sets[2]->GetRegister() == y);
+		REQUIRE(sets[2]->GetNewValue() == temp);
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("OutOfSSA (Old value read by a phi on the way out of the loop)", "[SSA]")
+{
+	// entry: br loop
+	// loop:  h = phi [n, entry], [nx, latch]; br latch
+	// latch: nx = isub h, 1; cbr nx, loop, end
+	// end:   r = phi [0, entry], [h, latch]; ret r
+	VirtualRegisterName* n = Reg();
+
+	std::vector<BasicBlock*> bbs;
+	Function* fn = CreateFunction(bbs, 4, { n });
+
+	VirtualRegisterName* h  = Reg();
+	VirtualRegisterName* nx = Reg();
+	VirtualRegisterName* r  = Reg();
+
+	PhiInsn* phiH = Helix::CreatePhi(h);
+	phiH->AddIncoming(n, bbs[0]);
+	phiH->AddIncoming(nx, bbs[2]);
+
+	PhiInsn* phiR = Helix::CreatePhi(r);
+	phiR->AddIncoming(Int32(0), bbs[0]);
+	phiR->AddIncoming(h, bbs[2]);
+
+	bbs[0]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[3], n));
+
+	bbs[1]->Append(phiH);
+	bbs[1]->Append(Helix::CreateUnconditionalBranch(bbs[2]));
+
+	bbs[2]->Append(Helix::CreateBinOp(HLIR::ISub, h, Int32(1), nx));
+	bbs[2]->Append(Helix::CreateConditionalBranch(bbs[1], bbs[3], nx));
+
+	bbs[3]->Append(phiR);
+	bbs[3]->Append(Helix::CreateRet(r));
+
+	OutOfSSA pass;
+	pass.Execute(fn, {});
+
+	REQUIRE(CountInstructions(fn, HLIR::Phi) == 0);
+
+	// 'end' still needs the old value of 'h' from the latch, so the copy into 'h' can't
+	// go before the latch's branch (the back edge has to be split instead).
+	Instruction* beforeBranch = &*IR::GetPrev(bbs[2]->GetLast());
+
+	const std::vector<BasicBlock*> preds = IR::GetPredecessors(bbs[1]);
+
+	REQUIRE(beforeBranch->GetOpcode() == HLIR::ISub);
+	REQUIRE(preds.size() == 2);
+	REQUIRE(std::find(preds.begin(), preds.end(), bbs[2]) == preds.end());
+}
+
+/******************************************************************************/
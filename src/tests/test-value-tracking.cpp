@@ -0,0 +1,243 @@
+/**
+ * @file test-value-tracking.cpp
+ * @author Barney Wilks
+ */
+
+/* Helix Core Includes */
+#include "../value-tracking.h"
+#include "../function.h"
+
+/* Testing Library Includes */
+#include "catch.hpp"
+#include "test-helpers.h"
+
+using namespace Helix;
+
+/******************************************************************************/
+
+TEST_CASE("ValueTracking (Bitwise Operations)", "[ValueTracking]")
+{
+	VirtualRegisterName* x = Reg();
+
+	BasicBlock* bb = nullptr;
+	Function* fn = CreateFunction(bb, { x });
+
+	VirtualRegisterName* masked  = Reg();
+	VirtualRegisterName* incr    = Reg();
+	VirtualRegisterName* flagged = Reg();
+	VirtualRegisterName* cleared = Reg();
+
+	bb->Append(Helix::CreateBinOp(HLIR::And, x, Int32(0xFF), masked));
+	bb->Append(Helix::CreateBinOp(HLIR::IAdd, masked, Int32(1), incr));
+	bb->Append(Helix::CreateBinOp(HLIR::Or, masked, Int32(0x100), flagged));
+	bb->Append(Helix::CreateBinOp(HLIR::Shl, masked, Int32(4), cleared));
+	bb->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	ValueTracking& vt = am.Get<ValueTracking>(fn);
+
+	SECTION("Parameters could be anything")
+	{
+		REQUIRE(vt.GetRange(x).IsFull());
+		REQUIRE(vt.GetKnownBits(x).Zero == 0);
+		REQUIRE(vt.GetKnownBits(x).One == 0);
+	}
+
+	SECTION("And clears the top bits")
+	{
+		REQUIRE(vt.GetKnownBits(masked).Zero == 0xFFFFFF00);
+		REQUIRE(vt.GetRange(masked) == ValueRange { 32, 0, 255 });
+	}
+
+	SECTION("Add of a small range doesn't overflow")
+	{
+		REQUIRE(vt.GetRange(incr) == ValueRange { 32, 1, 256 });
+		REQUIRE(vt.IsKnownNonNegative(incr));
+	}
+
+	SECTION("Or sets known bits")
+	{
+		REQUIRE(vt.GetKnownBits(flagged).One == 0x100);
+		REQUIRE(vt.GetRange(flagged) == ValueRange { 32, 256, 511 });
+	}
+
+	SECTION("Shifting left by a constant clears the bottom bits")
+	{
+		REQUIRE(vt.GetKnownBits(cleared).CountMinTrailingZeros() == 4);
+		REQUIRE(vt.GetRange(cleared) == ValueRange { 32, 0, 255 << 4 });
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("ValueTracking (Casts)", "[ValueTracking]")
+{
+	VirtualRegisterName* x = Reg();
+
+	BasicBlock* bb = nullptr;
+	Function* fn = CreateFunction(bb, { x });
+
+	VirtualRegisterName* narrow = Reg(BuiltinTypes::GetInt8());
+	VirtualRegisterName* zext   = Reg();
+	VirtualRegisterName* sext   = Reg();
+	VirtualRegisterName* small  = Reg();
+	VirtualRegisterName* trunc  = Reg(BuiltinTypes::GetInt8());
+
+	bb->Append(Helix::CreateTruncInsn(x, narrow));
+	bb->Append(Helix::CreateZExt(narrow, zext));
+	bb->Append(Helix::CreateSExt(narrow, sext));
+	bb->Append(Helix::CreateBinOp(HLIR::And, x, Int32(0x7F), small));
+	bb->Append(Helix::CreateTruncInsn(small, trunc));
+	bb->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	ValueTracking& vt = am.Get<ValueTracking>(fn);
+
+	REQUIRE(vt.GetRange(narrow) == ValueRange::Full(8));
+	REQUIRE(vt.GetRange(zext) == ValueRange { 32, 0, 255 });
+	REQUIRE(vt.GetKnownBits(zext).CountMinLeadingZeros() == 24);
+	REQUIRE(vt.GetRange(sext) == ValueRange { 32, -128, 127 });
+
+	// Truncating a value that fits keeps its range.
+	REQUIRE(vt.GetRange(trunc) == ValueRange { 8, 0, 127 });
+	REQUIRE(vt.GetRange(small).FitsInSigned(8));
+	REQUIRE(!vt.GetRange(zext).FitsInSigned(8));
+	REQUIRE(vt.GetRange(zext).FitsInUnsigned(8));
+}
+
+/******************************************************************************/
+
+TEST_CASE("ValueTracking (Compares)", "[ValueTracking]")
+{
+	VirtualRegisterName* x = Reg();
+
+	BasicBlock* bb = nullptr;
+	Function* fn = CreateFunction(bb, { x });
+
+	VirtualRegisterName* masked = Reg();
+	VirtualRegisterName* even   = Reg();
+	VirtualRegisterName* lt     = Reg();
+	VirtualRegisterName* unknown = Reg();
+
+	bb->Append(Helix::CreateBinOp(HLIR::And, x, Int32(15), masked));
+	bb->Append(Helix::CreateBinOp(HLIR::IMul, x, Int32(2), even));
+	bb->Append(Helix::CreateCompare(HLIR::ICmp_Lt, masked, Int32(16), lt));
+	bb->Append(Helix::CreateCompare(HLIR::ICmp_Lt, masked, Int32(8), unknown));
+	bb->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	ValueTracking& vt = am.Get<ValueTracking>(fn);
+
+	bool result = false;
+
+	REQUIRE(vt.TryEvaluateCompare(HLIR::ICmp_Lt, masked, Int32(16), &result));
+	REQUIRE(result);
+
+	REQUIRE(vt.TryEvaluateCompare(HLIR::ICmp_Gte, masked, Int32(0), &result));
+	REQUIRE(result);
+
+	REQUIRE(vt.TryEvaluateCompare(HLIR::ICmp_Gt, masked, Int32(15), &result));
+	REQUIRE(!result);
+
+	REQUIRE(!vt.TryEvaluateCompare(HLIR::ICmp_Lt, masked, Int32(8), &result));
+
+	// An even number is never equal to an odd one (known from the bottom bit).
+	REQUIRE(vt.TryEvaluateCompare(HLIR::ICmp_Eq, even, Int32(7), &result));
+	REQUIRE(!result);
+
+	REQUIRE(vt.GetRange(lt) == ValueRange::Constant(32, 1));
+	REQUIRE(vt.GetRange(unknown) == ValueRange { 32, 0, 1 });
+}
+
+/******************************************************************************/
+
+TEST_CASE("ValueTracking (Loops)", "[ValueTracking]")
+{
+	VirtualRegisterName* x = Reg();
+
+	BasicBlock* entry = nullptr;
+	Function* fn = CreateFunction(entry, { x });
+
+	BasicBlock* loop = BasicBlock::Create();
+	BasicBlock* exit = BasicBlock::Create();
+
+	fn->Append(loop);
+	fn->Append(exit);
+
+	VirtualRegisterName* i      = Reg();
+	VirtualRegisterName* next   = Reg();
+	VirtualRegisterName* cond   = Reg();
+	VirtualRegisterName* choice = Reg();
+
+	PhiInsn* phiI = Helix::CreatePhi(i);
+	phiI->AddIncoming(Int32(0), entry);
+	phiI->AddIncoming(next, loop);
+
+	PhiInsn* phiChoice = Helix::CreatePhi(choice);
+	phiChoice->AddIncoming(Int32(4), entry);
+	phiChoice->AddIncoming(Int32(12), loop);
+
+	entry->Append(Helix::CreateUnconditionalBranch(loop));
+
+	loop->Append(phiI);
+	loop->Append(phiChoice);
+	loop->Append(Helix::CreateBinOp(HLIR::IAdd, i, Int32(1), next));
+	loop->Append(Helix::CreateCompare(HLIR::ICmp_Lt, next, x, cond));
+	loop->Append(Helix::CreateConditionalBranch(loop, exit, cond));
+
+	exit->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	ValueTracking& vt = am.Get<ValueTracking>(fn);
+
+	SECTION("Facts hold for every incoming value")
+	{
+		REQUIRE(vt.GetRange(choice) == ValueRange { 32, 4, 12 });
+		REQUIRE(vt.GetKnownBits(choice).One == 4);
+		REQUIRE(vt.GetKnownBits(choice).CountMinTrailingZeros() == 2);
+	}
+
+	SECTION("Growing ranges are widened")
+	{
+		// 'i' can wrap around (since x is unknown) so nothing can be assumed.
+		REQUIRE(!vt.IsKnownNonNegative(i));
+		REQUIRE(vt.GetRange(cond) == ValueRange { 32, 0, 1 });
+	}
+}
+
+/******************************************************************************/
+
+TEST_CASE("ValueTracking (Division)", "[ValueTracking]")
+{
+	VirtualRegisterName* x = Reg();
+	VirtualRegisterName* y = Reg();
+
+	BasicBlock* bb = nullptr;
+	Function* fn = CreateFunction(bb, { x, y });
+
+	VirtualRegisterName* small    = Reg();
+	VirtualRegisterName* quotient = Reg();
+	VirtualRegisterName* rem      = Reg();
+	VirtualRegisterName* anyRem   = Reg();
+	VirtualRegisterName* anyDiv   = Reg();
+
+	bb->Append(Helix::CreateBinOp(HLIR::And, x, Int32(0x7FFF), small));
+	bb->Append(Helix::CreateBinOp(HLIR::ISDiv, small, Int32(3), quotient));
+	bb->Append(Helix::CreateBinOp(HLIR::ISRem, small, Int32(10), rem));
+	bb->Append(Helix::CreateBinOp(HLIR::ISRem, x, Int32(10), anyRem));
+	bb->Append(Helix::CreateBinOp(HLIR::ISDiv, x, y, anyDiv));
+	bb->Append(Helix::CreateRet());
+
+	AnalysisManager am;
+	ValueTracking& vt = am.Get<ValueTracking>(fn);
+
+	REQUIRE(vt.GetRange(quotient) == ValueRange { 32, 0, 0x7FFF / 3 });
+	REQUIRE(vt.GetRange(rem) == ValueRange { 32, 0, 9 });
+	REQUIRE(vt.GetRange(anyRem) == ValueRange { 32, -9, 9 });
+	REQUIRE(vt.GetRange(anyDiv).IsFull());
+
+	REQUIRE(vt.IsKnownNonNegative(quotient));
+	REQUIRE(!vt.IsKnownNonNegative(anyDiv));
+}
+
+/******************************************************************************/
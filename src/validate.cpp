@@ -7,6 +7,9 @@
 #include "module.h"
 #include "print.h"
 #include "instructions.h"
+#include "ir-helpers.h"
+
+#include <algorithm>
 
 using namespace Helix;
 
@@ -121,6 +124,41 @@ bool CheckCompareInsn(Function*, BasicBlock&, CompareInsn&) {
     return true;
 }
 
+bool CheckPhiInsn(Function*, BasicBlock& bb, PhiInsn& phi) {
+	for (const Instruction& insn : bb) {
+		if (&insn == &phi)
+			break;
+
+		if (insn.GetOpcode() != HLIR::Phi) {
+			helix_error(logs::validate, "invalid phi, phis must come before any other instruction in a block");
+			return false;
+		}
+	}
+
+	std::vector<BasicBlock*> preds = IR::GetPredecessors(&bb);
+	std::sort(preds.begin(), preds.end());
+	preds.erase(std::unique(preds.begin(), preds.end()), preds.end());
+
+	if (phi.GetCountIncoming() != preds.size()) {
+		helix_error(logs::validate, "invalid phi, should have one incoming value for every predecessor");
+		return false;
+	}
+
+	for (size_t i = 0; i < phi.GetCountIncoming(); ++i) {
+		if (!std::binary_search(preds.begin(), preds.end(), phi.GetIncomingBlock(i))) {
+			helix_error(logs::validate, "invalid phi, incoming block is not a predecessor");
+			return false;
+		}
+
+		if (phi.GetIncomingValue(i)->GetType() != phi.GetResult()->GetType()) {
+			helix_error(logs::validate, "invalid phi, incoming value type should match the result type");
+			return false;
+		}
+	}
+
+	return true;
+}
+
 bool CheckCastInsn(Function*,BasicBlock&,CastInsn& cast) {
 	/* FIXME: Temporarily disabling checking ptrtoint & inttoptr since regalloc screws
 	          up the source & destination types when it renames pointers -> i32.
@@ -204,6 +242,9 @@ void ValidationPass::Execute(Module* module, const PassRunInformation&) {
 				CASE_CHECK_INSN(HLIR::Xor, BinOpInsn);
 				CASE_CHECK_INSN(HLIR::Shl, BinOpInsn);
 				CASE_CHECK_INSN(HLIR::Shr, BinOpInsn);
+				CASE_CHECK_INSN(HLIR::AShr, BinOpInsn);
+				CASE_CHECK_INSN(HLIR::IMulHS, BinOpInsn);
+				CASE_CHECK_INSN(HLIR::IMulHU, BinOpInsn);
 				CASE_CHECK_INSN(HLIR::StackAlloc, StackAllocInsn);
 				CASE_CHECK_INSN(HLIR::Store, StoreInsn);
 				CASE_CHECK_INSN(HLIR::Load, LoadInsn);
@@ -217,6 +258,7 @@ void ValidationPass::Execute(Module* module, const PassRunInformation&) {
 				CASE_CHECK_INSN(HLIR::ICmp_Lte, CompareInsn);
 				CASE_CHECK_INSN(HLIR::IntToPtr, CastInsn);
 				CASE_CHECK_INSN(HLIR::PtrToInt, CastInsn);
+				CASE_CHECK_INSN(HLIR::Phi, PhiInsn);
 				default: {
 					helix_warn(logs::validate, "instruction '{}' has no validation rules, ignoring", GetOpcodeName((HLIR::Opcode) insn.GetOpcode()));
 					break;
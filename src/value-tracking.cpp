@@ -0,0 +1,887 @@
+/**
+ * @file value-tracking.cpp
+ * @author Barney Wilks
+ *
+ * Implements value-tracking.h
+ */
+
+/* Internal Project Includes */
+#include "value-tracking.h"
+#include "function.h"
+#include "instructions.h"
+#include "ir-helpers.h"
+
+/* C++ Standard Library Includes */
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Helix;
+
+/******************************************************************************/
+
+/// Number of times the range of a register can grow before it's widened to the
+/// full range of its type.
+static constexpr unsigned kMaxRangeChanges = 8;
+
+/// Give up (and assume nothing about anything) if the function hasn't settled
+/// after this many iterations.
+static constexpr unsigned kMaxIterations = 128;
+
+/******************************************************************************/
+
+static unsigned
+GetIntegerWidth(const Type* ty)
+{
+	if (const IntegerType* integerType = type_cast<IntegerType>(ty)) {
+		if (integerType->GetBitWidth() <= 64)
+			return (unsigned) integerType->GetBitWidth();
+	}
+
+	return 0;
+}
+
+/******************************************************************************/
+
+static uint64_t
+GetWidthMask(unsigned width)
+{
+	return width >= 64 ? UINT64_MAX : ((uint64_t(1) << width) - 1);
+}
+
+static int64_t
+GetSignedMin(unsigned width)
+{
+	return width >= 64 ? INT64_MIN : -(int64_t(1) << (width - 1));
+}
+
+static int64_t
+GetSignedMax(unsigned width)
+{
+	return width >= 64 ? INT64_MAX : (int64_t(1) << (width - 1)) - 1;
+}
+
+/// Interpret the bottom 'width' bits of 'value' as a two's complement integer.
+static int64_t
+ToSigned(uint64_t value, unsigned width)
+{
+	if (width >= 64)
+		return (int64_t) value;
+
+	const uint64_t signBit = uint64_t(1) << (width - 1);
+	value &= GetWidthMask(width);
+
+	return (int64_t) ((value ^ signBit) - signBit);
+}
+
+/******************************************************************************/
+
+/* Overflow checked arithmetic, return false if the result doesn't fit in an
+   int64_t. */
+
+static bool
+CheckedAdd(int64_t a, int64_t b, int64_t* result)
+{
+	if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b))
+		return false;
+
+	*result = a + b;
+	return true;
+}
+
+static bool
+CheckedSub(int64_t a, int64_t b, int64_t* result)
+{
+	if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b))
+		return false;
+
+	*result = a - b;
+	return true;
+}
+
+static bool
+CheckedMul(int64_t a, int64_t b, int64_t* result)
+{
+	if (a == 0 || b == 0) {
+		*result = 0;
+		return true;
+	}
+
+	if ((a == -1 && b == INT64_MIN) || (b == -1 && a == INT64_MIN))
+		return false;
+
+	const int64_t product = (int64_t) ((uint64_t) a * (uint64_t) b);
+
+	if (product / b != a)
+		return false;
+
+	*result = product;
+	return true;
+}
+
+/******************************************************************************/
+
+KnownBits
+KnownBits::Constant(unsigned width, uint64_t value)
+{
+	const uint64_t mask = GetWidthMask(width);
+	return { width, ~value & mask, value & mask };
+}
+
+/******************************************************************************/
+
+unsigned
+KnownBits::CountMinTrailingZeros() const
+{
+	unsigned count = 0;
+
+	while (count < Width && ((Zero >> count) & 1))
+		count++;
+
+	return count;
+}
+
+/******************************************************************************/
+
+unsigned
+KnownBits::CountMinLeadingZeros() const
+{
+	unsigned count = 0;
+
+	while (count < Width && ((Zero >> (Width - count - 1)) & 1))
+		count++;
+
+	return count;
+}
+
+/******************************************************************************/
+
+KnownBits
+KnownBits::Join(const KnownBits& a, const KnownBits& b)
+{
+	helix_assert(a.Width == b.Width, "can't join known bits of different widths");
+	return { a.Width, a.Zero & b.Zero, a.One & b.One };
+}
+
+/******************************************************************************/
+
+ValueRange
+ValueRange::Full(unsigned width)
+{
+	return { width, GetSignedMin(width), GetSignedMax(width) };
+}
+
+/******************************************************************************/
+
+bool
+ValueRange::FitsInSigned(unsigned width) const
+{
+	return Min >= GetSignedMin(width) && Max <= GetSignedMax(width);
+}
+
+/******************************************************************************/
+
+bool
+ValueRange::FitsInUnsigned(unsigned width) const
+{
+	return Min >= 0 && (width >= 64 || (uint64_t) Max <= GetWidthMask(width));
+}
+
+/******************************************************************************/
+
+ValueRange
+ValueRange::Join(const ValueRange& a, const ValueRange& b)
+{
+	helix_assert(a.Width == b.Width, "can't join ranges of different widths");
+	return { a.Width, std::min(a.Min, b.Min), std::max(a.Max, b.Max) };
+}
+
+/******************************************************************************/
+
+/// Get the bits that are known from knowing the value is in the given range,
+/// the top bits of every value in the range are the same if the range doesn't
+/// cross zero.
+static KnownBits
+GetKnownBitsFromRange(const ValueRange& range)
+{
+	const unsigned width = range.Width;
+
+	if (range.Min < 0 && range.Max >= 0)
+		return KnownBits::Unknown(width);
+
+	const uint64_t mask = GetWidthMask(width);
+	const uint64_t lo   = (uint64_t) range.Min & mask;
+	const uint64_t hi   = (uint64_t) range.Max & mask;
+
+	uint64_t known = mask;
+
+	for (uint64_t diff = lo ^ hi; diff != 0; diff >>= 1) {
+		known <<= 1;
+	}
+
+	known &= mask;
+
+	return { width, known & ~lo, known & lo };
+}
+
+/******************************************************************************/
+
+/// Get the smallest range containing every value that matches the known bits.
+static ValueRange
+GetRangeFromKnownBits(const KnownBits& bits)
+{
+	const unsigned width   = bits.Width;
+	const uint64_t mask    = GetWidthMask(width);
+	const uint64_t signBit = uint64_t(1) << (width - 1);
+
+	const uint64_t maybeOne = ~bits.Zero & mask;
+
+	if (bits.IsNonNegative())
+		return { width, ToSigned(bits.One, width), ToSigned(maybeOne & ~signBit, width) };
+
+	if (bits.IsNegative())
+		return { width, ToSigned(bits.One | signBit, width), ToSigned(maybeOne | signBit, width) };
+
+	return { width, ToSigned(bits.One | signBit, width), ToSigned(maybeOne & ~signBit, width) };
+}
+
+/******************************************************************************/
+
+/// Make the known bits & range of 'info' agree with each other, so that each
+/// includes what can be learned from the other.
+static void
+Refine(KnownBits& bits, ValueRange& range)
+{
+	const ValueRange fromBits = GetRangeFromKnownBits(bits);
+
+	const int64_t min = std::max(range.Min, fromBits.Min);
+	const int64_t max = std::min(range.Max, fromBits.Max);
+
+	// An empty range only happens for code that can't execute, leave it.
+	if (min > max)
+		return;
+
+	range.Min = min;
+	range.Max = max;
+
+	const KnownBits fromRange = GetKnownBitsFromRange(range);
+
+	if (((bits.Zero | fromRange.Zero) & (bits.One | fromRange.One)) == 0) {
+		bits.Zero |= fromRange.Zero;
+		bits.One  |= fromRange.One;
+	}
+}
+
+/******************************************************************************/
+
+/// Compute the known bits of `lhs + rhs + carry`
+static KnownBits
+AddKnownBits(const KnownBits& lhs, const KnownBits& rhs, bool carry)
+{
+	const uint64_t mask = lhs.GetMask();
+
+	const uint64_t possibleSumZero = ((~lhs.Zero & mask) + (~rhs.Zero & mask) + carry) & mask;
+	const uint64_t possibleSumOne  = (lhs.One + rhs.One + carry) & mask;
+
+	const uint64_t carryKnownZero = ~(possibleSumZero ^ lhs.Zero ^ rhs.Zero);
+	const uint64_t carryKnownOne  = possibleSumOne ^ lhs.One ^ rhs.One;
+
+	const uint64_t known = (lhs.Zero | lhs.One) & (rhs.Zero | rhs.One) & (carryKnownZero | carryKnownOne) & mask;
+
+	return { lhs.Width, ~possibleSumOne & known, possibleSumOne & known };
+}
+
+/******************************************************************************/
+
+ValueTracking::ValueTracking(Function* fn)
+{
+	HELIX_PROFILE_ZONE;
+
+	this->Solve(fn);
+}
+
+/******************************************************************************/
+
+bool
+ValueTracking::GetInfo(Value* value, ValueInfo* info) const
+{
+	const unsigned width = GetIntegerWidth(value->GetType());
+
+	if (width == 0)
+		return false;
+
+	if (ConstantInt* constant = value_cast<ConstantInt>(value)) {
+		info->Bits  = KnownBits::Constant(width, constant->GetIntegralValue());
+		info->Range = ValueRange::Constant(width, ToSigned(constant->GetIntegralValue(), width));
+		return true;
+	}
+
+	auto it = m_Info.find(value);
+
+	if (it != m_Info.end()) {
+		*info = it->second;
+		return true;
+	}
+
+	// Registers whose definition hasn't been visited yet (e.g. the value of a
+	// phi coming around a back edge) are left undefined, rather than assumed
+	// to be anything, so that the facts from the other incoming values aren't
+	// lost.
+	if (value_isa<VirtualRegisterName>(value) && IR::GetCountWriteUsers(value) > 0 && !m_Solved)
+		return false;
+
+	info->Bits  = KnownBits::Unknown(width);
+	info->Range = ValueRange::Full(width);
+	return true;
+}
+
+/******************************************************************************/
+
+bool
+ValueTracking::ComputeBinOp(HLIR::Opcode opc, const ValueInfo& lhs, const ValueInfo& rhs, ValueInfo* info) const
+{
+	const unsigned   width = lhs.Bits.Width;
+	const uint64_t   mask  = GetWidthMask(width);
+
+	const KnownBits&  lb = lhs.Bits;
+	const KnownBits&  rb = rhs.Bits;
+	const ValueRange& lr = lhs.Range;
+	const ValueRange& rr = rhs.Range;
+
+	KnownBits  bits  = KnownBits::Unknown(width);
+	ValueRange range = ValueRange::Full(width);
+
+	// Set the range to [min, max] if it doesn't overflow the type.
+	auto setRange = [&](int64_t min, int64_t max) {
+		if (min >= GetSignedMin(width) && max <= GetSignedMax(width))
+			range = { width, min, max };
+	};
+
+	switch (opc) {
+	case HLIR::IAdd: {
+		int64_t min, max;
+		bits = AddKnownBits(lb, rb, false);
+
+		if (CheckedAdd(lr.Min, rr.Min, &min) && CheckedAdd(lr.Max, rr.Max, &max))
+			setRange(min, max);
+
+		break;
+	}
+
+	case HLIR::ISub: {
+		int64_t min, max;
+		bits = AddKnownBits(lb, { width, rb.One, rb.Zero }, true);
+
+		if (CheckedSub(lr.Min, rr.Max, &min) && CheckedSub(lr.Max, rr.Min, &max))
+			setRange(min, max);
+
+		break;
+	}
+
+	case HLIR::IMul: {
+		int64_t corners[4];
+
+		const bool ok = CheckedMul(lr.Min, rr.Min, &corners[0]) && CheckedMul(lr.Min, rr.Max, &corners[1])
+		             && CheckedMul(lr.Max, rr.Min, &corners[2]) && CheckedMul(lr.Max, rr.Max, &corners[3]);
+
+		if (ok)
+			setRange(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+
+		const unsigned trailingZeros = std::min(width, lb.CountMinTrailingZeros() + rb.CountMinTrailingZeros());
+		bits.Zero = GetWidthMask(trailingZeros);
+		break;
+	}
+
+	case HLIR::ISDiv: {
+		// Dividing by a divisor that can't be zero (or -1, which could overflow)
+		// means the result is between the results of dividing the ends.
+		if (rr.Min > 0 || (rr.Max < -1)) {
+			int64_t corners[4] = {
+				lr.Min / rr.Min, lr.Min / rr.Max,
+				lr.Max / rr.Min, lr.Max / rr.Max
+			};
+
+			setRange(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+		}
+
+		break;
+	}
+
+	case HLIR::IUDiv: {
+		if (lr.IsNonNegative() && rr.Min > 0)
+			setRange(lr.Min / rr.Max, lr.Max / rr.Min);
+
+		break;
+	}
+
+	case HLIR::ISRem: {
+		// The result has the sign of the dividend & is smaller in magnitude than
+		// the divisor.
+		if (rr.Min > INT64_MIN && (rr.Min > 0 || rr.Max < 0)) {
+			const int64_t limit = std::max(std::abs(rr.Min), std::abs(rr.Max)) - 1;
+
+			if (lr.IsNonNegative())
+				setRange(0, std::min(lr.Max, limit));
+			else if (lr.Max <= 0)
+				setRange(std::max(lr.Min, -limit), 0);
+			else
+				setRange(-limit, limit);
+		}
+
+		break;
+	}
+
+	case HLIR::IURem: {
+		if (rr.Min > 0)
+			setRange(0, lr.IsNonNegative() ? std::min(lr.Max, rr.Max - 1) : rr.Max - 1);
+
+		break;
+	}
+
+	case HLIR::And:
+		bits = { width, lb.Zero | rb.Zero, lb.One & rb.One };
+		break;
+
+	case HLIR::Or:
+		bits = { width, lb.Zero & rb.Zero, lb.One | rb.One };
+		break;
+
+	case HLIR::Xor:
+		bits = { width, (lb.Zero & rb.Zero) | (lb.One & rb.One), (lb.Zero & rb.One) | (lb.One & rb.Zero) };
+		break;
+
+	case HLIR::Shl: {
+		if (!rr.IsConstant() || rr.Min < 0 || rr.Min >= (int64_t) width)
+			break;
+
+		const unsigned amount = (unsigned) rr.Min;
+
+		bits = { width, ((lb.Zero << amount) | GetWidthMask(amount)) & mask, (lb.One << amount) & mask };
+
+		int64_t min, max;
+
+		if (CheckedMul(lr.Min, int64_t(1) << amount, &min) && CheckedMul(lr.Max, int64_t(1) << amount, &max))
+			setRange(min, max);
+
+		break;
+	}
+
+	case HLIR::Shr: {
+		if (!rr.IsConstant() || rr.Min < 0 || rr.Min >= (int64_t) width)
+			break;
+
+		const unsigned amount = (unsigned) rr.Min;
+
+		bits = { width, ((lb.Zero & mask) >> amount) | (mask & ~(mask >> amount)), (lb.One & mask) >> amount };
+		break;
+	}
+
+	case HLIR::AShr: {
+		if (!rr.IsConstant() || rr.Min < 0 || rr.Min >= (int64_t) width)
+			break;
+
+		const unsigned amount = (unsigned) rr.Min;
+
+		// The bits shifted in at the top are copies of the sign bit, so are known
+		// if it is.
+		const uint64_t top     = mask & ~(mask >> amount);
+		const uint64_t signBit = uint64_t(1) << (width - 1);
+
+		bits = {
+			width,
+			((lb.Zero & mask) >> amount) | ((lb.Zero & signBit) ? top : 0),
+			((lb.One & mask) >> amount)  | ((lb.One & signBit) ? top : 0)
+		};
+
+		setRange(lr.Min >> amount, lr.Max >> amount);
+		break;
+	}
+
+	case HLIR::IMulHS:
+	case HLIR::IMulHU: {
+		// The top half of the product, so the ends of the range are the top halves
+		// of the products of the ends. Unsigned operands can only be treated this
+		// way if they're never negative.
+		if (width > 32 || (opc == HLIR::IMulHU && (!lr.IsNonNegative() || !rr.IsNonNegative())))
+			break;
+
+		int64_t corners[4];
+
+		const bool ok = CheckedMul(lr.Min, rr.Min, &corners[0]) && CheckedMul(lr.Min, rr.Max, &corners[1])
+		             && CheckedMul(lr.Max, rr.Min, &corners[2]) && CheckedMul(lr.Max, rr.Max, &corners[3]);
+
+		if (ok)
+			setRange(*std::min_element(corners, corners + 4) >> width, *std::max_element(corners, corners + 4) >> width);
+
+		break;
+	}
+
+	default:
+		return false;
+	}
+
+	bits.Zero &= mask;
+	bits.One  &= mask;
+
+	Refine(bits, range);
+
+	info->Bits  = bits;
+	info->Range = range;
+
+	return true;
+}
+
+/******************************************************************************/
+
+bool
+ValueTracking::ComputeCast(HLIR::Opcode opc, const ValueInfo& src, unsigned dstWidth, ValueInfo* info) const
+{
+	const unsigned srcWidth = src.Bits.Width;
+
+	const uint64_t srcMask = GetWidthMask(srcWidth);
+	const uint64_t dstMask = GetWidthMask(dstWidth);
+
+	KnownBits  bits  = KnownBits::Unknown(dstWidth);
+	ValueRange range = ValueRange::Full(dstWidth);
+
+	switch (opc) {
+	case HLIR::ZExt:
+		bits = { dstWidth, (src.Bits.Zero | ~srcMask) & dstMask, src.Bits.One };
+
+		if (src.Range.IsNonNegative())
+			range = { dstWidth, src.Range.Min, src.Range.Max };
+		else
+			range = { dstWidth, 0, (int64_t) srcMask };
+
+		break;
+
+	case HLIR::SExt: {
+		const uint64_t extension = dstMask & ~srcMask;
+
+		bits = { dstWidth, src.Bits.Zero, src.Bits.One };
+
+		if (src.Bits.IsNonNegative())
+			bits.Zero |= extension;
+		else if (src.Bits.IsNegative())
+			bits.One |= extension;
+
+		range = { dstWidth, src.Range.Min, src.Range.Max };
+		break;
+	}
+
+	case HLIR::Trunc:
+		bits = { dstWidth, src.Bits.Zero & dstMask, src.Bits.One & dstMask };
+
+		if (src.Range.FitsInSigned(dstWidth))
+			range = { dstWidth, src.Range.Min, src.Range.Max };
+
+		break;
+
+	default:
+		return false;
+	}
+
+	Refine(bits, range);
+
+	info->Bits  = bits;
+	info->Range = range;
+
+	return true;
+}
+
+/******************************************************************************/
+
+/// Work out the result of the compare from what's known about the operands.
+static bool
+EvaluateCompare(HLIR::Opcode opc, const KnownBits& lb, const ValueRange& lr,
+                const KnownBits& rb, const ValueRange& rr, bool* result)
+{
+	if (lb.Width != rb.Width)
+		return false;
+
+	switch (opc) {
+	case HLIR::ICmp_Eq:
+	case HLIR::ICmp_Neq: {
+		const bool isEq = opc == HLIR::ICmp_Eq;
+
+		if (lr.IsConstant() && rr.IsConstant() && lr.Min == rr.Min) {
+			*result = isEq;
+			return true;
+		}
+
+		const bool bitsConflict = ((lb.One & rb.Zero) | (lb.Zero & rb.One)) != 0;
+
+		if (lr.Max < rr.Min || rr.Max < lr.Min || bitsConflict) {
+			*result = !isEq;
+			return true;
+		}
+
+		return false;
+	}
+
+	case HLIR::ICmp_Lt:
+		if (lr.Max < rr.Min)  { *result = true;  return true; }
+		if (lr.Min >= rr.Max) { *result = false; return true; }
+		return false;
+
+	case HLIR::ICmp_Lte:
+		if (lr.Max <= rr.Min) { *result = true;  return true; }
+		if (lr.Min > rr.Max)  { *result = false; return true; }
+		return false;
+
+	case HLIR::ICmp_Gt:
+		return EvaluateCompare(HLIR::ICmp_Lt, rb, rr, lb, lr, result);
+
+	case HLIR::ICmp_Gte:
+		return EvaluateCompare(HLIR::ICmp_Lte, rb, rr, lb, lr, result);
+
+	default:
+		return false;
+	}
+}
+
+/******************************************************************************/
+
+bool
+ValueTracking::ComputeInstruction(Instruction* insn, Value** result, ValueInfo* info) const
+{
+	const HLIR::Opcode opc = (HLIR::Opcode) insn->GetOpcode();
+
+	if (HLIR::IsBinaryOp(opc)) {
+		BinOpInsn* binop = static_cast<BinOpInsn*>(insn);
+		ValueInfo lhs, rhs;
+
+		*result = binop->GetResult();
+
+		if (!GetInfo(binop->GetLHS(), &lhs) || !GetInfo(binop->GetRHS(), &rhs))
+			return false;
+
+		if (lhs.Bits.Width != rhs.Bits.Width || lhs.Bits.Width != GetIntegerWidth((*result)->GetType()))
+			return false;
+
+		return ComputeBinOp(opc, lhs, rhs, info);
+	}
+
+	if (HLIR::IsCompare(opc)) {
+		CompareInsn* compare = static_cast<CompareInsn*>(insn);
+		ValueInfo lhs, rhs;
+
+		*result = compare->GetResult();
+
+		const unsigned width = GetIntegerWidth((*result)->GetType());
+
+		if (width == 0 || !GetInfo(compare->GetLHS(), &lhs) || !GetInfo(compare->GetRHS(), &rhs))
+			return false;
+
+		bool value;
+
+		if (EvaluateCompare(opc, lhs.Bits, lhs.Range, rhs.Bits, rhs.Range, &value)) {
+			info->Bits  = KnownBits::Constant(width, value);
+			info->Range = ValueRange::Constant(width, value);
+		} else {
+			info->Bits  = { width, GetWidthMask(width) & ~uint64_t(1), 0 };
+			info->Range = { width, 0, 1 };
+		}
+
+		return true;
+	}
+
+	switch (opc) {
+	case HLIR::Set: {
+		SetInsn* set = static_cast<SetInsn*>(insn);
+		*result = set->GetRegister();
+
+		return GetInfo(set->GetNewValue(), info);
+	}
+
+	case HLIR::Phi: {
+		// Anything that's true for every incoming value is true for the result,
+		// incoming values that haven't been computed yet are skipped.
+		PhiInsn* phi = static_cast<PhiInsn*>(insn);
+		*result = phi->GetResult();
+
+		const unsigned width = GetIntegerWidth((*result)->GetType());
+		bool   hasIncoming   = false;
+
+		if (width == 0)
+			return false;
+
+		for (size_t i = 0; i < phi->GetCountIncoming(); ++i) {
+			Value*    value = phi->GetIncomingValue(i);
+			ValueInfo incoming;
+
+			if (value_isa<UndefValue>(value) || !GetInfo(value, &incoming))
+				continue;
+
+			if (incoming.Bits.Width != width)
+				return false;
+
+			if (hasIncoming) {
+				info->Bits  = KnownBits::Join(info->Bits, incoming.Bits);
+				info->Range = ValueRange::Join(info->Range, incoming.Range);
+			} else {
+				*info = incoming;
+				hasIncoming = true;
+			}
+		}
+
+		return hasIncoming;
+	}
+
+	case HLIR::ZExt:
+	case HLIR::SExt:
+	case HLIR::Trunc: {
+		CastInsn* cast = static_cast<CastInsn*>(insn);
+		ValueInfo src;
+
+		*result = cast->GetDst();
+
+		const unsigned width = GetIntegerWidth(cast->GetDstType());
+
+		if (width == 0 || !GetInfo(cast->GetSrc(), &src))
+			return false;
+
+		return ComputeCast(opc, src, width, info);
+	}
+
+	default:
+		return false;
+	}
+}
+
+/******************************************************************************/
+
+bool
+ValueTracking::Update(Value* value, const ValueInfo& info)
+{
+	auto it = m_Info.find(value);
+
+	if (it == m_Info.end()) {
+		m_Info[value] = info;
+		return true;
+	}
+
+	ValueInfo& existing = it->second;
+
+	KnownBits  bits  = KnownBits::Join(existing.Bits, info.Bits);
+	ValueRange range = ValueRange::Join(existing.Range, info.Range);
+
+	if (range != existing.Range && ++existing.CountRangeChanges > kMaxRangeChanges)
+		range = ValueRange::Full(range.Width);
+
+	Refine(bits, range);
+
+	if (bits.Zero == existing.Bits.Zero && bits.One == existing.Bits.One && range == existing.Range)
+		return false;
+
+	existing.Bits  = bits;
+	existing.Range = range;
+
+	return true;
+}
+
+/******************************************************************************/
+
+void
+ValueTracking::Solve(Function* fn)
+{
+	// Start off knowing everything about every register (by not having
+	// any entry for it) and then only keep what's still true each time
+	// its definition is visited, until nothing changes.
+	bool changed = true;
+
+	for (unsigned iteration = 0; changed; ++iteration) {
+		if (iteration == kMaxIterations) {
+			// Should never really happen, but if it does forgetting everything
+			// is always correct.
+			m_Info.clear();
+			break;
+		}
+
+		changed = false;
+
+		for (BasicBlock& bb : fn->blocks()) {
+			for (Instruction& insn : bb) {
+				Value*    result = nullptr;
+				ValueInfo info;
+
+				if (ComputeInstruction(&insn, &result, &info)) {
+					changed |= Update(result, info);
+					continue;
+				}
+
+				// Anything else that writes to an integer register (loads, calls,
+				// ptrtoint...) could write any value.
+				for (size_t i = 0; i < insn.GetCountOperands(); ++i) {
+					Value* operand = insn.GetOperand(i);
+
+					if (!insn.OperandHasFlags(i, Instruction::OP_WRITE) || !value_isa<VirtualRegisterName>(operand))
+						continue;
+
+					if (operand == result)
+						continue;
+
+					const unsigned width = GetIntegerWidth(operand->GetType());
+
+					if (width > 0)
+						changed |= Update(operand, { KnownBits::Unknown(width), ValueRange::Full(width) });
+				}
+			}
+		}
+	}
+
+	m_Solved = true;
+}
+
+/******************************************************************************/
+
+KnownBits
+ValueTracking::GetKnownBits(Value* value) const
+{
+	ValueInfo info;
+
+	if (!GetInfo(value, &info))
+		return KnownBits::Unknown(GetIntegerWidth(value->GetType()));
+
+	return info.Bits;
+}
+
+/******************************************************************************/
+
+ValueRange
+ValueTracking::GetRange(Value* value) const
+{
+	ValueInfo info;
+
+	if (!GetInfo(value, &info))
+		return ValueRange::Full(GetIntegerWidth(value->GetType()));
+
+	return info.Range;
+}
+
+/******************************************************************************/
+
+bool
+ValueTracking::IsKnownNonNegative(Value* value) const
+{
+	ValueInfo info;
+
+	if (!GetInfo(value, &info))
+		return false;
+
+	return info.Range.IsNonNegative();
+}
+
+/******************************************************************************/
+
+bool
+ValueTracking::TryEvaluateCompare(HLIR::Opcode opc, Value* lhs, Value* rhs, bool* result) const
+{
+	ValueInfo l, r;
+
+	if (!GetInfo(lhs, &l) || !GetInfo(rhs, &r))
+		return false;
+
+	return EvaluateCompare(opc, l.Bits, l.Range, r.Bits, r.Range, result);
+}
+
+/******************************************************************************/
@@ -0,0 +1,153 @@
+/**
+ * @file value-tracking.h
+ * @author Barney Wilks
+ *
+ * Known bits & integer value range analysis.
+ *
+ * For every integer virtual register in a function this works out which bits
+ * are always zero/one & the (signed) range of values that the register can
+ * hold, by propagating facts forward through binary operations, casts &
+ * compares.
+ *
+ * Every register has a single definition (HLIR is in SSA form after Mem2Reg,
+ * and before that variables still live in memory), but the facts for a phi in
+ * a loop depend on values computed later in the loop, so they are found by
+ * iterating to a fixed point over the whole function. Ranges that keep growing
+ * (e.g. loop counters) are widened to the full range of the type to guarantee
+ * that this terminates.
+ *
+ * Passes should get this through the AnalysisManager. Results stay correct as
+ * long as a pass only replaces values with equivalent values (which is what
+ * peephole optimisations do), they don't have to be thrown away after every
+ * change.
+ */
+
+#pragma once
+
+/* Internal Project Includes */
+#include "system.h"
+#include "analysis-manager.h"
+#include "opcodes.h"
+
+/* C++ Standard Library Includes */
+#include <unordered_map>
+
+/* C Standard Library Includes */
+#include <stdint.h>
+
+namespace Helix
+{
+	class Function;
+	class Instruction;
+	class Value;
+	class Type;
+
+	/// Bits of an integer that are known to always be zero or one.
+	struct KnownBits
+	{
+		/// Width of the integer in bits (at most 64)
+		unsigned Width = 0;
+
+		/// Bits that are always zero.
+		uint64_t Zero = 0;
+
+		/// Bits that are always one.
+		uint64_t One = 0;
+
+		static KnownBits Unknown(unsigned width) { return { width, 0, 0 }; }
+		static KnownBits Constant(unsigned width, uint64_t value);
+
+		uint64_t GetMask() const { return Width >= 64 ? UINT64_MAX : ((uint64_t(1) << Width) - 1); }
+
+		bool IsConstant() const { return ((Zero | One) & GetMask()) == GetMask(); }
+
+		/// Number of bits at the bottom of the value that are known to be zero.
+		unsigned CountMinTrailingZeros() const;
+
+		/// Number of bits at the top of the value that are known to be zero.
+		unsigned CountMinLeadingZeros() const;
+
+		bool IsNonNegative() const { return Width > 0 && (Zero >> (Width - 1)) & 1; }
+		bool IsNegative() const { return Width > 0 && (One >> (Width - 1)) & 1; }
+
+		/// Keep only the facts that are true for both 'a' and 'b'.
+		static KnownBits Join(const KnownBits& a, const KnownBits& b);
+	};
+
+	/// An inclusive range of values [Min, Max] that a (signed) integer can hold.
+	struct ValueRange
+	{
+		unsigned Width = 0;
+		int64_t  Min   = 0;
+		int64_t  Max   = 0;
+
+		static ValueRange Full(unsigned width);
+		static ValueRange Constant(unsigned width, int64_t value) { return { width, value, value }; }
+
+		bool IsFull() const { return *this == Full(Width); }
+		bool IsConstant() const { return Min == Max; }
+		bool IsNonNegative() const { return Min >= 0; }
+
+		/// Return true if every value in the range can be represented by a signed
+		/// (or unsigned) integer of the given width.
+		bool FitsInSigned(unsigned width) const;
+		bool FitsInUnsigned(unsigned width) const;
+
+		static ValueRange Join(const ValueRange& a, const ValueRange& b);
+
+		bool operator==(const ValueRange& other) const
+		{
+			return Width == other.Width && Min == other.Min && Max == other.Max;
+		}
+
+		bool operator!=(const ValueRange& other) const { return !(*this == other); }
+	};
+
+	class ValueTracking : public Analysis
+	{
+	public:
+		ValueTracking(Function* fn);
+
+		HELIX_NO_STEAL(ValueTracking);
+
+		/// Get the bits of the given integer value that are known. Constants
+		/// are known exactly, non integer values know nothing.
+		KnownBits GetKnownBits(Value* value) const;
+
+		/// Get the signed range of values that the given integer can hold.
+		ValueRange GetRange(Value* value) const;
+
+		/// Return true if the given integer is never negative when interpreted
+		/// as a signed value.
+		bool IsKnownNonNegative(Value* value) const;
+
+		/// Work out the result of comparing 'lhs' & 'rhs' with the given (signed)
+		/// compare opcode. Returns false if the result can vary, otherwise true
+		/// with 'result' set to the result of the compare.
+		bool TryEvaluateCompare(HLIR::Opcode opc, Value* lhs, Value* rhs, bool* result) const;
+
+	private:
+		struct ValueInfo
+		{
+			KnownBits  Bits;
+			ValueRange Range;
+			unsigned   CountRangeChanges = 0;
+		};
+
+		bool GetInfo(Value* value, ValueInfo* info) const;
+
+		bool ComputeInstruction(Instruction* insn, Value** result, ValueInfo* info) const;
+		bool ComputeBinOp(HLIR::Opcode opc, const ValueInfo& lhs, const ValueInfo& rhs, ValueInfo* info) const;
+		bool ComputeCast(HLIR::Opcode opc, const ValueInfo& src, unsigned dstWidth, ValueInfo* info) const;
+
+		bool Update(Value* value, const ValueInfo& info);
+
+		void Solve(Function* fn);
+
+	private:
+		std::unordered_map<const Value*, ValueInfo> m_Info;
+		bool                                        m_Solved = false;
+	};
+}
+
+REGISTER_ANALYSIS(ValueTracking, valuetracking, "Known bits & integer value ranges");
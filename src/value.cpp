@@ -112,6 +112,25 @@ void Value::RemoveUse(Instruction* user, uint16_t operandIndex)
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+int64_t ConstantInt::GetSignedIntegralValue() const
+{
+	const IntegerType* myType = type_cast<IntegerType>(this->GetType());
+	helix_assert(myType, "Wait, I _really_ should be an integer");
+
+	const size_t width = myType->GetBitWidth();
+
+	if (width >= 64)
+		return (int64_t) m_Integer;
+
+	const Integer mask    = ((Integer) 1 << width) - 1;
+	const Integer signBit = (Integer) 1 << (width - 1);
+	const Integer value   = m_Integer & mask;
+
+	return (int64_t) ((value ^ signBit) - signBit);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool ConstantInt::CanFitInType(const IntegerType* ty) const
 {
 	// #FIXME(bwilks): This doesn't handle any overflow/underflow cases, and it should
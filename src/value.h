@@ -235,6 +235,10 @@ namespace Helix
 
 		inline Integer GetIntegralValue() const { return m_Integer; }
 
+		/// Interpret the value as a two's complement integer of the bit width
+		/// of this constant's type (so i8 255 is -1).
+		int64_t GetSignedIntegralValue() const;
+
 		bool CanFitInType(const IntegerType* ty) const;
 
 	private:
@@ -253,6 +257,20 @@ namespace Helix
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+	/// How visible a function or global variable is outside of the translation
+	/// unit it's defined in.
+	enum class Linkage
+	{
+		/// Can be referenced from other translation units (the default)
+		External,
+
+		/// Only visible inside this translation unit (e.g. declared `static` in C),
+		/// so can be removed if nothing here uses it.
+		Internal
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 	class GlobalVariable : public Value
 	{
 	public:
@@ -268,6 +286,11 @@ namespace Helix
 
 		const Type* GetBaseType() const { return m_BaseType; }
 
+		Linkage GetLinkage() const { return m_Linkage; }
+		void SetLinkage(Linkage linkage) { m_Linkage = linkage; }
+
+		bool HasInternalLinkage() const { return m_Linkage == Linkage::Internal; }
+
 		static GlobalVariable* Create(const std::string& name, const Type* baseType, Value* init)
 		{
 			return new GlobalVariable(name, baseType, init);
@@ -282,6 +305,7 @@ namespace Helix
 		const Type* m_BaseType;
 		Value*      m_Init;
 		std::string m_Name;
+		Linkage     m_Linkage = Linkage::External;
 	};
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
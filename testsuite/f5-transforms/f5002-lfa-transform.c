@@ -11,8 +11,12 @@ int via_direct_ptr_access(struct MyType* a) {
   return a->b;
 }
 
+// Keep 'ty' in memory, rather than having SROA split it up.
+struct MyType* escape;
+
 int via_value_access() {
   struct MyType ty;
+  escape = &ty;
   ty.a = 20;
   return ty.a;
 }
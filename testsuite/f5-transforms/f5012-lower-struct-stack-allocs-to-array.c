@@ -5,9 +5,13 @@ struct MyStruct
   short c;
 };
 
+// Keep 'ms' in memory, rather than having SROA split it up.
+struct MyStruct* escape;
+
 int main()
 {
   struct MyStruct ms;
+  escape = &ms;
   ms.c = 23;
   return ms.c;
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+static int counter = 3;
+static int unused_counter = 7;
+
+static int unused_b(int x);
+
+static int unused_a(int x)
+{
+	unused_counter = x;
+	return unused_b(x);
+}
+
+static int unused_b(int x)
+{
+	return unused_a(x);
+}
+
+static int used(int x)
+{
+	return counter + x;
+}
+
+int main()
+{
+	return used(4);
+}
\ No newline at end of file
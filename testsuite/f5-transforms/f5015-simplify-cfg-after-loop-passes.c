@@ -0,0 +1,9 @@
+int sum_to(int n)
+{
+	int total = 0;
+
+	for (int i = 0; i < n; i = i + 1)
+		total = total + i;
+
+	return total;
+}
\ No newline at end of file